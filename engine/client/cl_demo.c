@@ -23,6 +23,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 void CL_FinishTimeDemo (void);
 float demtime;
+float olddemotime = 0;
 float recdemostart;	//keyed to Sys_DoubleTime
 int demoframe;
 
@@ -31,6 +32,8 @@ static int cls_lasttype;
 
 void CL_PlayDemo(char *demoname, qboolean usesystempath);
 void CL_PlayDemoFile(vfsfile_t *f, char *demoname, qboolean issyspath);
+void CL_PlayDemoStream(vfsfile_t *file, char *filename, qboolean issyspath, int demotype, float bufferdelay);
+vfsfile_t *CL_OpenFileInZipOrSys(char *name, qboolean usesystempath);
 
 extern cvar_t qtvcl_forceversion1;
 extern cvar_t qtvcl_eztvextensions;
@@ -388,6 +391,67 @@ void CL_ProgressDemoTime(void)
 		demtime += host_frametime;
 }
 
+//restarts playback from the last keyframe in the demo's .idx (written by sv_demoIndex) that is before newtime.
+//returns false if there's no usable index, or if it wouldn't get us any closer than we already are.
+static qboolean CL_DemoJumpIndexed(float newtime)
+{
+	vfsfile_t *df = cls.demoinfile;
+	vfsfile_t *idx;
+	int header[3];
+	qofs_t pos, bestpos = 0;
+	unsigned int besttime = 0, bestofs = 0;
+	int bestlen = 0;
+	char *data;
+
+	if (cls.demoplayback != DPB_MVD || !df || df->seekstyle != SS_SEEKABLE)
+		return false;
+	idx = CL_OpenFileInZipOrSys(va("%s.idx", cls.lastdemoname), cls.lastdemowassystempath);
+	if (!idx)
+		return false;
+
+	if (VFS_READ(idx, header, sizeof(int)*2) == sizeof(int)*2 && LittleLong(header[0]) == MVDINDEX_MAGIC && LittleLong(header[1]) == MVDINDEX_VERSION)
+	{
+		for (pos = sizeof(int)*2; VFS_READ(idx, header, sizeof(header)) == sizeof(header); )
+		{
+			if ((unsigned int)LittleLong(header[0]) > newtime*1000)
+				break;
+			besttime = LittleLong(header[0]);
+			bestofs = LittleLong(header[1]);
+			bestlen = LittleLong(header[2]);
+			bestpos = pos + sizeof(header);
+
+			pos = bestpos + bestlen;
+			if (!VFS_SEEK(idx, pos))
+				break;
+		}
+	}
+
+	//the keyframe has to fit in the demo buffer along with some actual demo data.
+	if (!bestpos || bestlen <= 0 || bestlen > sizeof(demobuffer)/2 || (newtime >= demtime && besttime <= demtime*1000))
+	{
+		VFS_CLOSE(idx);
+		return false;
+	}
+
+	data = BZ_Malloc(bestlen);
+	VFS_SEEK(idx, bestpos);
+	bestlen = VFS_READ(idx, data, bestlen);
+	VFS_CLOSE(idx);
+	if (bestlen <= 0 || !VFS_SEEK(df, bestofs))
+	{
+		BZ_Free(data);
+		return false;
+	}
+
+	//restart the stream with the keyframe's gamestate already buffered, followed by the rest of the demo from where the keyframe was taken.
+	cls.demoinfile = NULL;
+	CL_PlayDemoStream(df, cls.lastdemoname, cls.lastdemowassystempath, DPB_MVD, 0);
+	demo_resetcache(bestlen, data);
+	BZ_Free(data);
+	demtime = olddemotime = besttime/1000.0;
+	return true;
+}
+
 void CL_DemoJump_f(void)
 {
 	float newtime;
@@ -431,7 +495,9 @@ void CL_DemoJump_f(void)
 	if (newtime < 0)
 		newtime = 0;
 
-	if (newtime >= demtime)
+	if (CL_DemoJumpIndexed(newtime))
+		cls.demoseektime = newtime;
+	else if (newtime >= demtime)
 		cls.demoseektime = newtime;
 	else
 	{
@@ -506,7 +572,6 @@ CL_GetDemoMessage
 */
 
 vec3_t demoangles;
-float olddemotime = 0;
 float nextdemotime = 0;
 qboolean CL_GetDemoMessage (void)
 {
@@ -27,6 +27,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "cl_ignore.h"
 #include "shader.h"
 #include "vr.h"
+#include "com_mesh.h"
 #include <ctype.h>
 // callbacks
 void QDECL CL_Sbar_Callback(struct cvar_s *var, char *oldvalue);
@@ -5221,7 +5222,7 @@ void CL_Init (void)
 	Cmd_AddCommand ("qtvplay", CL_QTVPlay_f);
 	Cmd_AddCommand ("qtvlist", CL_QTVList_f);
 	Cmd_AddCommand ("qtvdemos", CL_QTVDemos_f);
-	Cmd_AddCommandD ("demo_jump", CL_DemoJump_f, "Jump to a specified time in a demo. Prefix with a + or - for a relative offset. Seeking backwards will restart the demo and the fast forward, which can take some time in long demos.");
+	Cmd_AddCommandD ("demo_jump", CL_DemoJump_f, "Jump to a specified time in a demo. Prefix with a + or - for a relative offset. Seeking backwards will restart the demo and the fast forward, which can take some time in long demos (unless the demo has an .idx file written by sv_demoIndex).");
 	Cmd_AddCommandD ("demo_nudge", CL_DemoNudge_f, "Nudge the demo by one frame. Argument should be +1 or -1. Nudging backwards is limited.");
 	Cmd_AddCommandAD ("timedemo", CL_TimeDemo_f, CL_DemoList_c, NULL);
 #ifdef _DEBUG
@@ -6512,6 +6513,9 @@ double Host_Frame (double time)
 #endif
 
 	cls.framecount++;
+#ifdef SKELETALMODELS
+	Alias_NewFrame();	//new frame, new poses.
+#endif
 
 	RSpeedRemark();
 
@@ -1194,6 +1194,7 @@ extern char emodel_name[], pmodel_name[], prespawn_name[], modellist_name[], sou
 
 //CL_TraceLine traces against network(positive)+csqc(negative) ents. returns frac(1 on failure), and impact, normal, ent values
 float CL_TraceLine (vec3_t start, vec3_t end, vec3_t impact, vec3_t normal, int *ent);
+qboolean CL_TraceLineIsClear (vec3_t start, vec3_t end);	//cheap check for whether CL_TraceLine can be skipped.
 entity_t *TraceLineR (vec3_t start, vec3_t end, vec3_t impact, vec3_t normal, qboolean bsponly);
 
 //
@@ -38,6 +38,7 @@ cvar_t r_dodgypcxfiles = CVARD("r_dodgypcxfiles", "0", "When enabled, this will
 #endif
 cvar_t r_dodgymiptex = CVARD("r_dodgymiptex", "1", "When enabled, this will force regeneration of mipmaps, discarding mips1-4 like glquake did. This may eg solve fullbright issues with some maps, but may reduce distant detail levels.");
 cvar_t r_keepimages = CVARD("r_keepimages", "0", "Retain unused images in memory for slightly faster map loading.\n0: Redundant images will be purged after each map change.\n1: Images will be retained until vid_reload (potentially consuming a lot of ram).");
+cvar_t r_imagecache = CVARFD("r_imagecache", "0", CVAR_ARCHIVE, "Stores the fully processed form of each image under $gamedir/imagecache/, so that later loads can skip decoding, mipmapping, and format conversions. Entries are named by the image's contents and the settings that affect it, so they never go stale, but the directory is never pruned either and can be deleted at any time.");
 cvar_t r_ignoremapprefixes = CVARD("r_ignoremapprefixes", "0",  "Ignores when textures were loaded from map-specific paths.\n0: textures/foo/tex.tga will not be confused with textures/foo/tex.tga.\n1: The same texture might be loaded multiple times over.");
 
 char *r_defaultimageextensions =
@@ -7497,10 +7498,92 @@ qbyte *ReadRawImageFile(qbyte *buf, int len, int *width, int *height, uploadfmt_
 	return NULL;
 }
 
-static void Image_MipMap1X8 (qbyte *in, int inwidth, int inheight, qbyte *out, int outwidth, int outheight)
+//large images are split into strips of rows so that the loader threads can help out with them.
+//func gets called with ranges of rows from whichever thread claimed them, so it must not care about the order.
+#define IMAGESTRIP_PIXELS (256*256)	//big enough that the helpers aren't just fighting over the counter
+static struct
+{	//for r_imagedecodebench and r_imagemipbench
+	qboolean scalar;	//bypass the simd paths
+	qboolean serial;	//don't split images across threads
+} image_bench;
+#ifdef LOADERTHREAD
+typedef struct
+{
+	void (*func)(void *ctx, unsigned int row, unsigned int endrow);
+	void *ctx;
+	unsigned int rows;
+	unsigned int striprows;
+	unsigned int strips;
+
+	volatile qatomic32_t nextstrip;
+	volatile qatomic32_t donestrips;
+	volatile qatomic32_t refs;	//the caller plus any helpers that were queued. last one out frees it.
+} imagestrips_t;
+static void Image_Strips_Run(imagestrips_t *st)
+{
+	unsigned int strip, row;
+	while ((strip = FTE_Atomic32_Inc(&st->nextstrip)-1) < st->strips)
+	{
+		row = strip*st->striprows;
+		st->func(st->ctx, row, min(row+st->striprows, st->rows));
+		FTE_Atomic32_Inc(&st->donestrips);
+	}
+}
+static void Image_Strips_Helper(void *ctx, void *data, size_t a, size_t b)
+{
+	imagestrips_t *st = ctx;
+	Image_Strips_Run(st);
+	if (!FTE_Atomic32_Dec(&st->refs))
+		BZ_Free(st);
+}
+#endif
+//ctx only needs to stay valid until this returns. helpers that turn up late won't find any strips left to look at it.
+static void Image_Strips(void (*func)(void *ctx, unsigned int row, unsigned int endrow), void *ctx, unsigned int rows, unsigned int striprows)
+{
+#ifdef LOADERTHREAD
+	imagestrips_t *st;
+	unsigned int strips, helpers;
+
+	striprows = max(1, striprows);
+	strips = (rows+striprows-1)/striprows;
+	if (image_bench.serial || strips <= 1)
+		helpers = 0;
+	else
+		helpers = min(strips-1, COM_WorkerCount(WG_LOADER));
+	if (!helpers)
+	{
+		func(ctx, 0, rows);
+		return;
+	}
+
+	st = BZ_Malloc(sizeof(*st));
+	st->func = func;
+	st->ctx = ctx;
+	st->rows = rows;
+	st->striprows = striprows;
+	st->strips = strips;
+	st->nextstrip = 0;
+	st->donestrips = 0;
+	st->refs = 1+helpers;
+	//helpers go to the front of the queue, but if the workers are all busy we'll just end up doing it all ourselves.
+	while (helpers-- > 0)
+		COM_InsertWork(WG_LOADER, Image_Strips_Helper, st, NULL, 0, 0);
+	Image_Strips_Run(st);
+	//anything still outstanding is being worked on right now, and won't take long.
+	while (st->donestrips < st->strips)
+		Sys_Sleep(0);
+	if (!FTE_Atomic32_Dec(&st->refs))
+		BZ_Free(st);
+#else
+	func(ctx, 0, rows);
+#endif
+}
+
+static void Image_MipMap1X8 (const void *indata, int inwidth, int inheight, void *outdata, int outwidth, int outheight)
 {
 	int		i, j;
-	qbyte	*inrow;
+	const qbyte	*in = indata, *inrow;
+	qbyte	*out = outdata;
 
 	int rowwidth = inwidth;	//rowwidth is the byte width of the input
 	inrow = in;
@@ -7529,10 +7612,11 @@ static void Image_MipMap1X8 (qbyte *in, int inwidth, int inheight, qbyte *out, i
 	}
 }
 
-static void Image_MipMap2X8 (qbyte *in, int inwidth, int inheight, qbyte *out, int outwidth, int outheight)
+static void Image_MipMap2X8 (const void *indata, int inwidth, int inheight, void *outdata, int outwidth, int outheight)
 {
 	int		i, j;
-	qbyte	*inrow;
+	const qbyte	*in = indata, *inrow;
+	qbyte	*out = outdata;
 
 	int rowwidth = inwidth*2;	//rowwidth is the byte width of the input
 	inrow = in;
@@ -7577,10 +7661,11 @@ static void Image_MipMap2X8 (qbyte *in, int inwidth, int inheight, qbyte *out, i
 	}
 }
 
-static void Image_MipMap3X8 (qbyte *in, int inwidth, int inheight, qbyte *out, int outwidth, int outheight)
+static void Image_MipMap3X8 (const void *indata, int inwidth, int inheight, void *outdata, int outwidth, int outheight)
 {
 	int		i, j;
-	qbyte	*inrow;
+	const qbyte	*in = indata, *inrow;
+	qbyte	*out = outdata;
 
 	int rowwidth = inwidth*3;	//rowwidth is the byte width of the input
 	inrow = in;
@@ -7629,10 +7714,11 @@ static void Image_MipMap3X8 (qbyte *in, int inwidth, int inheight, qbyte *out, i
 	}
 }
 
-static void Image_MipMap4X8 (qbyte *in, int inwidth, int inheight, qbyte *out, int outwidth, int outheight)
+static void Image_MipMap4X8 (const void *indata, int inwidth, int inheight, void *outdata, int outwidth, int outheight)
 {
 	int		i, j;
-	qbyte	*inrow;
+	const qbyte	*in = indata, *inrow;
+	qbyte	*out = outdata;
 
 	int rowwidth = inwidth*4;	//rowwidth is the byte width of the input
 	inrow = in;
@@ -7686,10 +7772,11 @@ static void Image_MipMap4X8 (qbyte *in, int inwidth, int inheight, qbyte *out, i
 }
 
 //oh how I wish I had C++'s template stuff right now
-static void Image_MipMap4X16 (unsigned short *in, int inwidth, int inheight, unsigned short *out, int outwidth, int outheight)
+static void Image_MipMap4X16 (const void *indata, int inwidth, int inheight, void *outdata, int outwidth, int outheight)
 {
 	int		i, j;
-	unsigned short	*inrow;
+	const unsigned short	*in = indata, *inrow;
+	unsigned short	*out = outdata;
 
 	int rowwidth = inwidth*4;	//rowwidth is the byte width of the input
 	inrow = in;
@@ -7826,10 +7913,11 @@ fte_inlinestatic unsigned short HalfFloatBlend4(unsigned short a, unsigned short
 {
 	return FloatToHalf((HalfToFloat(a) + HalfToFloat(b) + HalfToFloat(c) + HalfToFloat(d))/4);
 }
-static void Image_MipMap4X16F (unsigned short *in, int inwidth, int inheight, unsigned short *out, int outwidth, int outheight)
+static void Image_MipMap4X16F (const void *indata, int inwidth, int inheight, void *outdata, int outwidth, int outheight)
 {
 	int		i, j;
-	unsigned short	*inrow;
+	const unsigned short	*in = indata, *inrow;
+	unsigned short	*out = outdata;
 
 	int rowwidth = inwidth*4;	//rowwidth is the byte width of the input
 	inrow = in;
@@ -7882,10 +7970,11 @@ static void Image_MipMap4X16F (unsigned short *in, int inwidth, int inheight, un
 	}
 }
 
-static void Image_MipMap4X32F (float *in, int inwidth, int inheight, float *out, int outwidth, int outheight)
+static void Image_MipMap4X32F (const void *indata, int inwidth, int inheight, void *outdata, int outwidth, int outheight)
 {
 	int		i, j;
-	float	*inrow;
+	const float	*in = indata, *inrow;
+	float	*out = outdata;
 
 	int rowwidth = inwidth*4;	//rowwidth is the byte width of the input
 	inrow = in;
@@ -7947,10 +8036,11 @@ static qbyte Image_BlendPalette_4(qbyte a, qbyte b, qbyte c, qbyte d)
 	return a;
 }
 //this is expected to be slow, thanks to those two expensive helpers.
-static void Image_MipMap8Pal (qbyte *in, int inwidth, int inheight, qbyte *out, int outwidth, int outheight)
+static void Image_MipMap8Pal (const void *indata, int inwidth, int inheight, void *outdata, int outwidth, int outheight)
 {
 	int		i, j;
-	qbyte	*inrow;
+	const qbyte	*in = indata, *inrow;
+	qbyte	*out = outdata;
 
 	int rowwidth = inwidth;	//rowwidth is the byte width of the input
 	inrow = in;
@@ -7979,21 +8069,383 @@ static void Image_MipMap8Pal (qbyte *in, int inwidth, int inheight, qbyte *out,
 	}
 }
 
-void Image_GenerateMips(struct pendingtextureinfo *mips, unsigned int flags)
+//srgb textures should be averaged in linear space, otherwise the smaller mips get darker and contrast gets lost.
+//the averages are converted back to whichever srgb value is nearest, so a flat colour stays exactly the same.
+static unsigned int srgb_tolinear[256];		//24bit linear
+static unsigned int srgb_thresholds[257];	//the linear values that each srgb value is nearest from
+static qbyte srgb_fromlinear[1<<12];		//indexed by the top bits of the linear value. the srgb steps are all wider than this, so its either this value or the next.
+static volatile qboolean srgb_tablesready;
+static void Image_SRGBTables(void)
 {
-	int mip;
+	int i, j;
+	if (srgb_tablesready)
+		return;
+	//this can end up running on multiple threads at once, but they'll all be writing the same values.
+	for (i = 0; i < 256; i++)
+		srgb_tolinear[i] = Image_LinearFloatFromsRGBFloat(i*(1.0f/255))*(double)0xffffff + 0.5;
+	srgb_thresholds[0] = 0;
+	for (i = 1; i < 256; i++)
+		srgb_thresholds[i] = (srgb_tolinear[i-1]+srgb_tolinear[i]+1)>>1;
+	srgb_thresholds[256] = 0x7fffffff;
+	for (i = 0, j = 0; i < countof(srgb_fromlinear); i++)
+	{
+		while (srgb_thresholds[j+1] <= (i<<12))
+			j++;
+		srgb_fromlinear[i] = j;
+	}
+	srgb_tablesready = true;
+}
+fte_inlinestatic qbyte Image_SRGBFromLinear(unsigned int v)
+{
+	unsigned int i = srgb_fromlinear[v>>12];
+	return i + (v >= srgb_thresholds[i+1]);
+}
+//the first 'colours' channels of each pixel are srgb, any others are alpha and are averaged as-is.
+static void Image_MipMapSRGB (const qbyte *in, int inwidth, int inheight, qbyte *out, int outwidth, int outheight, int channels, int colours)
+{
+	int		i, j, c;
+	const qbyte	*inrow = in;
+	int rowwidth = inwidth*channels;
+	//mips round down, except for when the input is 1, in which case we reuse the same pixel instead of peeking past it.
+	int dx = (inwidth<=1)?0:channels, dy = (inheight<=1)?0:rowwidth;
 
-	if (mips->type == PTI_3D)
-		return;	//3d mipmaps are more complicated to compute.
+	Image_SRGBTables();
+	for (i=0 ; i<outheight ; i++, inrow+=rowwidth*2)
+	{
+		for (in = inrow, j=0 ; j<outwidth ; j++, in+=channels*2)
+		{
+			for (c = 0; c < colours; c++)
+				*out++ = Image_SRGBFromLinear((srgb_tolinear[in[c]] + srgb_tolinear[in[c+dx]] + srgb_tolinear[in[c+dy]] + srgb_tolinear[in[c+dx+dy]] + 2)>>2);
+			for (; c < channels; c++)
+				*out++ = (in[c] + in[c+dx] + in[c+dy] + in[c+dx+dy])>>2;
+		}
+	}
+}
+static void Image_MipMap1X8SRGB (const void *indata, int inwidth, int inheight, void *outdata, int outwidth, int outheight)
+{
+	Image_MipMapSRGB(indata, inwidth, inheight, outdata, outwidth, outheight, 1, 1);
+}
+static void Image_MipMap2X8SRGB (const void *indata, int inwidth, int inheight, void *outdata, int outwidth, int outheight)
+{
+	Image_MipMapSRGB(indata, inwidth, inheight, outdata, outwidth, outheight, 2, 1);
+}
+static void Image_MipMap3X8SRGB (const void *indata, int inwidth, int inheight, void *outdata, int outwidth, int outheight)
+{
+	Image_MipMapSRGB(indata, inwidth, inheight, outdata, outwidth, outheight, 3, 3);
+}
+static void Image_MipMap4X8SRGB (const void *indata, int inwidth, int inheight, void *outdata, int outwidth, int outheight)
+{
+	Image_MipMapSRGB(indata, inwidth, inheight, outdata, outwidth, outheight, 4, 3);
+}
 
-	if (flags & IF_NOMIPMAP)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+//vectorised versions of the common 2*2 case. these give exactly the same results as the scalar versions above, which still deal with the edges.
+#define MIPMAP_SSE2
+#include <emmintrin.h>
+
+static void Image_MipMap4X8_SSE2 (const void *indata, int inwidth, int inheight, void *outdata, int outwidth, int outheight)
+{
+	int		i, j;
+	const qbyte	*in, *inrow = indata;
+	qbyte	*out = outdata;
+	int rowwidth = inwidth*4;
+	const __m128i zero = _mm_setzero_si128();
+	__m128i t0, t1, b0, b1, lo, hi, l, r;
+
+	if (inwidth <= 1 || inheight <= 1)
+	{
+		Image_MipMap4X8(indata, inwidth, inheight, outdata, outwidth, outheight);
 		return;
+	}
+	for (i=0 ; i<outheight ; i++, inrow+=rowwidth*2)
+	{
+		//4 output pixels at a time. add the rows together first, then the neighbouring pixels.
+		for (in = inrow, j=0 ; j+4<=outwidth ; j+=4, out+=16, in+=32)
+		{
+			t0 = _mm_loadu_si128((const __m128i*)in);
+			t1 = _mm_loadu_si128((const __m128i*)(in+16));
+			b0 = _mm_loadu_si128((const __m128i*)(in+rowwidth));
+			b1 = _mm_loadu_si128((const __m128i*)(in+rowwidth+16));
 
-	if (sh_config.can_genmips && mips->encoding != PTI_P8)
+			lo = _mm_add_epi16(_mm_unpacklo_epi8(t0, zero), _mm_unpacklo_epi8(b0, zero));	//0,1
+			hi = _mm_add_epi16(_mm_unpackhi_epi8(t0, zero), _mm_unpackhi_epi8(b0, zero));	//2,3
+			l = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+			lo = _mm_add_epi16(_mm_unpacklo_epi8(t1, zero), _mm_unpacklo_epi8(b1, zero));	//4,5
+			hi = _mm_add_epi16(_mm_unpackhi_epi8(t1, zero), _mm_unpackhi_epi8(b1, zero));	//6,7
+			r = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+
+			_mm_storeu_si128((__m128i*)out, _mm_packus_epi16(_mm_srli_epi16(l, 2), _mm_srli_epi16(r, 2)));
+		}
+		if (j < outwidth)
+		{
+			Image_MipMap4X8(in, inwidth, inheight, out, outwidth-j, 1);
+			out += (outwidth-j)*4;
+		}
+	}
+}
+
+//these match the (slightly odd) rounding of HalfToFloat+FloatToHalf, rather than using f16c.
+static void SSE2_HalfToFloat(__m128i h, __m128 *lo, __m128 *hi)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i v, u, e;
+
+	v = _mm_unpacklo_epi16(h, zero);
+	e = _mm_andnot_si128(_mm_cmpeq_epi32(_mm_and_si128(v, _mm_set1_epi32(0x7c00)), zero), _mm_set1_epi32(112<<23));	//rebias the exponent, unless its a denormal
+	u = _mm_add_epi32(_mm_slli_epi32(_mm_and_si128(v, _mm_set1_epi32(0x7fff)), 13), e);
+	*lo = _mm_castsi128_ps(_mm_or_si128(u, _mm_slli_epi32(_mm_and_si128(v, _mm_set1_epi32(0x8000)), 16)));
+
+	v = _mm_unpackhi_epi16(h, zero);
+	e = _mm_andnot_si128(_mm_cmpeq_epi32(_mm_and_si128(v, _mm_set1_epi32(0x7c00)), zero), _mm_set1_epi32(112<<23));
+	u = _mm_add_epi32(_mm_slli_epi32(_mm_and_si128(v, _mm_set1_epi32(0x7fff)), 13), e);
+	*hi = _mm_castsi128_ps(_mm_or_si128(u, _mm_slli_epi32(_mm_and_si128(v, _mm_set1_epi32(0x8000)), 16)));
+}
+static __m128i SSE2_FloatToHalf4(__m128 f)
+{
+	__m128i u = _mm_castps_si128(f), e, m, r;
+	e = _mm_and_si128(_mm_srli_epi32(u, 23), _mm_set1_epi32(0xff));
+	m = _mm_andnot_si128(_mm_cmpgt_epi32(e, _mm_set1_epi32(127+15)), _mm_and_si128(_mm_srli_epi32(u, 13), _mm_set1_epi32(0x3ff)));	//infinity instead of a nan
+	r = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(u, 16), _mm_set1_epi32(0x8000)), _mm_slli_epi32(_mm_sub_epi32(e, _mm_set1_epi32(127-15)), 10));
+	r = _mm_andnot_si128(_mm_cmplt_epi32(e, _mm_set1_epi32(127-15)), _mm_or_si128(r, m));	//too small exponent, treat it as a 0 denormal
+	//sign-extend the low 16 bits so that packs doesn't saturate them
+	return _mm_srai_epi32(_mm_slli_epi32(r, 16), 16);
+}
+static void Image_MipMap4X16F_SSE2 (const void *indata, int inwidth, int inheight, void *outdata, int outwidth, int outheight)
+{
+	int		i, j;
+	const unsigned short	*in, *inrow = indata;
+	unsigned short	*out = outdata;
+	int rowwidth = inwidth*4;
+	const __m128 quarter = _mm_set1_ps(0.25f);
+	__m128 ta, tb, tc, td, ba, bb, bc, bd;
+
+	if (inwidth <= 1 || inheight <= 1)
+	{
+		Image_MipMap4X16F(indata, inwidth, inheight, outdata, outwidth, outheight);
 		return;
+	}
+	for (i=0 ; i<outheight ; i++, inrow+=rowwidth*2)
+	{
+		for (in = inrow, j=0 ; j+2<=outwidth ; j+=2, out+=8, in+=16)
+		{
+			SSE2_HalfToFloat(_mm_loadu_si128((const __m128i*)in), &ta, &tb);
+			SSE2_HalfToFloat(_mm_loadu_si128((const __m128i*)(in+8)), &tc, &td);
+			SSE2_HalfToFloat(_mm_loadu_si128((const __m128i*)(in+rowwidth)), &ba, &bb);
+			SSE2_HalfToFloat(_mm_loadu_si128((const __m128i*)(in+rowwidth+8)), &bc, &bd);
+			//same order of additions as HalfFloatBlend4, so the results round the same way.
+			ta = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_add_ps(ta, tb), ba), bb), quarter);
+			tc = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_add_ps(tc, td), bc), bd), quarter);
+			_mm_storeu_si128((__m128i*)out, _mm_packs_epi32(SSE2_FloatToHalf4(ta), SSE2_FloatToHalf4(tc)));
+		}
+		if (j < outwidth)
+		{
+			Image_MipMap4X16F(in, inwidth, inheight, out, outwidth-j, 1);
+			out += (outwidth-j)*4;
+		}
+	}
+}
 
-	if (mips->mip[0].depth != 1)
-		return;	//blurgh. we can't deal with layers.
+static void Image_MipMap4X32F_SSE2 (const void *indata, int inwidth, int inheight, void *outdata, int outwidth, int outheight)
+{
+	int		i, j;
+	const float	*in, *inrow = indata;
+	float	*out = outdata;
+	int rowwidth = inwidth*4;
+	const __m128 quarter = _mm_set1_ps(0.25f);
+
+	if (inwidth <= 1 || inheight <= 1)
+	{
+		Image_MipMap4X32F(indata, inwidth, inheight, outdata, outwidth, outheight);
+		return;
+	}
+	for (i=0 ; i<outheight ; i++, inrow+=rowwidth*2)
+		for (in = inrow, j=0 ; j<outwidth ; j++, out+=4, in+=8)
+			_mm_storeu_ps(out, _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_loadu_ps(in), _mm_loadu_ps(in+4)), _mm_loadu_ps(in+rowwidth)), _mm_loadu_ps(in+rowwidth+4)), quarter));
+}
+#endif
+
+#if defined(__AVX2__) && defined(MIPMAP_SSE2)
+//twice the width again.
+#define MIPMAP_AVX2
+#include <immintrin.h>
+static void Image_MipMap4X8_AVX2 (const void *indata, int inwidth, int inheight, void *outdata, int outwidth, int outheight)
+{
+	int		i, j;
+	const qbyte	*in, *inrow = indata;
+	qbyte	*out = outdata;
+	int rowwidth = inwidth*4;
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i t0, t1, b0, b1, lo, hi, l, r;
+
+	if (inwidth <= 1 || inheight <= 1)
+	{
+		Image_MipMap4X8(indata, inwidth, inheight, outdata, outwidth, outheight);
+		return;
+	}
+	for (i=0 ; i<outheight ; i++, inrow+=rowwidth*2)
+	{
+		//same as the sse2 version, but each lane ends up with a different part of the output.
+		for (in = inrow, j=0 ; j+8<=outwidth ; j+=8, out+=32, in+=64)
+		{
+			t0 = _mm256_loadu_si256((const __m256i*)in);
+			t1 = _mm256_loadu_si256((const __m256i*)(in+32));
+			b0 = _mm256_loadu_si256((const __m256i*)(in+rowwidth));
+			b1 = _mm256_loadu_si256((const __m256i*)(in+rowwidth+32));
+
+			lo = _mm256_add_epi16(_mm256_unpacklo_epi8(t0, zero), _mm256_unpacklo_epi8(b0, zero));
+			hi = _mm256_add_epi16(_mm256_unpackhi_epi8(t0, zero), _mm256_unpackhi_epi8(b0, zero));
+			l = _mm256_add_epi16(_mm256_unpacklo_epi64(lo, hi), _mm256_unpackhi_epi64(lo, hi));	//0,1 | 2,3
+			lo = _mm256_add_epi16(_mm256_unpacklo_epi8(t1, zero), _mm256_unpacklo_epi8(b1, zero));
+			hi = _mm256_add_epi16(_mm256_unpackhi_epi8(t1, zero), _mm256_unpackhi_epi8(b1, zero));
+			r = _mm256_add_epi16(_mm256_unpacklo_epi64(lo, hi), _mm256_unpackhi_epi64(lo, hi));	//4,5 | 6,7
+
+			l = _mm256_packus_epi16(_mm256_srli_epi16(l, 2), _mm256_srli_epi16(r, 2));	//0,1,4,5 | 2,3,6,7
+			_mm256_storeu_si256((__m256i*)out, _mm256_permute4x64_epi64(l, _MM_SHUFFLE(3,1,2,0)));
+		}
+		if (j < outwidth)
+		{
+			Image_MipMap4X8_SSE2(in, inwidth, inheight, out, outwidth-j, 1);
+			out += (outwidth-j)*4;
+		}
+	}
+}
+
+static __m256 AVX2_HalfToFloat(__m128i h)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i v = _mm256_cvtepu16_epi32(h), e, u;
+	e = _mm256_andnot_si256(_mm256_cmpeq_epi32(_mm256_and_si256(v, _mm256_set1_epi32(0x7c00)), zero), _mm256_set1_epi32(112<<23));
+	u = _mm256_add_epi32(_mm256_slli_epi32(_mm256_and_si256(v, _mm256_set1_epi32(0x7fff)), 13), e);
+	return _mm256_castsi256_ps(_mm256_or_si256(u, _mm256_slli_epi32(_mm256_and_si256(v, _mm256_set1_epi32(0x8000)), 16)));
+}
+static __m256i AVX2_FloatToHalf(__m256 f)
+{
+	__m256i u = _mm256_castps_si256(f), e, m, r;
+	e = _mm256_and_si256(_mm256_srli_epi32(u, 23), _mm256_set1_epi32(0xff));
+	m = _mm256_andnot_si256(_mm256_cmpgt_epi32(e, _mm256_set1_epi32(127+15)), _mm256_and_si256(_mm256_srli_epi32(u, 13), _mm256_set1_epi32(0x3ff)));
+	r = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(u, 16), _mm256_set1_epi32(0x8000)), _mm256_slli_epi32(_mm256_sub_epi32(e, _mm256_set1_epi32(127-15)), 10));
+	r = _mm256_andnot_si256(_mm256_cmpgt_epi32(_mm256_set1_epi32(127-15), e), _mm256_or_si256(r, m));
+	return _mm256_srai_epi32(_mm256_slli_epi32(r, 16), 16);
+}
+static void Image_MipMap4X16F_AVX2 (const void *indata, int inwidth, int inheight, void *outdata, int outwidth, int outheight)
+{
+	int		i, j;
+	const unsigned short	*in, *inrow = indata;
+	unsigned short	*out = outdata;
+	int rowwidth = inwidth*4;
+	const __m256 quarter = _mm256_set1_ps(0.25f);
+	__m128i p, q;
+	__m256 a, b, c, d;
+	__m256i r0, r1;
+
+	if (inwidth <= 1 || inheight <= 1)
+	{
+		Image_MipMap4X16F(indata, inwidth, inheight, outdata, outwidth, outheight);
+		return;
+	}
+	for (i=0 ; i<outheight ; i++, inrow+=rowwidth*2)
+	{
+		//4 output pixels at a time, 2 per register with the left input pixels in one and the right in the other.
+		for (in = inrow, j=0 ; j+4<=outwidth ; j+=4, out+=16, in+=32)
+		{
+			p = _mm_loadu_si128((const __m128i*)in);
+			q = _mm_loadu_si128((const __m128i*)(in+8));
+			a = AVX2_HalfToFloat(_mm_unpacklo_epi64(p, q));
+			b = AVX2_HalfToFloat(_mm_unpackhi_epi64(p, q));
+			p = _mm_loadu_si128((const __m128i*)(in+rowwidth));
+			q = _mm_loadu_si128((const __m128i*)(in+rowwidth+8));
+			c = AVX2_HalfToFloat(_mm_unpacklo_epi64(p, q));
+			d = AVX2_HalfToFloat(_mm_unpackhi_epi64(p, q));
+			r0 = AVX2_FloatToHalf(_mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_add_ps(a, b), c), d), quarter));
+
+			p = _mm_loadu_si128((const __m128i*)(in+16));
+			q = _mm_loadu_si128((const __m128i*)(in+24));
+			a = AVX2_HalfToFloat(_mm_unpacklo_epi64(p, q));
+			b = AVX2_HalfToFloat(_mm_unpackhi_epi64(p, q));
+			p = _mm_loadu_si128((const __m128i*)(in+rowwidth+16));
+			q = _mm_loadu_si128((const __m128i*)(in+rowwidth+24));
+			c = AVX2_HalfToFloat(_mm_unpacklo_epi64(p, q));
+			d = AVX2_HalfToFloat(_mm_unpackhi_epi64(p, q));
+			r1 = AVX2_FloatToHalf(_mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_add_ps(a, b), c), d), quarter));
+
+			r0 = _mm256_packs_epi32(r0, r1);	//0,2 | 1,3
+			_mm256_storeu_si256((__m256i*)out, _mm256_permute4x64_epi64(r0, _MM_SHUFFLE(3,1,2,0)));
+		}
+		if (j < outwidth)
+		{
+			Image_MipMap4X16F_SSE2(in, inwidth, inheight, out, outwidth-j, 1);
+			out += (outwidth-j)*4;
+		}
+	}
+}
+
+static void Image_MipMap4X32F_AVX2 (const void *indata, int inwidth, int inheight, void *outdata, int outwidth, int outheight)
+{
+	int		i, j;
+	const float	*in, *inrow = indata;
+	float	*out = outdata;
+	int rowwidth = inwidth*4;
+	const __m256 quarter = _mm256_set1_ps(0.25f);
+	__m256 p, q, a, b, c, d;
+
+	if (inwidth <= 1 || inheight <= 1)
+	{
+		Image_MipMap4X32F(indata, inwidth, inheight, outdata, outwidth, outheight);
+		return;
+	}
+	for (i=0 ; i<outheight ; i++, inrow+=rowwidth*2)
+	{
+		for (in = inrow, j=0 ; j+2<=outwidth ; j+=2, out+=8, in+=16)
+		{
+			p = _mm256_loadu_ps(in);
+			q = _mm256_loadu_ps(in+8);
+			a = _mm256_permute2f128_ps(p, q, 0x20);
+			b = _mm256_permute2f128_ps(p, q, 0x31);
+			p = _mm256_loadu_ps(in+rowwidth);
+			q = _mm256_loadu_ps(in+rowwidth+8);
+			c = _mm256_permute2f128_ps(p, q, 0x20);
+			d = _mm256_permute2f128_ps(p, q, 0x31);
+			_mm256_storeu_ps(out, _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_add_ps(a, b), c), d), quarter));
+		}
+		if (j < outwidth)
+		{
+			Image_MipMap4X32F_SSE2(in, inwidth, inheight, out, outwidth-j, 1);
+			out += (outwidth-j)*4;
+		}
+	}
+}
+#endif
+
+typedef void (*mipfunc_t) (const void *indata, int inwidth, int inheight, void *outdata, int outwidth, int outheight);
+typedef struct
+{
+	mipfunc_t func;
+	const qbyte *in;
+	qbyte *out;
+	int inwidth, inheight;
+	int outwidth;
+	size_t instride;	//two rows of the input
+	size_t outstride;
+} mipstrips_t;
+static void Image_MipMapRows(void *ctx, unsigned int row, unsigned int endrow)
+{
+	mipstrips_t *ms = ctx;
+	//inheight is only used to detect the single-row case, so it doesn't need to be adjusted for the strip.
+	ms->func(ms->in + row*ms->instride, ms->inwidth, ms->inheight, ms->out + row*ms->outstride, ms->outwidth, endrow-row);
+}
+#if defined(MIPMAP_AVX2)
+#define MIPMAP_SIMD(f) (image_bench.scalar?f:f##_AVX2)
+#elif defined(MIPMAP_SSE2)
+#define MIPMAP_SIMD(f) (image_bench.scalar?f:f##_SSE2)
+#else
+#define MIPMAP_SIMD(f) f
+#endif
+static void Image_GenerateMipChain(struct pendingtextureinfo *mips)
+{
+	int mip;
+	mipfunc_t mipfunc;
+	size_t pixelsize;
+	mipstrips_t ms;
 
 	switch(mips->encoding)
 	{
@@ -8002,180 +8454,64 @@ void Image_GenerateMips(struct pendingtextureinfo *mips, unsigned int flags)
 	case PTI_P8:
 		if (sh_config.can_mipcap)
 			return;	//if we can cap mips, do that. it'll save lots of expensive lookups and uglyness.
-		for (mip = mips->mipcount; mip < countof(mips->mip); mip++)
-		{
-			mips->mip[mip].width = mips->mip[mip-1].width >> 1;
-			mips->mip[mip].height = mips->mip[mip-1].height >> 1;
-			mips->mip[mip].depth = 1;
-			if (mips->mip[mip].width < 1 && mips->mip[mip].height < 1)
-				break;
-			if (mips->mip[mip].width < 1)
-				mips->mip[mip].width = 1;
-			if (mips->mip[mip].height < 1)
-				mips->mip[mip].height = 1;
-			mips->mip[mip].datasize = mips->mip[mip].width * mips->mip[mip].height;
-			mips->mip[mip].data = BZ_Malloc(mips->mip[mip].datasize);
-			mips->mip[mip].needfree = true;
-
-			Image_MipMap8Pal(mips->mip[mip-1].data, mips->mip[mip-1].width, mips->mip[mip-1].height, mips->mip[mip].data, mips->mip[mip].width, mips->mip[mip].height);
-			mips->mipcount = mip+1;
-		}
-		return;
+		mipfunc = Image_MipMap8Pal;
+		pixelsize = 1;
+		break;
+	case PTI_L8_SRGB:
+		mipfunc = Image_MipMap1X8SRGB;
+		pixelsize = 1;
+		break;
 	case PTI_R8:
 	case PTI_R8_SNORM:
 	case PTI_L8:
-	case PTI_L8_SRGB:
-		for (mip = mips->mipcount; mip < countof(mips->mip); mip++)
-		{
-			mips->mip[mip].width = mips->mip[mip-1].width >> 1;
-			mips->mip[mip].height = mips->mip[mip-1].height >> 1;
-			mips->mip[mip].depth = 1;
-			if (mips->mip[mip].width < 1 && mips->mip[mip].height < 1)
-				break;
-			if (mips->mip[mip].width < 1)
-				mips->mip[mip].width = 1;
-			if (mips->mip[mip].height < 1)
-				mips->mip[mip].height = 1;
-			mips->mip[mip].datasize = mips->mip[mip].width * mips->mip[mip].height;
-			mips->mip[mip].data = BZ_Malloc(mips->mip[mip].datasize);
-			mips->mip[mip].needfree = true;
-
-			Image_MipMap1X8(mips->mip[mip-1].data, mips->mip[mip-1].width, mips->mip[mip-1].height, mips->mip[mip].data, mips->mip[mip].width, mips->mip[mip].height);
-			mips->mipcount = mip+1;
-		}
-		return;	
+		mipfunc = Image_MipMap1X8;
+		pixelsize = 1;
+		break;
+	case PTI_L8A8_SRGB:
+		mipfunc = Image_MipMap2X8SRGB;
+		pixelsize = 2;
+		break;
 	case PTI_RG8:
 	case PTI_RG8_SNORM:
 	case PTI_L8A8:
-	case PTI_L8A8_SRGB:
-		for (mip = mips->mipcount; mip < countof(mips->mip); mip++)
-		{
-			mips->mip[mip].width = mips->mip[mip-1].width >> 1;
-			mips->mip[mip].height = mips->mip[mip-1].height >> 1;
-			mips->mip[mip].depth = 1;
-			if (mips->mip[mip].width < 1 && mips->mip[mip].height < 1)
-				break;
-			if (mips->mip[mip].width < 1)
-				mips->mip[mip].width = 1;
-			if (mips->mip[mip].height < 1)
-				mips->mip[mip].height = 1;
-			mips->mip[mip].datasize = mips->mip[mip].width * mips->mip[mip].height * 2;
-			mips->mip[mip].data = BZ_Malloc(mips->mip[mip].datasize);
-			mips->mip[mip].needfree = true;
-
-			Image_MipMap2X8(mips->mip[mip-1].data, mips->mip[mip-1].width, mips->mip[mip-1].height, mips->mip[mip].data, mips->mip[mip].width, mips->mip[mip].height);
-			mips->mipcount = mip+1;
-		}
-		return;
+		mipfunc = Image_MipMap2X8;
+		pixelsize = 2;
+		break;
 	case PTI_RGBA32F:
-		for (mip = mips->mipcount; mip < countof(mips->mip); mip++)
-		{
-			mips->mip[mip].width = mips->mip[mip-1].width >> 1;
-			mips->mip[mip].height = mips->mip[mip-1].height >> 1;
-			mips->mip[mip].depth = 1;
-			if (mips->mip[mip].width < 1 && mips->mip[mip].height < 1)
-				break;
-			if (mips->mip[mip].width < 1)
-				mips->mip[mip].width = 1;
-			if (mips->mip[mip].height < 1)
-				mips->mip[mip].height = 1;
-			mips->mip[mip].datasize = mips->mip[mip].width * mips->mip[mip].height * sizeof(float)*4;
-			mips->mip[mip].data = BZ_Malloc(mips->mip[mip].datasize);
-			mips->mip[mip].needfree = true;
-
-			Image_MipMap4X32F(mips->mip[mip-1].data, mips->mip[mip-1].width, mips->mip[mip-1].height, mips->mip[mip].data, mips->mip[mip].width, mips->mip[mip].height);
-			mips->mipcount = mip+1;
-		}
+		mipfunc = MIPMAP_SIMD(Image_MipMap4X32F);
+		pixelsize = sizeof(float)*4;
 		break;
 	case PTI_RGBA16F:
-		for (mip = mips->mipcount; mip < countof(mips->mip); mip++)
-		{
-			mips->mip[mip].width = mips->mip[mip-1].width >> 1;
-			mips->mip[mip].height = mips->mip[mip-1].height >> 1;
-			mips->mip[mip].depth = 1;
-			if (mips->mip[mip].width < 1 && mips->mip[mip].height < 1)
-				break;
-			if (mips->mip[mip].width < 1)
-				mips->mip[mip].width = 1;
-			if (mips->mip[mip].height < 1)
-				mips->mip[mip].height = 1;
-			mips->mip[mip].datasize = mips->mip[mip].width * mips->mip[mip].height * sizeof(unsigned short)*4;
-			mips->mip[mip].data = BZ_Malloc(mips->mip[mip].datasize);
-			mips->mip[mip].needfree = true;
-
-			Image_MipMap4X16F(mips->mip[mip-1].data, mips->mip[mip-1].width, mips->mip[mip-1].height, mips->mip[mip].data, mips->mip[mip].width, mips->mip[mip].height);
-			mips->mipcount = mip+1;
-		}
+		mipfunc = MIPMAP_SIMD(Image_MipMap4X16F);
+		pixelsize = sizeof(unsigned short)*4;
 		break;
 	case PTI_RGBA16:
-		for (mip = mips->mipcount; mip < countof(mips->mip); mip++)
-		{
-			mips->mip[mip].width = mips->mip[mip-1].width >> 1;
-			mips->mip[mip].height = mips->mip[mip-1].height >> 1;
-			mips->mip[mip].depth = 1;
-			if (mips->mip[mip].width < 1 && mips->mip[mip].height < 1)
-				break;
-			if (mips->mip[mip].width < 1)
-				mips->mip[mip].width = 1;
-			if (mips->mip[mip].height < 1)
-				mips->mip[mip].height = 1;
-			mips->mip[mip].datasize = mips->mip[mip].width * mips->mip[mip].height * sizeof(unsigned short)*4;
-			mips->mip[mip].data = BZ_Malloc(mips->mip[mip].datasize);
-			mips->mip[mip].needfree = true;
-
-			Image_MipMap4X16(mips->mip[mip-1].data, mips->mip[mip-1].width, mips->mip[mip-1].height, mips->mip[mip].data, mips->mip[mip].width, mips->mip[mip].height);
-			mips->mipcount = mip+1;
-		}
+		mipfunc = Image_MipMap4X16;
+		pixelsize = sizeof(unsigned short)*4;
 		break;
 	case PTI_RGB8_SRGB:
 	case PTI_BGR8_SRGB:
+		mipfunc = Image_MipMap3X8SRGB;
+		pixelsize = sizeof(qbyte)*3;
+		break;
 	case PTI_RGB8:
 	case PTI_BGR8:
-		for (mip = mips->mipcount; mip < countof(mips->mip); mip++)
-		{
-			mips->mip[mip].width = mips->mip[mip-1].width >> 1;
-			mips->mip[mip].height = mips->mip[mip-1].height >> 1;
-			mips->mip[mip].depth = 1;
-			if (mips->mip[mip].width < 1 && mips->mip[mip].height < 1)
-				break;
-			if (mips->mip[mip].width < 1)
-				mips->mip[mip].width = 1;
-			if (mips->mip[mip].height < 1)
-				mips->mip[mip].height = 1;
-			mips->mip[mip].datasize = mips->mip[mip].width * mips->mip[mip].height * sizeof(qbyte)*3;
-			mips->mip[mip].data = BZ_Malloc(mips->mip[mip].datasize);
-			mips->mip[mip].needfree = true;
-
-			Image_MipMap3X8(mips->mip[mip-1].data, mips->mip[mip-1].width, mips->mip[mip-1].height, mips->mip[mip].data, mips->mip[mip].width, mips->mip[mip].height);
-			mips->mipcount = mip+1;
-		}
+		mipfunc = Image_MipMap3X8;
+		pixelsize = sizeof(qbyte)*3;
 		break;
 	case PTI_RGBA8_SRGB:
 	case PTI_RGBX8_SRGB:
 	case PTI_BGRA8_SRGB:
 	case PTI_BGRX8_SRGB:
+		mipfunc = Image_MipMap4X8SRGB;	//table lookups, simd doesn't help (even avx2's gathers are slower).
+		pixelsize = sizeof(qbyte)*4;
+		break;
 	case PTI_RGBA8:
 	case PTI_RGBX8:
 	case PTI_BGRA8:
 	case PTI_BGRX8:
-		for (mip = mips->mipcount; mip < countof(mips->mip); mip++)
-		{
-			mips->mip[mip].width = mips->mip[mip-1].width >> 1;
-			mips->mip[mip].height = mips->mip[mip-1].height >> 1;
-			mips->mip[mip].depth = 1;
-			if (mips->mip[mip].width < 1 && mips->mip[mip].height < 1)
-				break;
-			if (mips->mip[mip].width < 1)
-				mips->mip[mip].width = 1;
-			if (mips->mip[mip].height < 1)
-				mips->mip[mip].height = 1;
-			mips->mip[mip].datasize = mips->mip[mip].width * mips->mip[mip].height * sizeof(qbyte)*4;
-			mips->mip[mip].data = BZ_Malloc(mips->mip[mip].datasize);
-			mips->mip[mip].needfree = true;
-
-			Image_MipMap4X8(mips->mip[mip-1].data, mips->mip[mip-1].width, mips->mip[mip-1].height, mips->mip[mip].data, mips->mip[mip].width, mips->mip[mip].height);
-			mips->mipcount = mip+1;
-		}
+		mipfunc = MIPMAP_SIMD(Image_MipMap4X8);
+		pixelsize = sizeof(qbyte)*4;
 		break;
 	case PTI_RGBA4444:
 	case PTI_RGB565:
@@ -8184,6 +8520,51 @@ void Image_GenerateMips(struct pendingtextureinfo *mips, unsigned int flags)
 	default:
 		return;	//not supported.
 	}
+
+	for (mip = mips->mipcount; mip < countof(mips->mip); mip++)
+	{
+		mips->mip[mip].width = mips->mip[mip-1].width >> 1;
+		mips->mip[mip].height = mips->mip[mip-1].height >> 1;
+		mips->mip[mip].depth = 1;
+		if (mips->mip[mip].width < 1 && mips->mip[mip].height < 1)
+			break;
+		if (mips->mip[mip].width < 1)
+			mips->mip[mip].width = 1;
+		if (mips->mip[mip].height < 1)
+			mips->mip[mip].height = 1;
+		mips->mip[mip].datasize = mips->mip[mip].width * mips->mip[mip].height * pixelsize;
+		mips->mip[mip].data = BZ_Malloc(mips->mip[mip].datasize);
+		mips->mip[mip].needfree = true;
+
+		//each level depends upon the previous, so only the rows within a level can be done in parallel.
+		ms.func = mipfunc;
+		ms.in = mips->mip[mip-1].data;
+		ms.out = mips->mip[mip].data;
+		ms.inwidth = mips->mip[mip-1].width;
+		ms.inheight = mips->mip[mip-1].height;
+		ms.outwidth = mips->mip[mip].width;
+		ms.instride = ms.inwidth*pixelsize*2;
+		ms.outstride = ms.outwidth*pixelsize;
+		Image_Strips(Image_MipMapRows, &ms, mips->mip[mip].height, IMAGESTRIP_PIXELS/ms.outwidth);
+		mips->mipcount = mip+1;
+	}
+}
+
+void Image_GenerateMips(struct pendingtextureinfo *mips, unsigned int flags)
+{
+	if (mips->type == PTI_3D)
+		return;	//3d mipmaps are more complicated to compute.
+
+	if (flags & IF_NOMIPMAP)
+		return;
+
+	if (sh_config.can_genmips && mips->encoding != PTI_P8)
+		return;
+
+	if (mips->mip[0].depth != 1)
+		return;	//blurgh. we can't deal with layers.
+
+	Image_GenerateMipChain(mips);
 }
 
 //stolen from DP
@@ -8221,110 +8602,206 @@ static void Image_Resample32LerpLine (const qbyte *in, qbyte *out, int inwidth,
 
 //yes, this is lordhavok's code too.
 //superblur away!
-//FIXME: optionally support borders as 0,0,0,0
 #define LERPBYTE(i) r = row1[i];out[i] = (qbyte) ((((row2[i] - r) * lerp) >> 16) + r)
-static void Image_Resample32Lerp(const void *indata, int inwidth, int inheight, void *outdata, int outwidth, int outheight)
+static void Image_Resample32LerpBlend (qbyte *out, const qbyte *row1, const qbyte *row2, int outwidth, int lerp)
+{
+	int j, r;
+	j = outwidth - 4;
+	while(j >= 0)
+	{
+		LERPBYTE( 0);
+		LERPBYTE( 1);
+		LERPBYTE( 2);
+		LERPBYTE( 3);
+		LERPBYTE( 4);
+		LERPBYTE( 5);
+		LERPBYTE( 6);
+		LERPBYTE( 7);
+		LERPBYTE( 8);
+		LERPBYTE( 9);
+		LERPBYTE(10);
+		LERPBYTE(11);
+		LERPBYTE(12);
+		LERPBYTE(13);
+		LERPBYTE(14);
+		LERPBYTE(15);
+		out += 16;
+		row1 += 16;
+		row2 += 16;
+		j -= 4;
+	}
+	if (j & 2)
+	{
+		LERPBYTE( 0);
+		LERPBYTE( 1);
+		LERPBYTE( 2);
+		LERPBYTE( 3);
+		LERPBYTE( 4);
+		LERPBYTE( 5);
+		LERPBYTE( 6);
+		LERPBYTE( 7);
+		out += 8;
+		row1 += 8;
+		row2 += 8;
+	}
+	if (j & 1)
+	{
+		LERPBYTE( 0);
+		LERPBYTE( 1);
+		LERPBYTE( 2);
+		LERPBYTE( 3);
+	}
+}
+#undef LERPBYTE
+
+#ifdef MIPMAP_SSE2
+//(d*lerp)>>16 for a signed 16bit d and an unsigned 16bit lerp. mulhi is signed-only, so lerps above 32767 come out as lerp-65536, which is fixed by adding d back on.
+fte_inlinestatic __m128i SSE2_LerpDelta(__m128i d, __m128i lerp)
+{
+	return _mm_add_epi16(_mm_mulhi_epi16(d, lerp), _mm_and_si128(d, _mm_srai_epi16(lerp, 15)));
+}
+static void Image_Resample32LerpLine_SSE2 (const qbyte *in, qbyte *out, int inwidth, int outwidth)
+{
+	int		j, f, fstep, endx, l0, l1;
+	const qbyte *px;
+	const __m128i zero = _mm_setzero_si128();
+	__m128i p, a, b;
+	fstep = (int) (inwidth*65536.0f/outwidth);
+	endx = (inwidth-1);
+	//two output pixels at a time, for as long as both of them have a pixel to lerp to.
+	for (j = 0,f = 0;j+2 <= outwidth && ((f+fstep)>>16) < endx;j+=2, f += fstep*2, out += 8)
+	{
+		p = _mm_unpacklo_epi32(_mm_loadl_epi64((const __m128i*)(in + (f>>16)*4)), _mm_loadl_epi64((const __m128i*)(in + ((f+fstep)>>16)*4)));
+		a = _mm_unpacklo_epi8(p, zero);
+		b = _mm_unpackhi_epi8(p, zero);
+		l0 = (short)(f&0xffff);
+		l1 = (short)((f+fstep)&0xffff);
+		a = _mm_add_epi16(a, SSE2_LerpDelta(_mm_sub_epi16(b, a), _mm_setr_epi16(l0,l0,l0,l0, l1,l1,l1,l1)));
+		_mm_storel_epi64((__m128i*)out, _mm_packus_epi16(a, a));
+	}
+	//finish off the right edge a pixel at a time
+	for (;j < outwidth;j++, f += fstep, out += 4)
+	{
+		px = in + (f>>16)*4;
+		if ((f>>16) < endx)
+		{
+			l0 = f & 0xFFFF;
+			out[0] = (qbyte) ((((px[4] - px[0]) * l0) >> 16) + px[0]);
+			out[1] = (qbyte) ((((px[5] - px[1]) * l0) >> 16) + px[1]);
+			out[2] = (qbyte) ((((px[6] - px[2]) * l0) >> 16) + px[2]);
+			out[3] = (qbyte) ((((px[7] - px[3]) * l0) >> 16) + px[3]);
+		}
+		else // last pixel of the line has no pixel to lerp to
+			memcpy(out, px, 4);
+	}
+}
+static void Image_Resample32LerpBlend_SSE2 (qbyte *out, const qbyte *row1, const qbyte *row2, int outwidth, int lerp)
 {
-	int i, j, r, yi, oldy, f, fstep, lerp, endy = (inheight-1), inwidth4 = inwidth*4, outwidth4 = outwidth*4;
+	int j, bytes = outwidth*4;
+	const __m128i zero = _mm_setzero_si128(), l = _mm_set1_epi16((short)lerp);
+	__m128i a, b, lo, hi;
+	for (j = 0; j+16 <= bytes; j += 16)
+	{
+		a = _mm_loadu_si128((const __m128i*)(row1+j));
+		b = _mm_loadu_si128((const __m128i*)(row2+j));
+		lo = _mm_unpacklo_epi8(a, zero);
+		hi = _mm_unpackhi_epi8(a, zero);
+		lo = _mm_add_epi16(lo, SSE2_LerpDelta(_mm_sub_epi16(_mm_unpacklo_epi8(b, zero), lo), l));
+		hi = _mm_add_epi16(hi, SSE2_LerpDelta(_mm_sub_epi16(_mm_unpackhi_epi8(b, zero), hi), l));
+		_mm_storeu_si128((__m128i*)(out+j), _mm_packus_epi16(lo, hi));
+	}
+	if (j < bytes)
+		Image_Resample32LerpBlend(out+j, row1+j, row2+j, (bytes-j)/4, lerp);
+}
+#endif
+
+typedef struct
+{
+	const qbyte *in;
+	int inwidth, inheight;
+	qbyte *out;
+	int outwidth, outheight;
+	void (*line) (const qbyte *in, qbyte *out, int inwidth, int outwidth);
+	void (*blend) (qbyte *out, const qbyte *row1, const qbyte *row2, int outwidth, int lerp);
+} resample32_t;
+static void Image_Resample32LerpRows(void *ctx, unsigned int row, unsigned int endrow)
+{
+	resample32_t *rs = ctx;
+	int i, yi, oldy, f, fstep, endy = (rs->inheight-1), inwidth4 = rs->inwidth*4, outwidth4 = rs->outwidth*4;
 	qbyte *out;
-	const qbyte *inrow;
-	qbyte *row1, *row2;
+	qbyte *row1, *row2, *t;
 
-	row1 = alloca(2*(outwidth*4));
-	row2 = row1 + (outwidth * 4);
+	row1 = alloca(2*(outwidth4));
+	row2 = row1 + outwidth4;
 
-	out = outdata;
-	fstep = (int) (inheight*65536.0f/outheight);
+	out = rs->out + row*outwidth4;
+	fstep = (int) (rs->inheight*65536.0f/rs->outheight);
 
-	inrow = indata;
-	oldy = 0;
-	Image_Resample32LerpLine (inrow, row1, inwidth, outwidth);
-	Image_Resample32LerpLine (inrow + inwidth4, row2, inwidth, outwidth);
-	for (i = 0, f = 0;i < outheight;i++,f += fstep)
+	oldy = -2;	//nothing loaded yet.
+	for (i = row, f = row*fstep;i < endrow;i++,f += fstep, out += outwidth4)
 	{
 		yi = f >> 16;
 		if (yi < endy)
 		{
-			lerp = f & 0xFFFF;
 			if (yi != oldy)
 			{
-				inrow = (const qbyte *)indata + inwidth4*yi;
 				if (yi == oldy+1)
-					memcpy(row1, row2, outwidth4);
+				{	//reuse the previous second row
+					t = row1;
+					row1 = row2;
+					row2 = t;
+				}
 				else
-					Image_Resample32LerpLine (inrow, row1, inwidth, outwidth);
-				Image_Resample32LerpLine (inrow + inwidth4, row2, inwidth, outwidth);
+					rs->line (rs->in + inwidth4*yi, row1, rs->inwidth, rs->outwidth);
+				rs->line (rs->in + inwidth4*(yi+1), row2, rs->inwidth, rs->outwidth);
 				oldy = yi;
 			}
-			j = outwidth - 4;
-			while(j >= 0)
-			{
-				LERPBYTE( 0);
-				LERPBYTE( 1);
-				LERPBYTE( 2);
-				LERPBYTE( 3);
-				LERPBYTE( 4);
-				LERPBYTE( 5);
-				LERPBYTE( 6);
-				LERPBYTE( 7);
-				LERPBYTE( 8);
-				LERPBYTE( 9);
-				LERPBYTE(10);
-				LERPBYTE(11);
-				LERPBYTE(12);
-				LERPBYTE(13);
-				LERPBYTE(14);
-				LERPBYTE(15);
-				out += 16;
-				row1 += 16;
-				row2 += 16;
-				j -= 4;
-			}
-			if (j & 2)
-			{
-				LERPBYTE( 0);
-				LERPBYTE( 1);
-				LERPBYTE( 2);
-				LERPBYTE( 3);
-				LERPBYTE( 4);
-				LERPBYTE( 5);
-				LERPBYTE( 6);
-				LERPBYTE( 7);
-				out += 8;
-				row1 += 8;
-				row2 += 8;
-			}
-			if (j & 1)
-			{
-				LERPBYTE( 0);
-				LERPBYTE( 1);
-				LERPBYTE( 2);
-				LERPBYTE( 3);
-				out += 4;
-				row1 += 4;
-				row2 += 4;
-			}
-			row1 -= outwidth4;
-			row2 -= outwidth4;
+			rs->blend(out, row1, row2, rs->outwidth, f & 0xFFFF);
 		}
 		else
 		{
 			yi = endy;	//don't read off the end
 			if (yi != oldy)
 			{
-				inrow = (const qbyte *)indata + inwidth4*yi;
 				if (yi == oldy+1)
-					memcpy(row1, row2, outwidth4);
+				{
+					t = row1;
+					row1 = row2;
+					row2 = t;
+				}
 				else
-					Image_Resample32LerpLine (inrow, row1, inwidth, outwidth);
+					rs->line (rs->in + inwidth4*yi, row1, rs->inwidth, rs->outwidth);
 				oldy = yi;
 			}
 			memcpy(out, row1, outwidth4);
-			out += outwidth4;	//Fixes a bug from DP.
 		}
 	}
 }
-
+//FIXME: optionally support borders as 0,0,0,0
+static void Image_Resample32Lerp(const void *indata, int inwidth, int inheight, void *outdata, int outwidth, int outheight)
+{
+	resample32_t rs;
+	rs.in = indata;
+	rs.inwidth = inwidth;
+	rs.inheight = inheight;
+	rs.out = outdata;
+	rs.outwidth = outwidth;
+	rs.outheight = outheight;
+#ifdef MIPMAP_SSE2
+	if (!image_bench.scalar)
+	{
+		rs.line = Image_Resample32LerpLine_SSE2;
+		rs.blend = Image_Resample32LerpBlend_SSE2;
+	}
+	else
+#endif
+	{
+		rs.line = Image_Resample32LerpLine;
+		rs.blend = Image_Resample32LerpBlend;
+	}
+	//each strip has to load its own starting rows, so don't make them too small.
+	Image_Strips(Image_Resample32LerpRows, &rs, outheight, IMAGESTRIP_PIXELS/outwidth);
+}
 
 /*
 ================
@@ -9559,10 +10036,16 @@ typedef union
 #define etc_expandv(p,x,y,z) p.v[0]|=p.v[0]>>(x),p.v[1]|=p.v[1]>>(y),p.v[2]|=p.v[2]>>(z)
 #ifdef DECOMPRESS_ETC2
 //FIXME: this is littleendian only...
-static void Image_Decode_ETC2_Block_TH_Internal(qbyte *fte_restrict in, pixel32_t *fte_restrict out, int w, pixel32_t base1, pixel32_t base2, int d, qboolean tmode)
+//etc's palettes are indexed by msb*2+lsb, where the msbs are the bits in in[4-5] and the lsbs are in in[6-7] (column-major).
+enum
+{
+	ETC_MODE_SUBBLOCKS,	//two palettes, split either horizontally or vertically according to the flip bit
+	ETC_MODE_TH,		//one palette for the whole block
+	ETC_MODE_PLANAR		//no palette, pal[0-2] are the origin/horizontal/vertical colours instead
+};
+static void Image_Decode_ETC2_TH_Palette(pixel32_t *fte_restrict painttable, pixel32_t base1, pixel32_t base2, int d, qboolean tmode)
 {
-	pixel32_t painttable[4];
-	int dtab[] = {3,6,11,16,23,32,41,64};	//writing that felt like giving out lottery numbers.
+	static const int dtab[] = {3,6,11,16,23,32,41,64};	//writing that felt like giving out lottery numbers.
 #define etc_addclamptopixel(r,p,d) r.v[0]=bound(0,p.v[0]+d, 255),r.v[1]=bound(0,p.v[1]+d, 255),r.v[2]=bound(0,p.v[2]+d, 255),r.v[3]=0xff
 	d = dtab[d];
 	if (tmode)
@@ -9579,44 +10062,26 @@ static void Image_Decode_ETC2_Block_TH_Internal(qbyte *fte_restrict in, pixel32_
 		etc_addclamptopixel(painttable[2], base2, d);
 		etc_addclamptopixel(painttable[3], base2, -d);
 	}
-#undef etc_addclamptoint
-	//yay, we have our painttable. now use it. also, screw that msb/lsb split.
-
-#define etc2_th_pix(r,i)								\
-	if (in[5-(i/8)]&(1<<(i&7))) {						\
-		if (in[7-(i/8)]&(1<<(i&7)))	r.u = painttable[3].u;	\
-		else						r.u = painttable[2].u;	\
-	} else {											\
-		if (in[7-(i/8)]&(1<<(i&7)))	r.u = painttable[1].u;	\
-		else						r.u = painttable[0].u;	\
-	}
-
-	etc2_th_pix(out[0], 0);
-	etc2_th_pix(out[1], 4);
-	etc2_th_pix(out[2], 8);
-	etc2_th_pix(out[3], 12);
-	out += w;
-	etc2_th_pix(out[0], 1);
-	etc2_th_pix(out[1], 5);
-	etc2_th_pix(out[2], 9);
-	etc2_th_pix(out[3], 13);
-	out += w;
-	etc2_th_pix(out[0], 2);
-	etc2_th_pix(out[1], 6);
-	etc2_th_pix(out[2], 10);
-	etc2_th_pix(out[3], 14);
-	out += w;
-	etc2_th_pix(out[0], 3);
-	etc2_th_pix(out[1], 7);
-	etc2_th_pix(out[2], 11);
-	etc2_th_pix(out[3], 15);
-#undef etc2_th_pix
 }
-static void Image_Decode_ETC2_Block_Internal(qbyte *fte_restrict in, pixel32_t *fte_restrict out0, int w, int alphamode)
+static void Image_Decode_ETC1_Palette(pixel32_t *fte_restrict pal, pixel32_t base, const qbyte *cw, qboolean opaque)
+{
+	if (opaque)
+		etc_addclamptopixel(pal[0], base, cw[0]);
+	else	//punchthrough alpha mode
+		etc_addclamptopixel(pal[0], base, 0);
+	etc_addclamptopixel(pal[1], base, cw[1]);
+	if (opaque)
+		etc_addclamptopixel(pal[2], base, -cw[0]);
+	else
+		pal[2].u = 0;
+	etc_addclamptopixel(pal[3], base, -cw[1]);
+}
+#undef etc_addclamptopixel
+static int Image_Decode_ETC2_Palette(qbyte *fte_restrict in, pixel32_t *fte_restrict pal, int alphamode)
 {
 	//the overflow modes are only valid with ETC2.
 	//alphamode=1 is used for punchthrough-alpha (which also forces the diff mode)
-	static const char tab[8][2] =
+	static const qbyte tab[8][2] =
 	{
 		{2,8},
 		{5,17},
@@ -9629,9 +10094,7 @@ static void Image_Decode_ETC2_Block_Internal(qbyte *fte_restrict in, pixel32_t *
 	};
 	int tv;
 	pixel32_t base1, base2, base3;
-	const char *cw1, *cw2;
 	unsigned char R1,G1,B1;
-	pixel32_t *out1, *out2, *out3;
 
 	qboolean opaque;
 
@@ -9654,8 +10117,8 @@ static void Image_Decode_ETC2_Block_Internal(qbyte *fte_restrict in, pixel32_t *
 			tv = ((in[3]&0x0c)>>1)|(in[3]&0x01);
 			etc_expandv(base1,4,4,4);
 			etc_expandv(base2,4,4,4);
-			Image_Decode_ETC2_Block_TH_Internal(in, out0, w, base1, base2, tv, true);
-			return;
+			Image_Decode_ETC2_TH_Palette(pal, base1, base2, tv, true);
+			return ETC_MODE_TH;
 		}
 		G1 += (char)((in[1]&3)|((in[1]&4)*0x3f));	//48+3
 		if (G1&~0x1f) //G2 overflow = H mode
@@ -9665,8 +10128,8 @@ static void Image_Decode_ETC2_Block_Internal(qbyte *fte_restrict in, pixel32_t *
 			tv = ((in[3]&0x04)>>1)|(in[3]&0x01);
 			etc_expandv(base1,4,4,4);
 			etc_expandv(base2,4,4,4);
-			Image_Decode_ETC2_Block_TH_Internal(in, out0, w, base1, base2, tv, false);
-			return;
+			Image_Decode_ETC2_TH_Palette(pal, base1, base2, tv, false);
+			return ETC_MODE_TH;
 		}
 		B1 += (char)((in[2]&3)|((in[2]&4)*0x3f));	//40+3
 		if (B1&~0x1f) //B2 overflow = Planar mode
@@ -9677,21 +10140,10 @@ static void Image_Decode_ETC2_Block_Internal(qbyte *fte_restrict in, pixel32_t *
 			etc_expandv(base1,6,7,6);
 			etc_expandv(base2,6,7,6);
 			etc_expandv(base3,6,7,6);
-#define etc2_planar2(r,x,y)				\
-	r[x].v[0] =	bound(0,(4*base1.v[0] + x*((short)base2.v[0]-base1.v[0]) + y*((short)base3.v[0]-base1.v[0]) + 2)>>2,0xff),	\
-	r[x].v[1] = bound(0,(4*base1.v[1] + x*((short)base2.v[1]-base1.v[1]) + y*((short)base3.v[1]-base1.v[1]) + 2)>>2,0xff),	\
-	r[x].v[2] = bound(0,(4*base1.v[2] + x*((short)base2.v[2]-base1.v[2]) + y*((short)base3.v[2]-base1.v[2]) + 2)>>2,0xff),	\
-	r[x].v[3] = 0xff
-#define etc2_planar(r,y)				\
-					etc2_planar2(r,0,y);		\
-					etc2_planar2(r,1,y);		\
-					etc2_planar2(r,2,y);		\
-					etc2_planar2(r,3,y);
-			etc2_planar(out0,0);out0 += w;
-			etc2_planar(out0,1);out0 += w;
-			etc2_planar(out0,2);out0 += w;
-			etc2_planar(out0,3);
-			return;
+			pal[0] = base1;
+			pal[1] = base2;
+			pal[2] = base3;
+			return ETC_MODE_PLANAR;
 		}
 		//they should still be 5 bits.
 		VectorSet(base2.v, (R1<<3)+(R1>>2), (G1<<3)+(G1>>2), (B1<<3)+(B1>>2));
@@ -9706,92 +10158,91 @@ static void Image_Decode_ETC2_Block_Internal(qbyte *fte_restrict in, pixel32_t *
 						 ((in[2]>>0)&15)*0x11);	/*40+4*/
 	}
 
-	cw1 = tab[(in[3]>>5)&7];	//37+3
-	cw2 = tab[(in[3]>>2)&7];	//34+3
-
-	out1 = out0+w*1;
-	out2 = out0+w*2;
-	out3 = out0+w*3;
-
-#define etc1_pix(r, base,cw,i)	\
-	if (in[7-(i/8)]&(1<<(i&7)))						\
-		tv = (in[5-(i/8)]&(1<<(i&7)))?-cw[1]:cw[1];	\
-	else if (opaque)								\
-		tv = (in[5-(i/8)]&(1<<(i&7)))?-cw[0]:cw[0];	\
-	else /*punchthrough alpha mode*/				\
-		tv = (in[5-(i/8)]&(1<<(i&7)))?-255:0;		\
-	if (tv==-255)									\
-		r.u = 0;									\
-	else											\
-		r.v[0] = bound(0,base.v[0]+tv,0xff),			\
-		r.v[1] = bound(0,base.v[1]+tv,0xff),			\
-		r.v[2] = bound(0,base.v[2]+tv,0xff),			\
-		r.v[3] = 0xff
-
-	etc1_pix(out0[0], base1,cw1,0);
-	etc1_pix(out0[1], base1,cw1,4);
-	etc1_pix(out1[0], base1,cw1,1);
-	etc1_pix(out1[1], base1,cw1,5);
-
-	etc1_pix(out2[2], base2,cw2,10);
-	etc1_pix(out2[3], base2,cw2,14);
-	etc1_pix(out3[2], base2,cw2,11);
-	etc1_pix(out3[3], base2,cw2,15);
-	if (in[3]&1)	//flipbit bit 32 - blocks are vertical
-	{
-		etc1_pix(out0[2], base1,cw1,8);
-		etc1_pix(out0[3], base1,cw1,12);
-		etc1_pix(out1[2], base1,cw1,9);
-		etc1_pix(out1[3], base1,cw1,13);
-
-		etc1_pix(out2[0], base2,cw2,2);
-		etc1_pix(out2[1], base2,cw2,6);
-		etc1_pix(out3[0], base2,cw2,3);
-		etc1_pix(out3[1], base2,cw2,7);
-	}
-	else
-	{
-		etc1_pix(out0[2], base2,cw2,8);
-		etc1_pix(out0[3], base2,cw2,12);
-		etc1_pix(out1[2], base2,cw2,9);
-		etc1_pix(out1[3], base2,cw2,13);
+	Image_Decode_ETC1_Palette(pal+0, base1, tab[(in[3]>>5)&7], opaque);	//37+3
+	Image_Decode_ETC1_Palette(pal+4, base2, tab[(in[3]>>2)&7], opaque);	//34+3
+	return ETC_MODE_SUBBLOCKS;
+}
+static void Image_Decode_ETC2_Block_Internal(qbyte *fte_restrict in, pixel32_t *fte_restrict out, int w, int alphamode)
+{
+	pixel32_t pal[8];
+	unsigned int msbs = in[5]|(in[4]<<8), lsbs = in[7]|(in[6]<<8);
+	int x, y, i, sub;
+	int mode = Image_Decode_ETC2_Palette(in, pal, alphamode);
 
-		etc1_pix(out2[0], base1,cw1,2);
-		etc1_pix(out2[1], base1,cw1,6);
-		etc1_pix(out3[0], base1,cw1,3);
-		etc1_pix(out3[1], base1,cw1,7);
+	if (mode == ETC_MODE_PLANAR)
+	{
+#define etc2_planar2(r,x,y)				\
+	r[x].v[0] =	bound(0,(4*pal[0].v[0] + x*((short)pal[1].v[0]-pal[0].v[0]) + y*((short)pal[2].v[0]-pal[0].v[0]) + 2)>>2,0xff),	\
+	r[x].v[1] = bound(0,(4*pal[0].v[1] + x*((short)pal[1].v[1]-pal[0].v[1]) + y*((short)pal[2].v[1]-pal[0].v[1]) + 2)>>2,0xff),	\
+	r[x].v[2] = bound(0,(4*pal[0].v[2] + x*((short)pal[1].v[2]-pal[0].v[2]) + y*((short)pal[2].v[2]-pal[0].v[2]) + 2)>>2,0xff),	\
+	r[x].v[3] = 0xff
+#define etc2_planar(r,y)				\
+					etc2_planar2(r,0,y);		\
+					etc2_planar2(r,1,y);		\
+					etc2_planar2(r,2,y);		\
+					etc2_planar2(r,3,y);
+		etc2_planar(out,0);out += w;
+		etc2_planar(out,1);out += w;
+		etc2_planar(out,2);out += w;
+		etc2_planar(out,3);
+#undef etc2_planar
+#undef etc2_planar2
+		return;
 	}
-#undef etc1_pix
+
+	for (y = 0; y < 4; y++, out += w)
+	{
+		for (x = 0; x < 4; x++)
+		{
+			i = x*4+y;
+			if (mode == ETC_MODE_TH)
+				sub = 0;
+			else if (in[3]&1)	//flipbit bit 32 - subblocks are top+bottom
+				sub = (y>=2)*4;
+			else
+				sub = (x>=2)*4;
+			out[x] = pal[sub + ((msbs>>i)&1)*2 + ((lsbs>>i)&1)];
+		}
+	}
+}
+static const signed char eac_modifiers[16][8] =
+{
+	{-3,-6, -9,-15,2,5,8,14},
+	{-3,-7,-10,-13,2,6,9,12},
+	{-2,-5, -8,-13,1,4,7,12},
+	{-2,-4, -6,-13,1,3,5,12},
+	{-3,-6, -8,-12,2,5,7,11},
+	{-3,-7, -9,-11,2,6,8,10},
+	{-4,-7, -8,-11,3,6,7,10},
+	{-3,-5, -8,-11,2,4,7,10},
+	{-2,-6, -8,-10,1,5,7,9},
+	{-3,-5, -8,-10,1,4,7,9},
+	{-2,-4, -8,-10,1,3,7,9},
+	{-2,-5, -7,-10,1,4,6,9},
+	{-3,-4, -7,-10,2,3,6,9},
+	{-1,-2, -3,-10,0,1,2,9},
+	{-4,-6, -8, -9,3,5,7,8},
+	{-3,-5, -7, -9,2,4,6,8},
+};
+//the 8-entry alpha/r11 table for an eac block.
+static void Image_Decode_EAC8U_Palette(qbyte *fte_restrict in, qbyte *fte_restrict pal)
+{
+	const qbyte base = in[0];
+	const qbyte mul = in[1]>>4;
+	const signed char *tab = eac_modifiers[in[1]&0xf];
+	int i;
+	for (i = 0; i < 8; i++)
+		pal[i] = bound(0, base + tab[i] * mul, 255);
 }
 static void Image_Decode_EAC8U_Block_Internal(qbyte *fte_restrict in, qbyte *fte_restrict out, int stride, qboolean goestoeleven)
 {
-	static const char tabs[16][8] =
-	{
-		{-3,-6, -9,-15,2,5,8,14},
-		{-3,-7,-10,-13,2,6,9,12},
-		{-2,-5, -8,-13,1,4,7,12},
-		{-2,-4, -6,-13,1,3,5,12},
-		{-3,-6, -8,-12,2,5,7,11},
-		{-3,-7, -9,-11,2,6,8,10},
-		{-4,-7, -8,-11,3,6,7,10},
-		{-3,-5, -8,-11,2,4,7,10},
-		{-2,-6, -8,-10,1,5,7,9},
-		{-3,-5, -8,-10,1,4,7,9},
-		{-2,-4, -8,-10,1,3,7,9},
-		{-2,-5, -7,-10,1,4,6,9},
-		{-3,-4, -7,-10,2,3,6,9},
-		{-1,-2, -3,-10,0,1,2,9},
-		{-4,-6, -8, -9,3,5,7,8},
-		{-3,-5, -7, -9,2,4,6,8},
-	};
+	qbyte pal[8];
+	const quint64_t bits = in[2] | (in[3]<<8) | (in[4]<<16) | ((quint64_t)in[5]<<24) | ((quint64_t)in[6]<<32) | ((quint64_t)in[7]<<40);
 
-	const qbyte base = in[0];
-	const qbyte mul = in[1]>>4;
-	const char *tab = tabs[in[1]&0xf];
-	const quint64_t bits = in[2] | (in[3]<<8) | (in[4]<<16) | (in[5]<<24) | ((quint64_t)in[6]<<32) | ((quint64_t)in[7]<<40);
+	Image_Decode_EAC8U_Palette(in, pal);
 
-#define EAC_Pix(r,x,y)	r = bound(0, base + tab[(bits>>((x*4+y)*3))&7] * mul, 255);
-#define EAC_Row(y)	EAC_Pix(out[0], 0,y);EAC_Pix(out[1], 1,y);EAC_Pix(out[2], 2,y);EAC_Pix(out[3], 3,y);
+#define EAC_Pix(r,x,y)	r = pal[(bits>>((x*4+y)*3))&7];
+#define EAC_Row(y)	EAC_Pix(out[0], 0,y);EAC_Pix(out[4], 1,y);EAC_Pix(out[8], 2,y);EAC_Pix(out[12], 3,y);
 	EAC_Row(0);out += stride;EAC_Row(1);out += stride;EAC_Row(2);out += stride;EAC_Row(3);
 #undef EAC_Row
 #undef EAC_Pix
@@ -9833,11 +10284,8 @@ static void Image_Decode_EAC_RG11U_Block(qbyte *fte_restrict in, pixel32_t *fte_
 #endif
 
 #ifdef DECOMPRESS_S3TC
-static void Image_Decode_S3TC_Block_Internal(qbyte *fte_restrict in, pixel32_t *fte_restrict out, int w, qbyte blackalpha)
+static void Image_Decode_S3TC_Palette(qbyte *fte_restrict in, pixel32_t *fte_restrict tab, qbyte blackalpha)
 {
-	pixel32_t tab[4];
-	unsigned int bits;
-
 	Vector4Set(tab[0].v, (in[1]&0xf8), ((in[0]&0xe0)>>3)|((in[1]&7)<<5), (in[0]&0x1f)<<3, 0xff);
 	etc_expandv(tab[0],5,6,5);
 	Vector4Set(tab[1].v, (in[3]&0xf8), ((in[2]&0xe0)>>3)|((in[3]&7)<<5), (in[2]&0x1f)<<3, 0xff);
@@ -9854,6 +10302,13 @@ static void Image_Decode_S3TC_Block_Internal(qbyte *fte_restrict in, pixel32_t *
 		BC1_Lerp(tab[0].v,1, tab[1].v,1, 2,tab[2].v);
 		Vector4Set(tab[3].v, 0, 0, 0, blackalpha);
 	}
+}
+static void Image_Decode_S3TC_Block_Internal(qbyte *fte_restrict in, pixel32_t *fte_restrict out, int w, qbyte blackalpha)
+{
+	pixel32_t tab[4];
+	unsigned int bits;
+
+	Image_Decode_S3TC_Palette(in, tab, blackalpha);
 
 	bits = in[4] | (in[5]<<8) | (in[6]<<16) | (in[7]<<24);
 
@@ -9898,94 +10353,370 @@ static void Image_Decode_BC2_Block(qbyte *fte_restrict in, pixel32_t *fte_restri
 }
 #endif
 #ifdef DECOMPRESS_RGTC
-static void Image_Decode_RGTC_Block_Internal(qbyte *fte_restrict in, qbyte *fte_restrict out, int stride, qboolean issigned)
+static void Image_Decode_RGTC_Palette(qbyte *fte_restrict in, qbyte *fte_restrict pal, qboolean issigned)
+{
+	int i;
+	union
+	{
+		qbyte u;
+		char s;
+	} tab[8];
+	tab[0].u = in[0];
+	tab[1].u = in[1];
+	if (issigned)
+	{
+		if (tab[0].s > tab[1].s)
+		{
+			tab[2].s = (tab[0].s*6 + tab[1].s*1)/7;
+			tab[3].s = (tab[0].s*5 + tab[1].s*2)/7;
+			tab[4].s = (tab[0].s*4 + tab[1].s*3)/7;
+			tab[5].s = (tab[0].s*3 + tab[1].s*4)/7;
+			tab[6].s = (tab[0].s*2 + tab[1].s*5)/7;
+			tab[7].s = (tab[0].s*1 + tab[1].s*6)/7;
+		}
+		else
+		{
+			tab[2].s = (tab[0].s*4 + tab[1].s*1)/5;
+			tab[3].s = (tab[0].s*3 + tab[1].s*2)/5;
+			tab[4].s = (tab[0].s*2 + tab[1].s*3)/5;
+			tab[5].s = (tab[0].s*1 + tab[1].s*4)/5;
+			tab[6].s = -128;
+			tab[7].s = 127;
+		}
+	}
+	else
+	{
+		if (tab[0].u > tab[1].u)
+		{
+			tab[2].u = (tab[0].u*6 + tab[1].u*1)/7;
+			tab[3].u = (tab[0].u*5 + tab[1].u*2)/7;
+			tab[4].u = (tab[0].u*4 + tab[1].u*3)/7;
+			tab[5].u = (tab[0].u*3 + tab[1].u*4)/7;
+			tab[6].u = (tab[0].u*2 + tab[1].u*5)/7;
+			tab[7].u = (tab[0].u*1 + tab[1].u*6)/7;
+		}
+		else
+		{
+			tab[2].u = (tab[0].u*4 + tab[1].u*1)/5;
+			tab[3].u = (tab[0].u*3 + tab[1].u*2)/5;
+			tab[4].u = (tab[0].u*2 + tab[1].u*3)/5;
+			tab[5].u = (tab[0].u*1 + tab[1].u*4)/5;
+			tab[6].u = 0;
+			tab[7].u = 0xff;
+		}
+	}
+	for (i = 0; i < 8; i++)
+		pal[i] = tab[i].u;
+}
+static void Image_Decode_RGTC_Block_Internal(qbyte *fte_restrict in, qbyte *fte_restrict out, int stride, qboolean issigned)
+{
+	qbyte tab[8];
+	quint64_t bits;
+
+	Image_Decode_RGTC_Palette(in, tab, issigned);
+
+	bits = in[2] | (in[3]<<8) | (in[4]<<16) | ((quint64_t)in[5]<<24) | ((quint64_t)in[6]<<32) | ((quint64_t)in[7]<<40);
+
+#define BC3AU_Pix(r,i)	r = tab[(bits>>((i)*3))&7];
+#define BC3AU_Row(i)	BC3AU_Pix(out[0], i+0);BC3AU_Pix(out[4], i+1);BC3AU_Pix(out[8], i+2);BC3AU_Pix(out[12], i+3);
+	BC3AU_Row(0);out += stride;BC3AU_Row(4);out += stride;BC3AU_Row(8);out += stride;BC3AU_Row(12);
+#undef BC3AU_Pix
+}
+#ifdef DECOMPRESS_S3TC
+//s3tc rgb channel, with an rgtc alpha channel that depends upon both encodings (really the origin of rgtc, but mneh).
+static void Image_Decode_BC3_Block(qbyte *fte_restrict in, pixel32_t *fte_restrict out, int w, uploadfmt_t fmt)
+{
+	Image_Decode_S3TC_Block_Internal(in+8, out, w, 0xff);
+	Image_Decode_RGTC_Block_Internal(in, out->v+3, w*4, false);
+}
+#endif
+static void Image_Decode_BC4_Block(qbyte *fte_restrict in, pixel32_t *fte_restrict out, int w, uploadfmt_t fmt)
+{	//BC4: BC3's alpha channel but used as red only.
+	pixel32_t r;
+	int i = 0;
+	Vector4Set(r.v, 0, 0, 0, 0xff);
+	for (i = 0; i < 4; i++)
+		out[w*0+i] = out[w*1+i] = out[w*2+i] = out[w*3+i] = r;
+	Image_Decode_RGTC_Block_Internal(in, out->v+0, w*4, fmt==PTI_BC4_R_SNORM);
+}
+static void Image_Decode_BC5_Block(qbyte *fte_restrict in, pixel32_t *fte_restrict out, int w, uploadfmt_t fmt)
+{	//BC5: two of BC3's alpha channels but used as red+green only.
+	pixel32_t r;
+	int i = 0;
+	Vector4Set(r.v, 0, 0, 0, 0xff);
+	for (i = 0; i < 4; i++)
+		out[w*0+i] = out[w*1+i] = out[w*2+i] = out[w*3+i] = r;
+	Image_Decode_RGTC_Block_Internal(in+0, out->v+0, w*4, fmt==PTI_BC5_RG_SNORM);
+	Image_Decode_RGTC_Block_Internal(in+8, out->v+1, w*4, fmt==PTI_BC5_RG_SNORM);
+}
+#endif
+
+#if defined(__SSSE3__) && (defined(DECOMPRESS_ETC2) || defined(DECOMPRESS_S3TC) || defined(DECOMPRESS_RGTC))
+//vectorised versions of the above. these formats all boil down to a small per-block palette and an index per pixel, which is a pshufb per row.
+//the palettes themselves are still built by the scalar code.
+#define DECOMPRESS_SSSE3
+#include <tmmintrin.h>
+
+//idx4 holds the 16 pixels' palette indexes*4, row-major. returns the shuffle that reads one row's rgba values out of a 4-entry palette.
+static __m128i SSSE3_PaletteRow(__m128i idx4, int row)
+{
+	__m128i m = _mm_shuffle_epi8(idx4, _mm_add_epi8(_mm_set1_epi8(row*4), _mm_setr_epi8(0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3)));
+	return _mm_or_si128(m, _mm_set1_epi32(0x03020100));
+}
+//spreads one row of 16 single-channel values to all four bytes of each pixel, mask off the channels you don't want.
+static __m128i SSSE3_ChannelRow(__m128i values, int row, unsigned int mask)
+{
+	values = _mm_shuffle_epi8(values, _mm_add_epi8(_mm_set1_epi8(row*4), _mm_setr_epi8(0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3)));
+	return _mm_and_si128(values, _mm_set1_epi32((int)mask));
+}
+static void SSSE3_StoreBlock(pixel32_t *fte_restrict out, int w, const __m128i *rows)
+{
+	_mm_storeu_si128((__m128i*)(out+w*0), rows[0]);
+	_mm_storeu_si128((__m128i*)(out+w*1), rows[1]);
+	_mm_storeu_si128((__m128i*)(out+w*2), rows[2]);
+	_mm_storeu_si128((__m128i*)(out+w*3), rows[3]);
+}
+//replaces the alpha channel of a block with the given values.
+static void SSSE3_MergeAlpha(__m128i *rows, __m128i alpha)
+{
+	int r;
+	for (r = 0; r < 4; r++)
+		rows[r] = _mm_or_si128(_mm_and_si128(rows[r], _mm_set1_epi32(0x00ffffff)), SSSE3_ChannelRow(alpha, r, 0xff000000));
+}
+
+#if defined(DECOMPRESS_RGTC) || defined(DECOMPRESS_ETC2)
+//16 3-bit indexes (as found in rgtc and eac blocks) to one byte each.
+static quint64_t SSSE3_Spread3(quint64_t x)
+{
+	x = (x & 0xfff) | ((x & 0xfff000) << 20);
+	x = (x & 0x0000003f0000003full) | ((x & 0x00000fc000000fc0ull) << 10);
+	x = (x & 0x0007000700070007ull) | ((x & 0x0038003800380038ull) << 5);
+	return x;
+}
+static __m128i SSSE3_Unpack3(const qbyte *fte_restrict in)
+{
+	quint64_t lo = in[0] | (in[1]<<8) | (in[2]<<16);
+	quint64_t hi = in[3] | (in[4]<<8) | (in[5]<<16);
+	return _mm_set_epi64x(SSSE3_Spread3(hi), SSSE3_Spread3(lo));
+}
+#endif
+
+#ifdef DECOMPRESS_ETC2
+static __m128i SSSE3_ETC2_Indexes(qbyte *fte_restrict in)
+{	//etc's index bits are column-major, with the msbs and lsbs in separate words. test the right bit for each (row-major) pixel.
+	const __m128i bytesel = _mm_setr_epi8(0,0,1,1, 0,0,1,1, 0,0,1,1, 0,0,1,1);
+	const __m128i bitsel = _mm_setr_epi8(1,16,1,16, 2,32,2,32, 4,64,4,64, 8,-128,8,-128);
+	__m128i msbs = _mm_shuffle_epi8(_mm_cvtsi32_si128(in[5]|(in[4]<<8)), bytesel);
+	__m128i lsbs = _mm_shuffle_epi8(_mm_cvtsi32_si128(in[7]|(in[6]<<8)), bytesel);
+	msbs = _mm_cmpeq_epi8(_mm_and_si128(msbs, bitsel), bitsel);
+	lsbs = _mm_cmpeq_epi8(_mm_and_si128(lsbs, bitsel), bitsel);
+	return _mm_or_si128(_mm_and_si128(msbs, _mm_set1_epi8(8)), _mm_and_si128(lsbs, _mm_set1_epi8(4)));
+}
+//returns false for planar blocks, which the caller should give to the scalar code instead.
+static qboolean SSSE3_ETC2_Rows(qbyte *fte_restrict in, __m128i *rows, int alphamode)
+{
+	FTE_ALIGN(16) pixel32_t pal[8];
+	int mode = Image_Decode_ETC2_Palette(in, pal, alphamode), r;
+	__m128i idx4, pal1, pal2, m;
+
+	if (mode == ETC_MODE_PLANAR)
+		return false;
+
+	idx4 = SSSE3_ETC2_Indexes(in);
+	pal1 = _mm_load_si128((const __m128i*)pal);
+	if (mode == ETC_MODE_TH)
+		pal2 = pal1;
+	else
+		pal2 = _mm_load_si128((const __m128i*)(pal+4));
+	if (mode == ETC_MODE_TH || (in[3]&1))
+	{	//one palette per row
+		rows[0] = _mm_shuffle_epi8(pal1, SSSE3_PaletteRow(idx4, 0));
+		rows[1] = _mm_shuffle_epi8(pal1, SSSE3_PaletteRow(idx4, 1));
+		rows[2] = _mm_shuffle_epi8(pal2, SSSE3_PaletteRow(idx4, 2));
+		rows[3] = _mm_shuffle_epi8(pal2, SSSE3_PaletteRow(idx4, 3));
+	}
+	else
+	{	//left+right subblocks. pshufb gives 0 where the top bit is set, so look up both halves and combine.
+		const __m128i killright = _mm_setr_epi32(0,0,(int)0x80808080,(int)0x80808080);
+		const __m128i killleft = _mm_setr_epi32((int)0x80808080,(int)0x80808080,0,0);
+		for (r = 0; r < 4; r++)
+		{
+			m = SSSE3_PaletteRow(idx4, r);
+			rows[r] = _mm_or_si128(_mm_shuffle_epi8(pal1, _mm_or_si128(m, killright)), _mm_shuffle_epi8(pal2, _mm_or_si128(m, killleft)));
+		}
+	}
+	return true;
+}
+static __m128i SSSE3_EAC8U_Values(qbyte *fte_restrict in)
+{
+	__m128i idx = SSSE3_Unpack3(in+2);
+	__m128i tab = _mm_loadl_epi64((const __m128i*)eac_modifiers[in[1]&0xf]);
+	//base + modifier*multiplier, in 16 bits so the pack does the clamping for us.
+	tab = _mm_unpacklo_epi8(tab, _mm_cmpgt_epi8(_mm_setzero_si128(), tab));
+	tab = _mm_add_epi16(_mm_set1_epi16(in[0]), _mm_mullo_epi16(tab, _mm_set1_epi16(in[1]>>4)));
+	tab = _mm_packus_epi16(tab, tab);
+	idx = _mm_shuffle_epi8(idx, _mm_setr_epi8(0,4,8,12, 1,5,9,13, 2,6,10,14, 3,7,11,15));	//column-major to row-major
+	return _mm_shuffle_epi8(tab, idx);
+}
+static void Image_Decode_ETC2_RGB8_Block_SSSE3(qbyte *fte_restrict in, pixel32_t *fte_restrict out, int w, uploadfmt_t fmt)
+{
+	__m128i rows[4];
+	if (SSSE3_ETC2_Rows(in, rows, false))
+		SSSE3_StoreBlock(out, w, rows);
+	else
+		Image_Decode_ETC2_Block_Internal(in, out, w, false);
+}
+static void Image_Decode_ETC2_RGB8A1_Block_SSSE3(qbyte *fte_restrict in, pixel32_t *fte_restrict out, int w, uploadfmt_t fmt)
+{
+	__m128i rows[4];
+	if (SSSE3_ETC2_Rows(in, rows, true))
+		SSSE3_StoreBlock(out, w, rows);
+	else
+		Image_Decode_ETC2_Block_Internal(in, out, w, true);
+}
+static void Image_Decode_ETC2_RGB8A8_Block_SSSE3(qbyte *fte_restrict in, pixel32_t *fte_restrict out, int w, uploadfmt_t fmt)
+{
+	__m128i rows[4];
+	if (SSSE3_ETC2_Rows(in+8, rows, false))
+	{
+		SSSE3_MergeAlpha(rows, SSSE3_EAC8U_Values(in));
+		SSSE3_StoreBlock(out, w, rows);
+	}
+	else
+		Image_Decode_ETC2_RGB8A8_Block(in, out, w, fmt);
+}
+static void Image_Decode_EAC_R11U_Block_SSSE3(qbyte *fte_restrict in, pixel32_t *fte_restrict out, int w, uploadfmt_t fmt)
+{
+	__m128i rows[4], r = SSSE3_EAC8U_Values(in);
+	int i;
+	for (i = 0; i < 4; i++)
+		rows[i] = _mm_or_si128(SSSE3_ChannelRow(r, i, 0x000000ff), _mm_set1_epi32((int)0xff000000));
+	SSSE3_StoreBlock(out, w, rows);
+}
+static void Image_Decode_EAC_RG11U_Block_SSSE3(qbyte *fte_restrict in, pixel32_t *fte_restrict out, int w, uploadfmt_t fmt)
+{
+	__m128i rows[4], r = SSSE3_EAC8U_Values(in), g = SSSE3_EAC8U_Values(in+8);
+	int i;
+	for (i = 0; i < 4; i++)
+		rows[i] = _mm_or_si128(_mm_or_si128(SSSE3_ChannelRow(r, i, 0x000000ff), SSSE3_ChannelRow(g, i, 0x0000ff00)), _mm_set1_epi32((int)0xff000000));
+	SSSE3_StoreBlock(out, w, rows);
+}
+#endif
+
+#ifdef DECOMPRESS_S3TC
+static void SSSE3_S3TC_Rows(qbyte *fte_restrict in, __m128i *rows, qbyte blackalpha)
+{	//2 bits per pixel, row-major, one byte per row.
+	const __m128i lsel = _mm_set1_epi32(0x40100401), msel = _mm_set1_epi32((int)0x80200802);
+	FTE_ALIGN(16) pixel32_t tab[2];
+	__m128i pal, swapped, idx4, lsbs, msbs;
+
+	//endpoints as in Image_Decode_S3TC_Palette, but the interpolated colours are done in 16 bits. the multiply is an exact /3 for this range.
+	Vector4Set(tab[0].v, (in[1]&0xf8), ((in[0]&0xe0)>>3)|((in[1]&7)<<5), (in[0]&0x1f)<<3, 0xff);
+	etc_expandv(tab[0],5,6,5);
+	Vector4Set(tab[1].v, (in[3]&0xf8), ((in[2]&0xe0)>>3)|((in[3]&7)<<5), (in[2]&0x1f)<<3, 0xff);
+	etc_expandv(tab[1],5,6,5);
+	pal = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)tab), _mm_setzero_si128());
+	swapped = _mm_shuffle_epi32(pal, _MM_SHUFFLE(1,0,3,2));
+	if ((in[0]|(in[1]<<8)) > (in[2]|(in[3]<<8)))
+		swapped = _mm_mulhi_epu16(_mm_add_epi16(_mm_add_epi16(pal, pal), swapped), _mm_set1_epi16(21846));
+	else
+	{
+		swapped = _mm_srli_epi16(_mm_add_epi16(pal, swapped), 1);
+		swapped = _mm_unpacklo_epi64(swapped, _mm_setr_epi16(0,0,0,blackalpha,0,0,0,0));
+	}
+	pal = _mm_packus_epi16(pal, swapped);
+
+	idx4 = _mm_shuffle_epi8(_mm_cvtsi32_si128(in[4] | (in[5]<<8) | (in[6]<<16) | (in[7]<<24)), _mm_setr_epi8(0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3));
+	lsbs = _mm_cmpeq_epi8(_mm_and_si128(idx4, lsel), lsel);
+	msbs = _mm_cmpeq_epi8(_mm_and_si128(idx4, msel), msel);
+	idx4 = _mm_or_si128(_mm_and_si128(msbs, _mm_set1_epi8(8)), _mm_and_si128(lsbs, _mm_set1_epi8(4)));
+
+	rows[0] = _mm_shuffle_epi8(pal, SSSE3_PaletteRow(idx4, 0));
+	rows[1] = _mm_shuffle_epi8(pal, SSSE3_PaletteRow(idx4, 1));
+	rows[2] = _mm_shuffle_epi8(pal, SSSE3_PaletteRow(idx4, 2));
+	rows[3] = _mm_shuffle_epi8(pal, SSSE3_PaletteRow(idx4, 3));
+}
+static void Image_Decode_BC1_Block_SSSE3(qbyte *fte_restrict in, pixel32_t *fte_restrict out, int w, uploadfmt_t fmt)
+{
+	__m128i rows[4];
+	SSSE3_S3TC_Rows(in, rows, 0xff);
+	SSSE3_StoreBlock(out, w, rows);
+}
+static void Image_Decode_BC1A_Block_SSSE3(qbyte *fte_restrict in, pixel32_t *fte_restrict out, int w, uploadfmt_t fmt)
+{
+	__m128i rows[4];
+	SSSE3_S3TC_Rows(in, rows, 0);
+	SSSE3_StoreBlock(out, w, rows);
+}
+static void Image_Decode_BC2_Block_SSSE3(qbyte *fte_restrict in, pixel32_t *fte_restrict out, int w, uploadfmt_t fmt)
+{
+	__m128i rows[4];
+	__m128i a = _mm_loadl_epi64((const __m128i*)in);
+	//straight 4-bit alpha, low nibble first.
+	a = _mm_unpacklo_epi8(_mm_and_si128(a, _mm_set1_epi8(0x0f)), _mm_and_si128(_mm_srli_epi16(a, 4), _mm_set1_epi8(0x0f)));
+	a = _mm_or_si128(a, _mm_slli_epi16(a, 4));
+
+	SSSE3_S3TC_Rows(in+8, rows, 0xff);
+	SSSE3_MergeAlpha(rows, a);
+	SSSE3_StoreBlock(out, w, rows);
+}
+#endif
+
+#ifdef DECOMPRESS_RGTC
+static __m128i SSSE3_RGTC_Values(qbyte *fte_restrict in, qboolean issigned)
 {
-	quint64_t bits;
-	union
-	{
-		qbyte u;
-		char s;
-	} tab[8];
-	tab[0].u = in[0];
-	tab[1].u = in[1];
+	FTE_ALIGN(16) qbyte pal[16];
+	__m128i tab, e0, e1;
 	if (issigned)
-	{
-		if (tab[0].s > tab[1].s)
-		{
-			tab[2].s = (tab[0].s*6 + tab[1].s*1)/7;
-			tab[3].s = (tab[0].s*5 + tab[1].s*2)/7;
-			tab[4].s = (tab[0].s*4 + tab[1].s*3)/7;
-			tab[5].s = (tab[0].s*3 + tab[1].s*4)/7;
-			tab[6].s = (tab[0].s*2 + tab[1].s*5)/7;
-			tab[7].s = (tab[0].s*1 + tab[1].s*6)/7;
-		}
-		else
-		{
-			tab[2].s = (tab[0].s*4 + tab[1].s*1)/5;
-			tab[3].s = (tab[0].s*3 + tab[1].s*2)/5;
-			tab[4].s = (tab[0].s*2 + tab[1].s*3)/5;
-			tab[5].s = (tab[0].s*1 + tab[1].s*4)/5;
-			tab[6].s = -128;
-			tab[7].s = 127;
-		}
+	{	//c's division rounds towards 0, which the multiply below doesn't do for negatives.
+		Image_Decode_RGTC_Palette(in, pal, issigned);
+		tab = _mm_loadl_epi64((const __m128i*)pal);
 	}
 	else
-	{
-		if (tab[0].u > tab[1].u)
+	{	//interpolate in 16 bits, then divide by 7 (or 5) via a fixed-point multiply that's exact for this range.
+		e0 = _mm_set1_epi16(in[0]);
+		e1 = _mm_set1_epi16(in[1]);
+		if (in[0] > in[1])
 		{
-			tab[2].u = (tab[0].u*6 + tab[1].u*1)/7;
-			tab[3].u = (tab[0].u*5 + tab[1].u*2)/7;
-			tab[4].u = (tab[0].u*4 + tab[1].u*3)/7;
-			tab[5].u = (tab[0].u*3 + tab[1].u*4)/7;
-			tab[6].u = (tab[0].u*2 + tab[1].u*5)/7;
-			tab[7].u = (tab[0].u*1 + tab[1].u*6)/7;
+			tab = _mm_add_epi16(_mm_mullo_epi16(e0, _mm_setr_epi16(7,0,6,5,4,3,2,1)), _mm_mullo_epi16(e1, _mm_setr_epi16(0,7,1,2,3,4,5,6)));
+			tab = _mm_mulhi_epu16(tab, _mm_set1_epi16(9363));
 		}
 		else
 		{
-			tab[2].u = (tab[0].u*4 + tab[1].u*1)/5;
-			tab[3].u = (tab[0].u*3 + tab[1].u*2)/5;
-			tab[4].u = (tab[0].u*2 + tab[1].u*3)/5;
-			tab[5].u = (tab[0].u*1 + tab[1].u*4)/5;
-			tab[6].u = 0;
-			tab[7].u = 0xff;
+			tab = _mm_add_epi16(_mm_mullo_epi16(e0, _mm_setr_epi16(5,0,4,3,2,1,0,0)), _mm_mullo_epi16(e1, _mm_setr_epi16(0,5,1,2,3,4,0,0)));
+			tab = _mm_or_si128(_mm_mulhi_epu16(tab, _mm_set1_epi16(13108)), _mm_setr_epi16(0,0,0,0,0,0,0,0xff));
 		}
+		tab = _mm_packus_epi16(tab, tab);
 	}
-
-	bits = in[2] | (in[3]<<8) | (in[4]<<16) | (in[5]<<24) | ((quint64_t)in[6]<<32) | ((quint64_t)in[7]<<40);
-
-#define BC3AU_Pix(r,i)	r = tab[(bits>>((i)*3))&7].u;
-#define BC3AU_Row(i)	BC3AU_Pix(out[0], i+0);BC3AU_Pix(out[4], i+1);BC3AU_Pix(out[8], i+2);BC3AU_Pix(out[12], i+3);
-	BC3AU_Row(0);out += stride;BC3AU_Row(4);out += stride;BC3AU_Row(8);out += stride;BC3AU_Row(12);
-#undef BC3AU_Pix
+	return _mm_shuffle_epi8(tab, SSSE3_Unpack3(in+2));
 }
 #ifdef DECOMPRESS_S3TC
-//s3tc rgb channel, with an rgtc alpha channel that depends upon both encodings (really the origin of rgtc, but mneh).
-static void Image_Decode_BC3_Block(qbyte *fte_restrict in, pixel32_t *fte_restrict out, int w, uploadfmt_t fmt)
+static void Image_Decode_BC3_Block_SSSE3(qbyte *fte_restrict in, pixel32_t *fte_restrict out, int w, uploadfmt_t fmt)
 {
-	Image_Decode_S3TC_Block_Internal(in+8, out, w, 0xff);
-	Image_Decode_RGTC_Block_Internal(in, out->v+3, w*4, false);
+	__m128i rows[4];
+	SSSE3_S3TC_Rows(in+8, rows, 0xff);
+	SSSE3_MergeAlpha(rows, SSSE3_RGTC_Values(in, false));
+	SSSE3_StoreBlock(out, w, rows);
 }
 #endif
-static void Image_Decode_BC4_Block(qbyte *fte_restrict in, pixel32_t *fte_restrict out, int w, uploadfmt_t fmt)
-{	//BC4: BC3's alpha channel but used as red only.
-	pixel32_t r;
-	int i = 0;
-	Vector4Set(r.v, 0, 0, 0, 0xff);
+static void Image_Decode_BC4_Block_SSSE3(qbyte *fte_restrict in, pixel32_t *fte_restrict out, int w, uploadfmt_t fmt)
+{
+	__m128i rows[4], r = SSSE3_RGTC_Values(in, fmt==PTI_BC4_R_SNORM);
+	int i;
 	for (i = 0; i < 4; i++)
-		out[w*0+i] = out[w*1+i] = out[w*2+i] = out[w*3+i] = r;
-	Image_Decode_RGTC_Block_Internal(in, out->v+0, w*4, fmt==PTI_BC4_R_SNORM);
+		rows[i] = _mm_or_si128(SSSE3_ChannelRow(r, i, 0x000000ff), _mm_set1_epi32((int)0xff000000));
+	SSSE3_StoreBlock(out, w, rows);
 }
-static void Image_Decode_BC5_Block(qbyte *fte_restrict in, pixel32_t *fte_restrict out, int w, uploadfmt_t fmt)
-{	//BC5: two of BC3's alpha channels but used as red+green only.
-	pixel32_t r;
-	int i = 0;
-	Vector4Set(r.v, 0, 0, 0, 0xff);
+static void Image_Decode_BC5_Block_SSSE3(qbyte *fte_restrict in, pixel32_t *fte_restrict out, int w, uploadfmt_t fmt)
+{
+	__m128i rows[4], r = SSSE3_RGTC_Values(in, fmt==PTI_BC5_RG_SNORM), g = SSSE3_RGTC_Values(in+8, fmt==PTI_BC5_RG_SNORM);
+	int i;
 	for (i = 0; i < 4; i++)
-		out[w*0+i] = out[w*1+i] = out[w*2+i] = out[w*3+i] = r;
-	Image_Decode_RGTC_Block_Internal(in+0, out->v+0, w*4, fmt==PTI_BC5_RG_SNORM);
-	Image_Decode_RGTC_Block_Internal(in+8, out->v+1, w*4, fmt==PTI_BC5_RG_SNORM);
+		rows[i] = _mm_or_si128(_mm_or_si128(SSSE3_ChannelRow(r, i, 0x000000ff), SSSE3_ChannelRow(g, i, 0x0000ff00)), _mm_set1_epi32((int)0xff000000));
+	SSSE3_StoreBlock(out, w, rows);
 }
 #endif
+#endif
 
 #ifdef DECOMPRESS_BPTC
 fte_inlinestatic int ReadBits(qbyte *in, int *bit, int n)
@@ -11585,91 +12316,75 @@ const char *Image_FormatName(uploadfmt_t fmt)
 	return "Unknown";
 }
 
-static pixel32_t *Image_Block_Decode(qbyte *fte_restrict in, size_t insize, int w, int h, int d, void(*decodeblock)(qbyte *fte_restrict in, pixel32_t *fte_restrict out, int w, uploadfmt_t srcfmt), uploadfmt_t encoding)
-{
+//software decoding can take a while for large textures, so the block rows are split into strips that the loader threads can help out with.
 #define TMPBLOCKSIZE 16u
-	pixel32_t *ret, *out;
-	pixel32_t tmp[TMPBLOCKSIZE*TMPBLOCKSIZE];
-	int x, y, z, i, j;
-	int sizediff;
-	int rows, columns, layers;
-
-	unsigned int blockbytes, blockwidth, blockheight, blockdepth;
-	Image_BlockSizeForEncoding(encoding, &blockbytes, &blockwidth, &blockheight, &blockdepth);
-
-	if (blockwidth > TMPBLOCKSIZE || blockheight > TMPBLOCKSIZE || blockdepth != 1)
-		Sys_Error("Image_Block_Decode only supports up to %u*%u blocks.\n", TMPBLOCKSIZE,TMPBLOCKSIZE);
-
-	sizediff = insize - blockbytes*((w+blockwidth-1)/blockwidth)*((h+blockheight-1)/blockheight)*d;
-	if (sizediff)
+typedef struct
+{
+	qbyte *in;
+	qbyte *out;
+	unsigned int w, h;
+	size_t pixelsize;
+	void(*decode32)(qbyte *fte_restrict in, pixel32_t *fte_restrict out, int w, uploadfmt_t srcfmt);
+	void(*decode64)(qbyte *fte_restrict in, pixel64_t *fte_restrict out, int w, uploadfmt_t srcfmt);
+	uploadfmt_t encoding;
+	unsigned int blockbytes, blockwidth, blockheight;
+	unsigned int rowbytes;		//size of one row of blocks
+	unsigned int layerrows;		//rows of blocks per layer
+} blockdecode_t;
+
+static void Image_Block_DecodeRows(void *ctx, unsigned int row, unsigned int endrow)
+{
+	blockdecode_t *bd = ctx;
+	union
 	{
-		Con_Printf("Image_Block_Decode: %s data size is %u, expected %u\n\n", Image_FormatName(encoding), (unsigned int)insize, (unsigned int)(insize-sizediff));
-		if (sizediff < 0)
-			return NULL;
-	}
+		pixel32_t p32[TMPBLOCKSIZE*TMPBLOCKSIZE];
+		pixel64_t p64[TMPBLOCKSIZE*TMPBLOCKSIZE];
+	} tmp;
+	qbyte *in = bd->in + row*bd->rowbytes, *out;
+	size_t stride = bd->w*bd->pixelsize;
+	unsigned int x, y, j, bw, bh;
 
-	ret = out = BZ_Malloc(w*h*d*sizeof(*out));
-
-	rows = h/blockheight;
-	rows *= blockheight;
-	columns = w/blockwidth;
-	columns *= blockwidth;
-	layers = d;
-	for (z = 0; z < layers; z++)
+	for (; row < endrow; row++)
 	{
-		for (y = 0; y < rows; y+=blockheight, out += w*(blockheight-1))
+		y = (row%bd->layerrows)*bd->blockheight;
+		bh = min(bd->blockheight, bd->h-y);
+		out = bd->out + ((row/bd->layerrows)*bd->h + y)*stride;
+		for (x = 0; x < bd->w; x+=bd->blockwidth, in+=bd->blockbytes, out+=bd->blockwidth*bd->pixelsize)
 		{
-			for (x = 0; x < columns; x+=blockwidth, in+=blockbytes, out+=blockwidth)
-				decodeblock(in, out, w, encoding);
-			if (w%blockwidth)
+			bw = min(bd->blockwidth, bd->w-x);
+			if (bw == bd->blockwidth && bh == bd->blockheight)
 			{
-				decodeblock(in, tmp, TMPBLOCKSIZE, encoding);
-				for (i = 0; x < w; x++, out++, i++)
-				{
-					for (j = 0; j < blockheight; j++)
-						out[w*j] = tmp[i+TMPBLOCKSIZE*j];
-				}
-				in+=blockbytes;
+				if (bd->decode64)
+					bd->decode64(in, (pixel64_t*)out, bd->w, bd->encoding);
+				else
+					bd->decode32(in, (pixel32_t*)out, bd->w, bd->encoding);
 			}
-		}
-		if (h%blockheight)
-		{	//now walk along the bottom of the image
-			h %= blockheight;
-			for (x = 0; x < w; )
-			{
-				decodeblock(in, tmp, TMPBLOCKSIZE, encoding);
-				i = 0;
-				do
-				{
-					if (x == w)
-						break;
-					for (y = 0; y < h; y++)
-						out[w*y] = tmp[i+TMPBLOCKSIZE*y];
-					out++;
-					i++;
-				} while (++x % blockwidth);
-				in+=blockbytes;
+			else
+			{	//partial block along the right or bottom edge. decode it elsewhere and copy the part that's actually in the image.
+				if (bd->decode64)
+					bd->decode64(in, tmp.p64, TMPBLOCKSIZE, bd->encoding);
+				else
+					bd->decode32(in, tmp.p32, TMPBLOCKSIZE, bd->encoding);
+				for (j = 0; j < bh; j++)
+					memcpy(out + j*stride, (qbyte*)&tmp + j*TMPBLOCKSIZE*bd->pixelsize, bw*bd->pixelsize);
 			}
 		}
 	}
-	return ret;
 }
-static pixel64_t *Image_Block_Decode64(qbyte *fte_restrict in, size_t insize, int w, int h, int d, void(*decodeblock)(qbyte *fte_restrict in, pixel64_t *fte_restrict out, int w, uploadfmt_t srcfmt), uploadfmt_t encoding)
+static void *Image_Block_Decode(qbyte *fte_restrict in, size_t insize, int w, int h, int d,
+								void(*decode32)(qbyte *fte_restrict in, pixel32_t *fte_restrict out, int w, uploadfmt_t srcfmt),
+								void(*decode64)(qbyte *fte_restrict in, pixel64_t *fte_restrict out, int w, uploadfmt_t srcfmt),
+								uploadfmt_t encoding)
 {
-#define TMPBLOCKSIZE 16u
-	pixel64_t *ret, *out;
-	pixel64_t tmp[TMPBLOCKSIZE*TMPBLOCKSIZE];
-	int x, y, z, i, j;
+	blockdecode_t bd;
 	int sizediff;
-	int rows, columns, layers;
-
 	unsigned int blockbytes, blockwidth, blockheight, blockdepth;
 	Image_BlockSizeForEncoding(encoding, &blockbytes, &blockwidth, &blockheight, &blockdepth);
 
 	if (blockwidth > TMPBLOCKSIZE || blockheight > TMPBLOCKSIZE || blockdepth != 1)
-		Sys_Error("Image_Block_Decode only supports up to %u*%u*%u blocks.\n", TMPBLOCKSIZE,TMPBLOCKSIZE,1);
+		Sys_Error("Image_Block_Decode only supports up to %u*%u blocks.\n", TMPBLOCKSIZE,TMPBLOCKSIZE);
 
-	sizediff = insize - blockbytes*((w+blockwidth-1)/blockwidth)*((h+blockheight-1)/blockheight)*((d+blockdepth-1)/blockdepth);
+	sizediff = insize - blockbytes*((w+blockwidth-1)/blockwidth)*((h+blockheight-1)/blockheight)*d;
 	if (sizediff)
 	{
 		Con_Printf("Image_Block_Decode: %s data size is %u, expected %u\n\n", Image_FormatName(encoding), (unsigned int)insize, (unsigned int)(insize-sizediff));
@@ -11677,54 +12392,29 @@ static pixel64_t *Image_Block_Decode64(qbyte *fte_restrict in, size_t insize, in
 			return NULL;
 	}
 
-	ret = out = BZ_Malloc(w*h*d*sizeof(*out));
+	bd.in = in;
+	bd.pixelsize = decode64?sizeof(pixel64_t):sizeof(pixel32_t);
+	bd.out = BZ_Malloc(w*h*d*bd.pixelsize);
+	bd.w = w;
+	bd.h = h;
+	bd.decode32 = decode32;
+	bd.decode64 = decode64;
+	bd.encoding = encoding;
+	bd.blockbytes = blockbytes;
+	bd.blockwidth = blockwidth;
+	bd.blockheight = blockheight;
+	bd.rowbytes = blockbytes*((w+blockwidth-1)/blockwidth);
+	bd.layerrows = (h+blockheight-1)/blockheight;
 
-	rows = h/blockheight;
-	rows *= blockheight;
-	columns = w/blockwidth;
-	columns *= blockwidth;
-	layers = d/blockdepth;
-	layers *= blockdepth;
-	for (z = 0; z < layers; z+=blockdepth)
-	{
-		for (y = 0; y < rows; y+=blockheight, out += w*(blockheight-1))
-		{
-			for (x = 0; x < columns; x+=blockwidth, in+=blockbytes, out+=blockwidth)
-				decodeblock(in, out, w, encoding);
-			if (w%blockwidth)
-			{
-				decodeblock(in, tmp, TMPBLOCKSIZE, encoding);
-				for (i = 0; x < w; x++, out++, i++)
-				{
-					for (j = 0; j < blockheight; j++)
-						out[w*j] = tmp[i+TMPBLOCKSIZE*j];
-				}
-				in+=blockbytes;
-			}
-		}
-		if (h%blockheight)
-		{	//now walk along the bottom of the image
-			h %= blockheight;
-			for (x = 0; x < w; )
-			{
-				decodeblock(in, tmp, TMPBLOCKSIZE, encoding);
-				i = 0;
-				do
-				{
-					if (x == w)
-						break;
-					for (y = 0; y < h; y++)
-						out[w*y] = tmp[i+TMPBLOCKSIZE*y];
-					out++;
-					i++;
-				} while (++x % blockwidth);
-				in+=blockbytes;
-			}
-		}
-	}
-	return ret;
+	Image_Strips(Image_Block_DecodeRows, &bd, bd.layerrows*d, IMAGESTRIP_PIXELS/(w*blockheight));
+	return bd.out;
 }
 
+#ifdef DECOMPRESS_SSSE3
+#define BLOCKDECODER_SIMD(f) (image_bench.scalar?f:f##_SSSE3)
+#else
+#define BLOCKDECODER_SIMD(f) f
+#endif
 static qboolean Image_DecompressFormat(struct pendingtextureinfo *mips, const char *imagename)
 {
 	//various compressed formats might not be supported by various gpus/apis.
@@ -11759,21 +12449,21 @@ static qboolean Image_DecompressFormat(struct pendingtextureinfo *mips, const ch
 	case PTI_ETC1_RGB8:
 	case PTI_ETC2_RGB8: //backwards compatible, so we just treat them the same
 	case PTI_ETC2_RGB8_SRGB:
-		decodefunc = Image_Decode_ETC2_RGB8_Block;
+		decodefunc = BLOCKDECODER_SIMD(Image_Decode_ETC2_RGB8_Block);
 		rcoding = (mips->encoding==PTI_ETC2_RGB8_SRGB)?PTI_RGBX8_SRGB:PTI_RGBX8;
 		break;
 	case PTI_ETC2_RGB8A1:	//weird hack mode
 	case PTI_ETC2_RGB8A1_SRGB:
-		decodefunc = Image_Decode_ETC2_RGB8A1_Block;
+		decodefunc = BLOCKDECODER_SIMD(Image_Decode_ETC2_RGB8A1_Block);
 		rcoding = (mips->encoding==PTI_ETC2_RGB8A1_SRGB)?PTI_RGBA8_SRGB:PTI_RGBA8;
 		break;
 	case PTI_ETC2_RGB8A8:
 	case PTI_ETC2_RGB8A8_SRGB:
-		decodefunc = Image_Decode_ETC2_RGB8A8_Block;
+		decodefunc = BLOCKDECODER_SIMD(Image_Decode_ETC2_RGB8A8_Block);
 		rcoding = (mips->encoding==PTI_ETC2_RGB8A8_SRGB)?PTI_RGBA8_SRGB:PTI_RGBA8;
 		break;
 	case PTI_EAC_R11:
-		decodefunc = Image_Decode_EAC_R11U_Block;
+		decodefunc = BLOCKDECODER_SIMD(Image_Decode_EAC_R11U_Block);
 		rcoding = PTI_RGBX8;
 		break;
 /*	case PTI_EAC_R11_SNORM:
@@ -11781,7 +12471,7 @@ static qboolean Image_DecompressFormat(struct pendingtextureinfo *mips, const ch
 		rcoding = PTI_RGBX8;
 		break;*/
 	case PTI_EAC_RG11:
-		decodefunc = Image_Decode_EAC_RG11U_Block;
+		decodefunc = BLOCKDECODER_SIMD(Image_Decode_EAC_RG11U_Block);
 		rcoding = PTI_RGBX8;
 		break;
 /*	case PTI_EAC_RG11_SNORM:
@@ -11807,7 +12497,7 @@ static qboolean Image_DecompressFormat(struct pendingtextureinfo *mips, const ch
 	case PTI_BC1_RGB:
 	case PTI_BC1_RGB_SRGB:
 #ifdef DECOMPRESS_S3TC
-		decodefunc = Image_Decode_BC1_Block;
+		decodefunc = BLOCKDECODER_SIMD(Image_Decode_BC1_Block);
 		rcoding = (mips->encoding==PTI_BC1_RGB_SRGB)?PTI_RGBX8_SRGB:PTI_RGBX8;
 #else
 		Con_ThrottlePrintf(&throttle, 0, "BC1 decompression is not supported in this build\n");
@@ -11816,7 +12506,7 @@ static qboolean Image_DecompressFormat(struct pendingtextureinfo *mips, const ch
 	case PTI_BC1_RGBA:
 	case PTI_BC1_RGBA_SRGB:
 #ifdef DECOMPRESS_S3TC
-		decodefunc = Image_Decode_BC1A_Block;
+		decodefunc = BLOCKDECODER_SIMD(Image_Decode_BC1A_Block);
 		rcoding = (mips->encoding==PTI_BC1_RGBA_SRGB)?PTI_RGBA8_SRGB:PTI_RGBA8;
 #else
 		Con_ThrottlePrintf(&throttle, 0, "BC1A decompression is not supported in this build\n");
@@ -11825,7 +12515,7 @@ static qboolean Image_DecompressFormat(struct pendingtextureinfo *mips, const ch
 	case PTI_BC2_RGBA:
 	case PTI_BC2_RGBA_SRGB:
 #ifdef DECOMPRESS_S3TC
-		decodefunc = Image_Decode_BC2_Block;
+		decodefunc = BLOCKDECODER_SIMD(Image_Decode_BC2_Block);
 		rcoding = (mips->encoding==PTI_BC2_RGBA_SRGB)?PTI_RGBA8_SRGB:PTI_RGBA8;
 #else
 		Con_ThrottlePrintf(&throttle, 0, "BC2 decompression is not supported in this build\n");
@@ -11834,7 +12524,7 @@ static qboolean Image_DecompressFormat(struct pendingtextureinfo *mips, const ch
 	case PTI_BC3_RGBA:
 	case PTI_BC3_RGBA_SRGB:
 #if defined(DECOMPRESS_RGTC) && defined(DECOMPRESS_S3TC)
-		decodefunc = Image_Decode_BC3_Block;
+		decodefunc = BLOCKDECODER_SIMD(Image_Decode_BC3_Block);
 		rcoding = (mips->encoding==PTI_BC3_RGBA_SRGB)?PTI_RGBA8_SRGB:PTI_RGBA8;
 #else
 		Con_ThrottlePrintf(&throttle, 0, "Fallback BC3 decompression is not supported in this build\n");
@@ -11843,12 +12533,12 @@ static qboolean Image_DecompressFormat(struct pendingtextureinfo *mips, const ch
 #ifdef DECOMPRESS_RGTC
 	case PTI_BC4_R_SNORM:
 	case PTI_BC4_R:
-		decodefunc = Image_Decode_BC4_Block;
+		decodefunc = BLOCKDECODER_SIMD(Image_Decode_BC4_Block);
 		rcoding = PTI_RGBX8;
 		break;
 	case PTI_BC5_RG_SNORM:
 	case PTI_BC5_RG:
-		decodefunc = Image_Decode_BC5_Block;
+		decodefunc = BLOCKDECODER_SIMD(Image_Decode_BC5_Block);
 		rcoding = PTI_RGBX8;
 		break;
 #else
@@ -11964,18 +12654,8 @@ static qboolean Image_DecompressFormat(struct pendingtextureinfo *mips, const ch
 #endif
 		for (mip = 0; mip < mips->mipcount; mip++)
 		{
-			size_t sz;
-			void *out;
-			if (decodefunc64)
-			{
-				sz = sizeof(pixel64_t);
-				out = Image_Block_Decode64(mips->mip[mip].data, mips->mip[mip].datasize, mips->mip[mip].width, mips->mip[mip].height, mips->mip[mip].depth, decodefunc64, mips->encoding);
-			}
-			else
-			{
-				sz = sizeof(pixel32_t);
-				out = Image_Block_Decode(mips->mip[mip].data, mips->mip[mip].datasize, mips->mip[mip].width, mips->mip[mip].height, mips->mip[mip].depth, decodefunc, mips->encoding);
-			}
+			size_t sz = decodefunc64?sizeof(pixel64_t):sizeof(pixel32_t);
+			void *out = Image_Block_Decode(mips->mip[mip].data, mips->mip[mip].datasize, mips->mip[mip].width, mips->mip[mip].height, mips->mip[mip].depth, decodefunc, decodefunc64, mips->encoding);
 			if (mips->mip[mip].needfree)
 				BZ_Free(mips->mip[mip].data);
 			mips->mip[mip].data = out;
@@ -11991,6 +12671,185 @@ static qboolean Image_DecompressFormat(struct pendingtextureinfo *mips, const ch
 	return false;
 }
 
+#ifdef HAVE_CLIENT
+//decodes the same pseudo-random texture for each format and reports the throughput (in decoded bytes) for each decoding path.
+//the scalar decoders are used as the reference, so this also checks that the other paths give identical results.
+static void Image_DecodeBench_f(void)
+{
+	static const uploadfmt_t formats[] = {
+		PTI_BC1_RGB, PTI_BC1_RGBA, PTI_BC2_RGBA, PTI_BC3_RGBA, PTI_BC4_R, PTI_BC5_RG, PTI_BC6_RGB_UFLOAT, PTI_BC7_RGBA,
+		PTI_ETC2_RGB8, PTI_ETC2_RGB8A1, PTI_ETC2_RGB8A8, PTI_EAC_R11, PTI_EAC_RG11,
+		PTI_ASTC_4X4_LDR, PTI_ASTC_8X8_LDR};
+	static const char *pathnames[] = {"scalar", "simd", "threaded"};
+	int size = (Cmd_Argc()>1)?atoi(Cmd_Argv(1)):1024;
+	int f, path, reps;
+	unsigned int bb, bw, bh, bd, i, seed;
+	size_t insize, outsize;
+	qbyte *src;
+	void *ref;
+	double start, elapsed, rate[countof(pathnames)];
+	qboolean mismatch;
+	struct pendingtextureinfo mips;
+
+	size = bound(4, size, 8192);
+	Con_Printf("%-16s %10s %10s %10s  (MB/s, %i*%i)\n", "format", pathnames[0], pathnames[1], pathnames[2], size, size);
+	for (f = 0; f < countof(formats); f++)
+	{
+		Image_BlockSizeForEncoding(formats[f], &bb, &bw, &bh, &bd);
+		insize = bb*((size+bw-1)/bw)*((size+bh-1)/bh);
+		src = BZ_Malloc(insize);
+		for (i = 0, seed = 0x1234567u+formats[f]; i < insize; i++)
+		{
+			seed = seed*1103515245u + 12345u;
+			src[i] = seed>>16;
+		}
+
+		ref = NULL;
+		outsize = 0;
+		mismatch = false;
+		for (path = 0; path < countof(pathnames); path++)
+		{
+			image_bench.scalar = (path == 0);
+			image_bench.serial = (path < 2);
+			rate[path] = 0;
+			elapsed = 0;
+			for (reps = 0; elapsed < 0.25 || reps < 2; reps++)
+			{
+				memset(&mips, 0, sizeof(mips));
+				mips.type = PTI_2D;
+				mips.encoding = formats[f];
+				mips.mipcount = 1;
+				mips.mip[0].data = src;
+				mips.mip[0].datasize = insize;
+				mips.mip[0].width = size;
+				mips.mip[0].height = size;
+				mips.mip[0].depth = 1;
+				mips.mip[0].needfree = false;
+
+				start = Sys_DoubleTime();
+				if (!Image_DecompressFormat(&mips, NULL))
+					break;
+				elapsed += Sys_DoubleTime() - start;
+
+				outsize = mips.mip[0].datasize;
+				if (!ref)
+					ref = mips.mip[0].data;
+				else
+				{
+					if (memcmp(ref, mips.mip[0].data, outsize))
+						mismatch = true;
+					BZ_Free(mips.mip[0].data);
+				}
+			}
+			if (reps)
+				rate[path] = (outsize*reps) / (elapsed*1024*1024);
+		}
+		BZ_Free(ref);
+		BZ_Free(src);
+
+		if (!outsize)
+			Con_Printf("%-16s unsupported\n", Image_FormatName(formats[f]));
+		else
+			Con_Printf("%-16s %10.1f %10.1f %10.1f%s\n", Image_FormatName(formats[f]), rate[0], rate[1], rate[2], mismatch?CON_ERROR" MISMATCH":"");
+	}
+	memset(&image_bench, 0, sizeof(image_bench));
+}
+
+//generates mips for the same pseudo-random texture in each format and reports the throughput (in bytes of the source image) for each path.
+//PTI_INVALID stands in for the lerped resampler, scaling the texture up by half.
+static void Image_MipBench_f(void)
+{
+	static const uploadfmt_t formats[] = {PTI_RGBA8, PTI_RGBA8_SRGB, PTI_RGB8, PTI_RGB8_SRGB, PTI_L8A8_SRGB, PTI_RGBA16, PTI_RGBA16F, PTI_RGBA32F, PTI_INVALID};
+	static const char *pathnames[] = {"scalar", "simd", "threaded"};
+	int size = (Cmd_Argc()>1)?atoi(Cmd_Argv(1)):2048;
+	int f, path, reps, m, rsize;
+	unsigned int bb, bw, bh, bd, i, seed;
+	size_t insize, elsize;
+	qbyte *src;
+	double start, elapsed, rate[countof(pathnames)];
+	qboolean mismatch;
+	struct pendingtextureinfo mips, ref;
+
+	size = bound(2, size, 4096);
+	rsize = size + size/2;
+	Con_Printf("%-16s %10s %10s %10s  (MB/s, %i*%i)\n", "format", pathnames[0], pathnames[1], pathnames[2], size, size);
+	for (f = 0; f < countof(formats); f++)
+	{
+		if (formats[f] == PTI_INVALID)
+			bb = 4;
+		else
+			Image_BlockSizeForEncoding(formats[f], &bb, &bw, &bh, &bd);
+		elsize = (formats[f] == PTI_RGBA32F)?sizeof(float):((formats[f] == PTI_RGBA16F)?sizeof(unsigned short):1);
+		insize = bb*size*size;
+		src = BZ_Malloc(insize);
+		for (i = 0, seed = 0x1234567u+formats[f]; i < insize/elsize; i++)
+		{
+			seed = seed*1103515245u + 12345u;
+			//keep the floats finite, nan payloads don't have to match.
+			if (formats[f] == PTI_RGBA32F)
+				((float*)src)[i] = (seed>>16)*(4.0f/65536);
+			else if (formats[f] == PTI_RGBA16F)
+				((unsigned short*)src)[i] = FloatToHalf((seed>>16)*(4.0f/65536));
+			else
+				src[i] = seed>>16;
+		}
+
+		memset(&ref, 0, sizeof(ref));
+		mismatch = false;
+		for (path = 0; path < countof(pathnames); path++)
+		{
+			image_bench.scalar = (path == 0);
+			image_bench.serial = (path < 2);
+			elapsed = 0;
+			for (reps = 0; elapsed < 0.25 || reps < 2; reps++)
+			{
+				memset(&mips, 0, sizeof(mips));
+				mips.type = PTI_2D;
+				mips.encoding = formats[f];
+				mips.mipcount = 1;
+				mips.mip[0].data = src;
+				mips.mip[0].datasize = insize;
+				mips.mip[0].width = size;
+				mips.mip[0].height = size;
+				mips.mip[0].depth = 1;
+				mips.mip[0].needfree = false;
+
+				start = Sys_DoubleTime();
+				if (formats[f] == PTI_INVALID)
+				{
+					mips.mip[1].datasize = rsize*rsize*4;
+					mips.mip[1].data = BZ_Malloc(mips.mip[1].datasize);
+					mips.mipcount = 2;
+					Image_Resample32Lerp(src, size, size, mips.mip[1].data, rsize, rsize);
+				}
+				else
+					Image_GenerateMipChain(&mips);
+				elapsed += Sys_DoubleTime() - start;
+
+				if (!ref.mipcount)
+					ref = mips;
+				else
+				{
+					for (m = 1; m < mips.mipcount; m++)
+					{
+						if (m >= ref.mipcount || memcmp(ref.mip[m].data, mips.mip[m].data, mips.mip[m].datasize))
+							mismatch = true;
+						BZ_Free(mips.mip[m].data);
+					}
+				}
+			}
+			rate[path] = (insize*reps) / (elapsed*1024*1024);
+		}
+		for (m = 1; m < ref.mipcount; m++)
+			BZ_Free(ref.mip[m].data);
+		BZ_Free(src);
+
+		Con_Printf("%-16s %10.1f %10.1f %10.1f%s\n", (formats[f] == PTI_INVALID)?"resample":Image_FormatName(formats[f]), rate[0], rate[1], rate[2], mismatch?CON_ERROR" MISMATCH":"");
+	}
+	memset(&image_bench, 0, sizeof(image_bench));
+}
+#endif
+
 static struct
 {
 	uploadfmt_t src;
@@ -13237,6 +14096,248 @@ void Image_ReadExternalAlpha(qbyte *rgbadata, size_t imgwidth, size_t imgheight,
 #endif
 }
 
+#ifdef HAVE_CLIENT
+//r_imagecache stores the final (decoded, mipped, and converted) image data under $gamedir/imagecache/, so the next load can skip straight to the upload.
+//entries are named by a hash of the source file along with everything else that can affect the result, so there's nothing to go stale - changing a setting just results in different names.
+//the data is in the native byte order and in whatever formats this gpu wanted, so its not meant to be shipped anywhere.
+#define IMAGECACHE_MAGIC	(('F'<<0)|('T'<<8)|('E'<<16)|('i'<<24))
+#define IMAGECACHE_VERSION	1	//bump this if anything changes how images get loaded.
+#define IMAGECACHE_ALIGN	16	//keep each mip's data aligned for the simd paths.
+typedef struct
+{
+	unsigned int magic;
+	unsigned int version;
+	unsigned int type;
+	unsigned int encoding;
+	unsigned int mipcount;
+	unsigned int pad[3];
+} imagecacheheader_t;
+typedef struct
+{
+	unsigned int width;
+	unsigned int height;
+	unsigned int depth;
+	unsigned int datasize;
+} imagecachemip_t;
+
+//figures out the name for the cache entry, or returns false if this image shouldn't be cached.
+static qboolean Image_Cache_Name(char *out, size_t outsize, unsigned int flags, const char *fname, const qbyte *filedata, size_t filesize)
+{
+	extern cvar_t vid_hardwaregamma;
+	const hashfunc_t *func = &hash_sha1;
+	void *ctx = alloca(func->contextsize);
+	qbyte digest[DIGEST_MAXSIZE];
+	char hex[DIGEST_MAXSIZE*2+1];
+	qboolean texfmt[PTI_MAX];
+	int picmip = Image_GetPicMip(flags);
+	int ival;
+	float fval;
+	char aname[MAX_QPATH], ext[8];
+
+	if (!r_imagecache.ival || !filesize)
+		return false;
+
+	//the _alpha companion (see Image_ReadExternalAlpha) isn't part of the hash, so don't cache anything that might be using one.
+	if (!(flags & IF_NOALPHA) && !strchr(fname, ':'))
+	{
+		COM_StripExtension(fname, aname, sizeof(aname));
+		COM_FileExtension(fname, ext, sizeof(ext));
+		Q_strncatz(aname, "_alpha.", sizeof(aname));
+		Q_strncatz(aname, ext, sizeof(aname));
+		if (FS_FLocateFile(aname, FSLF_IFFOUND|FSLF_QUIET|FSLF_DONTREFERENCE, NULL))
+			return false;
+	}
+
+	func->init(ctx);
+	ival = IMAGECACHE_VERSION;				func->process(ctx, &ival, sizeof(ival));
+	func->process(ctx, &flags, sizeof(flags));
+	func->process(ctx, &picmip, sizeof(picmip));
+
+	//what the renderer can accept. p8 is only ever used when explicitly asked for, and Image_ChangeFormatFlags toggles it from other threads anyway.
+	memcpy(texfmt, sh_config.texfmt, sizeof(texfmt));
+	texfmt[PTI_P8] = false;
+	func->process(ctx, texfmt, sizeof(texfmt));
+	func->process(ctx, &sh_config.texture2d_maxsize, sizeof(sh_config.texture2d_maxsize));
+	func->process(ctx, &sh_config.texture3d_maxsize, sizeof(sh_config.texture3d_maxsize));
+	func->process(ctx, &sh_config.texturecube_maxsize, sizeof(sh_config.texturecube_maxsize));
+	func->process(ctx, &sh_config.texture2darray_maxlayers, sizeof(sh_config.texture2darray_maxlayers));
+	func->process(ctx, &sh_config.texture_non_power_of_two, sizeof(sh_config.texture_non_power_of_two));
+	func->process(ctx, &sh_config.texture_non_power_of_two_pic, sizeof(sh_config.texture_non_power_of_two_pic));
+	func->process(ctx, &sh_config.npot_rounddown, sizeof(sh_config.npot_rounddown));
+	func->process(ctx, &sh_config.texture_allow_block_padding, sizeof(sh_config.texture_allow_block_padding));
+	func->process(ctx, &sh_config.can_genmips, sizeof(sh_config.can_genmips));
+	ival = vid.flags & VID_SRGBAWARE;		func->process(ctx, &ival, sizeof(ival));
+	ival = vid.fullbright;					func->process(ctx, &ival, sizeof(ival));
+
+	//cvars that the loaders look at
+	fval = gl_max_size.value;				func->process(ctx, &fval, sizeof(fval));
+	ival = gl_lerpimages.ival;				func->process(ctx, &ival, sizeof(ival));
+	ival = r_dodgymiptex.ival;				func->process(ctx, &ival, sizeof(ival));
+#ifdef IMAGEFMT_TGA
+	ival = r_dodgytgafiles.ival;			func->process(ctx, &ival, sizeof(ival));
+#endif
+#ifdef IMAGEFMT_PCX
+	ival = r_dodgypcxfiles.ival;			func->process(ctx, &ival, sizeof(ival));
+#endif
+	fval = r_shadow_bumpscale_basetexture.value;	func->process(ctx, &fval, sizeof(fval));
+	fval = r_shadow_bumpscale_bumpmap.value;		func->process(ctx, &fval, sizeof(fval));
+	fval = r_shadow_heightscale_basetexture.value;	func->process(ctx, &fval, sizeof(fval));
+	fval = r_shadow_heightscale_bumpmap.value;		func->process(ctx, &fval, sizeof(fval));
+
+	//software gamma gets baked into the image data
+	ival = !(flags&IF_NOGAMMA) && !vid_hardwaregamma.value;
+	func->process(ctx, &ival, sizeof(ival));
+	if (ival)
+		func->process(ctx, gammatable, sizeof(gammatable));
+	if (host_basepal)
+		func->process(ctx, host_basepal, 768);
+
+	func->process(ctx, filedata, filesize);
+	func->terminate(digest, ctx);
+
+	hex[Base16_EncodeBlock((const char*)digest, func->digestsize, (qbyte*)hex, sizeof(hex)-1)] = 0;
+	Q_snprintfz(out, outsize, "imagecache/%s.img", hex);
+	return true;
+}
+
+//true if the mip's datasize is exactly what its encoding needs for its dimensions (the upload code assumes as much).
+static qboolean Image_Cache_MipSizeValid(uploadfmt_t encoding, unsigned int width, unsigned int height, unsigned int depth, size_t datasize)
+{
+	unsigned int bb, bw, bh, bd;
+	quint64_t size;
+	Image_BlockSizeForEncoding(encoding, &bb, &bw, &bh, &bd);
+	if (!bb || !width || !height || !depth)
+		return false;
+	//bail as soon as it gets too big, so that bogus dimensions can't overflow it.
+	size = (quint64_t)bb * ((width+(quint64_t)bw-1)/bw);
+	if (size > datasize)
+		return false;
+	size *= (height+(quint64_t)bh-1)/bh;
+	if (size > datasize)
+		return false;
+	size *= (depth+(quint64_t)bd-1)/bd;
+	return size == datasize;
+}
+
+static struct pendingtextureinfo *Image_Cache_Read(const char *cachename)
+{
+	struct pendingtextureinfo *mips;
+	imagecacheheader_t *header;
+	imagecachemip_t *mip;
+	vfsfile_t *f = FS_OpenVFS(cachename, "rb", FS_GAMEONLY);
+	qofs_t filesize;
+	size_t offset;
+	qbyte *buf;
+	unsigned int i;
+
+	if (!f)
+		return NULL;
+	filesize = VFS_GETLEN(f);
+	if (filesize < sizeof(*header) || filesize > 0x7fffffff)
+	{
+		VFS_CLOSE(f);
+		return NULL;
+	}
+	buf = BZ_Malloc(filesize);
+	if (VFS_READ(f, buf, filesize) != filesize)
+		filesize = 0;
+	VFS_CLOSE(f);
+
+	//validate it. if it was truncated (or is still being written) then just treat it as a miss.
+	header = (imagecacheheader_t*)buf;
+	mip = (imagecachemip_t*)(header+1);
+	if (!filesize || header->magic != IMAGECACHE_MAGIC || header->version != IMAGECACHE_VERSION ||
+		header->type >= PTI_ANY || !header->mipcount || header->mipcount > countof(mips->mip) || header->encoding >= PTI_MAX ||
+		sizeof(*header)+sizeof(*mip)*header->mipcount > filesize)
+	{
+		BZ_Free(buf);
+		return NULL;
+	}
+	offset = sizeof(*header)+sizeof(*mip)*header->mipcount;
+	for (i = 0; i < header->mipcount; i++)
+	{
+		offset = (offset+IMAGECACHE_ALIGN-1)&~(size_t)(IMAGECACHE_ALIGN-1);
+		if (offset > filesize || mip[i].datasize > filesize-offset ||
+			!Image_Cache_MipSizeValid(header->encoding, mip[i].width, mip[i].height, mip[i].depth, mip[i].datasize))
+		{
+			BZ_Free(buf);
+			return NULL;
+		}
+		offset += mip[i].datasize;
+	}
+	if (offset != filesize)
+	{
+		BZ_Free(buf);
+		return NULL;
+	}
+
+	//all good. the mips just point into the file's buffer.
+	mips = Z_Malloc(sizeof(*mips));
+	mips->type = header->type;
+	mips->encoding = header->encoding;
+	mips->mipcount = header->mipcount;
+	mips->extrafree = buf;
+	offset = sizeof(*header)+sizeof(*mip)*header->mipcount;
+	for (i = 0; i < header->mipcount; i++)
+	{
+		offset = (offset+IMAGECACHE_ALIGN-1)&~(size_t)(IMAGECACHE_ALIGN-1);
+		mips->mip[i].data = buf+offset;
+		mips->mip[i].datasize = mip[i].datasize;
+		mips->mip[i].width = mip[i].width;
+		mips->mip[i].height = mip[i].height;
+		mips->mip[i].depth = mip[i].depth;
+		mips->mip[i].needfree = false;
+		offset += mip[i].datasize;
+	}
+	return mips;
+}
+
+static void Image_Cache_Write(const char *cachename, struct pendingtextureinfo *mips)
+{
+	static const qbyte padding[IMAGECACHE_ALIGN];
+	imagecacheheader_t header;
+	imagecachemip_t mip[countof(mips->mip)];
+	vfsfile_t *f;
+	size_t offset;
+	int i;
+
+	if (!mips->mipcount || mips->type >= PTI_ANY)
+		return;
+	for (i = 0; i < mips->mipcount; i++)
+		if (!Image_Cache_MipSizeValid(mips->encoding, mips->mip[i].width, mips->mip[i].height, mips->mip[i].depth, mips->mip[i].datasize))
+			return;	//the read would reject it anyway
+
+	memset(&header, 0, sizeof(header));
+	header.magic = IMAGECACHE_MAGIC;
+	header.version = IMAGECACHE_VERSION;
+	header.type = mips->type;
+	header.encoding = mips->encoding;
+	header.mipcount = mips->mipcount;
+	for (i = 0; i < mips->mipcount; i++)
+	{
+		mip[i].width = mips->mip[i].width;
+		mip[i].height = mips->mip[i].height;
+		mip[i].depth = mips->mip[i].depth;
+		mip[i].datasize = mips->mip[i].datasize;
+	}
+
+	f = FS_OpenVFS(cachename, "wb", FS_GAMEONLY);
+	if (!f)
+		return;
+	VFS_WRITE(f, &header, sizeof(header));
+	VFS_WRITE(f, mip, sizeof(*mip)*mips->mipcount);
+	offset = sizeof(header)+sizeof(*mip)*mips->mipcount;
+	for (i = 0; i < mips->mipcount; i++)
+	{
+		VFS_WRITE(f, padding, ((offset+IMAGECACHE_ALIGN-1)&~(size_t)(IMAGECACHE_ALIGN-1)) - offset);
+		offset = (offset+IMAGECACHE_ALIGN-1)&~(size_t)(IMAGECACHE_ALIGN-1);
+		VFS_WRITE(f, mips->mip[i].data, mips->mip[i].datasize);
+		offset += mips->mip[i].datasize;
+	}
+	VFS_CLOSE(f);
+}
+#endif
+
 //always frees filedata, even on failure.
 //also frees the textures fallback data, but only on success
 struct pendingtextureinfo *Image_LoadMipsFromMemory(int flags, const char *iname, const char *fname, qbyte *filedata, int filesize)
@@ -13248,6 +14349,15 @@ struct pendingtextureinfo *Image_LoadMipsFromMemory(int flags, const char *iname
 	size_t l;
 
 	struct pendingtextureinfo *mips = NULL;
+#ifdef HAVE_CLIENT
+	char cachename[MAX_QPATH];
+	qboolean cached = Image_Cache_Name(cachename, sizeof(cachename), flags, fname, filedata, filesize);
+	if (cached && (mips = Image_Cache_Read(cachename)))
+	{	//already fully processed, so there's nothing left to do with it.
+		BZ_Free(filedata);
+		return mips;
+	}
+#endif
 
 	//these formats have special handling, because they cannot be implemented via Read32BitImageFile - they don't result in rgba images.
 #ifdef IMAGEFMT_KTX
@@ -13308,6 +14418,7 @@ struct pendingtextureinfo *Image_LoadMipsFromMemory(int flags, const char *iname
 	if (mips)
 	{
 		unsigned int picmip = min(Image_GetPicMip(flags), mips->mipcount-1), i;
+		uploadfmt_t origencoding = mips->encoding;
 		if (picmip < mips->mipcount)
 		{
 			for (i = 0; i < picmip; i++)
@@ -13318,6 +14429,10 @@ struct pendingtextureinfo *Image_LoadMipsFromMemory(int flags, const char *iname
 		}
 
 		Image_ChangeFormatFlags(mips, flags, TF_INVALID, fname);
+#ifdef HAVE_CLIENT
+		if (cached && mips->encoding != origencoding)	//only worth caching if we had to decompress/convert it.
+			Image_Cache_Write(cachename, mips);
+#endif
 		return mips;
 	}
 
@@ -13361,6 +14476,10 @@ struct pendingtextureinfo *Image_LoadMipsFromMemory(int flags, const char *iname
 		{
 			Image_GenerateMips(mips, flags);
 			Image_ChangeFormatFlags(mips, flags, format, fname);
+#ifdef HAVE_CLIENT
+			if (cached)
+				Image_Cache_Write(cachename, mips);
+#endif
 			BZ_Free(filedata);
 			return mips;
 		}
@@ -14772,6 +15891,8 @@ void Image_Shutdown(void)
 	int i = 0, j = 0;
 	Cmd_RemoveCommand("r_imagelist");
 	Cmd_RemoveCommand("r_imageformats");
+	Cmd_RemoveCommand("r_imagedecodebench");
+	Cmd_RemoveCommand("r_imagemipbench");
 	while (imagelist)
 	{
 		tex = imagelist;
@@ -14818,6 +15939,8 @@ void Image_Init(void)
 
 	Cmd_AddCommandD("r_imagelist", Image_List_f, "Prints out a list of the currently-known textures.");
 	Cmd_AddCommandD("r_imageformats", Image_Formats_f, "Prints out a list of the usable hardware pixel formats.");
+	Cmd_AddCommandD("r_imagedecodebench", Image_DecodeBench_f, "Times the software decoders for compressed texture formats on a generated texture (optionally with the given size), reporting MB/s of decoded output.");
+	Cmd_AddCommandD("r_imagemipbench", Image_MipBench_f, "Times the software mipmap generation and lerped resampling on a generated texture (optionally with the given size), reporting MB/s of source image.");
 #endif
 }
 
@@ -216,7 +216,7 @@ qboolean SV_Master_AddressIsMaster(netadr_t *adr)
 			continue;
 		for (j = 0; j < MAX_MASTER_ADDRESSES; j++)
 			if (net_masterlist[i].adr[j].type != NA_INVALID)
-				if (NET_CompareBaseAdr(&net_from, &net_masterlist[i].adr[j]))
+				if (NET_CompareBaseAdr(adr, &net_masterlist[i].adr[j]))
 					return true;
 	}
 	return false;
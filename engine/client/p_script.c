@@ -413,6 +413,17 @@ trailstate_t *trailstates;
 int			ts_cycle; // current cyclic index of trailstates
 int			r_numtrailstates;
 
+//each type's particle physics is run before its emitting/clipping/drawing, as that's the only part that touches nothing but the particles themselves.
+//types with lots of particles split it into batches that can be handed off to the worker threads.
+#define PART_BATCHSIZE		1024	//particles per batch, so the workers can balance the load between them.
+#define PART_THREADMIN		4096	//don't bother waking up the workers if there's not this much work to do.
+static struct
+{
+	particle_t **p;		//the live particles of the type currently being run
+	vec3_t *oldorg;		//where each particle was before this frame's physics
+	unsigned int count;
+} pbatch;
+
 static		qboolean r_plooksdirty;	//a particle effect was changed, reevaluate shared looks.
 
 extern cvar_t r_bouncysparks;
@@ -3454,6 +3465,8 @@ static qboolean PScript_InitParticles (void)
 
 	particles = (particle_t *)
 			BZ_Malloc (r_numparticles * sizeof(particle_t));
+	pbatch.p = BZ_Malloc(r_numparticles * sizeof(*pbatch.p));
+	pbatch.oldorg = BZ_Malloc(r_numparticles * sizeof(*pbatch.oldorg));
 
 	beams = (beamseg_t *)
 			BZ_Malloc (r_numbeams * sizeof(beamseg_t));
@@ -3560,6 +3573,9 @@ static void PScript_Shutdown (void)
 	fallback = NULL;
 
 	BZ_Free (particles);
+	BZ_Free (pbatch.p);
+	BZ_Free (pbatch.oldorg);
+	memset(&pbatch, 0, sizeof(pbatch));
 	BZ_Free (beams);
 	BZ_Free (decals);
 	BZ_Free (trailstates);
@@ -6892,6 +6908,166 @@ static void R_AddTexturedParticle(scenetris_t *t, particle_t *p, plooks_t *type)
 	t->numidx += 6;
 }
 
+//moves and fades a run of one type's particles. this only touches the particles themselves, so it can run on the workers.
+static void PScript_UpdateParticles(part_type_t *type, particle_t **plist, vec3_t *oldorg, unsigned int count, const float *viewtranslation, qboolean doflurry)
+{
+	particle_t *p;
+	ramp_t *ramp;
+	unsigned int i;
+	int rampind;
+	float grav = type->gravity*pframetime, frac;
+	vec3_t friction, tmp;
+	int s1, s2;
+
+	friction[0] = 1 - type->friction[0]*pframetime;
+	friction[1] = 1 - type->friction[1]*pframetime;
+	friction[2] = 1 - type->friction[2]*pframetime;
+
+	for (i = 0; i < count; i++)
+	{
+		p = plist[i];
+		VectorCopy(p->org, oldorg[i]);
+		if (type->flags & PT_VELOCITY)
+		{
+			VectorMA(p->org, pframetime, p->vel, p->org);
+			if (type->flags & PT_FRICTION)
+			{
+				p->vel[0] *= friction[0];
+				p->vel[1] *= friction[1];
+				p->vel[2] *= friction[2];
+			}
+			if (type->flurry && doflurry)
+			{	//these should probably be partially synced, 
+				p->vel[0] += crandom() * type->flurry;
+				p->vel[1] += crandom() * type->flurry;
+			}
+			p->vel[2] -= grav;
+		}
+
+		if (type->viewspacefrac)
+		{
+			Matrix4x4_CM_Transform3(viewtranslation, p->org, tmp);
+			VectorInterpolate(p->org, type->viewspacefrac, tmp, p->org);
+			Matrix4x4_CM_Transform3x3(viewtranslation, p->vel, tmp);
+			VectorInterpolate(p->vel, type->viewspacefrac, tmp, p->vel);
+		}
+
+		p->angle += p->rotationspeed*pframetime;
+
+		switch (type->rampmode)
+		{
+		case RAMP_NEAREST:
+			rampind = (int)(type->rampindexes * (type->die - (p->die - particletime)) / type->die);
+			if (rampind >= type->rampindexes)
+				rampind = type->rampindexes - 1;
+			ramp = type->ramp + rampind;
+			VectorCopy(ramp->rgb, p->rgba);
+			p->rgba[3] = ramp->alpha;
+			p->scale = ramp->scale;
+			break;
+		case RAMP_LERP:
+			frac = (type->rampindexes * (type->die - (p->die - particletime)) / type->die);
+			s1 = min(type->rampindexes-1, frac);
+			s2 = min(type->rampindexes-1, s1+1);
+			frac -= s1;
+			VectorInterpolate(type->ramp[s1].rgb, frac, type->ramp[s2].rgb, p->rgba);
+			FloatInterpolate(type->ramp[s1].alpha, frac, type->ramp[s2].alpha, p->rgba[3]);
+			FloatInterpolate(type->ramp[s1].scale, frac, type->ramp[s2].scale, p->scale);
+			break;
+		case RAMP_DELTA:	//particle ramps
+			rampind = (int)(type->rampindexes * (type->die - (p->die - particletime)) / type->die);
+			if (rampind >= type->rampindexes)
+				rampind = type->rampindexes - 1;
+			ramp = type->ramp + rampind;
+			VectorMA(p->rgba, pframetime, ramp->rgb, p->rgba);
+			p->rgba[3] -= pframetime*ramp->alpha;
+			p->scale += pframetime*ramp->scale;
+			break;
+		case RAMP_NONE:	//particle changes acording to it's preset properties.
+			if (particletime < (p->die-type->die+type->rgbchangetime))
+			{
+				p->rgba[0] += pframetime*type->rgbchange[0];
+				p->rgba[1] += pframetime*type->rgbchange[1];
+				p->rgba[2] += pframetime*type->rgbchange[2];
+			}
+			p->rgba[3] += pframetime*type->alphachange;
+			p->scale += pframetime*type->scaledelta;
+			break;
+		}
+	}
+}
+
+static void PScript_RunBatch(part_type_t *type, unsigned int batch, const float *viewtranslation, qboolean doflurry)
+{
+	unsigned int first = batch*PART_BATCHSIZE;
+	PScript_UpdateParticles(type, pbatch.p+first, pbatch.oldorg+first, min(PART_BATCHSIZE, pbatch.count-first), viewtranslation, doflurry);
+}
+#ifdef LOADERTHREAD
+typedef struct
+{
+	part_type_t *type;
+	const float *viewtranslation;
+	qboolean doflurry;
+	unsigned int numbatches;
+
+	volatile qatomic32_t nextbatch;
+	volatile qatomic32_t donebatches;
+	volatile qatomic32_t refs;	//the main thread plus any helpers that were queued. last one out frees it.
+} pbatchrunner_t;
+static void PScript_RunBatchJobs(pbatchrunner_t *r)
+{
+	unsigned int batch;
+	while ((batch = FTE_Atomic32_Inc(&r->nextbatch)-1) < r->numbatches)
+	{
+		PScript_RunBatch(r->type, batch, r->viewtranslation, r->doflurry);
+		FTE_Atomic32_Inc(&r->donebatches);
+	}
+}
+static void PScript_RunBatchHelper(void *ctx, void *data, size_t a, size_t b)
+{
+	pbatchrunner_t *r = ctx;
+	PScript_RunBatchJobs(r);
+	if (!FTE_Atomic32_Dec(&r->refs))
+		BZ_Free(r);
+}
+#endif
+//runs the physics for the particles gathered into pbatch.
+static void PScript_RunBatches(part_type_t *type, const float *viewtranslation, qboolean doflurry)
+{
+	unsigned int i, numbatches = (pbatch.count+PART_BATCHSIZE-1)/PART_BATCHSIZE;
+#ifdef LOADERTHREAD
+	pbatchrunner_t *r;
+	unsigned int helpers;
+
+	if (pbatch.count < PART_THREADMIN || (type->flurry && doflurry))
+		helpers = 0;	//not worth it, or needs rand() which isn't safe to call from the workers.
+	else
+		helpers = min(numbatches-1, COM_WorkerCount(WG_LOADER));
+	if (helpers)
+	{
+		r = BZ_Malloc(sizeof(*r));
+		r->type = type;
+		r->viewtranslation = viewtranslation;
+		r->doflurry = doflurry;
+		r->numbatches = numbatches;
+		r->nextbatch = 0;
+		r->donebatches = 0;
+		r->refs = 1+helpers;
+		//helpers go to the front of the queue, but if the workers are busy loading stuff then we'll just end up doing it all ourselves.
+		while (helpers-- > 0)
+			COM_InsertWork(WG_LOADER, PScript_RunBatchHelper, r, NULL, 0, 0);
+		PScript_RunBatchJobs(r);
+		while (r->donebatches < r->numbatches)
+			Sys_Sleep(0);
+		if (!FTE_Atomic32_Dec(&r->refs))
+			BZ_Free(r);
+		return;
+	}
+#endif
+	for (i = 0; i < numbatches; i++)
+		PScript_RunBatch(type, i, viewtranslation, doflurry);
+}
+
 static void PScript_DrawParticleTypes (void)
 {
 	float viewtranslation[16];
@@ -6909,8 +7085,6 @@ static void PScript_DrawParticleTypes (void)
 	particle_t		*p, *kill;
 	clippeddecal_t *d, *dkill;
 	ramp_t *ramp;
-	float grav;
-	vec3_t friction;
 	scenetris_t *scenetri;
 	float dist;
 	particle_t *kill_list, *kill_first;	//the kill list is to stop particles from being freed and reused whilst still in this loop
@@ -6925,6 +7099,7 @@ static void PScript_DrawParticleTypes (void)
 	qboolean doflurry;
 	int batchflags;
 	int i;
+	unsigned int j;
 	RSpeedMark();
 
 	if (r_plooksdirty)
@@ -7287,7 +7462,8 @@ static void PScript_DrawParticleTypes (void)
 			goto endtype;
 		}
 
-		//kill off early ones.
+		//kill off early ones, and gather up the rest for the physics.
+		pbatch.count = 0;
 		if (type->emittime < 0)
 		{
 			for ( ;; )
@@ -7324,11 +7500,6 @@ static void PScript_DrawParticleTypes (void)
 			}
 		}
 
-		grav = type->gravity*pframetime;
-		friction[0] = 1 - type->friction[0]*pframetime;
-		friction[1] = 1 - type->friction[1]*pframetime;
-		friction[2] = 1 - type->friction[2]*pframetime;
-
 		for (p=type->particles ; p ; p=p->next)
 		{
 			if (type->emittime < 0)
@@ -7366,80 +7537,15 @@ static void PScript_DrawParticleTypes (void)
 					break;
 				}
 			}
+			pbatch.p[pbatch.count++] = p;
+		}
 
-			VectorCopy(p->org, oldorg);
-			if (type->flags & PT_VELOCITY)
-			{
-				p->org[0] += p->vel[0]*pframetime;
-				p->org[1] += p->vel[1]*pframetime;
-				p->org[2] += p->vel[2]*pframetime;
-				if (type->flags & PT_FRICTION)
-				{
-					p->vel[0] *= friction[0];
-					p->vel[1] *= friction[1];
-					p->vel[2] *= friction[2];
-				}
-				if (type->flurry && doflurry)
-				{	//these should probably be partially synced, 
-					p->vel[0] += crandom() * type->flurry;
-					p->vel[1] += crandom() * type->flurry;
-				}
-				p->vel[2] -= grav;
-			}
-
-			if (type->viewspacefrac)
-			{
-				vec3_t tmp;
-				Matrix4x4_CM_Transform3(viewtranslation, p->org, tmp);
-				VectorInterpolate(p->org, type->viewspacefrac, tmp, p->org);
-				Matrix4x4_CM_Transform3x3(viewtranslation, p->vel, tmp);
-				VectorInterpolate(p->vel, type->viewspacefrac, tmp, p->vel);
-			}
-
-			p->angle += p->rotationspeed*pframetime;
+		PScript_RunBatches(type, viewtranslation, doflurry);
 
-			switch (type->rampmode)
-			{
-			case RAMP_NEAREST:
-				rampind = (int)(type->rampindexes * (type->die - (p->die - particletime)) / type->die);
-				if (rampind >= type->rampindexes)
-					rampind = type->rampindexes - 1;
-				ramp = type->ramp + rampind;
-				VectorCopy(ramp->rgb, p->rgba);
-				p->rgba[3] = ramp->alpha;
-				p->scale = ramp->scale;
-				break;
-			case RAMP_LERP:
-				{
-					float frac = (type->rampindexes * (type->die - (p->die - particletime)) / type->die);
-					int s1, s2;
-					s1 = min(type->rampindexes-1, frac);
-					s2 = min(type->rampindexes-1, s1+1);
-					frac -= s1;
-					VectorInterpolate(type->ramp[s1].rgb, frac, type->ramp[s2].rgb, p->rgba);
-					FloatInterpolate(type->ramp[s1].alpha, frac, type->ramp[s2].alpha, p->rgba[3]);
-					FloatInterpolate(type->ramp[s1].scale, frac, type->ramp[s2].scale, p->scale);
-				}
-				break;
-			case RAMP_DELTA:	//particle ramps
-				rampind = (int)(type->rampindexes * (type->die - (p->die - particletime)) / type->die);
-				if (rampind >= type->rampindexes)
-					rampind = type->rampindexes - 1;
-				ramp = type->ramp + rampind;
-				VectorMA(p->rgba, pframetime, ramp->rgb, p->rgba);
-				p->rgba[3] -= pframetime*ramp->alpha;
-				p->scale += pframetime*ramp->scale;
-				break;
-			case RAMP_NONE:	//particle changes acording to it's preset properties.
-				if (particletime < (p->die-type->die+type->rgbchangetime))
-				{
-					p->rgba[0] += pframetime*type->rgbchange[0];
-					p->rgba[1] += pframetime*type->rgbchange[1];
-					p->rgba[2] += pframetime*type->rgbchange[2];
-				}
-				p->rgba[3] += pframetime*type->alphachange;
-				p->scale += pframetime*type->scaledelta;
-			}
+		for (j = 0; j < pbatch.count; j++)
+		{
+			p = pbatch.p[j];
+			VectorCopy(pbatch.oldorg[j], oldorg);
 
 			if (type->emit >= 0)
 			{
@@ -7458,7 +7564,7 @@ static void PScript_DrawParticleTypes (void)
 				if (DotProduct(stop,stop) > 10*10)
 				{
 					int e;
-					if (traces-->0&&CL_TraceLine(p->oldorg, p->org, stop, normal, &e)<1)
+					if (!CL_TraceLineIsClear(p->oldorg, p->org) && traces-->0&&CL_TraceLine(p->oldorg, p->org, stop, normal, &e)<1)
 					{
 						if (type->stainonimpact && r_bloodstains.value)
 							Surf_AddStain(stop,	p->rgba[1]*-10+p->rgba[2]*-10,
@@ -7557,7 +7663,7 @@ static void PScript_DrawParticleTypes (void)
 				VectorSubtract(p->org, p->oldorg, stop);
 				if (DotProduct(stop,stop) > 10*10)
 				{
-					if (traces-->0&&CL_TraceLine(p->oldorg, p->org, stop, normal, NULL)<1)
+					if (!CL_TraceLineIsClear(p->oldorg, p->org) && traces-->0&&CL_TraceLine(p->oldorg, p->org, stop, normal, NULL)<1)
 					{
 						if (type->stainonimpact < 0)
 							Surf_AddStain(stop,	(p->rgba[0]*-1),
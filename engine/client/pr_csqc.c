@@ -417,6 +417,8 @@ typedef struct csqcedict_s
 #ifdef USEAREAGRID
 	areagridlink_t	gridareas[AREAGRIDPERENT];	//on overflow, use the inefficient overflow list.
 	size_t			gridareasequence;	//used to avoid iterrating the same ent twice.
+	struct areabvh_s *areabvh;		//the tree we're linked into when using the bvh instead of the grid.
+	int				areabvhleaf;
 #else
 	link_t	area;
 #endif
@@ -6874,6 +6876,7 @@ static struct {
 	{"findradius",				PF_findradius,	22},		// #22 entity(vector org, float rad) findradius (QUAKE)
 #ifdef QCGC
 	{"findradius_list",			PF_findradius_list, 0},
+	{"tracebox_list",			PF_tracebox_list, 0},
 	{"find_list",				PF_FindList,			0},
 #endif
 	{"bprint",					PF_NoCSQC,	23},				// #23 void(string s, ...) bprint (QUAKE) (don't support)
@@ -8293,6 +8296,10 @@ qboolean CSQC_Init (qboolean anycsqc, const char *csprogsname, unsigned int chec
 #ifdef MULTITHREAD
 	csqcprogparms.usethreadedgc = pr_gc_threaded.ival;
 #endif
+#ifdef QCJIT
+	csqcprogparms.usejit = pr_jit.ival;
+	csqcprogparms.usethreadedcode = pr_threadedcode.ival;
+#endif
 
 	csqcprogparms.edicts = (struct edict_s **)&csqc_world.edicts;
 	csqcprogparms.num_edicts = &csqc_world.num_edicts;
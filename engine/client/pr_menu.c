@@ -3089,6 +3089,10 @@ qboolean MP_Init (void)
 #ifdef MULTITHREAD
 	menuprogparms.usethreadedgc = pr_gc_threaded.ival;
 #endif
+#ifdef QCJIT
+	menuprogparms.usejit = pr_jit.ival;
+	menuprogparms.usethreadedcode = pr_threadedcode.ival;
+#endif
 
 	menuprogparms.edicts = (struct edict_s **)&menu_edicts;
 	menuprogparms.num_edicts = &num_menu_edicts;
@@ -371,6 +371,7 @@ qboolean COM_DoWork(int thread, qboolean leavelocked);
 void COM_AddWork(wgroup_t thread, void(*func)(void *ctx, void *data, size_t a, size_t b), void *ctx, void *data, size_t a, size_t b);	//low priority
 void COM_InsertWork(wgroup_t tg, void(*func)(void *ctx, void *data, size_t a, size_t b), void *ctx, void *data, size_t a, size_t b);	//high priority
 qboolean COM_HasWork(void);
+int COM_WorkerCount(wgroup_t tg);
 void COM_WorkerFullSync(void);
 void COM_WorkerLock(void);	//callable on main thread to temporarily suspend workers (in a safe location)
 void COM_WorkerUnlock(void);
@@ -392,6 +393,7 @@ void COM_AssertMainThread(const char *msg);
 #define COM_WorkerLock()
 #define COM_WorkerUnlock()
 #define COM_HasWork() false
+#define COM_WorkerCount(t) 0
 #define COM_DoWork(t,l) false
 #define COM_AssertMainThread(msg)
 #define COM_MainThreadWork() while(0)
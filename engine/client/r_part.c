@@ -886,6 +886,91 @@ entity_t *TraceLineR (vec3_t start, vec3_t end, vec3_t impact, vec3_t normal, qb
 	return result;
 }
 
+//particles spend most of their time in open space, where tracing them is a waste of time.
+//a q1bsp leaf is convex, so if both ends of a line are in the same non-solid leaf then the line can't hit the world, and if nothing else solid overlaps that leaf then it can't hit anything else either.
+//whether each leaf is clear of entities is worked out the first time a particle asks about it each frame, so particles in the same leaf share the answer.
+static struct
+{
+	model_t *model;
+	int numleafs;
+	int *framecount;	//cls.framecount when this leaf was last checked
+	qbyte *clear;
+} cl_leafcache;
+static qboolean CL_LeafIsClear(model_t *mod, int leafnum)
+{
+	mleaf_t *leaf;
+	physent_t *pe;
+	vec3_t mins, maxs;
+	float rad;
+	int i;
+
+	if (cl_leafcache.model != mod || cl_leafcache.numleafs != mod->numleafs)
+	{
+		BZ_Free(cl_leafcache.framecount);
+		cl_leafcache.model = mod;
+		cl_leafcache.numleafs = mod->numleafs;
+		cl_leafcache.framecount = BZ_Malloc((mod->numleafs+1) * (sizeof(*cl_leafcache.framecount)+sizeof(*cl_leafcache.clear)));
+		cl_leafcache.clear = (qbyte*)(cl_leafcache.framecount + mod->numleafs+1);
+		for (i = 0; i <= mod->numleafs; i++)
+			cl_leafcache.framecount[i] = cls.framecount-1;
+	}
+	if (cl_leafcache.framecount[leafnum] == cls.framecount)
+		return cl_leafcache.clear[leafnum];
+	cl_leafcache.framecount[leafnum] = cls.framecount;
+	cl_leafcache.clear[leafnum] = false;
+
+	leaf = mod->leafs + leafnum;
+	for (i = 1; i < pmove.numphysent; i++)
+	{
+		pe = &pmove.physents[i];
+		if (pe->nonsolid || !pe->model || pe->model->loadstate != MLS_LOADED || !pe->model->funcs.NativeTrace)
+			continue;
+		if (pe->angles[0] || pe->angles[1] || pe->angles[2])
+		{
+			rad = RadiusFromBounds(pe->model->mins, pe->model->maxs);
+			VectorSet(mins, pe->origin[0]-rad, pe->origin[1]-rad, pe->origin[2]-rad);
+			VectorSet(maxs, pe->origin[0]+rad, pe->origin[1]+rad, pe->origin[2]+rad);
+		}
+		else
+		{
+			VectorAdd(pe->origin, pe->model->mins, mins);
+			VectorAdd(pe->origin, pe->model->maxs, maxs);
+		}
+		//leaf bounds are only accurate to the nearest unit, so be a little generous.
+		if (mins[0] <= leaf->minmaxs[3]+1 && maxs[0] >= leaf->minmaxs[0]-1 &&
+			mins[1] <= leaf->minmaxs[4]+1 && maxs[1] >= leaf->minmaxs[1]-1 &&
+			mins[2] <= leaf->minmaxs[5]+1 && maxs[2] >= leaf->minmaxs[2]-1)
+			return false;	//something might be in the way
+	}
+	cl_leafcache.clear[leafnum] = true;
+	return true;
+}
+
+//returns true if CL_TraceLine between these points would definitely not hit anything. false means you need to trace it.
+qboolean CL_TraceLineIsClear (vec3_t start, vec3_t end)
+{
+	model_t *mod = cl.worldmodel;
+	int area, startleaf, endleaf;
+	unsigned int contents;
+#ifdef CSQC_DAT
+	extern world_t csqc_world;
+	if (csqc_world.progs)
+		return false;	//csqc's solid entities aren't in the physents.
+#endif
+	if (!mod || mod->loadstate != MLS_LOADED || (mod->fromgame != fg_quake && mod->fromgame != fg_halflife) || mod->terrain || !mod->funcs.InfoForPoint)
+		return false;	//other formats don't have convex leafs, or have other stuff to hit.
+	if (pmove.numphysent < 1 || pmove.physents[0].model != mod)
+		return false;
+
+	mod->funcs.InfoForPoint(mod, end, &area, &endleaf, &contents);
+	if (contents & MASK_WORLDSOLID)
+		return false;
+	mod->funcs.InfoForPoint(mod, start, &area, &startleaf, &contents);
+	if (startleaf != endleaf || endleaf < 0 || endleaf >= mod->numleafs)
+		return false;
+	return CL_LeafIsClear(mod, endleaf+1);
+}
+
 #include "pr_common.h"
 //traces against networked entities only.
 float CL_TraceLine (vec3_t start, vec3_t end, vec3_t impact, vec3_t normal, int *ent)
@@ -921,6 +1006,8 @@ float CL_TraceLine (vec3_t start, vec3_t end, vec3_t impact, vec3_t normal, int
 		model_t *mod;
 		int result=0;
 		vec3_t axis[3];
+		vec3_t linemins, linemaxs;
+		float rad;
 
 		memset (&trace, 0, sizeof(trace));
 
@@ -928,6 +1015,12 @@ float CL_TraceLine (vec3_t start, vec3_t end, vec3_t impact, vec3_t normal, int
 		if (normal)
 			VectorClear(normal);
 
+		for (i = 0; i < 3; i++)
+		{
+			linemins[i] = min(start[i], end[i]) - 1;
+			linemaxs[i] = max(start[i], end[i]) + 1;
+		}
+
 		for (i=0 ; i < pmove.numphysent ; i++)
 		{
 			pe = &pmove.physents[i];
@@ -936,6 +1029,21 @@ float CL_TraceLine (vec3_t start, vec3_t end, vec3_t impact, vec3_t normal, int
 			mod = pe->model;
 			if (mod && mod->loadstate == MLS_LOADED && mod->funcs.NativeTrace)
 			{
+				if (i && mod->type == mod_brush)
+				{	//don't bother tracing against doors etc that aren't anywhere near the line (the world is always traced, as its outside is solid).
+					if (pe->angles[0] || pe->angles[1] || pe->angles[2])
+					{
+						rad = RadiusFromBounds(mod->mins, mod->maxs);
+						if (pe->origin[0]-rad > linemaxs[0] || pe->origin[0]+rad < linemins[0] ||
+							pe->origin[1]-rad > linemaxs[1] || pe->origin[1]+rad < linemins[1] ||
+							pe->origin[2]-rad > linemaxs[2] || pe->origin[2]+rad < linemins[2])
+							continue;
+					}
+					else if (pe->origin[0]+mod->mins[0] > linemaxs[0] || pe->origin[0]+mod->maxs[0] < linemins[0] ||
+							 pe->origin[1]+mod->mins[1] > linemaxs[1] || pe->origin[1]+mod->maxs[1] < linemins[1] ||
+							 pe->origin[2]+mod->mins[2] > linemaxs[2] || pe->origin[2]+mod->maxs[2] < linemins[2])
+						continue;
+				}
 				VectorSubtract(start, pe->origin, ts);
 				VectorSubtract(end, pe->origin, te);
 				if (pe->angles[0] || pe->angles[1] || pe->angles[2])
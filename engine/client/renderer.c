@@ -322,6 +322,7 @@ cvar_t	r_stereo_method						= CVARFD("r_stereo_method", "0", CVAR_ARCHIVE, "Valu
 extern cvar_t r_dodgytgafiles;
 extern cvar_t r_dodgypcxfiles;
 extern cvar_t r_keepimages;
+extern cvar_t r_imagecache;
 extern cvar_t r_ignoremapprefixes;
 extern cvar_t r_dodgymiptex;
 extern char *r_defaultimageextensions;
@@ -816,6 +817,7 @@ void Renderer_Init(void)
 
 	Cvar_Register(&r_keepimages, GRAPHICALNICETIES);
 	Cvar_Register(&r_ignoremapprefixes, GRAPHICALNICETIES);
+	Cvar_Register(&r_imagecache, GRAPHICALNICETIES);
 	Cvar_ForceCallback(&r_keepimages);
 	Cvar_ForceCallback(&r_ignoremapprefixes);
 #ifdef IMAGEFMT_TGA
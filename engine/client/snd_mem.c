@@ -974,7 +974,7 @@ static void S_LoadSoundWorker (void *ctx, void *ctxdata, size_t forcedecode, siz
 			else
 				Q_snprintfz(namebuffer, sizeof(namebuffer), "%s%s", prefixes[pre], name);
 
-			data = FS_LoadMallocFile(namebuffer, &filesize);
+			data = FS_LoadMappedFile(namebuffer, &filesize, false);
 			if (data)
 				break;
 			COM_FileExtension(namebuffer, orig, sizeof(orig));
@@ -984,7 +984,7 @@ static void S_LoadSoundWorker (void *ctx, void *ctxdata, size_t forcedecode, siz
 				if (!strcmp(orig, extensions[ex]+1))
 					continue;
 				Q_snprintfz(namebuffer, sizeof(namebuffer), "%s%s", altname, extensions[ex]);
-				data = FS_LoadMallocFile(namebuffer, &filesize);
+				data = FS_LoadMappedFile(namebuffer, &filesize, false);
 				if (data)
 				{
 					static float throttletimer;
@@ -996,7 +996,7 @@ static void S_LoadSoundWorker (void *ctx, void *ctxdata, size_t forcedecode, siz
 
 		if (data && !Ruleset_FileLoaded(name, data, filesize))
 		{
-			BZ_Free(data);
+			FS_FreeFile(data);
 			data = NULL;
 			filesize = 0;
 		}
@@ -1021,7 +1021,7 @@ static void S_LoadSoundWorker (void *ctx, void *ctxdata, size_t forcedecode, siz
 			{
 				//wake up the main thread in case it decided to wait for us.
 				COM_AddWork(WG_MAIN, S_LoadedOrFailed, s, NULL, SLS_LOADED, 0);
-				BZ_Free(data);
+				FS_FreeFile(data);
 				return;
 			}
 		}
@@ -1031,7 +1031,7 @@ static void S_LoadSoundWorker (void *ctx, void *ctxdata, size_t forcedecode, siz
 		Con_Printf ("Format not recognised: %s\n", namebuffer);
 
 	COM_AddWork(WG_MAIN, S_LoadedOrFailed, s, NULL, SLS_FAILED, 0);
-	BZ_Free(data);
+	FS_FreeFile(data);
 	return;
 }
 
@@ -23,159 +23,186 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #ifdef HAVE_MIXER
 
-
-//#define MIXER_PAINT_F32
-#ifdef MIXER_PAINT_F32
-	#define MIX_16_8(val) ((val)/(float)(1<<(15+8)))
-	#define MIX_8_8(val) ((val)/(float)(1<<(7+8)))
-	typedef struct {
-		float s[MAXSOUNDCHANNELS];
-	} portable_samplegroup_t;
-#else
-	#define MIX_16_8(val) ((val)>>8)	//value is a 16bit*8bit value (audio*vol) value. discard the lower 8 bits to treat the volume as a fraction
-	#define MIX_8_8(val) (val)	//value is a 8bit*8bit value (audio*vol) value. result is 16bit.
-
-	typedef struct {
-		int s[MAXSOUNDCHANNELS];	//signed, 1=0x7fff ish. will be clamped to allow oversaturation
-	} portable_samplegroup_t;
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define MIXER_SSE2	//sse2 is part of the baseline on x86_64, so there's nothing to detect.
 #endif
 
 #define	PAINTBUFFER_SIZE	2048
 
-static portable_samplegroup_t paintbuffer[PAINTBUFFER_SIZE];	//FIXME: we really ought to be using SSE and floats or something.
+//all mixing is done in float, one plane per output channel, so that each output can be mixed several samples at a time.
+//1 is full volume, values outside of -1...1 will be clipped when the buffer is transfered.
+static float paintbuffer[MAXSOUNDCHANNELS][PAINTBUFFER_SIZE];
+//the current channel's source samples, after conversion to float and resampling to the output rate.
+static float mixsamples[2][PAINTBUFFER_SIZE];
 
-void S_TransferPaintBuffer(soundcardinfo_t *sc, int endtime)
-{
-	unsigned int 	out_idx;
-	unsigned int 	count;
-	unsigned int 	outlimit;
-#ifdef MIXER_PAINT_F32
-	float 			*p = (float *fte_restrict)paintbuffer;
-#else
-	int 			*p = (int *fte_restrict) paintbuffer;
-#endif
-	int				val;
-//	int				snd_vol;
-	void			*pbuf;
-	int				i, numc;
+/*
+===============================================================================
 
-	count = (endtime - sc->paintedtime) * sc->sn.numchannels;
-	outlimit = sc->sn.samples;
-	out_idx = (sc->paintedtime * sc->sn.numchannels) % outlimit;
-//	snd_vol = (volume.value*voicevolumemod)*256;
-	numc = sc->sn.numchannels;
+OUTPUT CONVERSION
 
-	pbuf = sc->Lock(sc, &out_idx);
-	if (!pbuf)
-		return;
+===============================================================================
+*/
 
-	switch(sc->sn.sampleformat)
+//writes a single sample. slow, but only needed if a frame straddles the end of the ring buffer.
+static void SND_TransferSample(int sampleformat, void *out, unsigned int idx, float v)
+{
+	int val;
+	switch(sampleformat)
 	{
-	case QSF_INVALID:	//erk...
-	case QSF_EXTERNALMIXER:	//shouldn't reach this.
+	case QSF_U8:
+		val = v*128+128;
+		((unsigned char*)out)[idx] = bound(0, val, 255);
+		break;
+	case QSF_S8:
+		val = v*128;
+		((signed char*)out)[idx] = bound(-128, val, 127);
 		break;
+	case QSF_S16:
+		val = v*32768;
+		((signed short*)out)[idx] = bound(-32768, val, 32767);
+		break;
+	case QSF_F32:
+		((float*)out)[idx] = v;
+		break;
+	}
+}
+
+//interleaves+clips count frames from the paintbuffer, starting at frame 'first', into one contiguous run of the output.
+static void SND_TransferFrames(int sampleformat, void *pbuf, unsigned int first, unsigned int count, unsigned int numc)
+{
+	unsigned int i, c;
+	int val;
+	switch(sampleformat)
+	{
 	case QSF_U8:
 		{
-			unsigned char *out = (unsigned char *) pbuf;
-			while (count)
-			{
-				for (i = 0; i < numc; i++)
+			unsigned char *out = pbuf;
+			for (i = 0; i < count; i++)
+				for (c = 0; c < numc; c++)
 				{
-#ifdef MIXER_PAINT_F32
-					val = (*p++ + 1)*128;
-					if (val > 255)
-						val = 255;
-					else if (val < 0)
-						val = 0;
-					out[out_idx] = val;
-#else
-					val = *p++;
-					if (val > 0x7fff)
-						val = 0x7fff;
-					else if (val < (short)0x8000)
-						val = (short)0x8000;
-					out[out_idx] = (val>>8) + 128;
-#endif
-					out_idx = (out_idx + 1) % outlimit;
+					val = paintbuffer[c][first+i]*128+128;
+					*out++ = bound(0, val, 255);
 				}
-				p += MAXSOUNDCHANNELS - numc;
-				count -= numc;
-			}
 		}
 		break;
 	case QSF_S8:
 		{
-			char *out = (char *) pbuf;
-			while (count)
-			{
-				for (i = 0; i < numc; i++)
+			signed char *out = pbuf;
+			for (i = 0; i < count; i++)
+				for (c = 0; c < numc; c++)
 				{
-#ifdef MIXER_PAINT_F32
-					val = *p++*128;
-					if (val > 127)
-						val = 127;
-					else if (val < -128)
-						val = -128;
-					out[out_idx] = val;
-#else
-					val = *p++;
-					if (val > 0x7fff)
-						val = 0x7fff;
-					else if (val < (short)0x8000)
-						val = (short)0x8000;
-					out[out_idx] = (val>>8);
-#endif
-					out_idx = (out_idx + 1) % outlimit;
+					val = paintbuffer[c][first+i]*128;
+					*out++ = bound(-128, val, 127);
 				}
-				p += MAXSOUNDCHANNELS - numc;
-				count -= numc;
-			}
 		}
 		break;
 	case QSF_S16:
 		{
-			short *out = (short *) pbuf;
-			while (count)
+			signed short *out = pbuf;
+			i = 0;
+#ifdef MIXER_SSE2
+			//the saturating pack does the clipping for us.
+			if (numc == 2)
 			{
-				for (i = 0; i < numc; i++)
+				const float *fte_restrict l = paintbuffer[0]+first, *fte_restrict r = paintbuffer[1]+first;
+				const __m128 scale = _mm_set1_ps(32768);
+				__m128i li, ri;
+				for (; i+4 <= count; i += 4, out += 8)
 				{
-#ifdef MIXER_PAINT_F32
-					val = *p++*0x7fff;
-#else
-					val = *p++;
-#endif
-					if (val > 0x7fff)
-						val = 0x7fff;
-					else if (val < (short)0x8000)
-						val = (short)0x8000;
-					out[out_idx] = val;
-					out_idx = (out_idx + 1) % outlimit;
+					li = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(l+i), scale));
+					ri = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(r+i), scale));
+					_mm_storeu_si128((__m128i*)out, _mm_packs_epi32(_mm_unpacklo_epi32(li, ri), _mm_unpackhi_epi32(li, ri)));
 				}
-				p += MAXSOUNDCHANNELS - numc;
-				count -= numc;
 			}
+			else if (numc == 1)
+			{
+				const float *fte_restrict m = paintbuffer[0]+first;
+				const __m128 scale = _mm_set1_ps(32768);
+				for (; i+8 <= count; i += 8, out += 8)
+					_mm_storeu_si128((__m128i*)out, _mm_packs_epi32(_mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(m+i), scale)), _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(m+i+4), scale))));
+			}
+#endif
+			for (; i < count; i++)
+				for (c = 0; c < numc; c++)
+				{
+					val = paintbuffer[c][first+i]*32768;
+					*out++ = bound(-32768, val, 32767);
+				}
 		}
 		break;
 	case QSF_F32:
-		{
-			float *out = (float *) pbuf;
-			while (count)
+		{	//no clipping needed here, the mixer will do that if it needs to.
+			float *out = pbuf;
+			i = 0;
+#ifdef MIXER_SSE2
+			if (numc == 2)
 			{
-				for (i = 0; i < numc; i++)
+				const float *fte_restrict l = paintbuffer[0]+first, *fte_restrict r = paintbuffer[1]+first;
+				__m128 lv, rv;
+				for (; i+4 <= count; i += 4, out += 8)
 				{
-#ifdef MIXER_PAINT_F32	//FIXME: replace with a memcpy.
-					out[out_idx] = *p++;
-#else
-					out[out_idx] = *p++ * (1.0 / 32768);
-#endif
-					out_idx = (out_idx + 1) % outlimit;
+					lv = _mm_loadu_ps(l+i);
+					rv = _mm_loadu_ps(r+i);
+					_mm_storeu_ps(out+0, _mm_unpacklo_ps(lv, rv));
+					_mm_storeu_ps(out+4, _mm_unpackhi_ps(lv, rv));
 				}
-				p += MAXSOUNDCHANNELS - numc;
-				count -= numc;
 			}
+#endif
+			for (; i < count; i++)
+				for (c = 0; c < numc; c++)
+					*out++ = paintbuffer[c][first+i];
 		}
 		break;
 	}
+}
+
+void S_TransferPaintBuffer(soundcardinfo_t *sc, int endtime)
+{
+	unsigned int 	out_idx;
+	unsigned int 	count;
+	unsigned int 	outlimit;
+	unsigned int	frame, run;
+	void			*pbuf;
+	unsigned int	c, numc;
+	int				samplebytes;
+
+	count = endtime - sc->paintedtime;
+	outlimit = sc->sn.samples;
+	numc = sc->sn.numchannels;
+	out_idx = (sc->paintedtime * numc) % outlimit;
+
+	pbuf = sc->Lock(sc, &out_idx);
+	if (!pbuf)
+		return;
+
+	switch(sc->sn.sampleformat)
+	{
+	case QSF_U8:
+	case QSF_S8:	samplebytes = 1;	break;
+	case QSF_S16:	samplebytes = 2;	break;
+	case QSF_F32:	samplebytes = 4;	break;
+	case QSF_INVALID:	//erk...
+	case QSF_EXTERNALMIXER:	//shouldn't reach this.
+	default:
+		sc->Unlock(sc, pbuf);
+		return;
+	}
+
+	//the output is a ring buffer, so convert it in runs up to the point where it wraps.
+	for (frame = 0; frame < count; frame += run)
+	{
+		run = min(count - frame, (outlimit - out_idx) / numc);
+		if (!run)
+		{	//this frame straddles the end of the buffer
+			for (c = 0; c < numc; c++, out_idx = (out_idx + 1) % outlimit)
+				SND_TransferSample(sc->sn.sampleformat, pbuf, out_idx, paintbuffer[c][frame]);
+			run = 1;
+			continue;
+		}
+		SND_TransferFrames(sc->sn.sampleformat, (qbyte*)pbuf + out_idx*samplebytes, frame, run, numc);
+		out_idx = (out_idx + run*numc) % outlimit;
+	}
 
 	sc->Unlock(sc, pbuf);
 }
@@ -189,24 +216,112 @@ CHANNEL MIXING
 ===============================================================================
 */
 
-static void SND_PaintChannel8_O2I1	(channel_t *ch, sfxcache_t *sc, int starttime, int count, int rate);
-static void SND_PaintChannel16_O2I1	(channel_t *ch, sfxcache_t *sc, int starttime, int count, int rate);
-static void SND_PaintChannel8_O4I1	(channel_t *ch, sfxcache_t *sc, int count, int rate);
-static void SND_PaintChannel16_O4I1	(channel_t *ch, sfxcache_t *sc, int count, int rate);
-static void SND_PaintChannel8_O6I1	(channel_t *ch, sfxcache_t *sc, int count, int rate);
-static void SND_PaintChannel16_O6I1	(channel_t *ch, sfxcache_t *sc, int count, int rate);
-static void SND_PaintChannel8_O8I1	(channel_t *ch, sfxcache_t *sc, int count, int rate);
-static void SND_PaintChannel16_O8I1	(channel_t *ch, sfxcache_t *sc, int count, int rate);
-static void SND_PaintChannel8_O2I2	(channel_t *ch, sfxcache_t *sc, int starttime, int count, int rate);
-static void SND_PaintChannel16_O2I2	(channel_t *ch, sfxcache_t *sc, int starttime, int count, int rate);
+//expands 16bit samples to float without any resampling, which is the common case.
+static void SND_ConvertS16(float *fte_restrict out, const signed short *fte_restrict in, int count)
+{
+	int i = 0;
+#ifdef MIXER_SSE2
+	const __m128 scale = _mm_set1_ps(1.0f/32768);
+	__m128i s;
+	for (; i+8 <= count; i += 8)
+	{
+		s = _mm_loadu_si128((const __m128i*)(in+i));
+		_mm_storeu_ps(out+i+0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16)), scale));
+		_mm_storeu_ps(out+i+4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16)), scale));
+	}
+#endif
+	for (; i < count; i++)
+		out[i] = in[i] * (1.0f/32768);
+}
 
+//converts a channel's source data to floats in mixsamples, resampling as needed.
+//stereo sounds use nearest sampling, mono sounds are linearly interpolated.
+#define SND_RESAMPLE(type,scale)																						\
+	do {																												\
+		const type *fte_restrict sfx = (const type *)sc->data;															\
+		if (sc->numchannels == 2)																						\
+		{																												\
+			for (i = 0; i < count; i++, pos += rate)																	\
+			{																											\
+				mixsamples[0][i] = sfx[(pos>>(PITCHSHIFT-1))&~1] * (scale);												\
+				mixsamples[1][i] = sfx[(pos>>(PITCHSHIFT-1))|1] * (scale);												\
+			}																											\
+		}																												\
+		else if (rate == (1<<PITCHSHIFT))																				\
+		{																												\
+			sfx += pos>>PITCHSHIFT;																						\
+			for (i = 0; i < count; i++)																					\
+				mixsamples[0][i] = sfx[i] * (scale);																	\
+		}																												\
+		else																											\
+		{																												\
+			for (i = 0; i < count; i++, pos += rate)																	\
+			{																											\
+				int frac = pos&((1<<PITCHSHIFT)-1);																		\
+				mixsamples[0][i] = (sfx[pos>>PITCHSHIFT]*(float)((1<<PITCHSHIFT)-frac) + sfx[(pos>>PITCHSHIFT)+1]*(float)frac) * ((scale)/(1<<PITCHSHIFT));	\
+			}																											\
+		}																												\
+	} while(0)
+static qboolean SND_ResampleChannel(channel_t *ch, sfxcache_t *sc, int count, int rate)
+{
+	unsigned int pos = ch->pos-(sc->soundoffset<<PITCHSHIFT);
+	int i;
+
+	switch(sc->format)
+	{
+	case QAF_S8:
+		SND_RESAMPLE(signed char, 1.0f/128);
+		return true;
+	case QAF_S16:
+		if (sc->numchannels == 1 && rate == (1<<PITCHSHIFT))
+			SND_ConvertS16(mixsamples[0], (const signed short *)sc->data + (pos>>PITCHSHIFT), count);
+		else
+			SND_RESAMPLE(signed short, 1.0f/32768);
+		return true;
 #ifdef MIXER_F32
-static void SND_PaintChannel32F_O2I1(channel_t *ch, sfxcache_t *sc, int starttime, int count, int rate);
-static void SND_PaintChannel32F_O4I1(channel_t *ch, sfxcache_t *sc, int count, int rate);
-static void SND_PaintChannel32F_O6I1(channel_t *ch, sfxcache_t *sc, int count, int rate);
-static void SND_PaintChannel32F_O8I1(channel_t *ch, sfxcache_t *sc, int count, int rate);
-static void SND_PaintChannel32F_O2I2(channel_t *ch, sfxcache_t *sc, int starttime, int count, int rate);
+	case QAF_F32:
+		SND_RESAMPLE(float, 1.0f);
+		return true;
 #endif
+	default:
+		return false;
+	}
+}
+
+//out += in*vol
+static void SND_AccumulateSamples(float *fte_restrict out, const float *fte_restrict in, float vol, int count)
+{
+	int i = 0;
+#ifdef MIXER_SSE2
+	const __m128 v = _mm_set1_ps(vol);
+	for (; i+4 <= count; i += 4)
+		_mm_storeu_ps(out+i, _mm_add_ps(_mm_loadu_ps(out+i), _mm_mul_ps(_mm_loadu_ps(in+i), v)));
+#endif
+	for (; i < count; i++)
+		out[i] += in[i]*vol;
+}
+
+static void SND_PaintChannel(channel_t *ch, sfxcache_t *sc, int starttime, int count, int rate, int numc)
+{
+	int c;
+
+	if (!SND_ResampleChannel(ch, sc, count, rate))
+		return;
+
+	if (sc->numchannels == 2)
+	{	//stereo sounds only go to the front speakers.
+		if (ch->vol[0])
+			SND_AccumulateSamples(paintbuffer[0]+starttime, mixsamples[0], ch->vol[0]*(1.0f/256), count);
+		if (ch->vol[1] && numc > 1)
+			SND_AccumulateSamples(paintbuffer[1]+starttime, mixsamples[1], ch->vol[1]*(1.0f/256), count);
+	}
+	else
+	{
+		for (c = 0; c < numc; c++)
+			if (ch->vol[c])
+				SND_AccumulateSamples(paintbuffer[c]+starttime, mixsamples[0], ch->vol[c]*(1.0f/256), count);
+	}
+}
 
 //NOTE: MAY NOT CALL SYS_ERROR
 void S_PaintChannels(soundcardinfo_t *sc, int endtime)
@@ -230,7 +345,8 @@ void S_PaintChannels(soundcardinfo_t *sc, int endtime)
 			end = sc->paintedtime + PAINTBUFFER_SIZE;
 
 	// clear the paint buffer
-		Q_memset(paintbuffer, 0, (end - sc->paintedtime) * sizeof(portable_samplegroup_t));
+		for (i = 0; i < sc->sn.numchannels; i++)
+			Q_memset(paintbuffer[i], 0, (end - sc->paintedtime) * sizeof(*paintbuffer[i]));
 
 	// paint in the channels.
 		ch = sc->channel;
@@ -354,51 +470,7 @@ void S_PaintChannels(soundcardinfo_t *sc, int endtime)
 						continue;
 					}
 
-					switch(scache->format)
-					{
-					case QAF_S8:
-						if (scache->numchannels==2)
-							SND_PaintChannel8_O2I2(ch, scache, ltime-sc->paintedtime, count, rate);
-						else if (sc->sn.numchannels <= 2)
-							SND_PaintChannel8_O2I1(ch, scache, ltime-sc->paintedtime, count, rate);
-						else if (sc->sn.numchannels <= 4)
-							SND_PaintChannel8_O4I1(ch, scache, count, rate);
-						else if (sc->sn.numchannels <= 6)
-							SND_PaintChannel8_O6I1(ch, scache, count, rate);
-						else
-							SND_PaintChannel8_O8I1(ch, scache, count, rate);
-						break;
-					case QAF_S16:
-						if (scache->numchannels==2)
-							SND_PaintChannel16_O2I2(ch, scache, ltime-sc->paintedtime, count, rate);
-						else if (sc->sn.numchannels <= 2)
-							SND_PaintChannel16_O2I1(ch, scache, ltime-sc->paintedtime, count, rate);
-						else if (sc->sn.numchannels <= 4)
-							SND_PaintChannel16_O4I1(ch, scache, count, rate);
-						else if (sc->sn.numchannels <= 6)
-							SND_PaintChannel16_O6I1(ch, scache, count, rate);
-						else
-							SND_PaintChannel16_O8I1(ch, scache, count, rate);
-						break;
-#ifdef MIXER_F32
-					case QAF_F32:
-						if (scache->numchannels==2)
-							SND_PaintChannel32F_O2I2(ch, scache, ltime-sc->paintedtime, count, rate);
-						else if (sc->sn.numchannels <= 2)
-							SND_PaintChannel32F_O2I1(ch, scache, ltime-sc->paintedtime, count, rate);
-						else if (sc->sn.numchannels <= 4)
-							SND_PaintChannel32F_O4I1(ch, scache, count, rate);
-						else if (sc->sn.numchannels <= 6)
-							SND_PaintChannel32F_O6I1(ch, scache, count, rate);
-						else
-							SND_PaintChannel32F_O8I1(ch, scache, count, rate);
-						break;
-#endif
-#ifdef FTE_TARGET_WEB
-					case QAF_BLOB:
-						break;
-#endif
-					}
+					SND_PaintChannel(ch, scache, ltime-sc->paintedtime, count, rate, sc->sn.numchannels);
 					ltime += count;
 					ch->pos += rate * count;
 				}
@@ -412,589 +484,4 @@ void S_PaintChannels(soundcardinfo_t *sc, int endtime)
 		sc->paintedtime = end;
 	}
 }
-
-static void SND_PaintChannel8_O2I1 (channel_t *ch, sfxcache_t *sc, int starttime, int count, int rate)
-{
-	int 	data;
-	signed char *sfx;
-	int		i;
-	unsigned int pos = ch->pos-(sc->soundoffset<<PITCHSHIFT);
-
-	if (rate != (1<<PITCHSHIFT))
-	{
-		sfx = (signed char *fte_restrict)sc->data;
-		for (i=0 ; i<count ; i++)
-		{
-			data = sfx[pos>>PITCHSHIFT];
-			pos += rate;
-			paintbuffer[starttime+i].s[0] += MIX_8_8(ch->vol[0] * data);
-			paintbuffer[starttime+i].s[1] += MIX_8_8(ch->vol[1] * data);
-		}
-	}
-	else
-	{
-		sfx = (signed char *fte_restrict)sc->data + (pos>>PITCHSHIFT);
-		for (i=0 ; i<count ; i++)
-		{
-			data = sfx[i];
-			paintbuffer[starttime+i].s[0] += MIX_8_8(ch->vol[0] * data);
-			paintbuffer[starttime+i].s[1] += MIX_8_8(ch->vol[1] * data);
-		}
-	}
-}
-
-static void SND_PaintChannel8_O2I2 (channel_t *ch, sfxcache_t *sc, int starttime, int count, int rate)
-{
-//	int 	data;
-	signed char *sfx;
-	int		i;
-	unsigned int pos = ch->pos-(sc->soundoffset<<PITCHSHIFT);
-
-	if (rate != (1<<PITCHSHIFT))
-	{
-		sfx = (signed char *fte_restrict)sc->data;
-		for (i=0 ; i<count ; i++)
-		{
-			paintbuffer[starttime+i].s[0] += MIX_8_8(ch->vol[0] * sfx[(pos>>(PITCHSHIFT-1))&~1]);
-			paintbuffer[starttime+i].s[1] += MIX_8_8(ch->vol[1] * sfx[(pos>>(PITCHSHIFT-1))|1]);
-			pos += rate;
-		}
-	}
-	else
-	{
-		sfx = (signed char *fte_restrict)sc->data + (pos>>PITCHSHIFT)*2;
-		for (i=0 ; i<count ; i++)
-		{
-			paintbuffer[starttime+i].s[0] += MIX_8_8(ch->vol[0] * sfx[(i<<1)]);
-			paintbuffer[starttime+i].s[1] += MIX_8_8(ch->vol[1] * sfx[(i<<1)+1]);
-		}
-	}
-}
-
-static void SND_PaintChannel8_O4I1 (channel_t *ch, sfxcache_t *sc, int count, int rate)
-{
-	signed char *sfx;
-	int		i;
-	unsigned int pos = ch->pos-(sc->soundoffset<<PITCHSHIFT);
-
-	if (rate != (1<<PITCHSHIFT))
-	{
-		signed char data;
-		sfx = (signed char *fte_restrict)sc->data;
-		for (i=0 ; i<count ; i++)
-		{
-			data = sfx[pos>>PITCHSHIFT];
-			pos += rate;
-			paintbuffer[i].s[0] += MIX_8_8(ch->vol[0] * data);
-			paintbuffer[i].s[1] += MIX_8_8(ch->vol[1] * data);
-			paintbuffer[i].s[2] += MIX_8_8(ch->vol[2] * data);
-			paintbuffer[i].s[3] += MIX_8_8(ch->vol[3] * data);
-		}
-	}
-	else
-	{
-		sfx = (signed char *fte_restrict)sc->data + (pos>>PITCHSHIFT);
-		for (i=0 ; i<count ; i++)
-		{
-			paintbuffer[i].s[0] += MIX_8_8(ch->vol[0] * sfx[i]);
-			paintbuffer[i].s[1] += MIX_8_8(ch->vol[1] * sfx[i]);
-			paintbuffer[i].s[2] += MIX_8_8(ch->vol[2] * sfx[i]);
-			paintbuffer[i].s[3] += MIX_8_8(ch->vol[3] * sfx[i]);
-		}
-	}
-}
-
-static void SND_PaintChannel8_O6I1 (channel_t *ch, sfxcache_t *sc, int count, int rate)
-{
-	signed char *sfx;
-	int		i;
-	unsigned int pos = ch->pos-(sc->soundoffset<<PITCHSHIFT);
-
-	if (rate != (1<<PITCHSHIFT))
-	{
-		signed char data;
-		sfx = (signed char *fte_restrict)sc->data;
-		for (i=0 ; i<count ; i++)
-		{
-			data = sfx[pos>>PITCHSHIFT];
-			pos += rate;
-			paintbuffer[i].s[0] += MIX_8_8(ch->vol[0] * data);
-			paintbuffer[i].s[1] += MIX_8_8(ch->vol[1] * data);
-			paintbuffer[i].s[2] += MIX_8_8(ch->vol[2] * data);
-			paintbuffer[i].s[3] += MIX_8_8(ch->vol[3] * data);
-			paintbuffer[i].s[4] += MIX_8_8(ch->vol[4] * data);
-			paintbuffer[i].s[5] += MIX_8_8(ch->vol[5] * data);
-		}
-	}
-	else
-	{
-		sfx = (signed char *fte_restrict)sc->data + (pos>>PITCHSHIFT);
-		for (i=0 ; i<count ; i++)
-		{
-			paintbuffer[i].s[0] += MIX_8_8(ch->vol[0] * sfx[i]);
-			paintbuffer[i].s[1] += MIX_8_8(ch->vol[1] * sfx[i]);
-			paintbuffer[i].s[2] += MIX_8_8(ch->vol[2] * sfx[i]);
-			paintbuffer[i].s[3] += MIX_8_8(ch->vol[3] * sfx[i]);
-			paintbuffer[i].s[4] += MIX_8_8(ch->vol[4] * sfx[i]);
-			paintbuffer[i].s[5] += MIX_8_8(ch->vol[5] * sfx[i]);
-		}
-	}
-}
-
-static void SND_PaintChannel8_O8I1 (channel_t *ch, sfxcache_t *sc, int count, int rate)
-{
-	signed char *sfx;
-	int		i;
-	unsigned int pos = ch->pos-(sc->soundoffset<<PITCHSHIFT);
-
-	if (rate != (1<<PITCHSHIFT))
-	{
-		signed char data;
-		sfx = (signed char *fte_restrict)sc->data;
-		for (i=0 ; i<count ; i++)
-		{
-			data = sfx[pos>>PITCHSHIFT];
-			pos += rate;
-			paintbuffer[i].s[0] += MIX_8_8(ch->vol[0] * data);
-			paintbuffer[i].s[1] += MIX_8_8(ch->vol[1] * data);
-			paintbuffer[i].s[2] += MIX_8_8(ch->vol[2] * data);
-			paintbuffer[i].s[3] += MIX_8_8(ch->vol[3] * data);
-			paintbuffer[i].s[4] += MIX_8_8(ch->vol[4] * data);
-			paintbuffer[i].s[5] += MIX_8_8(ch->vol[5] * data);
-			paintbuffer[i].s[6] += MIX_8_8(ch->vol[6] * data);
-			paintbuffer[i].s[7] += MIX_8_8(ch->vol[7] * data);
-		}
-	}
-	else
-	{
-		sfx = (signed char *fte_restrict)sc->data + (pos>>PITCHSHIFT);
-		for (i=0 ; i<count ; i++)
-		{
-			paintbuffer[i].s[0] += MIX_8_8(ch->vol[0] * sfx[i]);
-			paintbuffer[i].s[1] += MIX_8_8(ch->vol[1] * sfx[i]);
-			paintbuffer[i].s[2] += MIX_8_8(ch->vol[2] * sfx[i]);
-			paintbuffer[i].s[3] += MIX_8_8(ch->vol[3] * sfx[i]);
-			paintbuffer[i].s[4] += MIX_8_8(ch->vol[4] * sfx[i]);
-			paintbuffer[i].s[5] += MIX_8_8(ch->vol[5] * sfx[i]);
-			paintbuffer[i].s[6] += MIX_8_8(ch->vol[6] * sfx[i]);
-			paintbuffer[i].s[7] += MIX_8_8(ch->vol[7] * sfx[i]);
-		}
-	}
-}
-
-
-static void SND_PaintChannel16_O2I1 (channel_t *ch, sfxcache_t *sc, int starttime, int count, int rate)
-{
-	int data;
-	int leftvol, rightvol;
-	signed short *sfx;
-	int	i;
-	unsigned int pos = ch->pos-(sc->soundoffset<<PITCHSHIFT);
-
-	leftvol = ch->vol[0];
-	rightvol = ch->vol[1];
-
-	if (rate != (1<<PITCHSHIFT))
-	{
-		signed int data;
-		sfx = (signed short *fte_restrict)sc->data;
-		for (i=0 ; i<count ; i++)
-		{
-			int frac = pos&((1<<PITCHSHIFT)-1);
-			data = sfx[pos>>PITCHSHIFT] * ((1<<PITCHSHIFT)-frac) + sfx[(pos>>PITCHSHIFT)+1] * frac;
-			pos += rate;
-			paintbuffer[starttime+i].s[0] += MIX_16_8((leftvol * data)>>PITCHSHIFT);
-			paintbuffer[starttime+i].s[1] += MIX_16_8((rightvol * data)>>PITCHSHIFT);
-		}
-	}
-	else
-	{
-		sfx = (signed short *fte_restrict)sc->data + (pos>>PITCHSHIFT);
-		for (i=0 ; i<count ; i++)
-		{
-			data = sfx[i];
-			paintbuffer[starttime+i].s[0] += MIX_16_8(data * leftvol);
-			paintbuffer[starttime+i].s[1] += MIX_16_8(data * rightvol);
-		}
-	}
-}
-
-static void SND_PaintChannel16_O2I2 (channel_t *ch, sfxcache_t *sc, int starttime, int count, int rate)
-{
-	int leftvol, rightvol;
-	signed short *sfx;
-	int	i;
-	unsigned int pos = ch->pos-(sc->soundoffset<<PITCHSHIFT);
-
-	leftvol = ch->vol[0];
-	rightvol = ch->vol[1];
-
-	if (rate != (1<<PITCHSHIFT))
-	{
-		signed short l, r;
-		sfx = (signed short *fte_restrict)sc->data;
-		for (i=0 ; i<count ; i++)
-		{
-			l = sfx[(pos>>(PITCHSHIFT-1))&~1];
-			r = sfx[(pos>>(PITCHSHIFT-1))|1];
-			pos += rate;
-			paintbuffer[starttime+i].s[0] += MIX_16_8(ch->vol[0] * l);
-			paintbuffer[starttime+i].s[1] += MIX_16_8(ch->vol[1] * r);
-		}
-	}
-	else
-	{
-		sfx = (signed short *fte_restrict)sc->data + (pos>>PITCHSHIFT)*2;
-		for (i=0 ; i<count ; i++)
-		{
-			paintbuffer[starttime+i].s[0] += MIX_16_8(*sfx++ * leftvol);
-			paintbuffer[starttime+i].s[1] += MIX_16_8(*sfx++ * rightvol);
-		}
-	}
-}
-
-static void SND_PaintChannel16_O4I1 (channel_t *ch, sfxcache_t *sc, int count, int rate)
-{
-	int vol[4];
-	signed short *sfx;
-	int	i;
-	unsigned int pos = ch->pos-(sc->soundoffset<<PITCHSHIFT);
-
-	vol[0] = ch->vol[0];
-	vol[1] = ch->vol[1];
-	vol[2] = ch->vol[2];
-	vol[3] = ch->vol[3];
-
-	if (rate != (1<<PITCHSHIFT))
-	{
-		signed short data;
-		sfx = (signed short *fte_restrict)sc->data;
-		for (i=0 ; i<count ; i++)
-		{
-			data = sfx[pos>>PITCHSHIFT];
-			pos += rate;
-			paintbuffer[i].s[0] += MIX_16_8(vol[0] * data);
-			paintbuffer[i].s[1] += MIX_16_8(vol[1] * data);
-			paintbuffer[i].s[2] += MIX_16_8(vol[2] * data);
-			paintbuffer[i].s[3] += MIX_16_8(vol[3] * data);
-		}
-	}
-	else
-	{
-		sfx = (signed short *fte_restrict)sc->data + (pos>>PITCHSHIFT);
-		for (i=0 ; i<count ; i++)
-		{
-			paintbuffer[i].s[0] += MIX_16_8(sfx[i] * vol[0]);
-			paintbuffer[i].s[1] += MIX_16_8(sfx[i] * vol[1]);
-			paintbuffer[i].s[2] += MIX_16_8(sfx[i] * vol[2]);
-			paintbuffer[i].s[3] += MIX_16_8(sfx[i] * vol[3]);
-		}
-	}
-}
-
-static void SND_PaintChannel16_O6I1 (channel_t *ch, sfxcache_t *sc, int count, int rate)
-{
-	int vol[6];
-	signed short *sfx;
-	int	i;
-	unsigned int pos = ch->pos-(sc->soundoffset<<PITCHSHIFT);
-
-	vol[0] = ch->vol[0];
-	vol[1] = ch->vol[1];
-	vol[2] = ch->vol[2];
-	vol[3] = ch->vol[3];
-	vol[4] = ch->vol[4];
-	vol[5] = ch->vol[5];
-
-	if (rate != (1<<PITCHSHIFT))
-	{
-		signed short data;
-		sfx = (signed short *fte_restrict)sc->data;
-		for (i=0 ; i<count ; i++)
-		{
-			data = sfx[pos>>PITCHSHIFT];
-			pos += rate;
-			paintbuffer[i].s[0] += MIX_16_8(vol[0] * data);
-			paintbuffer[i].s[1] += MIX_16_8(vol[1] * data);
-			paintbuffer[i].s[2] += MIX_16_8(vol[2] * data);
-			paintbuffer[i].s[3] += MIX_16_8(vol[3] * data);
-			paintbuffer[i].s[4] += MIX_16_8(vol[4] * data);
-			paintbuffer[i].s[5] += MIX_16_8(vol[5] * data);
-		}
-	}
-	else
-	{
-		sfx = (signed short *fte_restrict)sc->data + (pos>>PITCHSHIFT);
-		for (i=0 ; i<count ; i++)
-		{
-			paintbuffer[i].s[0] += MIX_16_8(sfx[i] * vol[0]);
-			paintbuffer[i].s[1] += MIX_16_8(sfx[i] * vol[1]);
-			paintbuffer[i].s[2] += MIX_16_8(sfx[i] * vol[2]);
-			paintbuffer[i].s[3] += MIX_16_8(sfx[i] * vol[3]);
-			paintbuffer[i].s[4] += MIX_16_8(sfx[i] * vol[4]);
-			paintbuffer[i].s[5] += MIX_16_8(sfx[i] * vol[5]);
-		}
-	}
-}
-
-static void SND_PaintChannel16_O8I1 (channel_t *ch, sfxcache_t *sc, int count, int rate)
-{
-	int vol[8];
-	signed short *sfx;
-	int	i;
-	unsigned int pos = ch->pos-(sc->soundoffset<<PITCHSHIFT);
-
-	vol[0] = ch->vol[0];
-	vol[1] = ch->vol[1];
-	vol[2] = ch->vol[2];
-	vol[3] = ch->vol[3];
-	vol[4] = ch->vol[4];
-	vol[5] = ch->vol[5];
-	vol[6] = ch->vol[6];
-	vol[7] = ch->vol[7];
-
-	if (rate != (1<<PITCHSHIFT))
-	{
-		signed short data;
-		sfx = (signed short *fte_restrict)sc->data;
-		for (i=0 ; i<count ; i++)
-		{
-			data = sfx[pos>>PITCHSHIFT];
-			pos += rate;
-			paintbuffer[i].s[0] += MIX_16_8(vol[0] * data);
-			paintbuffer[i].s[1] += MIX_16_8(vol[1] * data);
-			paintbuffer[i].s[2] += MIX_16_8(vol[2] * data);
-			paintbuffer[i].s[3] += MIX_16_8(vol[3] * data);
-			paintbuffer[i].s[4] += MIX_16_8(vol[4] * data);
-			paintbuffer[i].s[5] += MIX_16_8(vol[5] * data);
-			paintbuffer[i].s[6] += MIX_16_8(vol[6] * data);
-			paintbuffer[i].s[7] += MIX_16_8(vol[7] * data);
-		}
-	}
-	else
-	{
-		sfx = (signed short *fte_restrict)sc->data + (pos>>PITCHSHIFT);
-		for (i=0 ; i<count ; i++)
-		{
-			paintbuffer[i].s[0] += MIX_16_8(sfx[i] * vol[0]);
-			paintbuffer[i].s[1] += MIX_16_8(sfx[i] * vol[1]);
-			paintbuffer[i].s[2] += MIX_16_8(sfx[i] * vol[2]);
-			paintbuffer[i].s[3] += MIX_16_8(sfx[i] * vol[3]);
-			paintbuffer[i].s[4] += MIX_16_8(sfx[i] * vol[4]);
-			paintbuffer[i].s[5] += MIX_16_8(sfx[i] * vol[5]);
-			paintbuffer[i].s[6] += MIX_16_8(sfx[i] * vol[6]);
-			paintbuffer[i].s[7] += MIX_16_8(sfx[i] * vol[7]);
-		}
-	}
-}
-
-#ifdef MIXER_F32
-static void SND_PaintChannel32F_O2I1 (channel_t *ch, sfxcache_t *sc, int starttime, int count, int rate)
-{
-	float data;
-	int left, right;
-	int leftvol, rightvol;
-	float *sfx;
-	int	i;
-	unsigned int pos = ch->pos-(sc->soundoffset<<PITCHSHIFT);
-
-	leftvol = ch->vol[0]*128;
-	rightvol = ch->vol[1]*128;
-
-	if (rate != (1<<PITCHSHIFT))
-	{
-		sfx = (float *fte_restrict)sc->data;
-		for (i=0 ; i<count ; i++)
-		{
-			float frac = pos&((1<<PITCHSHIFT)-1);
-			data = sfx[pos>>PITCHSHIFT] * (1-frac) + sfx[(pos>>PITCHSHIFT)+1] * frac;
-			pos += rate;
-			paintbuffer[starttime+i].s[0] += (leftvol * data);
-			paintbuffer[starttime+i].s[1] += (rightvol * data);
-		}
-	}
-	else
-	{
-		sfx = (float *fte_restrict)sc->data + (pos>>PITCHSHIFT);
-		for (i=0 ; i<count ; i++)
-		{
-			data = sfx[i];
-			left = (data * leftvol);
-			right = (data * rightvol);
-			paintbuffer[starttime+i].s[0] += left;
-			paintbuffer[starttime+i].s[1] += right;
-		}
-	}
-}
-
-static void SND_PaintChannel32F_O2I2 (channel_t *ch, sfxcache_t *sc, int starttime, int count, int rate)
-{
-	float leftvol, rightvol;
-	float *sfx;
-	int	i;
-	unsigned int pos = ch->pos-(sc->soundoffset<<PITCHSHIFT);
-
-	leftvol = ch->vol[0]*128;
-	rightvol = ch->vol[1]*128;
-
-	if (rate != (1<<PITCHSHIFT))
-	{
-		float l, r;
-		sfx = (float *fte_restrict)sc->data;
-		for (i=0 ; i<count ; i++)
-		{
-			l = sfx[(pos>>(PITCHSHIFT-1))&~1];
-			r = sfx[(pos>>(PITCHSHIFT-1))|1];
-			pos += rate;
-			paintbuffer[starttime+i].s[0] += (l * leftvol);
-			paintbuffer[starttime+i].s[1] += (r * rightvol);
-		}
-	}
-	else
-	{
-		sfx = (float *fte_restrict)sc->data + (pos>>PITCHSHIFT)*2;
-		for (i=0 ; i<count ; i++)
-		{
-			paintbuffer[starttime+i].s[0] += (*sfx++ * leftvol);
-			paintbuffer[starttime+i].s[1] += (*sfx++ * rightvol);
-		}
-	}
-}
-
-static void SND_PaintChannel32F_O4I1 (channel_t *ch, sfxcache_t *sc, int count, int rate)
-{
-	int vol[4];
-	float *sfx;
-	int	i;
-	unsigned int pos = ch->pos-(sc->soundoffset<<PITCHSHIFT);
-
-	vol[0] = ch->vol[0]*128;
-	vol[1] = ch->vol[1]*128;
-	vol[2] = ch->vol[2]*128;
-	vol[3] = ch->vol[3]*128;
-
-	if (rate != (1<<PITCHSHIFT))
-	{
-		float data;
-		sfx = (float *fte_restrict)sc->data;
-		for (i=0 ; i<count ; i++)
-		{
-			data = sfx[pos>>PITCHSHIFT];
-			pos += rate;
-			paintbuffer[i].s[0] += (vol[0] * data);
-			paintbuffer[i].s[1] += (vol[1] * data);
-			paintbuffer[i].s[2] += (vol[2] * data);
-			paintbuffer[i].s[3] += (vol[3] * data);
-		}
-	}
-	else
-	{
-		sfx = (float *fte_restrict)sc->data + (pos>>PITCHSHIFT);
-		for (i=0 ; i<count ; i++)
-		{
-			paintbuffer[i].s[0] += (sfx[i] * vol[0]);
-			paintbuffer[i].s[1] += (sfx[i] * vol[1]);
-			paintbuffer[i].s[2] += (sfx[i] * vol[2]);
-			paintbuffer[i].s[3] += (sfx[i] * vol[3]);
-		}
-	}
-}
-
-static void SND_PaintChannel32F_O6I1 (channel_t *ch, sfxcache_t *sc, int count, int rate)
-{
-	int vol[6];
-	float *sfx;
-	int	i;
-	unsigned int pos = ch->pos-(sc->soundoffset<<PITCHSHIFT);
-
-	vol[0] = ch->vol[0]*128;
-	vol[1] = ch->vol[1]*128;
-	vol[2] = ch->vol[2]*128;
-	vol[3] = ch->vol[3]*128;
-	vol[4] = ch->vol[4]*128;
-	vol[5] = ch->vol[5]*128;
-
-	if (rate != (1<<PITCHSHIFT))
-	{
-		float data;
-		sfx = (float *fte_restrict)sc->data;
-		for (i=0 ; i<count ; i++)
-		{
-			data = sfx[pos>>PITCHSHIFT];
-			pos += rate;
-			paintbuffer[i].s[0] += (vol[0] * data);
-			paintbuffer[i].s[1] += (vol[1] * data);
-			paintbuffer[i].s[2] += (vol[2] * data);
-			paintbuffer[i].s[3] += (vol[3] * data);
-			paintbuffer[i].s[4] += (vol[4] * data);
-			paintbuffer[i].s[5] += (vol[5] * data);
-		}
-	}
-	else
-	{
-		sfx = (float *fte_restrict)sc->data + (pos>>PITCHSHIFT);
-		for (i=0 ; i<count ; i++)
-		{
-			paintbuffer[i].s[0] += (sfx[i] * vol[0]);
-			paintbuffer[i].s[1] += (sfx[i] * vol[1]);
-			paintbuffer[i].s[2] += (sfx[i] * vol[2]);
-			paintbuffer[i].s[3] += (sfx[i] * vol[3]);
-			paintbuffer[i].s[4] += (sfx[i] * vol[4]);
-			paintbuffer[i].s[5] += (sfx[i] * vol[5]);
-		}
-	}
-}
-
-static void SND_PaintChannel32F_O8I1 (channel_t *ch, sfxcache_t *sc, int count, int rate)
-{
-	int vol[8];
-	float *sfx;
-	int	i;
-	unsigned int pos = ch->pos-(sc->soundoffset<<PITCHSHIFT);
-
-	//input is +/- 1, output is +/- 32767. ch->vol is 0-255, so we just need to scale up by an extra 128
-	vol[0] = ch->vol[0]*128;
-	vol[1] = ch->vol[1]*128;
-	vol[2] = ch->vol[2]*128;
-	vol[3] = ch->vol[3]*128;
-	vol[4] = ch->vol[4]*128;
-	vol[5] = ch->vol[5]*128;
-	vol[6] = ch->vol[6]*128;
-	vol[7] = ch->vol[7]*128;
-
-	if (rate != (1<<PITCHSHIFT))
-	{
-		float data;
-		sfx = (float *fte_restrict)sc->data;
-		for (i=0 ; i<count ; i++)
-		{
-			data = sfx[pos>>PITCHSHIFT];
-			pos += rate;
-			paintbuffer[i].s[0] += (vol[0] * data);
-			paintbuffer[i].s[1] += (vol[1] * data);
-			paintbuffer[i].s[2] += (vol[2] * data);
-			paintbuffer[i].s[3] += (vol[3] * data);
-			paintbuffer[i].s[4] += (vol[4] * data);
-			paintbuffer[i].s[5] += (vol[5] * data);
-			paintbuffer[i].s[6] += (vol[6] * data);
-			paintbuffer[i].s[7] += (vol[7] * data);
-		}
-	}
-	else
-	{
-		sfx = (float *fte_restrict)sc->data + (pos>>PITCHSHIFT);
-		for (i=0 ; i<count ; i++)
-		{
-			paintbuffer[i].s[0] += (sfx[i] * vol[0]);
-			paintbuffer[i].s[1] += (sfx[i] * vol[1]);
-			paintbuffer[i].s[2] += (sfx[i] * vol[2]);
-			paintbuffer[i].s[3] += (sfx[i] * vol[3]);
-			paintbuffer[i].s[4] += (sfx[i] * vol[4]);
-			paintbuffer[i].s[5] += (sfx[i] * vol[5]);
-			paintbuffer[i].s[6] += (sfx[i] * vol[6]);
-			paintbuffer[i].s[7] += (sfx[i] * vol[7]);
-		}
-	}
-}
-#endif
 #endif
@@ -1193,6 +1193,11 @@ STAT_MOVEVARS_AIRACCEL_SIDEWAYS_FRICTION	= 255, // DP
 #define dem_stats		5
 #define dem_all			6
 
+//optional .idx sidecar file written alongside uncompressed mvds, for seeking.
+//header is {MVDINDEX_MAGIC, MVDINDEX_VERSION}, followed by keyframes of {msecs, fileoffset, length} and then length bytes of mvd data that recreate the full gamestate (to be followed by the demo's data from fileoffset).
+#define MVDINDEX_MAGIC		(('I'<<24)+('D'<<16)+('V'<<8)+'M')	//"MVDI"
+#define MVDINDEX_VERSION	1
+
 
 #if 0 //fuck sake, just build it in an older chroot.
 /*
@@ -29,6 +29,9 @@ cvar_t mod_nomipmap							= CVARD ("mod_nomipmap", "0", "Disables the use of mip
 #ifdef MODELFMT_OBJ
 cvar_t mod_obj_orientation					= CVARD("mod_obj_orientation", "1", "Controls how the model's axis are interpreted.\n0: x=forward, z=up (Quake)\n1: x=forward, y=up\n2: z=forward, y=up");
 #endif
+#ifdef SKELETALMODELS
+static cvar_t mod_skel_posecache				= CVARD("mod_skel_posecache", "2", "Controls reuse of evaluated skeletal poses.\n0: Evaluate the skeleton every time it's needed.\n1: Reuse poses for identical frame states within a frame.\n2: Additionally evaluate visible entities' poses on worker threads.");
+#endif
 #ifdef MD5MODELS
 cvar_t mod_md5_singleanimation				= CVARD("mod_md5_singleanimation", "1", "When loading an md5mesh file, also attempt to load an .md5anim file, and unpack it into individual poses. Use 0 for mods that will be precaching their own md5anims for use with skeletal objects.");
 #endif
@@ -361,7 +364,7 @@ static void PSKGenMatrix(float x, float y, float z, float qx, float qy, float qz
 #endif
 
 /*transforms some skeletal vecV_t values*/
-static void Alias_TransformVerticies_V(const float *bonepose, int vertcount, boneidx_t *bidx, float *weights, float *xyzin, float *fte_restrict xyzout)
+static void Alias_TransformVerticies_V_Scalar(const float *bonepose, int vertcount, const boneidx_t *bidx, const float *weights, const float *xyzin, float *fte_restrict xyzout)
 {
 #if 1
 	int i, j;
@@ -437,7 +440,7 @@ static void Alias_TransformVerticies_V(const float *bonepose, int vertcount, bon
 }
 
 /*transforms some skeletal vecV_t values*/
-static void Alias_TransformVerticies_VN(const float *bonepose, int vertcount, const boneidx_t *bidx, float *weights,
+static void Alias_TransformVerticies_VN_Scalar(const float *bonepose, int vertcount, const boneidx_t *bidx, const float *weights,
 										const float *xyzin, float *fte_restrict xyzout,
 										const float *normin, float *fte_restrict normout)
 {
@@ -481,7 +484,7 @@ static void Alias_TransformVerticies_VN(const float *bonepose, int vertcount, co
 }
 
 /*transforms some skeletal vecV_t values*/
-static void Alias_TransformVerticies_VNST(const float *bonepose, int vertcount, const boneidx_t *bidx, const float *weights,
+static void Alias_TransformVerticies_VNST_Scalar(const float *bonepose, int vertcount, const boneidx_t *bidx, const float *weights,
 										const float *xyzin, float *fte_restrict xyzout,
 										const float *normin, float *fte_restrict normout,
 										const float *sdirin, float *fte_restrict sdirout,
@@ -539,6 +542,138 @@ static void Alias_TransformVerticies_VNST(const float *bonepose, int vertcount,
 	}
 }
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	//sse2 is part of the baseline on x86_64, so there's nothing to detect.
+	#include <xmmintrin.h>
+	#define SKEL_SIMD "SSE2"
+	typedef __m128 skelvec_t;
+	#define SKV_Load(p)			_mm_loadu_ps(p)
+	#define SKV_Zero()			_mm_setzero_ps()
+	#define SKV_Scale(v,s)		_mm_mul_ps(v, _mm_set1_ps(s))
+	#define SKV_MulAdd(a,v,s)	_mm_add_ps(a, _mm_mul_ps(v, _mm_set1_ps(s)))
+	#define SKV_Add(a,b)		_mm_add_ps(a, b)
+	#define SKV_Transpose(r0,r1,r2,r3)	_MM_TRANSPOSE4_PS(r0,r1,r2,r3)
+	#define SKV_Store3(o,v)		do {_mm_storel_pi((__m64*)(o), v); _mm_store_ss((o)+2, _mm_movehl_ps(v, v));} while(0)
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#include <arm_neon.h>
+	#define SKEL_SIMD "NEON"
+	typedef float32x4_t skelvec_t;
+	#define SKV_Load(p)			vld1q_f32(p)
+	#define SKV_Zero()			vdupq_n_f32(0)
+	#define SKV_Scale(v,s)		vmulq_n_f32(v, s)
+	#define SKV_MulAdd(a,v,s)	vaddq_f32(a, vmulq_n_f32(v, s))
+	#define SKV_Add(a,b)		vaddq_f32(a, b)
+	#define SKV_Transpose(r0,r1,r2,r3)	do {											\
+			float32x4x2_t t01 = vtrnq_f32(r0, r1), t23 = vtrnq_f32(r2, r3);				\
+			r0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));		\
+			r1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));		\
+			r2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));	\
+			r3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));	\
+		} while(0)
+	#define SKV_Store3(o,v)		do {vst1_f32(o, vget_low_f32(v)); vst1q_lane_f32((o)+2, v, 2);} while(0)
+#endif
+
+#ifdef SKEL_SIMD
+//blends the vertex's (up to) 4 bone matrices, and then transposes them into columns so that each vector can be transformed with only multiplies and adds.
+//operations are done in the same order as the scalar versions, so the results should be identical.
+#define SKV_BlendColumns(bonepose,bidx,weights,c0,c1,c2,c3)	do {						\
+		const float *m = &bonepose[12*bidx[0]];												\
+		c0 = SKV_Load(m); c1 = SKV_Load(m+4); c2 = SKV_Load(m+8); c3 = SKV_Zero();			\
+		if (weights[1])																		\
+		{																					\
+			c0 = SKV_Scale(c0, weights[0]); c1 = SKV_Scale(c1, weights[0]); c2 = SKV_Scale(c2, weights[0]);	\
+			m = &bonepose[12*bidx[1]];														\
+			c0 = SKV_MulAdd(c0, SKV_Load(m), weights[1]); c1 = SKV_MulAdd(c1, SKV_Load(m+4), weights[1]); c2 = SKV_MulAdd(c2, SKV_Load(m+8), weights[1]);	\
+			if (weights[2])																	\
+			{																				\
+				m = &bonepose[12*bidx[2]];													\
+				c0 = SKV_MulAdd(c0, SKV_Load(m), weights[2]); c1 = SKV_MulAdd(c1, SKV_Load(m+4), weights[2]); c2 = SKV_MulAdd(c2, SKV_Load(m+8), weights[2]);	\
+				if (weights[3])																\
+				{																			\
+					m = &bonepose[12*bidx[3]];												\
+					c0 = SKV_MulAdd(c0, SKV_Load(m), weights[3]); c1 = SKV_MulAdd(c1, SKV_Load(m+4), weights[3]); c2 = SKV_MulAdd(c2, SKV_Load(m+8), weights[3]);	\
+				}																			\
+			}																				\
+		}																					\
+		SKV_Transpose(c0, c1, c2, c3);														\
+	} while(0)
+#define SKV_TransformPoint(c0,c1,c2,c3,in)	SKV_Add(SKV_MulAdd(SKV_MulAdd(SKV_Scale(c0, (in)[0]), c1, (in)[1]), c2, (in)[2]), c3)
+#define SKV_TransformDir(c0,c1,c2,in)		SKV_MulAdd(SKV_MulAdd(SKV_Scale(c0, (in)[0]), c1, (in)[1]), c2, (in)[2])
+
+static void Alias_TransformVerticies_V_SIMD(const float *bonepose, int vertcount, const boneidx_t *bidx, const float *weights, const float *xyzin, float *fte_restrict xyzout)
+{
+	int i;
+	skelvec_t c0, c1, c2, c3, r;
+	for (i = 0; i < vertcount; i++, bidx+=4, weights+=4)
+	{
+		SKV_BlendColumns(bonepose, bidx, weights, c0, c1, c2, c3);
+		r = SKV_TransformPoint(c0, c1, c2, c3, xyzin);
+		SKV_Store3(xyzout, r);
+		xyzout+=sizeof(vecV_t)/sizeof(vec_t);
+		xyzin+=sizeof(vecV_t)/sizeof(vec_t);
+	}
+}
+static void Alias_TransformVerticies_VN_SIMD(const float *bonepose, int vertcount, const boneidx_t *bidx, const float *weights,
+										const float *xyzin, float *fte_restrict xyzout,
+										const float *normin, float *fte_restrict normout)
+{
+	int i;
+	skelvec_t c0, c1, c2, c3, r;
+	for (i = 0; i < vertcount; i++, bidx+=4, weights+=4)
+	{
+		SKV_BlendColumns(bonepose, bidx, weights, c0, c1, c2, c3);
+		r = SKV_TransformPoint(c0, c1, c2, c3, xyzin);
+		SKV_Store3(xyzout, r);
+		xyzout+=sizeof(vecV_t)/sizeof(vec_t);
+		xyzin+=sizeof(vecV_t)/sizeof(vec_t);
+
+		r = SKV_TransformDir(c0, c1, c2, normin);
+		SKV_Store3(normout, r);
+		normout+=sizeof(vec3_t)/sizeof(vec_t);
+		normin+=sizeof(vec3_t)/sizeof(vec_t);
+	}
+}
+static void Alias_TransformVerticies_VNST_SIMD(const float *bonepose, int vertcount, const boneidx_t *bidx, const float *weights,
+										const float *xyzin, float *fte_restrict xyzout,
+										const float *normin, float *fte_restrict normout,
+										const float *sdirin, float *fte_restrict sdirout,
+										const float *tdirin, float *fte_restrict tdirout)
+{
+	int i;
+	skelvec_t c0, c1, c2, c3, r;
+	for (i = 0; i < vertcount; i++, bidx+=4, weights+=4)
+	{
+		SKV_BlendColumns(bonepose, bidx, weights, c0, c1, c2, c3);
+		r = SKV_TransformPoint(c0, c1, c2, c3, xyzin);
+		SKV_Store3(xyzout, r);
+		xyzout+=sizeof(vecV_t)/sizeof(vec_t);
+		xyzin+=sizeof(vecV_t)/sizeof(vec_t);
+
+		r = SKV_TransformDir(c0, c1, c2, normin);
+		SKV_Store3(normout, r);
+		normout+=sizeof(vec3_t)/sizeof(vec_t);
+		normin+=sizeof(vec3_t)/sizeof(vec_t);
+
+		r = SKV_TransformDir(c0, c1, c2, sdirin);
+		SKV_Store3(sdirout, r);
+		sdirout+=sizeof(vec3_t)/sizeof(vec_t);
+		sdirin+=sizeof(vec3_t)/sizeof(vec_t);
+
+		r = SKV_TransformDir(c0, c1, c2, tdirin);
+		SKV_Store3(tdirout, r);
+		tdirout+=sizeof(vec3_t)/sizeof(vec_t);
+		tdirin+=sizeof(vec3_t)/sizeof(vec_t);
+	}
+}
+	#define Alias_TransformVerticies_V		Alias_TransformVerticies_V_SIMD
+	#define Alias_TransformVerticies_VN		Alias_TransformVerticies_VN_SIMD
+	#define Alias_TransformVerticies_VNST	Alias_TransformVerticies_VNST_SIMD
+#else
+	#define Alias_TransformVerticies_V		Alias_TransformVerticies_V_Scalar
+	#define Alias_TransformVerticies_VN		Alias_TransformVerticies_VN_Scalar
+	#define Alias_TransformVerticies_VNST	Alias_TransformVerticies_VNST_Scalar
+#endif
+
 //converts one entire frame to another skeleton type
 //only writes to destbuffer if absolutely needed
 static const float *Alias_ConvertBoneData(skeltype_t sourcetype, const float *sourcedata, size_t bonecount, galiasbone_t *bones, skeltype_t desttype, float *destbuffer, float *destbufferalt, size_t destbonecount)
@@ -1243,11 +1378,168 @@ static int Alias_BlendBoneData(galiasinfo_t *inf, framestate_t *fstate, float *r
 	return endbone;
 }
 
-/*retrieves the bone data.
+/*
+	bone pose cache.
+	an entity that gets traced against, queried for tags, and then drawn (possibly several times if there's rtlights) would otherwise evaluate its skeleton every single time.
+	entries are keyed by the model+framestate+skeltype that produced them rather than by entity, so stale entries are simply never matched again.
+	the generation is bumped once at the start of each host frame (so traces, tags, csqc and every scene drawn that frame all share the same poses), and when models are destroyed.
+	the renderer can also queue up visible entities to be evaluated on worker threads.
+*/
+#define SKELPOSECACHE_SIZE 512	//must be a power of two
+#define SKELPOSECACHE_PROBE 4
+enum
+{
+	SPC_EMPTY,
+	SPC_PENDING,	//a worker is still busy writing the pose. must not be reused until its ready.
+	SPC_READY
+};
+typedef struct
+{
+	int status;
+	unsigned int generation;
+	unsigned int lastused;
+	galiasinfo_t *inf;
+	skeltype_t skeltype;
+	struct framestateregion_s g[FS_COUNT];
+	size_t numbones;
+	size_t maxbones;
+	float *pose;
+} skelpose_t;
+static struct
+{
+	void *mutex;
+	unsigned int generation;
+	unsigned int sequence;
+	skelpose_t entry[SKELPOSECACHE_SIZE];
+} skelposecache;
+
+static qboolean Alias_PoseCacheable(const galiasinfo_t *inf, const framestate_t *framestate)
+{
+	if (!mod_skel_posecache.ival || !inf->numbones || inf->numbones > MAX_BONES)
+		return false;
+#ifdef SKELETALOBJECTS
+	if (framestate->bonestate && framestate->bonecount >= inf->numbones)
+		return false;	//skeletal objects can be changed by the gamecode at any time, and are cheap to use anyway.
+#endif
+	return true;
+}
+static unsigned int Alias_PoseCacheHash(const galiasinfo_t *inf, const framestate_t *framestate, skeltype_t skeltype)
+{
+	const unsigned int *d = (const unsigned int*)framestate->g;
+	size_t i;
+	unsigned int h = (unsigned int)(size_t)inf ^ skeltype;
+	for (i = 0; i < sizeof(framestate->g)/(sizeof(unsigned int)); i++)
+		h = h*31 + d[i];
+	return h ^ (h>>16);
+}
+//mutex must be held. returns the matching entry, or if create is set then a (possibly stale) entry that has been reset to match.
+static skelpose_t *Alias_PoseCacheFind(galiasinfo_t *inf, const framestate_t *framestate, skeltype_t skeltype, qboolean create)
+{
+	unsigned int h = Alias_PoseCacheHash(inf, framestate, skeltype), i;
+	skelpose_t *e, *victim = NULL;
+	qboolean stale, victimstale = false;
+	skelposecache.sequence++;
+	for (i = 0; i < SKELPOSECACHE_PROBE; i++)
+	{
+		e = &skelposecache.entry[(h+i)&(SKELPOSECACHE_SIZE-1)];
+		stale = e->status == SPC_EMPTY || e->generation != skelposecache.generation;
+		if (!stale && e->inf == inf && e->skeltype == skeltype && !memcmp(e->g, framestate->g, sizeof(e->g)))
+		{
+			e->lastused = skelposecache.sequence;
+			return e;
+		}
+		if (e->status == SPC_PENDING)
+			continue;	//a worker is still writing to it.
+		if (!victim || (stale && !victimstale) || (stale == victimstale && (int)(e->lastused - victim->lastused) < 0))
+		{	//prefer stale entries, otherwise the least recently used.
+			victim = e;
+			victimstale = stale;
+		}
+	}
+	if (!create || !victim)
+		return NULL;
+
+	if (victim->maxbones < inf->numbones)
+	{
+		BZ_Free(victim->pose);
+		victim->maxbones = inf->numbones;
+		victim->pose = BZ_Malloc(sizeof(float)*12*victim->maxbones);
+	}
+	victim->status = SPC_EMPTY;
+	victim->generation = skelposecache.generation;
+	victim->lastused = skelposecache.sequence;
+	victim->inf = inf;
+	victim->skeltype = skeltype;
+	memcpy(victim->g, framestate->g, sizeof(victim->g));
+	victim->numbones = inf->numbones;
+	return victim;
+}
+//for tags, where we only need one bone. returns false if there's no pose ready to be read.
+static qboolean Alias_PoseCacheGetBone(galiasinfo_t *inf, const framestate_t *framestate, int bonenum, float *result)
+{
+	skelpose_t *e;
+	qboolean found = false;
+	if (!Alias_PoseCacheable(inf, framestate))
+		return false;
+	Sys_LockMutex(skelposecache.mutex);
+	if ((e = Alias_PoseCacheFind(inf, framestate, SKEL_ABSOLUTE, false)) && e->status == SPC_READY)
+	{
+		memcpy(result, e->pose + bonenum*12, sizeof(float)*12);
+		found = true;
+	}
+	else if ((e = Alias_PoseCacheFind(inf, framestate, SKEL_INVERSE_ABSOLUTE, false)) && e->status == SPC_READY)
+	{	//undo the inverse bind pose, but only for the bone we actually want.
+		float iim[12];
+		Matrix3x4_Invert_Simple(inf->ofsbones[bonenum].inverse, iim);
+		R_ConcatTransforms((const void*)(e->pose + bonenum*12), (const void*)iim, (void*)result);
+		found = true;
+	}
+	Sys_UnlockMutex(skelposecache.mutex);
+	return found;
+}
+#ifndef SERVERONLY
+//called at the start of each host frame, so entries don't get reused forever.
+void Alias_NewFrame(void)
+{
+	Sys_LockMutex(skelposecache.mutex);
+	skelposecache.generation++;
+	Sys_UnlockMutex(skelposecache.mutex);
+}
+#endif
+//called when models are destroyed, so that we can't match against a freed galiasinfo_t that happened to get the same address.
+static void Alias_FlushPoseCache(void)
+{
+	size_t i;
+	if (Sys_IsMainThread())
+	{	//make sure the workers are no longer poking at anything.
+		for (i = 0; i < SKELPOSECACHE_SIZE; i++)
+			if (skelposecache.entry[i].status == SPC_PENDING)
+				COM_WorkerPartialSync(&skelposecache.entry[i], &skelposecache.entry[i].status, SPC_PENDING);
+	}
+	Sys_LockMutex(skelposecache.mutex);
+	skelposecache.generation++;
+	Sys_UnlockMutex(skelposecache.mutex);
+}
+static void Alias_ShutdownPoseCache(void)
+{
+	size_t i;
+	Alias_FlushPoseCache();
+	for (i = 0; i < SKELPOSECACHE_SIZE; i++)
+	{
+		if (skelposecache.entry[i].status == SPC_PENDING)
+			continue;	//shouldn't happen, but don't crash if it does.
+		BZ_Free(skelposecache.entry[i].pose);
+		skelposecache.entry[i].pose = NULL;
+		skelposecache.entry[i].maxbones = 0;
+		skelposecache.entry[i].status = SPC_EMPTY;
+	}
+}
+
+/*evaluates the bone data.
 only writes targetbuffer if needed. the return value is the only real buffer result.
 assumes that all blended types are the same. probably buggy, but meh.
 */
-static const float *Alias_GetBoneInformation(galiasinfo_t *inf, const framestate_t *framestate, skeltype_t targettype, float *targetbuffer, float *targetbufferalt, size_t maxbufferbones)
+static const float *Alias_EvaluateBoneInformation(galiasinfo_t *inf, const framestate_t *framestate, skeltype_t targettype, float *targetbuffer, float *targetbufferalt, size_t maxbufferbones)
 {
 	skellerps_t lerps[FS_COUNT], *lerp;
 	size_t numgroups;
@@ -1368,6 +1660,172 @@ static const float *Alias_GetBoneInformation(galiasinfo_t *inf, const framestate
 	return Alias_ConvertBoneData(lerps[0].skeltype, targetbuffer, inf->numbones, inf->ofsbones, targettype, targetbuffer, targetbufferalt, maxbufferbones);
 }
 
+//returns true if any of the frames in use come from a plugin, which makes looking up the poses expensive.
+static qboolean Alias_UsesRawBones(galiasinfo_t *inf, const framestate_t *framestate)
+{
+	int r, b;
+	unsigned int frame;
+	for (r = 0; r < FS_COUNT; r++)
+	{
+		for (b = 0; b < FRAME_BLENDS; b++)
+		{
+			if (!framestate->g[r].lerpweight[b])
+				continue;
+			frame = framestate->g[r].frame[b];
+			if (frame >= inf->numanimations)
+				frame = 0;
+			if (frame < inf->numanimations && inf->ofsanimations[frame].GetRawBones)
+				return true;
+		}
+	}
+	return false;
+}
+
+/*retrieves the bone data, reusing a previous result for the same frame state where possible.
+only writes targetbuffer if needed. the return value is the only real buffer result.
+*/
+static const float *Alias_GetBoneInformation(galiasinfo_t *inf, const framestate_t *framestate, skeltype_t targettype, float *targetbuffer, float *targetbufferalt, size_t maxbufferbones)
+{
+	skelpose_t *e;
+	const float *ret;
+	skellerps_t lerps[FS_COUNT];
+
+	if (!Alias_PoseCacheable(inf, framestate) || maxbufferbones < inf->numbones)
+		return Alias_EvaluateBoneInformation(inf, framestate, targettype, targetbuffer, targetbufferalt, maxbufferbones);
+
+	if (!Alias_UsesRawBones(inf, framestate))
+	{	//a single unblended pose of the right type is returned in-place anyway, so don't bother locking or copying anything for it.
+		if (Alias_FindRawSkelData(inf, framestate, lerps, 0, inf->numbones) == 1 && lerps[0].lerpcount == 1 && lerps[0].skeltype == targettype)
+			return lerps[0].pose[0];
+	}
+
+	Sys_LockMutex(skelposecache.mutex);
+	e = Alias_PoseCacheFind(inf, framestate, targettype, false);
+	if (e && e->status == SPC_PENDING && Sys_IsMainThread())
+	{	//a worker is already on it, wait for that instead of duplicating its work.
+		Sys_UnlockMutex(skelposecache.mutex);
+		COM_WorkerPartialSync(e, &e->status, SPC_PENDING);
+		Sys_LockMutex(skelposecache.mutex);
+		e = Alias_PoseCacheFind(inf, framestate, targettype, false);
+	}
+	if (e && e->status == SPC_READY)
+	{	//copy it out, so the entry can be reused without breaking whatever the caller does with it.
+		memcpy(targetbuffer, e->pose, sizeof(float)*12*e->numbones);
+		Sys_UnlockMutex(skelposecache.mutex);
+		return targetbuffer;
+	}
+	Sys_UnlockMutex(skelposecache.mutex);
+
+	ret = Alias_EvaluateBoneInformation(inf, framestate, targettype, targetbuffer, targetbufferalt, maxbufferbones);
+
+	Sys_LockMutex(skelposecache.mutex);
+	e = Alias_PoseCacheFind(inf, framestate, targettype, true);
+	if (e && e->status == SPC_EMPTY)
+	{
+		memcpy(e->pose, ret, sizeof(float)*12*inf->numbones);
+		e->status = SPC_READY;
+	}
+	Sys_UnlockMutex(skelposecache.mutex);
+	return ret;
+}
+
+#ifndef SERVERONLY
+#define SKELPOSEBATCH_SIZE 16	//poses are fairly cheap individually, so don't swamp the workers with tiny jobs.
+typedef struct
+{
+	size_t count;
+	skelpose_t *entry[SKELPOSEBATCH_SIZE];
+} skelposebatch_t;
+static void Alias_PoseCacheReady(void *ctx, void *data, size_t a, size_t b)
+{
+	skelposebatch_t *batch = data;
+	size_t i;
+	for (i = 0; i < batch->count; i++)
+		batch->entry[i]->status = SPC_READY;
+	Z_Free(batch);
+}
+static void Alias_PoseCacheWorker(void *ctx, void *data, size_t a, size_t b)
+{
+	skelposebatch_t *batch = data;
+	skelpose_t *e;
+	framestate_t fs;
+	float *buffer;
+	const float *ret;
+	size_t i, maxbones = 0;
+
+	for (i = 0; i < batch->count; i++)
+		maxbones = max(maxbones, batch->entry[i]->numbones);
+	buffer = BZ_Malloc(sizeof(float)*12*maxbones*2);
+
+	memset(&fs, 0, sizeof(fs));
+	for (i = 0; i < batch->count; i++)
+	{
+		e = batch->entry[i];
+		memcpy(fs.g, e->g, sizeof(fs.g));
+		ret = Alias_EvaluateBoneInformation(e->inf, &fs, e->skeltype, buffer, buffer+12*maxbones, maxbones);
+		memcpy(e->pose, ret, sizeof(float)*12*e->numbones);
+	}
+	BZ_Free(buffer);
+
+	if (Sys_IsMainThread())
+		Alias_PoseCacheReady(ctx, data, a, b);
+	else	//the main thread does the status changes, so that it gets woken up if its waiting on them.
+		COM_AddWork(WG_MAIN, Alias_PoseCacheReady, ctx, data, a, b);
+}
+//called once per frame with the visible entities, to evaluate their poses on the workers before the renderer gets to them.
+void Alias_PrepareBonePoses(entity_t *ents, size_t numents)
+{
+	size_t i, a;
+	int surfnum;
+	model_t *mod;
+	galiasinfo_t *inf;
+	skelpose_t *e;
+	skelposebatch_t *batch = NULL;
+
+	if (mod_skel_posecache.ival < 2)
+		return;
+
+	for (i = 0; i < numents; i++)
+	{
+		mod = ents[i].model;
+		if (!mod || mod->type != mod_alias || mod->loadstate != MLS_LOADED)
+			continue;
+		for (inf = Mod_Extradata(mod), surfnum = 0; inf; inf = inf->nextsurf, surfnum++)
+		{
+			if (inf->shares_bones != surfnum || !Alias_PoseCacheable(inf, &ents[i].framestate))
+				continue;	//only the surface that owns the bones gets evaluated.
+			for (a = 0; a < inf->numanimations; a++)
+				if (inf->ofsanimations[a].GetRawBones)
+					break;	//plugin-provided animations might not be thread safe.
+			if (a < inf->numanimations)
+				continue;
+
+			Sys_LockMutex(skelposecache.mutex);
+			if (Alias_PoseCacheFind(inf, &ents[i].framestate, SKEL_INVERSE_ABSOLUTE, false))
+				e = NULL;	//already got it (or its already queued)
+			else if ((e = Alias_PoseCacheFind(inf, &ents[i].framestate, SKEL_INVERSE_ABSOLUTE, true)))
+				e->status = SPC_PENDING;
+			Sys_UnlockMutex(skelposecache.mutex);
+
+			if (e)
+			{
+				if (!batch)
+					batch = Z_Malloc(sizeof(*batch));
+				batch->entry[batch->count++] = e;
+				if (batch->count == SKELPOSEBATCH_SIZE)
+				{
+					COM_AddWork(WG_LOADER, Alias_PoseCacheWorker, batch->entry[0], batch, 0, 0);
+					batch = NULL;
+				}
+			}
+		}
+	}
+	if (batch)
+		COM_AddWork(WG_LOADER, Alias_PoseCacheWorker, batch->entry[0], batch, 0, 0);
+}
+#endif
+
+
 static void Alias_BuildSkeletalMesh(mesh_t *mesh, framestate_t *framestate, galiasinfo_t *inf)
 {
 	boneidx_t *fte_restrict bidx = inf->ofs_skel_idx[0];
@@ -1656,6 +2114,9 @@ void Alias_FlushCache(void)
 
 void Alias_Shutdown(void)
 {
+#ifdef SKELETALMODELS
+	Alias_ShutdownPoseCache();
+#endif
 	if (meshcache.norm)
 		BZ_Free(meshcache.norm);
 	meshcache.norm = NULL;
@@ -3033,6 +3494,9 @@ static void Mod_DefaultMesh(galiasinfo_t *galias, const char *name, unsigned int
 
 void Mod_DestroyMesh(galiasinfo_t *galias)
 {
+#ifdef SKELETALMODELS
+	Alias_FlushPoseCache();
+#endif
 #ifndef SERVERONLY
 	if (!qrenderer || !BE_VBO_Destroy)
 		return;
@@ -5281,6 +5745,10 @@ qboolean Mod_GetTag(model_t *model, int tagnum, framestate_t *fstate, float *res
 				numbonegroups = 1;
 			}
 
+			//try reusing a pose that was already evaluated for this frame state
+			if (!numbonegroups && Alias_PoseCacheGetBone(inf, fstate, tagnum, result))
+				return true;
+
 			//try getting the data from the frame state
 			if (!numbonegroups)
 				numbonegroups = Alias_FindRawSkelData(inf, fstate, lerps, 0, inf->numbones);
@@ -10078,9 +10546,133 @@ static qboolean QDECL Mod_LoadObjModel(model_t *mod, void *buffer, size_t fsize)
 }
 #endif
 
+#ifdef SKELETALMODELS
+//times the skinning kernels against a real model's base pose, so that the simd paths can be checked for both speed and correctness.
+static void Mod_SkinBench_f(void)
+{
+	model_t *mod = Mod_ForName(Cmd_Argv(1), MLV_WARNSYNC);
+	int iterations = Cmd_Argc()>2?atoi(Cmd_Argv(2)):100;
+	galiasinfo_t *inf;
+	framestate_t fs;
+	float *bonebuf, *bonebufalt;
+	const float *bonepose;
+	int it, k, surfs = 0, verts = 0;
+	double t[6] = {0}, st;
+	float maxdiff = 0;
+	vecV_t *xyz[2];
+	vec3_t *norm[2], *sdir[2], *tdir[2];
+
+	if (Cmd_Argc() < 2)
+	{
+		Con_Printf("%s <model> [iterations]\n", Cmd_Argv(0));
+		return;
+	}
+	if (!mod || mod->loadstate != MLS_LOADED || mod->type != mod_alias)
+	{
+		Con_Printf("%s: %s is not a loaded mesh model\n", Cmd_Argv(0), Cmd_Argv(1));
+		return;
+	}
+	if (iterations < 1)
+		iterations = 1;
+
+	memset(&fs, 0, sizeof(fs));
+	fs.g[FS_REG].lerpweight[0] = 1;
+	bonebuf = BZ_Malloc(sizeof(float)*12*MAX_BONES*2);
+	bonebufalt = bonebuf + 12*MAX_BONES;
+
+	for (inf = Mod_Extradata(mod); inf; inf = inf->nextsurf)
+	{
+		if (!inf->numbones || !inf->ofs_skel_xyz || !inf->ofs_skel_norm || !inf->ofs_skel_svect || !inf->ofs_skel_tvect || !inf->ofs_skel_idx || !inf->ofs_skel_weight)
+			continue;
+		bonepose = Alias_GetBoneInformation(inf, &fs, SKEL_INVERSE_ABSOLUTE, bonebuf, bonebufalt, MAX_BONES);
+		if (!bonepose)
+			continue;
+		surfs++;
+		verts += inf->numverts;
+
+		for (k = 0; k < 2; k++)
+		{
+			xyz[k] = BZ_Malloc(sizeof(*xyz[k])*inf->numverts);
+			norm[k] = BZ_Malloc(sizeof(*norm[k])*inf->numverts);
+			sdir[k] = BZ_Malloc(sizeof(*sdir[k])*inf->numverts);
+			tdir[k] = BZ_Malloc(sizeof(*tdir[k])*inf->numverts);
+		}
+
+		st = Sys_DoubleTime();
+		for (it = 0; it < iterations; it++)
+			Alias_TransformVerticies_V_Scalar(bonepose, inf->numverts, inf->ofs_skel_idx[0], inf->ofs_skel_weight[0], inf->ofs_skel_xyz[0], xyz[0][0]);
+		t[0] += Sys_DoubleTime() - st;
+		st = Sys_DoubleTime();
+		for (it = 0; it < iterations; it++)
+			Alias_TransformVerticies_V(bonepose, inf->numverts, inf->ofs_skel_idx[0], inf->ofs_skel_weight[0], inf->ofs_skel_xyz[0], xyz[1][0]);
+		t[1] += Sys_DoubleTime() - st;
+
+		st = Sys_DoubleTime();
+		for (it = 0; it < iterations; it++)
+			Alias_TransformVerticies_VN_Scalar(bonepose, inf->numverts, inf->ofs_skel_idx[0], inf->ofs_skel_weight[0], inf->ofs_skel_xyz[0], xyz[0][0], inf->ofs_skel_norm[0], norm[0][0]);
+		t[2] += Sys_DoubleTime() - st;
+		st = Sys_DoubleTime();
+		for (it = 0; it < iterations; it++)
+			Alias_TransformVerticies_VN(bonepose, inf->numverts, inf->ofs_skel_idx[0], inf->ofs_skel_weight[0], inf->ofs_skel_xyz[0], xyz[1][0], inf->ofs_skel_norm[0], norm[1][0]);
+		t[3] += Sys_DoubleTime() - st;
+
+		st = Sys_DoubleTime();
+		for (it = 0; it < iterations; it++)
+			Alias_TransformVerticies_VNST_Scalar(bonepose, inf->numverts, inf->ofs_skel_idx[0], inf->ofs_skel_weight[0], inf->ofs_skel_xyz[0], xyz[0][0], inf->ofs_skel_norm[0], norm[0][0], inf->ofs_skel_svect[0], sdir[0][0], inf->ofs_skel_tvect[0], tdir[0][0]);
+		t[4] += Sys_DoubleTime() - st;
+		st = Sys_DoubleTime();
+		for (it = 0; it < iterations; it++)
+			Alias_TransformVerticies_VNST(bonepose, inf->numverts, inf->ofs_skel_idx[0], inf->ofs_skel_weight[0], inf->ofs_skel_xyz[0], xyz[1][0], inf->ofs_skel_norm[0], norm[1][0], inf->ofs_skel_svect[0], sdir[1][0], inf->ofs_skel_tvect[0], tdir[1][0]);
+		t[5] += Sys_DoubleTime() - st;
+
+		for (it = 0; it < inf->numverts; it++)
+		{
+			for (k = 0; k < 3; k++)
+			{
+				maxdiff = max(maxdiff, fabs(xyz[0][it][k] - xyz[1][it][k]));
+				maxdiff = max(maxdiff, fabs(norm[0][it][k] - norm[1][it][k]));
+				maxdiff = max(maxdiff, fabs(sdir[0][it][k] - sdir[1][it][k]));
+				maxdiff = max(maxdiff, fabs(tdir[0][it][k] - tdir[1][it][k]));
+			}
+		}
+
+		for (k = 0; k < 2; k++)
+		{
+			BZ_Free(xyz[k]);
+			BZ_Free(norm[k]);
+			BZ_Free(sdir[k]);
+			BZ_Free(tdir[k]);
+		}
+	}
+	BZ_Free(bonebuf);
+
+	if (!verts)
+	{
+		Con_Printf("%s: %s has no skeletal surfaces\n", Cmd_Argv(0), mod->name);
+		return;
+	}
+	Con_Printf("%s: %i surfaces, %i verts, %i iterations\n", mod->name, surfs, verts, iterations);
+	for (k = 0; k < 3; k++)
+	{
+		static const char *kernelnames[] = {"V", "VN", "VNST"};
+		Con_Printf("%-5s scalar: %8.2f Mverts/sec", kernelnames[k], (t[k*2+0]>0)?verts*(double)iterations/t[k*2+0]/1000000:0);
+#ifdef SKEL_SIMD
+		Con_Printf("   " SKEL_SIMD ": %8.2f Mverts/sec", (t[k*2+1]>0)?verts*(double)iterations/t[k*2+1]/1000000:0);
+#endif
+		Con_Printf("\n");
+	}
+	Con_Printf("max difference: %g\n", maxdiff);
+}
+#endif
 
 void Alias_Register(void)
 {
+#ifdef SKELETALMODELS
+	Cvar_Register(&mod_skel_posecache, NULL);
+	if (!skelposecache.mutex)
+		skelposecache.mutex = Sys_CreateMutex();
+	Cmd_AddCommandD("mod_skinbench", Mod_SkinBench_f, "Times the vertex skinning functions against the named skeletal model, and reports vertices per second for each.");
+#endif
 #ifdef MD1MODELS
 #ifndef SERVERONLY
 	Cvar_Register(&dpcompat_nofloodfill, NULL);
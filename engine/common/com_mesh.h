@@ -281,6 +281,10 @@ void QDECL Alias_ForceConvertBoneData(skeltype_t sourcetype, const float *source
 qboolean Alias_GAliasBuildMesh(mesh_t *mesh, vbo_t **vbop, galiasinfo_t *inf, int surfnum, entity_t *e, qboolean allowskel);
 void Mod_DestroyMesh(galiasinfo_t *galias);
 void Alias_FlushCache(void);
+#if defined(SKELETALMODELS) && !defined(SERVERONLY)
+void Alias_PrepareBonePoses(entity_t *ents, size_t numents);
+void Alias_NewFrame(void);
+#endif
 void Alias_Shutdown(void);
 void Alias_Register(void);
 shader_t *Mod_ShaderForSkin(model_t *model, int surfaceidx, int num, float time, texnums_t **out_texnums);
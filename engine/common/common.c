@@ -6330,6 +6330,14 @@ void COM_WorkerFullSync(void)
 	Sys_UnlockConditional(com_workercondition[WG_MAIN]);
 }
 
+//how many threads are servicing the given queue, for anything that wants to split its work up.
+int COM_WorkerCount(wgroup_t tg)
+{
+	if (tg >= WG_COUNT || (tg!=WG_MAIN && com_workererror))
+		return 0;
+	return com_liveworkers[tg];
+}
+
 //main thread wants a specific object to be prioritised.
 //an ancestor of the work must be pending on either the main thread or the worker thread.
 //typically the worker gives us a signal to handle the final activation of the object.
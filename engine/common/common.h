@@ -833,6 +833,7 @@ void *FS_LoadMallocFile (const char *path, size_t *fsize);
 qbyte *FS_LoadMallocFileFlags (const char *path, unsigned int locateflags, size_t *fsize);
 qofs_t FS_LoadFile(const char *name, void **file);
 void FS_FreeFile(void *file);
+void *FS_LoadMappedFile(const char *path, size_t *fsize, qboolean filters);	//may return a view of the file instead of a copy. release with FS_FreeFile.
 
 qbyte *COM_LoadFile (const char *path, unsigned int locateflags, int usehunk, size_t *filesize);
 
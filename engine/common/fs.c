@@ -31,6 +31,9 @@ static cvar_t fs_game				= CVARAFCD	("fs_game"/*q3*/, "", "game"/*q2/qs*/, CVAR_
 static cvar_t fs_gamepath			= CVARAFD	("fs_gamepath"/*q3ish*/, "", "fs_gamedir"/*q2*/, CVAR_NOUNSAFEEXPAND|CVAR_NOSET|CVAR_NOSAVE, "Provided for Q2/Q3 compat. System path of the active gamedir.");
 static cvar_t fs_basepath			= CVARAFD	("fs_basepath"/*q3*/,    "", "fs_basedir"/*q2*/, CVAR_NOUNSAFEEXPAND|CVAR_NOSET|CVAR_NOSAVE, "Provided for Q2/Q3 compat. System path of the base directory.");
 static cvar_t fs_homepath			= CVARAFD	("fs_homepath"/*q3ish*/, "", "fs_homedir"/*q2ish*/, CVAR_NOUNSAFEEXPAND|CVAR_NOSET|CVAR_NOSAVE, "Provided for Q2/Q3 compat. System path of the base directory.");
+#ifdef FS_HAVEMMAP
+static cvar_t fs_mmap				= CVARD		("fs_mmap", "1", "Allows uncompressed files inside paks/pk3s to be mapped straight into memory instead of being copied, where the loader supports it (maps, models, sounds).");
+#endif
 static cvar_t dpcompat_ignoremodificationtimes = CVARAFD("fs_packageprioritisation", "1", "dpcompat_ignoremodificationtimes", CVAR_NOUNSAFEEXPAND|CVAR_NOSAVE, "Favours the package that is:\n0: Most recently modified\n1: Is alphabetically last (favour z over a, 9 over 0).");
 int active_fs_cachetype;
 static int fs_referencetype;
@@ -2847,6 +2850,55 @@ qbyte *QDECL COM_LoadStackFile (const char *path, void *buffer, int bufsize, siz
 }
 
 
+#ifdef FS_HAVEMMAP
+typedef struct fsmapping_s
+{
+	struct fsmapping_s *next;
+	void *data;
+	qofs_t len;
+} fsmapping_t;
+static fsmapping_t *fs_mappings;	//live views, so FS_FreeFile knows which pointers need unmapping.
+static void *fs_mappings_mutex;
+#endif
+
+//like FS_LoadMallocGroupFile, but where the file is stored uncompressed within a pak/pk3 it'll be mapped instead of copied.
+//the result is still writable and null terminated (changes are private), but MUST be released with FS_FreeFile.
+void *FS_LoadMappedFile(const char *path, size_t *fsize, qboolean filters)
+{
+#ifdef FS_HAVEMMAP
+	flocation_t loc;
+	qbyte *data;
+	fsmapping_t *m;
+
+	if (fs_mmap.ival && FS_FLocateFile(path, FSLF_IFFOUND, &loc) && loc.search && loc.search->handle->fsver >= 4 && loc.search->handle->MapFile)	//older plugins' structs end before MapFile
+	{
+		data = loc.search->handle->MapFile(loc.search->handle, &loc);
+		if (data && filters && loc.len >= 6 && ((data[0] == 0x1f && data[1] == 0x8b) || !memcmp(data, "\xfd""7zXZ", 6)))
+		{	//gzipped/xzed, so needs to go through VFS_Filter instead.
+			VFSOS_UnmapRegion(data, loc.len);
+			data = NULL;
+		}
+		if (data)
+		{
+			m = Z_Malloc(sizeof(*m));
+			m->data = data;
+			m->len = loc.len;
+			if (fs_mappings_mutex)
+				Sys_LockMutex(fs_mappings_mutex);
+			m->next = fs_mappings;
+			fs_mappings = m;
+			if (fs_mappings_mutex)
+				Sys_UnlockMutex(fs_mappings_mutex);
+
+			fs_accessed_time = realtime;
+			*fsize = loc.len;
+			return data;
+		}
+	}
+#endif
+	return FS_LoadMallocGroupFile(NULL, (char*)path, fsize, filters);
+}
+
 /*warning: at some point I'll change this function to return only read-only buffers*/
 qofs_t FS_LoadFile(const char *name, void **file)
 {
@@ -2858,6 +2910,30 @@ qofs_t FS_LoadFile(const char *name, void **file)
 }
 void FS_FreeFile(void *file)
 {
+#ifdef FS_HAVEMMAP
+	fsmapping_t **link, *m = NULL;
+	if (fs_mappings && file)
+	{
+		if (fs_mappings_mutex)
+			Sys_LockMutex(fs_mappings_mutex);
+		for (link = &fs_mappings; (m = *link); link = &m->next)
+		{
+			if (m->data == file)
+			{
+				*link = m->next;
+				break;
+			}
+		}
+		if (fs_mappings_mutex)
+			Sys_UnlockMutex(fs_mappings_mutex);
+	}
+	if (m)
+	{
+		VFSOS_UnmapRegion(m->data, m->len);
+		Z_Free(m);
+		return;
+	}
+#endif
 	BZ_Free(file);
 }
 
@@ -7483,6 +7559,9 @@ void COM_InitFilesystem (void)
 	Cvar_Register(&cfg_reload_on_gamedir, "Filesystem");
 	Cvar_Register(&dpcompat_ignoremodificationtimes, "Filesystem");
 	Cvar_Register(&com_fs_cache, "Filesystem");
+#ifdef FS_HAVEMMAP
+	Cvar_Register(&fs_mmap, "Filesystem");
+#endif
 	Cvar_Register(&fs_gamename, "Filesystem");
 #ifdef PACKAGEMANAGER
 	Cvar_Register(&pkg_autoupdate, "Filesystem");
@@ -7499,6 +7578,9 @@ void COM_InitFilesystem (void)
 	fs_readonly = COM_CheckParm("-readonly");
 
 	fs_thread_mutex = Sys_CreateMutex();
+#ifdef FS_HAVEMMAP
+	fs_mappings_mutex = Sys_CreateMutex();
+#endif
 }
 
 
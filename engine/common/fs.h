@@ -8,7 +8,11 @@ Files may be shared between threads, but not simultaneously.
 The filesystem driver is responsible for closing the pak/pk3 once all files are closed, and must ensure that opens+reads+closes as well as archive closure are thread safe.
 */
 
-#define FSVER 3
+#define FSVER 4
+
+#if !defined(_WIN32) && !defined(NACL) && !defined(FTE_TARGET_WEB) && !defined(WEBSVONLY)
+	#define FS_HAVEMMAP	//archives can hand out mmapped views of their stored files.
+#endif
 
 
 #define FF_NOTFOUND		(0u)	//file wasn't found
@@ -53,6 +57,7 @@ struct searchpathfuncs_s
 	qboolean		(QDECL *CreateFile)(searchpathfuncs_t *handle, flocation_t *loc, const char *filename);		//like FindFile, but returns a usable loc even if the file does not exist yet (may also create requisite directories too)
 	qboolean		(QDECL *RenameFile)(searchpathfuncs_t *handle, const char *oldname, const char *newname);	//returns true on success, false if source doesn't exist, or if dest does (cached locs may refer to either new or old name).
 	qboolean		(QDECL *RemoveFile)(searchpathfuncs_t *handle, const char *filename);	//returns true on success, false if it wasn't found or is readonly.
+	void *			(QDECL *MapFile)(searchpathfuncs_t *handle, flocation_t *loc);	//optional. returns a private null-terminated mapping of a file that is stored uncompressed, or NULL. release with VFSOS_UnmapRegion.
 };
 //searchpathfuncs_t *(QDECL *OpenNew)(vfsfile_t *file, const char *desc);	//returns a handle to a new pak/path
 
@@ -64,6 +69,10 @@ extern searchpathfuncs_t *(QDECL FSPAK_LoadArchive) (vfsfile_t *file, searchpath
 extern searchpathfuncs_t *(QDECL FSDWD_LoadArchive) (vfsfile_t *file, searchpathfuncs_t *parent, const char *filename, const char *desc, const char *prefix);
 extern searchpathfuncs_t *(QDECL FSDZ_LoadArchive)	(vfsfile_t *file, searchpathfuncs_t *parent, const char *filename, const char *desc, const char *prefix);
 vfsfile_t *QDECL VFSOS_Open(const char *osname, const char *mode);
+#ifdef FS_HAVEMMAP
+void *VFSOS_MapRegion(vfsfile_t *file, qofs_t offset, qofs_t len);	//NULL if the file isn't a plain os file.
+void VFSOS_UnmapRegion(void *data, qofs_t len);
+#endif
 vfsfile_t *FS_DecompressGZip(vfsfile_t *infile, vfsfile_t *outfile);
 
 int FS_RegisterFileSystemType(void *module, const char *extension, searchpathfuncs_t *(QDECL *OpenNew)(vfsfile_t *file, searchpathfuncs_t *parent, const char *filename, const char *desc, const char *prefix), qboolean loadscan);
@@ -294,6 +294,13 @@ static void QDECL FSPAK_ReadFile(searchpathfuncs_t *handle, flocation_t *loc, ch
 	VFS_CLOSE(f);
 }
 
+#ifdef FS_HAVEMMAP
+static void *QDECL FSPAK_MapFile(searchpathfuncs_t *handle, flocation_t *loc)
+{	//paks never compress anything, so this works whenever the pak itself is a real file.
+	pack_t *pak = (pack_t*)handle;
+	return VFSOS_MapRegion(pak->handle, loc->offset, loc->len);
+}
+#endif
 
 /*
 =================
@@ -385,6 +392,9 @@ searchpathfuncs_t *QDECL FSPAK_LoadArchive (vfsfile_t *file, searchpathfuncs_t *
 	pack->pub.EnumerateFiles = FSPAK_EnumerateFiles;
 	pack->pub.GeneratePureCRC = FSPAK_GeneratePureCRC;
 	pack->pub.OpenVFS = FSPAK_OpenVFS;
+#ifdef FS_HAVEMMAP
+	pack->pub.MapFile = FSPAK_MapFile;
+#endif
 	return &pack->pub;
 }
 
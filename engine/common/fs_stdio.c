@@ -235,6 +235,38 @@ vfsfile_t *VFSSTDIO_Open(const char *osname, const char *mode, qboolean *needsfl
 	return (vfsfile_t*)file;
 }
 
+#ifdef FS_HAVEMMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+//maps part of an os file into memory. the mapping is private (copy-on-write), so loaders can still scribble over it, and gets a null terminator like COM_LoadFile does.
+void *VFSOS_MapRegion(vfsfile_t *file, qofs_t offset, qofs_t len)
+{
+	vfsstdiofile_t *intfile = (vfsstdiofile_t*)file;
+	qofs_t pagemask = sysconf(_SC_PAGESIZE)-1;
+	qofs_t skip = offset & pagemask;
+	struct stat st;
+	qbyte *base;
+
+	if (!file || file->Close != VFSSTDIO_Close)
+		return NULL;	//not a real file (probably a pak inside a pk3 or something)
+	if (fstat(fileno(intfile->handle), &st) || offset+len > (qofs_t)st.st_size || skip+len+1 != (size_t)(skip+len+1))
+		return NULL;
+	if (offset+len == (qofs_t)st.st_size && !(st.st_size & pagemask))
+		return NULL;	//the terminator would land beyond the file's last page, which would be a SIGBUS
+	base = mmap(NULL, skip+len+1, PROT_READ|PROT_WRITE, MAP_PRIVATE, fileno(intfile->handle), offset-skip);
+	if (base == MAP_FAILED)
+		return NULL;
+	base[skip+len] = 0;
+	return base+skip;
+}
+void VFSOS_UnmapRegion(void *data, qofs_t len)
+{
+	size_t skip = (size_t)data & (sysconf(_SC_PAGESIZE)-1);
+	munmap((qbyte*)data-skip, skip+len+1);
+}
+#endif
+
 #ifndef WEBSVONLY
 #if !defined(_WIN32) || defined(FTE_SDL) || defined(WINRT) || defined(_XBOX)
 vfsfile_t *VFSOS_Open(const char *osname, const char *mode)
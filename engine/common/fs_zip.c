@@ -1461,6 +1461,23 @@ static vfsfile_t *QDECL FSZIP_OpenVFS(searchpathfuncs_t *handle, flocation_t *lo
 	return (vfsfile_t*)vfsz;
 }
 
+#ifdef FS_HAVEMMAP
+static void *QDECL FSZIP_MapFile(searchpathfuncs_t *handle, flocation_t *loc)
+{
+	zipfile_t *zip = (void*)handle;
+	zpackfile_t *pf = loc->fhandle;
+	qofs_t datastart, datasize;
+
+	//only plain stored files can be used as-is.
+	if ((pf->flags & (ZFL_STORED|ZFL_CORRUPT|ZFL_DEFLATED|ZFL_BZIP2|ZFL_SYMLINK|ZFL_WEAKENCRYPT)) != ZFL_STORED)
+		return NULL;
+	if (zip->thisdisk != pf->disknum || qofs_Error(loc->len))
+		return NULL;	//don't bother with spanned zips.
+	if (!FSZIP_ValidateLocalHeader(zip, pf, &datastart, &datasize) || datasize != loc->len)
+		return NULL;
+	return VFSOS_MapRegion(zip->raw, datastart, loc->len);
+}
+#endif
 
 //ZIP features:
 //zip64 for huge zips
@@ -2229,6 +2246,9 @@ searchpathfuncs_t *QDECL FSZIP_LoadArchive (vfsfile_t *packhandle, searchpathfun
 	zip->pub.FileStat			= FSZIP_FileStat;
 	zip->pub.GeneratePureCRC	= FSZIP_GeneratePureCRC;
 	zip->pub.OpenVFS			= FSZIP_OpenVFS;
+#ifdef FS_HAVEMMAP
+	zip->pub.MapFile			= FSZIP_MapFile;
+#endif
 	return &zip->pub;
 }
 
@@ -18,6 +18,9 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 */
 // net_wins.c
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE	//for recvmmsg/sendmmsg
+#endif
 #include "quakedef.h"
 #include "netinc.h"
 #include <stddef.h>
@@ -120,6 +123,12 @@ void IPX_CloseSocket (int socket);
 cvar_t	timeout					= CVARD("timeout","65", "Connections will time out if no packets are received for this duration of time.");		// seconds without any message
 cvar_t	net_hybriddualstack		= CVARD("net_hybriddualstack",		"1", "Uses hybrid ipv4+ipv6 sockets where possible. Not supported on xp or below.");
 cvar_t	net_fakeloss			= CVARFD("net_fakeloss",			"0", CVAR_CHEAT, "Simulates packetloss in both receiving and sending, on a scale from 0 to 1.");
+#ifdef HAVE_REUSEPORT
+static cvar_t net_querythreads	= CVARD("net_querythreads",			"0", "Number of extra threads (each with its own SO_REUSEPORT socket) that answer status/info queries sent to the server's udp ports, so that query floods cannot stall the game. Other packets still go to the main thread. Takes effect when the socket is next opened.");
+#endif
+#ifdef HAVE_MMSG
+static cvar_t net_batchudp		= CVARD("net_batchudp",				"1", "Read and write multiple udp packets per syscall on listening sockets. Takes effect when the socket is next opened.");
+#endif
 static cvar_t net_dns_ipv4		= CVARD("net_dns_ipv4",				"1", "If 0, disables dns resolution of names to ipv4 addresses (removing any associated error messages). Also hides ipv4 addresses in address:port listings.");
 static cvar_t net_dns_ipv6		= CVARD("net_dns_ipv6",				"1", "If 0, disables dns resolution of names to ipv6 addresses (removing any associated error messages). Also hides ipv6 addresses in address:port listings.");
 cvar_t	net_enabled				= CVARD("net_enabled",				"1", "If 0, disables all network access, including name resolution and socket creation. Does not affect loopback/internal connections.");
@@ -3701,6 +3710,59 @@ int FTENET_Generic_GetLocalAddresses(struct ftenet_generic_connection_s *con, un
 #endif
 }
 
+#ifdef HAVE_PACKET
+//prints something useful about a failed recv. from may be unset (AF_UNSPEC) if the os didn't tell us who it was.
+static void FTENET_Datagram_RecvError(ftenet_generic_connection_t *con, int err, struct sockaddr_qstorage *from, int fromlen)
+{
+	char		adr[MAX_ADR_SIZE];
+
+	if (err == NET_EMSGSIZE)
+	{
+		static unsigned int resettime;
+		unsigned int curtime = Sys_Milliseconds();
+		if (curtime-resettime >= 5000)	//throttle prints to once per 5 secs (even if they're about different clients, yay ddos)
+		{
+			SockadrToNetadr (from, fromlen, &net_from);
+			Con_TPrintf ("Warning:  Oversize packet from %s\n",
+			NET_AdrToString (adr, sizeof(adr), &net_from));
+		}
+		return;
+	}
+	if (err == NET_ECONNABORTED || err == NET_ECONNRESET)
+	{
+		static unsigned int resettime;
+		unsigned int curtime = Sys_Milliseconds();
+		if (curtime-resettime >= 5000 || err == NET_ECONNRESET)	//throttle prints to once per 5 secs (even if they're about different clients, yay ddos)
+		{
+			if (((struct sockaddr*)from)->sa_family != AF_UNSPEC)
+			{
+				SockadrToNetadr (from, fromlen, &net_from);
+				Con_TPrintf ("Connection lost or aborted (%s)\n", NET_AdrToString (adr, sizeof(adr), &net_from));	//server died/connection lost.
+			}
+			else
+				Con_TPrintf ("Connection lost or aborted\n");	//server died/connection lost.
+			resettime = curtime;
+#ifdef HAVE_CLIENT
+			//fixme: synthesise a reset packet for the caller to handle? "\xff\xff\xff\xffreset" ?
+			if (cls.state != ca_disconnected && !con->islisten)
+			{
+				if (cls.lastarbiatarypackettime+5 < Sys_DoubleTime())	//too many mvdsv
+					Cbuf_AddText("disconnect\nreconnect\n", RESTRICT_LOCAL);	//retry connecting.
+				else
+					Con_Printf("Packet was not delivered - server might be badly configured\n");
+			}
+#endif
+		}
+		return;
+	}
+
+	if (((struct sockaddr*)from)->sa_family != AF_UNSPEC)
+		Con_Printf ("NET_GetPacket: Error (%i): %s (%s)\n", err, strerror(err), NET_AdrToString (adr, sizeof(adr), &net_from));
+	else
+		Con_Printf ("NET_GetPacket: Error (%i): %s\n", err, strerror(err));
+}
+#endif
+
 qboolean FTENET_Datagram_GetPacket(ftenet_generic_connection_t *con)
 {
 #ifndef HAVE_PACKET
@@ -3725,51 +3787,7 @@ qboolean FTENET_Datagram_GetPacket(ftenet_generic_connection_t *con)
 
 		if (err == NET_EWOULDBLOCK)
 			return false;
-		if (err == NET_EMSGSIZE)
-		{
-			static unsigned int resettime;
-			unsigned int curtime = Sys_Milliseconds();
-			if (curtime-resettime >= 5000)	//throttle prints to once per 5 secs (even if they're about different clients, yay ddos)
-			{
-				SockadrToNetadr (&from, fromlen, &net_from);
-				Con_TPrintf ("Warning:  Oversize packet from %s\n",
-				NET_AdrToString (adr, sizeof(adr), &net_from));
-			}
-			return false;
-		}
-		if (err == NET_ECONNABORTED || err == NET_ECONNRESET)
-		{
-			static unsigned int resettime;
-			unsigned int curtime = Sys_Milliseconds();
-			if (curtime-resettime >= 5000 || err == NET_ECONNRESET)	//throttle prints to once per 5 secs (even if they're about different clients, yay ddos)
-			{
-				if (((struct sockaddr*)&from)->sa_family != AF_UNSPEC)
-				{
-					SockadrToNetadr (&from, fromlen, &net_from);
-					Con_TPrintf ("Connection lost or aborted (%s)\n", NET_AdrToString (adr, sizeof(adr), &net_from));	//server died/connection lost.
-				}
-				else
-					Con_TPrintf ("Connection lost or aborted\n");	//server died/connection lost.
-				resettime = curtime;
-#ifdef HAVE_CLIENT
-				//fixme: synthesise a reset packet for the caller to handle? "\xff\xff\xff\xffreset" ?
-				if (cls.state != ca_disconnected && !con->islisten)
-				{
-					if (cls.lastarbiatarypackettime+5 < Sys_DoubleTime())	//too many mvdsv
-						Cbuf_AddText("disconnect\nreconnect\n", RESTRICT_LOCAL);	//retry connecting.
-					else
-						Con_Printf("Packet was not delivered - server might be badly configured\n");
-					return false;
-				}
-#endif
-			}
-			return false;
-		}
-
-		if (((struct sockaddr*)&from)->sa_family != AF_UNSPEC)
-			Con_Printf ("NET_GetPacket: Error (%i): %s (%s)\n", err, strerror(err), NET_AdrToString (adr, sizeof(adr), &net_from));
-		else
-			Con_Printf ("NET_GetPacket: Error (%i): %s\n", err, strerror(err));
+		FTENET_Datagram_RecvError(con, err, &from, fromlen);
 		return false;
 	}
 
@@ -3794,90 +3812,750 @@ qboolean FTENET_Datagram_GetPacket(ftenet_generic_connection_t *con)
 #endif
 }
 
-neterr_t FTENET_Datagram_SendPacket(ftenet_generic_connection_t *con, int length, const void *data, netadr_t *to)
+#ifdef HAVE_PACKET
+//converts the address to something the socket can use. returns 0 if its the wrong type of address for this connection.
+static int FTENET_Datagram_ToSockadr(ftenet_generic_connection_t *con, netadr_t *to, struct sockaddr_qstorage *addr)
 {
-#ifndef HAVE_PACKET
-	return NETERR_DISCONNECTED;
-#else
-	struct sockaddr_qstorage	addr;
 	int size;
-	int ret;
 
 	if (to->prot != NP_DGRAM)
-		return NETERR_NOROUTE;
+		return 0;
 
 	for (size = 0; size < FTENET_ADDRTYPES; size++)
 		if (to->type == con->addrtype[size])
 			break;
 	if (size == FTENET_ADDRTYPES)
-		return NETERR_NOROUTE;
+		return 0;
 
 #ifdef HAVE_IPV6
 	/*special code to handle sending to hybrid sockets*/
 	if (con->addrtype[1] == NA_IPV6 && to->type == NA_IP)
 	{
-		memset(&addr, 0, sizeof(struct sockaddr_in6));
-		((struct sockaddr_in6*)&addr)->sin6_family = AF_INET6;
-		*(short*)&((struct sockaddr_in6*)&addr)->sin6_addr.s6_addr[10] = 0xffff;
-		*(int*)&((struct sockaddr_in6*)&addr)->sin6_addr.s6_addr[12] = *(int*)&to->address.ip;
-		((struct sockaddr_in6*)&addr)->sin6_port = to->port;
-		size = sizeof(struct sockaddr_in6);
+		memset(addr, 0, sizeof(struct sockaddr_in6));
+		((struct sockaddr_in6*)addr)->sin6_family = AF_INET6;
+		*(short*)&((struct sockaddr_in6*)addr)->sin6_addr.s6_addr[10] = 0xffff;
+		*(int*)&((struct sockaddr_in6*)addr)->sin6_addr.s6_addr[12] = *(int*)&to->address.ip;
+		((struct sockaddr_in6*)addr)->sin6_port = to->port;
+		return sizeof(struct sockaddr_in6);
 	}
-	else
 #endif
+	return NetadrToSockadr (to, addr);
+}
+
+//maps the errno from a failed send to something our callers can understand, printing anything unexpected.
+static neterr_t FTENET_Datagram_SendError(int ecode, netadr_t *to)
+{
+// wouldblock is silent
+	if (ecode == NET_EWOULDBLOCK)
+		return NETERR_CLOGGED;
+
+	if (ecode == NET_ECONNREFUSED)
+		return NETERR_DISCONNECTED;
+
+	if (ecode == NET_EMSGSIZE)
+		return NETERR_MTU;
+
+	if (ecode == NET_EADDRNOTAVAIL)
+		return NETERR_NOROUTE;	//this interface doesn't actually support that (eg: happens when ipv6 is disabled on a specific interface).
+
+	if (ecode == NET_EACCES)
 	{
-		size = NetadrToSockadr (to, &addr);
+		Con_Printf("Access denied: check firewall\n");
+		return NETERR_DISCONNECTED;
+	}
+
+	{
+		char adr[256];
+		if (ecode==NET_ENETUNREACH&&to->type==NA_IPV6)	//ipv6 support STILL sucks too much. don't spam non-developers, its just annoying.
+			Con_DPrintf("NET_SendPacket(%s) Warning: %i\n", NET_AdrToString (adr, sizeof(adr), to), ecode);
+#ifdef HAVE_CLIENT
+		else if (ecode == NET_EADDRNOTAVAIL || (ecode==NET_ENETUNREACH&&to->type==NA_IPV6))
+			Con_DPrintf("NET_SendPacket(%s) Warning: %i\n", NET_AdrToString (adr, sizeof(adr), to), ecode);
+		else
+#endif
+		{
+#ifdef _WIN32
+			Con_Printf ("NET_SendPacket(%s) ERROR: %i\n", NET_AdrToString (adr, sizeof(adr), to), ecode);
+#else
+			Con_Printf ("NET_SendPacket(%s) ERROR: %s\n", NET_AdrToString (adr, sizeof(adr), to), strerror(ecode));
+#endif
+		}
 	}
+	return NETERR_SENT;
+}
+#endif
+
+neterr_t FTENET_Datagram_SendPacket(ftenet_generic_connection_t *con, int length, const void *data, netadr_t *to)
+{
+#ifndef HAVE_PACKET
+	return NETERR_DISCONNECTED;
+#else
+	struct sockaddr_qstorage	addr;
+	int size;
+	int ret;
+
+	size = FTENET_Datagram_ToSockadr(con, to, &addr);
+	if (!size)
+		return NETERR_NOROUTE;
 
 	if (!data)
 		ret = 0;	//don't send a runt, but pretend we did... yes, this'll confuse EnsureRoute, but at least it'll ensure there's a udp socket open, somewhere.
 	else
 		ret = sendto (con->thesocket, data, length, 0, (struct sockaddr*)&addr, size );
 	if (ret == -1)
+		return FTENET_Datagram_SendError(neterrno(), to);
+	else if (ret < length)
+		return NETERR_MTU;
+	return NETERR_SENT;
+#endif
+}
+
+#if defined(HAVE_MMSG) || defined(HAVE_REUSEPORT)
+/*
+batched datagram connections read+write multiple packets per syscall, which helps when there's lots of clients.
+reads are always batched, packets are handed out one at a time by GetPacket.
+writes are only queued while BatchSends is active (ie: while the server is sending out its per-client packets).
+
+query threads each own an extra socket bound to the same port with SO_REUSEPORT.
+a bpf program makes the kernel deliver connectionless packets (0xffffffff) to those sockets and everything else to ours,
+so status floods get answered (or dropped) without ever touching the main thread.
+anything the threads can't handle gets queued for our GetPacket.
+*/
+#define DGRAM_BATCH 32
+#define DGRAM_SLOTSIZE 2048	//comfortably bigger than anything that doesn't get ip-fragmented. bigger packets spill over into a shared buffer.
+#define MAX_QUERYTHREADS 8
+#ifdef HAVE_REUSEPORT
+typedef struct dgramqueued_s
+{
+	struct dgramqueued_s *next;
+	netadr_t from;
+	size_t length;
+	qbyte data[1];
+} dgramqueued_t;
+typedef struct
+{
+	struct ftenet_datagram_connection_s *con;
+	SOCKET sock;
+	void *thread;
+	unsigned int handled, passed;	//for the status command
+} dgramquerythread_t;
+#endif
+typedef struct ftenet_datagram_connection_s
+{
+	ftenet_generic_connection_t generic;
+	qboolean (*RawGetPacket)(ftenet_generic_connection_t *con);
+
+#ifdef HAVE_REUSEPORT
+	volatile qboolean querydie;
+	unsigned int numquerythreads;
+	dgramquerythread_t querythread[MAX_QUERYTHREADS];
+	void *queuemutex;
+	dgramqueued_t *queuehead, **queuetail;
+	unsigned int queuecount;
+	int wakefd[2];	//written to whenever a packet is queued, so NET_Sleep wakes up for it.
+#ifdef HAVE_EPOLL
+	epollctx_t wakeepoll;
+#endif
+#endif
+
+#ifdef HAVE_MMSG
+	unsigned int rxcount;	//number of packets in the rx buffers
+	unsigned int rxnext;	//next one to give to GetPacket
+	int rxspill;			//the last packet in the batch that spilled into rxoverflow. any earlier ones had their tails overwritten.
+	struct mmsghdr rxhdr[DGRAM_BATCH];
+	struct iovec rxiov[DGRAM_BATCH][2];
+	struct sockaddr_qstorage rxaddr[DGRAM_BATCH];
+	qbyte rxdata[DGRAM_BATCH][DGRAM_SLOTSIZE];
+	qbyte rxoverflow[MAX_OVERALLMSGLEN-DGRAM_SLOTSIZE];	//same total limit as the unbatched path, but without needing a full buffer per slot.
+
+	qboolean txbatch;
+	unsigned int txcount;
+	struct mmsghdr txhdr[DGRAM_BATCH];
+	struct iovec txiov[DGRAM_BATCH];
+	struct sockaddr_qstorage txaddr[DGRAM_BATCH];
+	qbyte txdata[DGRAM_BATCH][MAX_UDP_PACKET];
+	unsigned int txerrcount;	//errors from queued packets, reported to the next send to the same address.
+	netadr_t txerradr[DGRAM_BATCH];
+	neterr_t txerr[DGRAM_BATCH];
+
+	//for the status command
+	unsigned int rxsyscalls, rxpackets;
+	unsigned int txsyscalls, txpackets;
+#endif
+} ftenet_datagram_connection_t;
+
+#ifdef HAVE_MMSG
+
+static qboolean FTENET_Datagram_GetPacketBatched(ftenet_generic_connection_t *gcon)
+{
+	ftenet_datagram_connection_t *con = (ftenet_datagram_connection_t*)gcon;
+	struct msghdr *hdr;
+	unsigned int i;
+	int ret;
+	char adr[MAX_ADR_SIZE];
+
+	if (gcon->thesocket == INVALID_SOCKET)
+		return false;
+
+	for(;;)
 	{
-		int ecode = neterrno();
-// wouldblock is silent
-		if (ecode == NET_EWOULDBLOCK)
-			return NETERR_CLOGGED;
+		if (con->rxnext == con->rxcount)
+		{
+			con->rxnext = con->rxcount = 0;
+			for (i = 0; i < DGRAM_BATCH; i++)
+			{
+				hdr = &con->rxhdr[i].msg_hdr;
+				con->rxiov[i][0].iov_base = con->rxdata[i];
+				con->rxiov[i][0].iov_len = sizeof(con->rxdata[i]);
+				con->rxiov[i][1].iov_base = con->rxoverflow;
+				con->rxiov[i][1].iov_len = sizeof(con->rxoverflow);
+				memset(hdr, 0, sizeof(*hdr));
+				hdr->msg_name = &con->rxaddr[i];
+				hdr->msg_namelen = sizeof(con->rxaddr[i]);
+				hdr->msg_iov = con->rxiov[i];
+				hdr->msg_iovlen = 2;
+			}
+			ret = recvmmsg(gcon->thesocket, con->rxhdr, DGRAM_BATCH, MSG_DONTWAIT, NULL);
+			if (ret <= 0)
+			{
+				if (ret < 0)
+				{
+					int err = neterrno();
+					if (err != NET_EWOULDBLOCK)
+					{	//the error is consumed by this call, so report it here instead of hoping recvfrom sees it too.
+						((struct sockaddr*)&con->rxaddr[0])->sa_family = AF_UNSPEC;
+						FTENET_Datagram_RecvError(gcon, err, &con->rxaddr[0], sizeof(con->rxaddr[0]));
+					}
+				}
+				return false;
+			}
+			con->rxcount = ret;
+			con->rxsyscalls++;
+			con->rxpackets += ret;
+			con->rxspill = -1;
+			for (i = 0; i < con->rxcount; i++)
+				if (con->rxhdr[i].msg_len > DGRAM_SLOTSIZE)
+					con->rxspill = i;
+		}
 
-		if (ecode == NET_ECONNREFUSED)
-			return NETERR_DISCONNECTED;
+		i = con->rxnext++;
+		hdr = &con->rxhdr[i].msg_hdr;
+		SockadrToNetadr (&con->rxaddr[i], hdr->msg_namelen, &net_from);
 
-		if (ecode == NET_EMSGSIZE)
-			return NETERR_MTU;
+		if ((hdr->msg_flags & MSG_TRUNC) || con->rxhdr[i].msg_len >= sizeof(net_message_buffer))
+		{
+			static unsigned int resettime;
+			unsigned int curtime = Sys_Milliseconds();
+			if (curtime-resettime >= 5000)	//throttle prints to once per 5 secs (even if they're about different clients, yay ddos)
+			{
+				Con_TPrintf ("Warning:  Oversize packet from %s\n", NET_AdrToString (adr, sizeof(adr), &net_from));
+				resettime = curtime;
+			}
+			continue;
+		}
+		if (net_from.type == NA_INVALID)
+		{	//this really shouldn't happen. Blame the OS.
+			Con_TPrintf ("Warning: sender's address type not known (%i)\n", (int)((struct sockaddr*)&con->rxaddr[i])->sa_family);
+			continue;	//packet from an unsupported protocol? no way can we respond, so what's the point
+		}
+
+		if (con->rxhdr[i].msg_len > DGRAM_SLOTSIZE)
+		{
+			if (i != con->rxspill)
+			{	//a later packet in the same batch overwrote the rest of this one. two big packets at once is rare enough to just drop it.
+				Con_DPrintf ("Dropped oversize packet from %s\n", NET_AdrToString (adr, sizeof(adr), &net_from));
+				continue;
+			}
+			memcpy(net_message_buffer, con->rxdata[i], DGRAM_SLOTSIZE);
+			memcpy(net_message_buffer+DGRAM_SLOTSIZE, con->rxoverflow, con->rxhdr[i].msg_len-DGRAM_SLOTSIZE);
+		}
+		else
+			memcpy(net_message_buffer, con->rxdata[i], con->rxhdr[i].msg_len);
+		net_message.packing = SZ_RAWBYTES;
+		net_message.currentbit = 0;
+		net_message.cursize = con->rxhdr[i].msg_len;
+		return true;
+	}
+}
 
-		if (ecode == NET_EADDRNOTAVAIL)
-			return NETERR_NOROUTE;	//this interface doesn't actually support that (eg: happens when ipv6 is disabled on a specific interface).
+static void FTENET_Datagram_Flush(ftenet_datagram_connection_t *con)
+{
+	unsigned int sent = 0, i;
+	int ret;
+	netadr_t to;
+	neterr_t err;
 
-		if (ecode == NET_EACCES)
+	while (sent < con->txcount)
+	{
+		ret = sendmmsg(con->generic.thesocket, con->txhdr+sent, con->txcount-sent, 0);
+		con->txsyscalls++;
+		if (ret > 0)
 		{
-			Con_Printf("Access denied: check firewall\n");
-			return NETERR_DISCONNECTED;
+			con->txpackets += ret;
+			sent += ret;
+			continue;
 		}
 
+		//sendmmsg only fails outright when the first packet fails (later failures just cut the batch short).
+		//resend that one by itself so it gets the same treatment as an unbatched send, and carry on with the rest.
+		SockadrToNetadr(&con->txaddr[sent], con->txhdr[sent].msg_hdr.msg_namelen, &to);
+		ret = sendto(con->generic.thesocket, con->txiov[sent].iov_base, con->txiov[sent].iov_len, 0, (struct sockaddr*)&con->txaddr[sent], con->txhdr[sent].msg_hdr.msg_namelen);
+		if (ret == -1)
+			err = FTENET_Datagram_SendError(neterrno(), &to);
+		else if (ret < con->txiov[sent].iov_len)
+			err = NETERR_MTU;
+		else
+			err = NETERR_SENT;
+		con->txsyscalls++;
+		sent++;
+
+		if (err != NETERR_SENT)
+		{	//the netchan has already been told it was sent, so hand the error to its next send instead (eg: so it can reduce its mss).
+			for (i = 0; i < con->txerrcount; i++)
+				if (NET_CompareAdr(&con->txerradr[i], &to))
+					break;
+			if (i == con->txerrcount)
+			{
+				if (con->txerrcount == countof(con->txerr))
+					continue;	//too many errors to track. they'll fail again anyway.
+				con->txerrcount++;
+			}
+			con->txerradr[i] = to;
+			con->txerr[i] = err;
+		}
+		else
+			con->txpackets++;
+	}
+	con->txcount = 0;
+}
+
+static neterr_t FTENET_Datagram_SendPacketBatched(ftenet_generic_connection_t *gcon, int length, const void *data, netadr_t *to)
+{
+	ftenet_datagram_connection_t *con = (ftenet_datagram_connection_t*)gcon;
+	struct msghdr *hdr;
+	int size;
+	unsigned int i;
+	neterr_t err = NETERR_SENT, ret;
+
+	//report anything that went wrong with the last queued packet to this address.
+	for (i = 0; i < con->txerrcount; i++)
+	{
+		if (NET_CompareAdr(&con->txerradr[i], to))
 		{
-			char adr[256];
-			if (ecode==NET_ENETUNREACH&&to->type==NA_IPV6)	//ipv6 support STILL sucks too much. don't spam non-developers, its just annoying.
-				Con_DPrintf("NET_SendPacket(%s) Warning: %i\n", NET_AdrToString (adr, sizeof(adr), to), ecode);
-#ifdef HAVE_CLIENT
-			else if (ecode == NET_EADDRNOTAVAIL || (ecode==NET_ENETUNREACH&&to->type==NA_IPV6))
-				Con_DPrintf("NET_SendPacket(%s) Warning: %i\n", NET_AdrToString (adr, sizeof(adr), to), ecode);
-			else
+			err = con->txerr[i];
+			con->txerrcount--;
+			con->txerradr[i] = con->txerradr[con->txerrcount];
+			con->txerr[i] = con->txerr[con->txerrcount];
+			break;
+		}
+	}
+
+	if (!con->txbatch || !data || length > sizeof(con->txdata[0]))
+	{
+		if (con->txcount)
+			FTENET_Datagram_Flush(con);	//don't reorder stuff.
+		ret = FTENET_Datagram_SendPacket(gcon, length, data, to);
+		return (ret == NETERR_SENT)?err:ret;
+	}
+
+	size = FTENET_Datagram_ToSockadr(gcon, to, &con->txaddr[con->txcount]);
+	if (!size)
+		return NETERR_NOROUTE;
+
+	memcpy(con->txdata[con->txcount], data, length);
+	con->txiov[con->txcount].iov_base = con->txdata[con->txcount];
+	con->txiov[con->txcount].iov_len = length;
+	hdr = &con->txhdr[con->txcount].msg_hdr;
+	memset(hdr, 0, sizeof(*hdr));
+	hdr->msg_name = &con->txaddr[con->txcount];
+	hdr->msg_namelen = size;
+	hdr->msg_iov = &con->txiov[con->txcount];
+	hdr->msg_iovlen = 1;
+
+	if (++con->txcount == DGRAM_BATCH)
+		FTENET_Datagram_Flush(con);
+	return err;	//errors from this packet get reported on the next send to the same address.
+}
+
+static void FTENET_Datagram_BatchSends(ftenet_generic_connection_t *gcon, qboolean batch)
+{
+	ftenet_datagram_connection_t *con = (ftenet_datagram_connection_t*)gcon;
+	con->txbatch = batch;
+	if (!batch && con->txcount)
+		FTENET_Datagram_Flush(con);
+}
+
 #endif
+
+#ifdef HAVE_REUSEPORT
+static qboolean FTENET_Datagram_GetPacketQueued(ftenet_generic_connection_t *gcon)
+{
+	ftenet_datagram_connection_t *con = (ftenet_datagram_connection_t*)gcon;
+	dgramqueued_t *q;
+
+	Sys_LockMutex(con->queuemutex);
+	q = con->queuehead;
+	if (q)
+	{
+		con->queuehead = q->next;
+		if (!con->queuehead)
+			con->queuetail = &con->queuehead;
+		con->queuecount--;
+	}
+	Sys_UnlockMutex(con->queuemutex);
+
+	if (!q)
+		return con->RawGetPacket(gcon);
+
+	net_from = q->from;
+	memcpy(net_message_buffer, q->data, q->length);
+	net_message.packing = SZ_RAWBYTES;
+	net_message.currentbit = 0;
+	net_message.cursize = q->length;
+	BZ_Free(q);
+	return true;
+}
+
+//called from query threads, for packets that need the main thread.
+static void FTENET_Datagram_QueuePacket(ftenet_datagram_connection_t *con, netadr_t *from, const qbyte *data, size_t length)
+{
+	dgramqueued_t *q;
+	qboolean wake;
+
+	if (con->queuecount >= 256)
+		return;	//main thread isn't keeping up. its only connectionless stuff though, so they'll retry.
+	q = BZ_Malloc(sizeof(*q) + length);
+	if (!q)
+		return;
+	q->next = NULL;
+	q->from = *from;
+	q->length = length;
+	memcpy(q->data, data, length);
+
+	Sys_LockMutex(con->queuemutex);
+	wake = !con->queuehead;
+	*con->queuetail = q;
+	con->queuetail = &q->next;
+	con->queuecount++;
+	Sys_UnlockMutex(con->queuemutex);
+
+	if (wake && con->wakefd[1] >= 0)
+		(void)!write(con->wakefd[1], "", 1);	//if the pipe is full then its going to wake up anyway.
+}
+
+static void FTENET_Datagram_QueryReply(void *ctx, netadr_t *to, const void *data, size_t length)
+{
+	dgramquerythread_t *qt = ctx;
+	struct sockaddr_qstorage addr;
+	int size = FTENET_Datagram_ToSockadr(&qt->con->generic, to, &addr);
+	if (size)
+		sendto(qt->sock, data, length, 0, (struct sockaddr*)&addr, size);
+}
+
+static int FTENET_Datagram_QueryThread(void *arg)
+{
+	dgramquerythread_t *qt = arg;
+	ftenet_datagram_connection_t *con = qt->con;
+	ftenet_connections_t *col = con->generic.owner;
+	struct sockaddr_qstorage addr;
+	socklen_t addrlen;
+	qbyte data[MAX_UDP_PACKET];
+	netadr_t from;
+	int ret;
+
+	while (!con->querydie)
+	{
+		addrlen = sizeof(addr);
+		ret = recvfrom(qt->sock, (char*)data, sizeof(data), MSG_TRUNC, (struct sockaddr*)&addr, &addrlen);
+		if (ret <= 0 || ret > sizeof(data))
+			continue;	//timeouts, shutdowns, icmp errors, oversized packets...
+		SockadrToNetadr(&addr, addrlen, &from);
+		if (from.type == NA_INVALID)
+			continue;
+
+		if (ret >= 4 && !memcmp(data, "\xff\xff\xff\xff", 4) && col->ThreadedConnectionless)
+		{
+			if (col->ThreadedConnectionless(&from, data, ret, FTENET_Datagram_QueryReply, qt))
 			{
-#ifdef _WIN32
-				Con_Printf ("NET_SendPacket(%s) ERROR: %i\n", NET_AdrToString (adr, sizeof(adr), to), ecode);
-#else
-				Con_Printf ("NET_SendPacket(%s) ERROR: %s\n", NET_AdrToString (adr, sizeof(adr), to), strerror(ecode));
-#endif
+				qt->handled++;
+				continue;
 			}
 		}
+		//connects, rcon, or game packets if the kernel didn't take our bpf program.
+		FTENET_Datagram_QueuePacket(con, &from, data, ret);
+		qt->passed++;
+	}
+	return 0;
+}
+
+#ifdef HAVE_EPOLL
+static void FTENET_Datagram_WakePolled(epollctx_t *ctx, unsigned int events)
+{
+	ftenet_datagram_connection_t *con = NULL;
+	char junk[64];
+	con = (ftenet_datagram_connection_t *)((qbyte*)ctx - ((qbyte*)&con->wakeepoll-(qbyte*)con));
+	while (read(con->wakefd[0], junk, sizeof(junk)) > 0)
+		;
+	while (con->generic.GetPacket(&con->generic))
+	{
+		net_from.connum = con->generic.connum;
+		con->generic.owner->ReadGamePacket();
+	}
+}
+#endif
+
+//opens the extra sockets and their threads. our own socket must already be bound (with SO_REUSEPORT) so that it gets index 0 in the group.
+static void FTENET_Datagram_StartQueryThreads(ftenet_datagram_connection_t *con, int family, int protocol, qboolean hybrid, struct sockaddr_qstorage *qs, int qslen, int count)
+{
+	unsigned long _true = true;
+	unsigned long _false = false;
+	struct timeval tv = {1, 0};	//so they notice querydie even if shutdown doesn't wake them
+	dgramquerythread_t *qt;
+	SOCKET sock;
+
+	count = min(count, MAX_QUERYTHREADS);
+	con->wakefd[0] = con->wakefd[1] = -1;
+	con->queuemutex = Sys_CreateMutex();
+	con->queuetail = &con->queuehead;
+	if (!con->queuemutex)
+		return;
+	if (pipe2(con->wakefd, O_NONBLOCK|O_CLOEXEC) < 0)
+		con->wakefd[0] = con->wakefd[1] = -1;
+	else
+	{
+#ifdef HAVE_EPOLL
+		{
+			struct epoll_event event = {EPOLLIN|EPOLLET, {&con->wakeepoll}};
+			con->wakeepoll.Polled = FTENET_Datagram_WakePolled;
+			epoll_ctl(epoll_fd, EPOLL_CTL_ADD, con->wakefd[0], &event);
+		}
+#endif
+	}
+
+	while (con->numquerythreads < count)
+	{
+		sock = socket(family, SOCK_CLOEXEC|SOCK_DGRAM, protocol);
+		if (sock == INVALID_SOCKET)
+			break;
+#if defined(HAVE_IPV6) && defined(IPV6_V6ONLY)
+		if (family == AF_INET6)
+			setsockopt(sock, IPPROTO_IPV6, IPV6_V6ONLY, hybrid?(char *)&_false:(char *)&_true, sizeof(_true));
+#endif
+		setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, (char *)&_true, sizeof(_true));
+		setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (char *)&tv, sizeof(tv));
+		if (bind(sock, (struct sockaddr *)qs, qslen) == INVALID_SOCKET)
+		{
+			Con_Printf(CON_ERROR "Unable to bind query socket: %s\n", strerror(neterrno()));
+			closesocket(sock);
+			break;
+		}
+
+		qt = &con->querythread[con->numquerythreads];
+		qt->con = con;
+		qt->sock = sock;
+		qt->thread = Sys_CreateThread("udpquery", FTENET_Datagram_QueryThread, qt, THREADP_NORMAL, 0);
+		if (!qt->thread)
+		{
+			closesocket(sock);
+			break;
+		}
+		con->numquerythreads++;
+	}
+
+	if (con->numquerythreads)
+	{	//only spread over the sockets that actually got a thread, or packets would land on sockets that nothing reads
+		struct sock_filter steer[] = {
+			BPF_STMT(BPF_LD|BPF_W|BPF_ABS, 0),					//first 4 bytes of the udp payload (packets that are too short give 0)
+			BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, 0xffffffff, 1, 0),
+			BPF_STMT(BPF_RET|BPF_K, 0),							//sequenced packets go to the main thread's socket
+			BPF_STMT(BPF_LD|BPF_W|BPF_ABS, SKF_AD_OFF+SKF_AD_RANDOM),
+			BPF_STMT(BPF_ALU|BPF_MOD|BPF_K, con->numquerythreads),
+			BPF_STMT(BPF_ALU|BPF_ADD|BPF_K, 1),
+			BPF_STMT(BPF_RET|BPF_A, 0),							//connectionless packets get spread over the query sockets
+		};
+		struct sock_fprog prog = {countof(steer), steer};
+		if (setsockopt(con->generic.thesocket, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, (char *)&prog, sizeof(prog)) < 0)
+			Con_Printf(CON_WARNING "Unable to steer packets to query threads (%s), game packets will be delayed\n", strerror(neterrno()));
+	}
+}
+
+static void FTENET_Datagram_StopQueryThreads(ftenet_datagram_connection_t *con)
+{
+	unsigned int i;
+	dgramqueued_t *q;
+
+	con->querydie = true;
+	for (i = 0; i < con->numquerythreads; i++)
+		shutdown(con->querythread[i].sock, SHUT_RDWR);	//wakes up the blocking recvfrom
+	for (i = 0; i < con->numquerythreads; i++)
+	{
+		Sys_WaitOnThread(con->querythread[i].thread);
+		closesocket(con->querythread[i].sock);
+	}
+	con->numquerythreads = 0;
+
+	while ((q = con->queuehead))
+	{
+		con->queuehead = q->next;
+		BZ_Free(q);
+	}
+	if (con->wakefd[0] >= 0)
+	{
+#ifdef HAVE_EPOLL
+		epoll_ctl(epoll_fd, EPOLL_CTL_DEL, con->wakefd[0], NULL);
+#endif
+		close(con->wakefd[0]);
+		close(con->wakefd[1]);
+	}
+	if (con->queuemutex)
+		Sys_DestroyMutex(con->queuemutex);
+}
+#endif
+
+static void FTENET_Datagram_PrintStatus(ftenet_generic_connection_t *gcon)
+{
+	ftenet_datagram_connection_t *con = (ftenet_datagram_connection_t*)gcon;
+#ifdef HAVE_MMSG
+	if (gcon->GetPacket == FTENET_Datagram_GetPacketBatched || con->RawGetPacket == FTENET_Datagram_GetPacketBatched)
+		Con_Printf("%s: %u packets in %u recvmmsg calls, %u packets in %u sendmmsg calls\n", gcon->name, con->rxpackets, con->rxsyscalls, con->txpackets, con->txsyscalls);
+#endif
+#ifdef HAVE_REUSEPORT
+	{
+		unsigned int i;
+		for (i = 0; i < con->numquerythreads; i++)
+			Con_Printf("%s: query thread %u answered %u packets, passed on %u\n", gcon->name, i, con->querythread[i].handled, con->querythread[i].passed);
 	}
-	else if (ret < length)
-		return NETERR_MTU;
-	return NETERR_SENT;
 #endif
 }
+#endif
+
+#ifdef HAVE_MMSG
+//times draining bursts of loopback packets through both the batched and unbatched receive paths,
+//and sending a packet to each of lots of clients (like the server does each frame) through both send paths.
+static void NET_UDPBench_f(void)
+{
+	int total = (Cmd_Argc()>1)?atoi(Cmd_Argv(1)):200000;
+	int size = (Cmd_Argc()>2)?atoi(Cmd_Argv(2)):64;
+	int clients = (Cmd_Argc()>3)?atoi(Cmd_Argv(3)):64;
+	const int burst = 128;
+	int rcvbuf = 1<<20;	//enough for a whole burst of big packets
+	ftenet_datagram_connection_t *con;
+	struct sockaddr_in addr;
+	socklen_t addrlen = sizeof(addr);
+	SOCKET tx, *cl;
+	netadr_t *cladr;
+	unsigned long _true = true;
+	qbyte payload[1400];
+	int mode, sent, n, got;
+	double start, elapsed;
+
+	size = bound(1, size, sizeof(payload));
+	clients = bound(1, clients, 1024);
+	if (total < burst)
+		total = burst;
+	memset(payload, 0x5a, size);
+
+	con = Z_Malloc(sizeof(*con));
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	con->generic.thesocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	con->generic.addrtype[0] = NA_IP;
+	tx = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (con->generic.thesocket == INVALID_SOCKET || tx == INVALID_SOCKET ||
+		bind(con->generic.thesocket, (struct sockaddr*)&addr, sizeof(addr)) == -1 ||
+		getsockname(con->generic.thesocket, (struct sockaddr*)&addr, &addrlen) == -1 ||
+		ioctlsocket(con->generic.thesocket, FIONBIO, &_true) == -1)
+	{
+		Con_Printf("net_udpbench: unable to create loopback sockets\n");
+		if (con->generic.thesocket != INVALID_SOCKET)
+			closesocket(con->generic.thesocket);
+		if (tx != INVALID_SOCKET)
+			closesocket(tx);
+		Z_Free(con);
+		return;
+	}
+
+	setsockopt(con->generic.thesocket, SOL_SOCKET, SO_RCVBUF, (void*)&rcvbuf, sizeof(rcvbuf));
+
+	for (mode = 0; mode < 2; mode++)
+	{
+		con->rxnext = con->rxcount = con->rxsyscalls = con->rxpackets = 0;
+		elapsed = 0;
+		got = 0;
+		for (sent = 0; sent < total; sent += burst)
+		{
+			for (n = 0; n < burst; n++)
+				sendto(tx, payload, size, 0, (struct sockaddr*)&addr, sizeof(addr));
+			start = Sys_DoubleTime();
+			if (mode)
+				while (FTENET_Datagram_GetPacketBatched(&con->generic))
+					got++;
+			else
+				while (FTENET_Datagram_GetPacket(&con->generic))
+					got++;
+			elapsed += Sys_DoubleTime() - start;
+		}
+		Con_Printf("%s: %i of %i %i-byte packets, %.0f ns/packet, %.2f Mpackets/sec", mode?"recvmmsg":"recvfrom", got, sent, size, elapsed*1e9/max(got,1), got/(elapsed*1e6));
+		if (mode)
+			Con_Printf(" (%u syscalls)", con->rxsyscalls);
+		Con_Printf("\n");
+	}
+	closesocket(tx);
+
+	//now the other way around. each 'frame' sends one packet to each client, and then the clients get drained (untimed).
+	cl = Z_Malloc(sizeof(*cl)*clients);
+	cladr = Z_Malloc(sizeof(*cladr)*clients);
+	for (n = 0; n < clients; n++)
+	{
+		addr.sin_port = 0;
+		addrlen = sizeof(addr);
+		cl[n] = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		if (cl[n] == INVALID_SOCKET ||
+			bind(cl[n], (struct sockaddr*)&addr, sizeof(addr)) == -1 ||
+			getsockname(cl[n], (struct sockaddr*)&addr, &addrlen) == -1 ||
+			ioctlsocket(cl[n], FIONBIO, &_true) == -1)
+		{
+			Con_Printf("net_udpbench: unable to create client socket %i\n", n);
+			if (cl[n] != INVALID_SOCKET)
+				closesocket(cl[n]);
+			clients = n;
+			break;
+		}
+		SockadrToNetadr((struct sockaddr_qstorage*)&addr, addrlen, &cladr[n]);
+		cladr[n].prot = NP_DGRAM;
+	}
+	for (mode = 0; mode < 2 && clients; mode++)
+	{
+		con->txsyscalls = con->txpackets = con->txerrcount = 0;
+		elapsed = 0;
+		for (sent = 0; sent < total; )
+		{
+			start = Sys_DoubleTime();
+			con->txbatch = mode;
+			for (n = 0; n < clients; n++, sent++)
+				FTENET_Datagram_SendPacketBatched(&con->generic, size, payload, &cladr[n]);
+			FTENET_Datagram_BatchSends(&con->generic, false);
+			elapsed += Sys_DoubleTime() - start;
+
+			for (n = 0; n < clients; n++)
+				while (recv(cl[n], (char*)payload, sizeof(payload), 0) > 0)
+					;
+		}
+		Con_Printf("%s: %i %i-byte packets to %i clients, %.0f ns/packet, %.2f Mpackets/sec", mode?"sendmmsg":"sendto", sent, size, clients, elapsed*1e9/max(sent,1), sent/(elapsed*1e6));
+		if (mode)
+			Con_Printf(" (%u syscalls)", con->txsyscalls);
+		Con_Printf("\n");
+	}
+	for (n = 0; n < clients; n++)
+		closesocket(cl[n]);
+	Z_Free(cl);
+	Z_Free(cladr);
+
+	closesocket(con->generic.thesocket);
+	Z_Free(con);
+}
+#endif
 
 qboolean	NET_PortToAdr (netadrtype_t adrfamily, netproto_t adrprot, const char *s, netadr_t *a)
 {
@@ -3939,6 +4617,13 @@ static void FTENET_Datagram_Close(ftenet_generic_connection_t *con)
 	}
 	Z_Free(con);
 }
+#ifdef HAVE_REUSEPORT
+static void FTENET_Datagram_CloseQueried(ftenet_generic_connection_t *con)
+{
+	FTENET_Datagram_StopQueryThreads((ftenet_datagram_connection_t*)con);
+	FTENET_Datagram_Close(con);
+}
+#endif
 #endif
 
 #ifdef HAVE_EPOLL
@@ -3946,7 +4631,7 @@ static void FTENET_Datagram_Polled(epollctx_t *ctx, unsigned int events)
 {
 	ftenet_generic_connection_t *con = NULL;
 	con = (ftenet_generic_connection_t *)((qbyte*)ctx - ((qbyte*)&con->epoll-(qbyte*)con));
-	while (FTENET_Datagram_GetPacket(con))
+	while (con->GetPacket(con))
 	{
 		net_from.connum = con->connum;
 		con->owner->ReadGamePacket();
@@ -3975,6 +4660,12 @@ ftenet_generic_connection_t *FTENET_Datagram_EstablishConnection(ftenet_connecti
 	qboolean hybrid = false;
 	int protocol;
 	char addrstr[128];
+#ifdef HAVE_MMSG
+	qboolean batch = isserver && net_batchudp.ival;
+#endif
+#ifdef HAVE_REUSEPORT
+	int querythreads = 0;
+#endif
 
 	switch(adr.type)
 	{
@@ -4061,6 +4752,14 @@ ftenet_generic_connection_t *FTENET_Datagram_EstablishConnection(ftenet_connecti
 	bufsz = 1<<18;
 	setsockopt(newsocket, SOL_SOCKET, SO_RCVBUF, (void*)&bufsz, sizeof(bufsz));
 
+#ifdef HAVE_REUSEPORT
+	//note: this lets other processes (of the same user) share the port too, if they also ask for it.
+	if (isserver && col->ThreadedConnectionless && (family == AF_INET || family == AF_INET6))
+		querythreads = bound(0, net_querythreads.ival, MAX_QUERYTHREADS);
+	if (querythreads)
+		setsockopt(newsocket, SOL_SOCKET, SO_REUSEPORT, (char *)&_true, sizeof(_true));
+#endif
+
 	switch(family)
 	{
 #ifdef UNIXSOCKETS
@@ -4158,7 +4857,22 @@ ftenet_generic_connection_t *FTENET_Datagram_EstablishConnection(ftenet_connecti
 	if (!isserver && net_local_cl_ipadr.type == NA_INVALID)
 		NET_GetLocalAddress (newsocket, &net_local_cl_ipadr);
 
-	newcon = Z_Malloc(sizeof(*newcon));
+#if defined(HAVE_MMSG) || defined(HAVE_REUSEPORT)
+	if (0
+#ifdef HAVE_MMSG
+		|| batch
+#endif
+#ifdef HAVE_REUSEPORT
+		|| querythreads
+#endif
+		)
+	{
+		ftenet_datagram_connection_t *dcon = Z_Malloc(sizeof(*dcon));
+		newcon = &dcon->generic;
+	}
+	else
+#endif
+		newcon = Z_Malloc(sizeof(*newcon));
 	if (newcon)
 	{
 		newcon->GetLocalAddresses = FTENET_Generic_GetLocalAddresses;
@@ -4166,6 +4880,24 @@ ftenet_generic_connection_t *FTENET_Datagram_EstablishConnection(ftenet_connecti
 		newcon->SendPacket = FTENET_Datagram_SendPacket;
 		newcon->Close = FTENET_Datagram_Close;
 		newcon->ChangeLocalAddress = FTENET_Datagram_ChangeLocalAddress;
+#ifdef HAVE_MMSG
+		if (batch)
+		{
+			newcon->GetPacket = FTENET_Datagram_GetPacketBatched;
+			newcon->SendPacket = FTENET_Datagram_SendPacketBatched;
+			newcon->BatchSends = FTENET_Datagram_BatchSends;
+			newcon->PrintStatus = FTENET_Datagram_PrintStatus;
+		}
+#endif
+#ifdef HAVE_REUSEPORT
+		if (querythreads)
+		{
+			((ftenet_datagram_connection_t*)newcon)->RawGetPacket = newcon->GetPacket;
+			newcon->GetPacket = FTENET_Datagram_GetPacketQueued;
+			newcon->Close = FTENET_Datagram_CloseQueried;
+			newcon->PrintStatus = FTENET_Datagram_PrintStatus;
+		}
+#endif
 
 		newcon->owner = col;
 		newcon->islisten = isserver;
@@ -4194,6 +4926,15 @@ ftenet_generic_connection_t *FTENET_Datagram_EstablishConnection(ftenet_connecti
 		}
 #endif
 
+#ifdef HAVE_REUSEPORT
+		if (querythreads)
+		{	//the query sockets need to bind to the port we actually got
+			temp = sizeof(qs);
+			if (getsockname(newsocket, (struct sockaddr *)&qs, &temp) == 0)
+				FTENET_Datagram_StartQueryThreads((ftenet_datagram_connection_t*)newcon, ((struct sockaddr*)&qs)->sa_family, protocol, hybrid, &qs, temp, querythreads);
+		}
+#endif
+
 		return newcon;
 	}
 	else
@@ -7977,6 +8718,18 @@ void NET_ReadPackets (ftenet_connections_t *collection)
 	}
 }
 
+void NET_BatchSends (ftenet_connections_t *collection, qboolean batch)
+{
+	size_t c;
+	if (!collection)
+		return;
+	for (c = 0; c < MAX_CONNECTIONS; c++)
+	{
+		if (collection->conn[c] && collection->conn[c]->BatchSends)
+			collection->conn[c]->BatchSends(collection->conn[c], batch);
+	}
+}
+
 int NET_LocalAddressForRemote(ftenet_connections_t *collection, netadr_t *remote, netadr_t *local, int idx)
 {
 	int adrflags;
@@ -8813,6 +9566,9 @@ void SVNET_AddPort_f(void)
 	if (!svs.sockets)
 	{
 		svs.sockets = FTENET_CreateCollection(true, SV_ReadPacket);
+#ifdef HAVE_REUSEPORT
+		svs.sockets->ThreadedConnectionless = SV_ThreadedConnectionless;
+#endif
 #ifdef HAVE_CLIENT
 		FTENET_AddToCollection(svs.sockets, "SVLoopback", STRINGIFY(PORT_DEFAULTSERVER), NA_LOOPBACK, NP_DGRAM);
 #endif
@@ -8896,6 +9652,13 @@ void NET_Init (void)
 	Cvar_Register(&timeout, "networking");
 	Cvar_Register(&net_hybriddualstack, "networking");
 	Cvar_Register(&net_fakeloss, "networking");
+#ifdef HAVE_MMSG
+	Cvar_Register(&net_batchudp, "networking");
+	Cmd_AddCommandD("net_udpbench", NET_UDPBench_f, "Sends bursts of loopback udp packets to a temporary socket, and reports how quickly the batched and unbatched receive paths drain them. Then sends a packet per frame to each of lots of loopback clients, and reports how quickly the batched and unbatched send paths get them out. Arguments are the packet count, packet size and client count.");
+#endif
+#ifdef HAVE_REUSEPORT
+	Cvar_Register(&net_querythreads, "networking");
+#endif
 
 #if defined(HAVE_SSL)
 	Cvar_Register(&tls_provider, "networking");
@@ -9166,6 +9929,9 @@ void NET_InitServer(void)
 		if (!svs.sockets)
 		{
 			svs.sockets = FTENET_CreateCollection(true, SV_ReadPacket);
+#ifdef HAVE_REUSEPORT
+			svs.sockets->ThreadedConnectionless = SV_ThreadedConnectionless;
+#endif
 #ifdef HAVE_CLIENT
 			FTENET_AddToCollection(svs.sockets, "SVLoopback", STRINGIFY(PORT_DEFAULTSERVER), NA_LOOPBACK, NP_DGRAM);
 #endif
@@ -151,6 +151,16 @@
 			#define HAVE_EPOLL
 		//#else too old, probably android...
 		#endif
+		//recvmmsg+sendmmsg, for fewer syscalls on busy servers. requires linux 3.0 up, and _GNU_SOURCE for the prototypes.
+		#if defined(MSG_WAITFORONE) && defined(_GNU_SOURCE)
+			#define HAVE_MMSG
+		#endif
+		//multiple sockets sharing a port, with a bpf program steering connectionless packets to threads that can't stall the game. requires linux 4.5 up.
+		#if defined(SO_REUSEPORT) && defined(SO_ATTACH_REUSEPORT_CBPF) && defined(MULTITHREAD)
+			#include <linux/filter.h>
+			#include <fcntl.h>
+			#define HAVE_REUSEPORT
+		#endif
 	#endif
 
 	#if defined(__MORPHOS__) && !defined(ixemul)
@@ -315,6 +325,7 @@ typedef struct ftenet_generic_connection_s {
 	qboolean (*GetPacket)(struct ftenet_generic_connection_s *con);
 	neterr_t (*SendPacket)(struct ftenet_generic_connection_s *con, int length, const void *data, netadr_t *to);
 	void (*Close)(struct ftenet_generic_connection_s *con);
+	void (*BatchSends)(struct ftenet_generic_connection_s *con, qboolean batch);	//optional. while set, SendPacket may queue packets instead of sending them immediately. clearing it flushes them.
 #if defined(HAVE_PACKET) && !defined(HAVE_EPOLL)
 	int (*SetFDSets) (struct ftenet_generic_connection_s *con, fd_set *readfdset, fd_set *writefdset);	/*set for connections which have multiple sockets (ie: listening tcp connections)*/
 #endif
@@ -416,6 +427,10 @@ typedef struct ftenet_connections_s
 	ftenet_generic_connection_t *conn[MAX_CONNECTIONS];
 
 	void (*ReadGamePacket) (void);
+#ifdef HAVE_REUSEPORT
+	//called from query threads for connectionless packets. returns false to pass the packet on to the main thread instead.
+	qboolean (*ThreadedConnectionless) (netadr_t *from, const qbyte *data, size_t length, void (*Reply)(void *ctx, netadr_t *to, const void *data, size_t length), void *ctx);
+#endif
 
 #ifdef HAVE_DTLS
 	struct dtlspeer_s *dtls;	//linked list. linked lists are shit, but at least it keeps pointers valid when things are resized.
@@ -23,6 +23,9 @@ cvar_t sv_gameplayfix_blowupfallenzombies = CVARD("sv_gameplayfix_blowupfallenzo
 cvar_t sv_gameplayfix_findradiusdistancetobox = CVARD("sv_gameplayfix_findradiusdistancetobox", "0", "When 1, findradius checks to the nearest part of the entity instead of only its origin, making it find slightly more entities.");
 cvar_t sv_gameplayfix_droptofloorstartsolid = CVARD("sv_gameplayfix_droptofloorstartsolid", "0", "When droptofloor fails, this causes a second attemp, but with traceline instead.");
 cvar_t dpcompat_findradiusarealinks = CVARD("dpcompat_findradiusarealinks", "0", "Use the world collision info to accelerate findradius instead of looping through every single entity. May actually be slower for large radiuses, or fail to find entities which have not been linked properly with setorigin.");
+#ifdef USEAREAGRID
+cvar_t sv_areabvh = CVARD("sv_areabvh", "0", "Use a dynamic bounding volume tree to find entities for collisions instead of a fixed grid. Better with large entities, lots of entities in one place, or long traces. Takes effect on map change.");
+#endif
 #ifdef HAVE_LEGACY
 cvar_t dpcompat_strcat_limit = CVARD("dpcompat_strcat_limit", "", "When set, cripples strcat (and related function) string lengths to the value specified.\nSet to 16383 to replicate DP's limit, otherwise leave as 0 to avoid limits.");
 #endif
@@ -37,6 +40,10 @@ cvar_t pr_gc_threaded = CVARD("pr_gc_threaded", "1", "Says whether to use a sepa
 #else
 cvar_t pr_gc_threaded = CVARD("pr_gc_threaded", "0", "Says whether to use a separate thread for tempstring garbage collections. This avoids main-thread stalls but at the expense of more memory usage.");
 #endif
+#ifdef QCJIT
+cvar_t pr_jit = CVARD("pr_jit", "0", "Generate native code for 32bit QC progs as they are loaded. Anything it can't handle (including debugging) falls back on the interpreter. Takes effect when the progs are next loaded.");
+cvar_t pr_threadedcode = CVARD("pr_threadedcode", "0", "Interpret 32bit QC progs via computed-goto dispatch, with common statement pairs fused together. The jit takes precedence where it can. Takes effect when the progs are next loaded.");
+#endif
 cvar_t	pr_sourcedir = CVARD("pr_sourcedir", "src", "Subdirectory where your qc source is located. Used by the internal compiler and qc debugging functionality.");
 cvar_t pr_enable_uriget = CVARD("pr_enable_uriget", "1", "Allows gamecode to make direct http requests");
 cvar_t pr_enable_profiling = CVARD("pr_enable_profiling", "0", "Enables profiling support. Will run more slowly. Change the map and then use the profile_ssqc/profile_csqc commands to see the results.");
@@ -89,6 +96,9 @@ void PF_Common_RegisterCvars(void)
 	Cvar_Register (&sv_gameplayfix_linknonsolid, cvargroup_progs);
 	Cvar_Register (&sv_gameplayfix_droptofloorstartsolid, cvargroup_progs);
 	Cvar_Register (&dpcompat_findradiusarealinks, cvargroup_progs);
+#ifdef USEAREAGRID
+	Cvar_Register (&sv_areabvh, cvargroup_progs);
+#endif
 #ifdef HAVE_LEGACY
 	Cvar_Register (&dpcompat_strcat_limit, cvargroup_progs);
 #endif
@@ -97,6 +107,10 @@ void PF_Common_RegisterCvars(void)
 	Cvar_Register (&pr_tempstringcount, cvargroup_progs);
 	Cvar_Register (&pr_tempstringsize, cvargroup_progs);
 	Cvar_Register (&pr_gc_threaded, cvargroup_progs);
+#ifdef QCJIT
+	Cvar_Register (&pr_jit, cvargroup_progs);
+	Cvar_Register (&pr_threadedcode, cvargroup_progs);
+#endif
 #ifdef WEBCLIENT
 	Cvar_Register (&pr_enable_uriget, cvargroup_progs);
 #endif
@@ -4010,6 +4024,70 @@ void QCBUILTIN PF_findradius_list (pubprogfuncs_t *prinst, struct globalvars_s *
 }
 #endif
 
+//must match the traceray_t struct in tracebox_list's description.
+typedef struct
+{
+	pvec3_t	start;
+	pvec3_t	end;
+	pvec_t	fraction;
+	pvec_t	allsolid;
+	pvec_t	startsolid;
+	pint_t	ent;
+	pvec3_t	endpos;
+	pvec3_t	plane_normal;
+	pvec_t	plane_dist;
+	pint_t	contents;
+} qctraceray_t;
+//void(traceray_t *rays, int numrays, vector mins, vector maxs, float nomonsters, entity forent)
+void QCBUILTIN PF_tracebox_list (pubprogfuncs_t *prinst, struct globalvars_s *pr_globals)
+{
+	world_t *w = prinst->parms->user;
+	int numrays = G_INT(OFS_PARM1);
+	qctraceray_t *rays = (numrays > 0 && numrays <= 0x10000)?PR_GetWriteQCPtr(prinst, G_INT(OFS_PARM0), numrays*sizeof(*rays)):NULL;
+	float *mins = G_VECTOR(OFS_PARM2);
+	float *maxs = G_VECTOR(OFS_PARM3);
+	int nomonsters = G_FLOAT(OFS_PARM4);
+	wedict_t *ent = G_WEDICT(prinst, OFS_PARM5);
+	vec3_t *starts, *ends;
+	vec3_t vmins, vmaxs;
+	trace_t *trace;
+	int i;
+
+	if (numrays <= 0)
+		return;
+	if (!rays)
+	{
+		PR_BIError(prinst, "PF_tracebox_list: invalid pointer\n");
+		return;
+	}
+
+	starts = BZ_Malloc(numrays * (sizeof(*starts)*2 + sizeof(*trace)));
+	ends = starts + numrays;
+	trace = (trace_t*)(ends + numrays);
+	for (i = 0; i < numrays; i++)
+	{
+		VectorCopy(rays[i].start, starts[i]);
+		VectorCopy(rays[i].end, ends[i]);
+	}
+	VectorCopy(mins, vmins);
+	VectorCopy(maxs, vmaxs);
+
+	World_MoveList(w, numrays, starts, ends, vmins, vmaxs, nomonsters|MOVE_IGNOREHULL, ent, trace);
+
+	for (i = 0; i < numrays; i++)
+	{
+		rays[i].fraction = trace[i].fraction;
+		rays[i].allsolid = trace[i].allsolid;
+		rays[i].startsolid = trace[i].startsolid;
+		rays[i].ent = EDICT_TO_PROG(prinst, trace[i].ent?trace[i].ent:w->edicts);
+		VectorCopy(trace[i].endpos, rays[i].endpos);
+		VectorCopy(trace[i].plane.normal, rays[i].plane_normal);
+		rays[i].plane_dist = trace[i].plane.dist;
+		rays[i].contents = trace[i].contents;
+	}
+	BZ_Free(starts);
+}
+
 //entity nextent(entity)
 void QCBUILTIN PF_nextent (pubprogfuncs_t *prinst, struct globalvars_s *pr_globals)
 {
@@ -26,6 +26,8 @@ struct wedict_s
 #ifdef USEAREAGRID
 	areagridlink_t	gridareas[AREAGRIDPERENT];	//on overflow, use the inefficient overflow list.
 	size_t			gridareasequence;	//used to avoid iterrating the same ent twice.
+	struct areabvh_s *areabvh;		//the tree we're linked into when using the bvh instead of the grid.
+	int				areabvhleaf;
 #else
 	link_t	area;
 #endif
@@ -83,6 +85,10 @@ extern cvar_t pr_tempstringcount;
 extern cvar_t pr_enable_profiling;
 extern cvar_t pr_fixbrokenqccarrays;
 extern cvar_t pr_gc_threaded;
+#ifdef QCJIT
+extern cvar_t pr_jit;
+extern cvar_t pr_threadedcode;
+#endif
 
 extern int qcinput_scan;
 extern int qcinput_unicode;
@@ -415,6 +421,7 @@ void QCBUILTIN PF_digest_hex (pubprogfuncs_t *prinst, struct globalvars_s *pr_gl
 void QCBUILTIN PF_digest_ptr (pubprogfuncs_t *prinst, struct globalvars_s *pr_globals);
 
 void QCBUILTIN PF_findradius_list (pubprogfuncs_t *prinst, struct globalvars_s *pr_globals);
+void QCBUILTIN PF_tracebox_list (pubprogfuncs_t *prinst, struct globalvars_s *pr_globals);
 void QCBUILTIN PF_findradius (pubprogfuncs_t *prinst, struct globalvars_s *pr_globals);
 void QCBUILTIN PF_edict_for_num (pubprogfuncs_t *prinst, struct globalvars_s *pr_globals);
 void QCBUILTIN PF_num_for_edict (pubprogfuncs_t *prinst, struct globalvars_s *pr_globals);
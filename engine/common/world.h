@@ -150,6 +150,25 @@ typedef struct q2trace_s
 		ming[1] = bound(0, ming[1], (w)->gridsize[1]-1);	\
 		maxg[0] = bound(ming[0], maxg[0], (w)->gridsize[0]-1)+1;	\
 		maxg[1] = bound(ming[1], maxg[1], (w)->gridsize[1]-1)+1;
+
+//dynamic aabb tree, an alternative to the grid (sv_areabvh).
+//leafs hold a slightly fattened box, so ents only need to be reinserted once they move out of it.
+typedef struct
+{
+	vec3_t		mins, maxs;
+	int			parent;		//or the next free node
+	int			child[2];	//-1 for leafs
+	int			height;		//0 for leafs
+	struct wedict_s	*ed;
+} areabvhnode_t;
+typedef struct areabvh_s
+{
+	areabvhnode_t	*nodes;
+	int				numnodes;
+	int				maxnodes;
+	int				root;
+	int				freenodes;
+} areabvh_t;
 #else
 #define	EDICT_FROM_AREA(l) STRUCT_FROM_LINK(l,wedict_t,area)
 #endif
@@ -231,6 +250,8 @@ struct world_s
 	areagridlink_t	*gridareas;		//[gridsize[0]*gridsize[1]]
 	areagridlink_t	jumboarea;		//node containing ents too large to fit.
 	areagridlink_t	portallist;
+	qboolean		useareabvh;		//ents are linked into areabvh instead of the grid (portals still use portallist).
+	areabvh_t		areabvh;
 #endif
 
 	double		physicstime;		// the last time global physics were run
@@ -337,6 +358,9 @@ extern int World_AreaEdicts (world_t *w, vec3_t mins, vec3_t maxs, wedict_t **li
 #ifdef USEAREAGRID
 void World_TouchAllLinks (world_t *w, wedict_t *ent);
 extern size_t areagridsequence;
+void World_AreaBVH_Walk (world_t *w, const vec3_t mins, const vec3_t maxs, const float *start, const float *end, const float *emins, const float *emaxs, qboolean (*callback)(world_t *w, wedict_t *ed, void *ctx), void *ctx);
+// calls the callback for each ent in the bvh whose (fattened) box overlaps mins/maxs, until it returns false.
+// if start+end are set, nodes must also be hit by that line, with nodes expanded to include a box of emins/emaxs.
 #else
 void World_TouchLinks (world_t *w, wedict_t *ent, areanode_t *node);
 #define World_TouchAllLinks(w,e) World_TouchLinks(w,e,(w)->areanodes)
@@ -366,6 +390,8 @@ qboolean World_TransformedTrace (struct model_s *model, int hulloverride, frames
  passedict is explicitly excluded from clipping checks (normally NULL)
 */
 trace_t World_Move (world_t *w, vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, int type, wedict_t *passedict);
+void World_MoveList (world_t *w, size_t count, vec3_t *starts, vec3_t *ends, vec3_t mins, vec3_t maxs, int type, wedict_t *passedict, trace_t *results);
+// same as calling World_Move for each start+end pair, but cheaper when there are lots of them.
 
 
 #ifdef Q2SERVER
@@ -2925,6 +2925,10 @@ void BE_GenModelBatches(batch_t **batches, const dlight_t *dl, unsigned int bemo
 		//the alias cache is a backend thing that provides support for multiple entities using the same skeleton.
 		//thus it needs to be cleared so that it won't reuse the cache over multiple frames.
 		Alias_FlushCache();
+#ifdef SKELETALMODELS
+		//get the workers started on any skeletons that we're about to need.
+		Alias_PrepareBonePoses(cl_visedicts+r_refdef.firstvisedict, cl_numvisedicts-r_refdef.firstvisedict);
+#endif
 	}
 
 	// draw sprites seperately, because of alpha blending
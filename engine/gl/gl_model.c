@@ -1196,7 +1196,7 @@ static void Mod_LoadModelWorker (void *ctx, void *data, size_t a, size_t b)
 				continue;
 
 			TRACE(("Mod_LoadModel: Trying to load (replacement) model \"%s\"\n", altname));
-			buf = (unsigned *)FS_LoadMallocGroupFile(NULL, altname, &filesize, true);
+			buf = (unsigned *)FS_LoadMappedFile(altname, &filesize, true);
 
 			if (buf)
 				Q_strncpyz(mod->name, altname, sizeof(mod->name));
@@ -1204,7 +1204,7 @@ static void Mod_LoadModelWorker (void *ctx, void *data, size_t a, size_t b)
 		else
 		{
 			TRACE(("Mod_LoadModel: Trying to load model \"%s\"\n", mod->publicname));
-			buf = (unsigned *)FS_LoadMallocGroupFile(NULL, mod->publicname, &filesize, true);
+			buf = (unsigned *)FS_LoadMappedFile(mod->publicname, &filesize, true);
 			if (buf)
 				Q_strncpyz(mod->name, mod->publicname, sizeof(mod->name));
 			else if (!buf)
@@ -1214,7 +1214,7 @@ static void Mod_LoadModelWorker (void *ctx, void *data, size_t a, size_t b)
 				{
 					TRACE(("Mod_LoadModel: doomsprite: \"%s\"\n", mod->name));
 					Mod_LoadDoomSprite(mod);
-					BZ_Free(buf);
+					FS_FreeFile(buf);
 					COM_AddWork(WG_MAIN, Mod_ModelLoaded, mod, NULL, MLS_LOADED, 0);
 					return;
 				}
@@ -1256,7 +1256,7 @@ static void Mod_LoadModelWorker (void *ctx, void *data, size_t a, size_t b)
 			continue;
 		if (filesize < 4)
 		{
-			BZ_Free(buf);
+			FS_FreeFile(buf);
 			continue;
 		}
 
@@ -1265,7 +1265,7 @@ static void Mod_LoadModelWorker (void *ctx, void *data, size_t a, size_t b)
 //
 		if (!Mod_DoCRC(mod, (char*)buf, filesize))
 		{
-			BZ_Free(buf);
+			FS_FreeFile(buf);
 			continue;
 		}
 
@@ -1290,7 +1290,7 @@ static void Mod_LoadModelWorker (void *ctx, void *data, size_t a, size_t b)
 		{
 			if (!modelloaders[i].load(mod, buf, filesize))
 			{
-				BZ_Free(buf);
+				FS_FreeFile(buf);
 				continue;
 			}
 		}
@@ -1306,14 +1306,14 @@ static void Mod_LoadModelWorker (void *ctx, void *data, size_t a, size_t b)
 			{
 				if (!modelloaders[i].load(mod, buf, filesize))
 				{
-					BZ_Free(buf);
+					FS_FreeFile(buf);
 					continue;
 				}
 			}
 			else
 			{
 				Con_Printf(CON_WARNING "Unrecognised model format %c%c%c%c\n", ((char*)buf)[0], ((char*)buf)[1], ((char*)buf)[2], ((char*)buf)[3]);
-				BZ_Free(buf);
+				FS_FreeFile(buf);
 				continue;
 			}
 		}
@@ -1332,7 +1332,7 @@ static void Mod_LoadModelWorker (void *ctx, void *data, size_t a, size_t b)
 
 		TRACE(("Mod_LoadModel: Loaded\n"));
 
-		BZ_Free(buf);
+		FS_FreeFile(buf);
 
 		COM_AddWork(WG_MAIN, Mod_ModelLoaded, mod, NULL, MLS_LOADED, 0);
 		return;
@@ -40,6 +40,12 @@
 #define QCFAULT return (prinst.pr_xstatement=(st-pr_statements)-1),PR_HandleFault
 #define EVAL_FLOATISTRUE(ev) ((ev)->_int & 0x7fffffff) //mask away sign bit. This avoids using denormalized floats.
 
+#ifdef THREADED
+#define THREADEDLABEL(o) tl_##o:	//so hot statements can be dispatched to directly
+#else
+#define THREADEDLABEL(o)
+#endif
+
 #ifdef __GNUC__
 #define errorif(x) if(__builtin_expect(x,0))
 #else
@@ -93,6 +99,95 @@
 
 	op = (progfuncs->funcs.debug_trace?(st->op & ~0x8000):st->op);
 reeval:
+#elif defined(THREADED)
+	st++;
+	op = st->op;
+	goto *threaded[st-stbase];
+
+	//superinstructions for statement pairs that were spotted when the progs were translated.
+	//these must give the same results as running both statements separately, so anything out of the ordinary is left to the first statement's normal handler.
+tl_LOAD_STORE:	//LOAD_F then STORE_F
+	if ((unsigned)OPA->edict < (unsigned)num_edicts)
+	{
+		ed = PROG_TO_EDICT_PB(progfuncs, OPA->edict);
+		i = OPB->_int + progfuncs->funcs.fieldadjust;
+#ifdef NOLEGACY
+		if (ed->ereftype != ER_FREE && (unsigned int)(i+1)*4 <= ed->fieldsize)
+#else
+		if ((unsigned int)(i+1)*4 <= ed->fieldsize)
+#endif
+		{
+			OPC->_int = ((eval_t *)(((int *)edvars(ed)) + i))->_int;
+			st++;
+			OPB->_int = OPA->_int;
+			continue;
+		}
+	}
+	goto tl_OP_LOAD_P;
+
+tl_ADDRESS_STOREP:	//ADDRESS then STOREP_F
+tl_ADDRESS_STOREP_V:	//ADDRESS then STOREP_V
+	if ((unsigned)OPA->edict < (unsigned)num_edicts)
+	{
+		ed = PROG_TO_EDICT_PB(progfuncs, OPA->edict);
+		i = OPB->_int + progfuncs->funcs.fieldadjust;
+		if (ed && !ed->readonly
+#ifdef NOLEGACY
+			&& ed->ereftype != ER_FREE
+#endif
+#ifdef PARANOID
+			&& (unsigned int)i*4 < ed->fieldsize
+#endif
+			)
+		{
+			OPC->_int = ENGINEPOINTER((((int *)edvars(ed)) + i));
+			st++;
+			op = st->op;
+			i = OPB->_int + OPC->_int*sizeof(ptr->_int);
+			if (op == OP_STOREP_V)
+			{
+				if (QCPOINTERWRITEFAIL(i, sizeof(pvec3_t)))
+					goto tl_OP_STOREP_V;
+				ptr = QCPOINTERM(i);
+				ptr->_vector[0] = OPA->_vector[0];
+				ptr->_vector[1] = OPA->_vector[1];
+				ptr->_vector[2] = OPA->_vector[2];
+			}
+			else
+			{
+				if (QCPOINTERWRITEFAIL(i, sizeof(ptr->_int)))
+					goto tl_OP_STOREP_I;
+				ptr = QCPOINTERM(i);
+				ptr->_int = OPA->_int;
+			}
+			continue;
+		}
+	}
+	goto tl_OP_ADDRESS;
+
+	//a comparison followed by a branch on its result. the result is always 0 or 1, so the _I and _F branches act the same.
+#define FUSEDBRANCH(o,c)	\
+tl_##o##_IF:	\
+	tmpi = (c);	\
+	OPC->_float = (float)tmpi;	\
+	st++;	\
+	RUNAWAYCHECK();	\
+	if (tmpi != (st->op == OP_IFNOT_I || st->op == OP_IFNOT_F))	\
+		st += (sofs)st->b - 1;	\
+	continue;
+	FUSEDBRANCH(OP_EQ_F, OPA->_float == OPB->_float)
+	FUSEDBRANCH(OP_NE_F, OPA->_float != OPB->_float)
+	FUSEDBRANCH(OP_LT_F, OPA->_float < OPB->_float)
+	FUSEDBRANCH(OP_LE_F, OPA->_float <= OPB->_float)
+	FUSEDBRANCH(OP_GT_F, OPA->_float > OPB->_float)
+	FUSEDBRANCH(OP_GE_F, OPA->_float >= OPB->_float)
+	FUSEDBRANCH(OP_NOT_F, !EVAL_FLOATISTRUE(OPA))
+	FUSEDBRANCH(OP_NOT_ENT, !OPA->edict)
+	FUSEDBRANCH(OP_EQ_E, OPA->_int == OPB->_int)
+	FUSEDBRANCH(OP_NE_E, OPA->_int != OPB->_int)
+#undef FUSEDBRANCH
+
+tl_switch:
 #else
 	st++;
 	op = st->op;
@@ -100,46 +195,46 @@ reeval:
 
 	safeswitch ((enum qcop_e)op)
 	{
-	case OP_ADD_F:
+	case OP_ADD_F:	THREADEDLABEL(OP_ADD_F)
 		OPC->_float = OPA->_float + OPB->_float;
 		break;
-	case OP_ADD_V:
+	case OP_ADD_V:	THREADEDLABEL(OP_ADD_V)
 		OPC->_vector[0] = OPA->_vector[0] + OPB->_vector[0];
 		OPC->_vector[1] = OPA->_vector[1] + OPB->_vector[1];
 		OPC->_vector[2] = OPA->_vector[2] + OPB->_vector[2];
 		break;
 
-	case OP_SUB_F:
+	case OP_SUB_F:	THREADEDLABEL(OP_SUB_F)
 		OPC->_float = OPA->_float - OPB->_float;
 		break;
-	case OP_SUB_V:
+	case OP_SUB_V:	THREADEDLABEL(OP_SUB_V)
 		OPC->_vector[0] = OPA->_vector[0] - OPB->_vector[0];
 		OPC->_vector[1] = OPA->_vector[1] - OPB->_vector[1];
 		OPC->_vector[2] = OPA->_vector[2] - OPB->_vector[2];
 		break;
 
-	case OP_MUL_F:
+	case OP_MUL_F:	THREADEDLABEL(OP_MUL_F)
 		OPC->_float = OPA->_float * OPB->_float;
 		break;
-	case OP_MUL_V:
+	case OP_MUL_V:	THREADEDLABEL(OP_MUL_V)
 		OPC->_float = OPA->_vector[0]*OPB->_vector[0]
 				+ OPA->_vector[1]*OPB->_vector[1]
 				+ OPA->_vector[2]*OPB->_vector[2];
 		break;
-	case OP_MUL_FV:
+	case OP_MUL_FV:	THREADEDLABEL(OP_MUL_FV)
 		tmpf = OPA->_float;
 		OPC->_vector[0] = tmpf * OPB->_vector[0];
 		OPC->_vector[1] = tmpf * OPB->_vector[1];
 		OPC->_vector[2] = tmpf * OPB->_vector[2];
 		break;
-	case OP_MUL_VF:
+	case OP_MUL_VF:	THREADEDLABEL(OP_MUL_VF)
 		tmpf = OPB->_float;
 		OPC->_vector[0] = tmpf * OPA->_vector[0];
 		OPC->_vector[1] = tmpf * OPA->_vector[1];
 		OPC->_vector[2] = tmpf * OPA->_vector[2];
 		break;
 
-	case OP_DIV_F:
+	case OP_DIV_F:	THREADEDLABEL(OP_DIV_F)
 /*		errorif (OPB->_float == 0)
 		{
 			prinst.pr_xstatement = st-pr_statements;
@@ -164,16 +259,16 @@ reeval:
 		OPC->_vector[2] = OPA->_vector[2] / tmpf;
 		break;
 
-	case OP_BITAND_F:
+	case OP_BITAND_F:	THREADEDLABEL(OP_BITAND_F)
 		OPC->_float = (float)((int)OPA->_float & (int)OPB->_float);
 		break;
 
-	case OP_BITOR_F:
+	case OP_BITOR_F:	THREADEDLABEL(OP_BITOR_F)
 		OPC->_float = (float)((int)OPA->_float | (int)OPB->_float);
 		break;
 
 
-	case OP_GE_F:
+	case OP_GE_F:	THREADEDLABEL(OP_GE_F)
 		OPC->_float = (float)(OPA->_float >= OPB->_float);
 		break;
 	case OP_GE_I:
@@ -186,7 +281,7 @@ reeval:
 		OPC->_int = (int)(OPA->_float >= OPB->_int);
 		break;
 
-	case OP_LE_F:
+	case OP_LE_F:	THREADEDLABEL(OP_LE_F)
 		OPC->_float = (float)(OPA->_float <= OPB->_float);
 		break;
 	case OP_LE_I:
@@ -202,7 +297,7 @@ reeval:
 		OPC->_int = (int)(OPA->_uint <= OPB->_uint);
 		break;
 
-	case OP_GT_F:
+	case OP_GT_F:	THREADEDLABEL(OP_GT_F)
 		OPC->_float = (float)(OPA->_float > OPB->_float);
 		break;
 	case OP_GT_I:
@@ -215,7 +310,7 @@ reeval:
 		OPC->_int = (int)(OPA->_float > OPB->_int);
 		break;
 
-	case OP_LT_F:
+	case OP_LT_F:	THREADEDLABEL(OP_LT_F)
 		OPC->_float = (float)(OPA->_float < OPB->_float);
 		break;
 	case OP_LT_I:
@@ -231,37 +326,37 @@ reeval:
 		OPC->_int = (OPA->_uint < OPB->_uint);
 		break;
 
-	case OP_AND_F:
+	case OP_AND_F:	THREADEDLABEL(OP_AND_F)
 		//original logic
 		//OPC->_float = (float)(OPA->_float && OPB->_float);
 		//deal with denormalized floats by ensuring that they're not 0 (ignoring sign bit).
 		//this avoids issues where the fpu treats denormalised floats as 0, or fpus that don't support denormals.
 		OPC->_float = (float)(EVAL_FLOATISTRUE(OPA) && EVAL_FLOATISTRUE(OPB));
 		break;
-	case OP_OR_F:
+	case OP_OR_F:	THREADEDLABEL(OP_OR_F)
 		OPC->_float = (float)(EVAL_FLOATISTRUE(OPA) || EVAL_FLOATISTRUE(OPB));
 		break;
 
-	case OP_NOT_F:
+	case OP_NOT_F:	THREADEDLABEL(OP_NOT_F)
 		OPC->_float = (float)(!EVAL_FLOATISTRUE(OPA));
 		break;
-	case OP_NOT_V:
+	case OP_NOT_V:	THREADEDLABEL(OP_NOT_V)
 		OPC->_float = (float)(!OPA->_vector[0] && !OPA->_vector[1] && !OPA->_vector[2]);
 		break;
-	case OP_NOT_S:
+	case OP_NOT_S:	THREADEDLABEL(OP_NOT_S)
 		OPC->_float = (float)(!(OPA->string) || !*PR_StringToNative(&progfuncs->funcs, OPA->string));
 		break;
-	case OP_NOT_FNC:
+	case OP_NOT_FNC:	THREADEDLABEL(OP_NOT_FNC)
 		OPC->_float = (float)(!(OPA->function & ~0xff000000));
 		break;
-	case OP_NOT_ENT:
+	case OP_NOT_ENT:	THREADEDLABEL(OP_NOT_ENT)
 		OPC->_float = (float)(!(OPA->edict));//(PROG_TO_EDICT(progfuncs, OPA->edict) == (edictrun_t *)sv_edicts);
 		break;
 	case OP_NOT_I:
 		OPC->_int = !OPA->_int;
 		break;
 
-	case OP_EQ_F:
+	case OP_EQ_F:	THREADEDLABEL(OP_EQ_F)
 		OPC->_float = (float)(OPA->_float == OPB->_float);
 		break;
 	case OP_EQ_IF:
@@ -272,12 +367,12 @@ reeval:
 		break;
 
 
-	case OP_EQ_V:
+	case OP_EQ_V:	THREADEDLABEL(OP_EQ_V)
 		OPC->_float = (float)((OPA->_vector[0] == OPB->_vector[0]) &&
 					(OPA->_vector[1] == OPB->_vector[1]) &&
 					(OPA->_vector[2] == OPB->_vector[2]));
 		break;
-	case OP_EQ_S:
+	case OP_EQ_S:	THREADEDLABEL(OP_EQ_S)
 		if (OPA->string==OPB->string)
 			OPC->_float = true;
 		else if (!OPA->string)
@@ -297,23 +392,23 @@ reeval:
 		else
 			OPC->_float = (float)(!strcmp(PR_StringToNative(&progfuncs->funcs, OPA->string),PR_StringToNative(&progfuncs->funcs, OPB->string)));
 		break;
-	case OP_EQ_E:
+	case OP_EQ_E:	THREADEDLABEL(OP_EQ_E)
 		OPC->_float = (float)(OPA->_int == OPB->_int);
 		break;
-	case OP_EQ_FNC:
+	case OP_EQ_FNC:	THREADEDLABEL(OP_EQ_FNC)
 		OPC->_float = (float)(OPA->function == OPB->function);
 		break;
 
 
-	case OP_NE_F:
+	case OP_NE_F:	THREADEDLABEL(OP_NE_F)
 		OPC->_float = (float)(OPA->_float != OPB->_float);
 		break;
-	case OP_NE_V:
+	case OP_NE_V:	THREADEDLABEL(OP_NE_V)
 		OPC->_float = (float)((OPA->_vector[0] != OPB->_vector[0]) ||
 					(OPA->_vector[1] != OPB->_vector[1]) ||
 					(OPA->_vector[2] != OPB->_vector[2]));
 		break;
-	case OP_NE_S:
+	case OP_NE_S:	THREADEDLABEL(OP_NE_S)
 		if (OPA->string==OPB->string)
 			OPC->_float = false;
 		else if (!OPA->string)
@@ -333,10 +428,10 @@ reeval:
 		else
 			OPC->_float = (float)(strcmp(PR_StringToNative(&progfuncs->funcs, OPA->string),PR_StringToNative(&progfuncs->funcs, OPB->string)));		
 		break;
-	case OP_NE_E:
+	case OP_NE_E:	THREADEDLABEL(OP_NE_E)
 		OPC->_float = (float)(OPA->_int != OPB->_int);
 		break;
-	case OP_NE_FNC:
+	case OP_NE_FNC:	THREADEDLABEL(OP_NE_FNC)
 		OPC->_float = (float)(OPA->function != OPB->function);
 		break;
 
@@ -348,7 +443,7 @@ reeval:
 		OPB->_int = (int)OPA->_float;
 		break;
 		
-	case OP_STORE_F:
+	case OP_STORE_F:	THREADEDLABEL(OP_STORE_F)
 	case OP_STORE_ENT:
 	case OP_STORE_FLD:		// integers
 	case OP_STORE_S:
@@ -357,7 +452,7 @@ reeval:
 	case OP_STORE_P:
 		OPB->_int = OPA->_int;
 		break;
-	case OP_STORE_V:
+	case OP_STORE_V:	THREADEDLABEL(OP_STORE_V)
 		OPB->_vector[0] = OPA->_vector[0];
 		OPB->_vector[1] = OPA->_vector[1];
 		OPB->_vector[2] = OPA->_vector[2];
@@ -394,7 +489,7 @@ reeval:
 			ptr = QCPOINTERM(i);
 		ptr->_int = (int)OPA->_float;
 		break;
-	case OP_STOREP_I:
+	case OP_STOREP_I:	THREADEDLABEL(OP_STOREP_I)
 	case OP_STOREP_F:
 	case OP_STOREP_ENT:
 	case OP_STOREP_FLD:		// integers
@@ -435,7 +530,7 @@ reeval:
 			ptr = QCPOINTERM(i);
 		ptr->i64 = OPA->i64;
 		break;
-	case OP_STOREP_V:
+	case OP_STOREP_V:	THREADEDLABEL(OP_STOREP_V)
 		i = OPB->_int + (OPC->_int*sizeof(ptr->_int));
 		errorif (QCPOINTERWRITEFAIL(i, sizeof(pvec3_t)))
 		{
@@ -617,7 +712,7 @@ reeval:
 
 
 	//get a pointer to a field var
-	case OP_ADDRESS:
+	case OP_ADDRESS:	THREADEDLABEL(OP_ADDRESS)
 		errorif ((unsigned)OPA->edict >= (unsigned)num_edicts)
 		{
 			if (PR_ExecRunWarning (&progfuncs->funcs, st-pr_statements, "OP_ADDRESS references invalid entity in %s\n", PR_StringToNative(&progfuncs->funcs, prinst.pr_xfunction->s_name)))
@@ -671,7 +766,7 @@ reeval:
 		break;
 
 	//load a field to a value
-	case OP_LOAD_P:
+	case OP_LOAD_P:	THREADEDLABEL(OP_LOAD_P)
 	case OP_LOAD_I:
 	case OP_LOAD_F:
 	case OP_LOAD_FLD:
@@ -749,7 +844,7 @@ reeval:
 			OPC->i64 = ptr->i64;
 		}
 		break;
-	case OP_LOAD_V:
+	case OP_LOAD_V:	THREADEDLABEL(OP_LOAD_V)
 		errorif ((unsigned)OPA->edict >= (unsigned)num_edicts)
 		{
 			if (PR_ExecRunWarning (&progfuncs->funcs, st-pr_statements, "OP_LOAD_V references invalid entity %i in %s\n", OPA->edict, PR_StringToNative(&progfuncs->funcs, prinst.pr_xfunction->s_name)))
@@ -792,50 +887,50 @@ reeval:
 
 //==================
 
-	case OP_IFNOT_S:
+	case OP_IFNOT_S:	THREADEDLABEL(OP_IFNOT_S)
 		RUNAWAYCHECK();
 		if (!OPA->string || !PR_StringToNative(&progfuncs->funcs, OPA->string))
 			st += (sofs)st->b - 1;	// offset the s++
 		break;
 
-	case OP_IFNOT_F:
+	case OP_IFNOT_F:	THREADEDLABEL(OP_IFNOT_F)
 		RUNAWAYCHECK();
 		if (!EVAL_FLOATISTRUE(OPA))
 			st += (sofs)st->b - 1;	// offset the s++
 		break;
 
 	//WARNING: vanilla uses this for floats too, which results in a discrepancy with -0
-	case OP_IFNOT_I:
+	case OP_IFNOT_I:	THREADEDLABEL(OP_IFNOT_I)
 		RUNAWAYCHECK();
 		if (!OPA->_int)
 			st += (sofs)st->b - 1;	// offset the s++
 		break;
 
-	case OP_IF_S:
+	case OP_IF_S:	THREADEDLABEL(OP_IF_S)
 		RUNAWAYCHECK();
 		if (OPA->string && PR_StringToNative(&progfuncs->funcs, OPA->string))
 			st += (sofs)st->b - 1;	// offset the s++
 		break;
 
-	case OP_IF_F:
+	case OP_IF_F:	THREADEDLABEL(OP_IF_F)
 		RUNAWAYCHECK();
 		if (EVAL_FLOATISTRUE(OPA))
 			st += (sofs)st->b - 1;	// offset the s++
 		break;
 
 	//WARNING: vanilla uses this for floats too, which results in a discrepancy with -0
-	case OP_IF_I:
+	case OP_IF_I:	THREADEDLABEL(OP_IF_I)
 		RUNAWAYCHECK();
 		if (OPA->_int)
 			st += (sofs)st->b - 1;	// offset the s++
 		break;
 
-	case OP_GOTO:
+	case OP_GOTO:	THREADEDLABEL(OP_GOTO)
 		RUNAWAYCHECK();
 		st += (sofs)st->a - 1;	// offset the s++
 		break;
 
-	case OP_CALL8H:
+	case OP_CALL8H:	THREADEDLABEL(OP_CALL8H)
 	case OP_CALL7H:
 	case OP_CALL6H:
 	case OP_CALL5H:
@@ -845,12 +940,12 @@ reeval:
 		G_VECTOR(OFS_PARM1)[0] = OPC->_vector[0];
 		G_VECTOR(OFS_PARM1)[1] = OPC->_vector[1];
 		G_VECTOR(OFS_PARM1)[2] = OPC->_vector[2];
-	case OP_CALL1H:
+	case OP_CALL1H:	THREADEDLABEL(OP_CALL1H)
 		G_VECTOR(OFS_PARM0)[0] = OPB->_vector[0];
 		G_VECTOR(OFS_PARM0)[1] = OPB->_vector[1];
 		G_VECTOR(OFS_PARM0)[2] = OPB->_vector[2];
 
-	case OP_CALL8:
+	case OP_CALL8:	THREADEDLABEL(OP_CALL8)
 	case OP_CALL7:
 	case OP_CALL6:
 	case OP_CALL5:
@@ -934,7 +1029,7 @@ reeval:
 		//resume at the new statement, which might be in a different progs
 		return s;
 
-	case OP_DONE:
+	case OP_DONE:	THREADEDLABEL(OP_DONE)
 	case OP_RETURN:
 
 		RUNAWAYCHECK();
@@ -953,11 +1048,11 @@ reeval:
 		return s;
 //		break;
 
-	case OP_STATE:
+	case OP_STATE:	THREADEDLABEL(OP_STATE)
 		externs->stateop(&progfuncs->funcs, OPA->_float, OPB->function);
 		break;
 
-	case OP_ADD_I:		
+	case OP_ADD_I:	THREADEDLABEL(OP_ADD_I)		
 		OPC->_int = OPA->_int + OPB->_int;
 		break;
 	case OP_ADD_FI:
@@ -967,7 +1062,7 @@ reeval:
 		OPC->_float = (float)OPA->_int + OPB->_float;
 		break;
   
-	case OP_SUB_I:
+	case OP_SUB_I:	THREADEDLABEL(OP_SUB_I)
 		OPC->_int = OPA->_int - OPB->_int;
 		break;
 	case OP_SUB_FI:
@@ -977,10 +1072,10 @@ reeval:
 		OPC->_float = (float)OPA->_int - OPB->_float;
 		break;
 
-	case OP_CONV_ITOF:
+	case OP_CONV_ITOF:	THREADEDLABEL(OP_CONV_ITOF)
 		OPC->_float = (float)OPA->_int;
 		break;
-	case OP_CONV_FTOI:
+	case OP_CONV_FTOI:	THREADEDLABEL(OP_CONV_FTOI)
 		OPC->_int = (int)OPA->_float;
 		break;
 
@@ -1672,6 +1767,13 @@ reeval:
 #endif
 
 	safedefault:
+#ifdef THREADED
+		if (op & OP_BIT_BREAKPOINT)
+		{	//leave breakpoints to the debugable interpreter
+			current_progstate->hasbreakpoints = true;
+			return st-pr_statements-1;
+		}
+#else
 		if (op & OP_BIT_BREAKPOINT)	//break point!
 		{
 			op &= ~OP_BIT_BREAKPOINT;
@@ -1687,6 +1789,7 @@ reeval:
 			}
 			goto reeval;	//reexecute
 		}
+#endif
 		prinst.pr_xstatement = st-pr_statements;
 		PR_RunError (&progfuncs->funcs, "Bad opcode %i", st->op);
 	}
@@ -1704,4 +1807,5 @@ reeval:
 #undef ENGINEPOINTER
 #undef QCPOINTER
 #undef QCPOINTERM
+#undef THREADEDLABEL
 
@@ -606,6 +606,18 @@ static int ASMCALL PR_LeaveFunction (progfuncs_t *progfuncs)
 	return st->s;
 }
 
+#ifdef QCJIT
+//for the jit's call/return helpers, so they don't need their own copies.
+int PR_JitEnterFunction (progfuncs_t *progfuncs, mfunction_t *f, int progsnum)
+{
+	return PR_EnterFunction(progfuncs, f, progsnum);
+}
+int PR_JitLeaveFunction (progfuncs_t *progfuncs)
+{
+	return PR_LeaveFunction(progfuncs);
+}
+#endif
+
 ddef32_t *ED_FindLocalOrGlobal(progfuncs_t *progfuncs, const char *name, eval_t **val)
 {
 	static ddef32_t def;
@@ -1242,6 +1254,8 @@ int PDECL PR_ToggleBreakpoint(pubprogfuncs_t *ppf, const char *filename, int lin
 							case PST_FTE32:
 							case PST_UHEXEN2:
 								((dstatement32_t*)cp->statements + i)->op = op;
+								if (op & OP_BIT_BREAKPOINT)
+									cp->hasbreakpoints = true;
 								break;
 							default:
 								externs->Sys_Error("Bad structtype");
@@ -1317,6 +1331,8 @@ int PDECL PR_ToggleBreakpoint(pubprogfuncs_t *ppf, const char *filename, int lin
 					case PST_FTE32:
 					case PST_UHEXEN2:
 						((dstatement32_t*)cp->statements + i)->op = op;
+						if (op & OP_BIT_BREAKPOINT)
+							cp->hasbreakpoints = true;
 						break;
 					default:
 						externs->Sys_Error("Bad structtype");
@@ -1727,6 +1743,136 @@ static int PR_ExecuteCode32 (progfuncs_t *fte_restrict progfuncs, int s, int *ft
 #endif
 }
 
+#ifdef QCTHREADED
+//same as PR_ExecuteCode32, but each statement is pretranslated into the address of its handler so we can skip the switch.
+//a few common statement pairs are also translated into superinstructions (see execloop.h).
+//anything involving the debugger is left to PR_ExecuteCode32.
+static int PR_ExecuteCode32Threaded (progfuncs_t *fte_restrict progfuncs, int s, int *fte_restrict runaway)
+{
+	unsigned int switchcomparison = 0;
+	const dstatement32_t	*fte_restrict st;
+	const dstatement32_t	*fte_restrict stbase = pr_statements32;
+	const void				**fte_restrict threaded = current_progstate->threadedcode;
+	mfunction_t	*fte_restrict newf;
+	int		i;
+	edictrun_t	*ed;
+	eval_t	*ptr;
+
+	float *fte_restrict glob = pr_globals;
+	float tmpf;
+	int tmpi;
+	eval_t	*switchref = (eval_t*)glob;
+	unsigned int num_edicts = sv_num_edicts;
+
+	unsigned int op;
+
+	if (!threaded)
+	{
+		static const void *const handlers[OP_NUMREALOPS] = {
+			[OP_ADD_F] = &&tl_OP_ADD_F,			[OP_ADD_V] = &&tl_OP_ADD_V,
+			[OP_SUB_F] = &&tl_OP_SUB_F,			[OP_SUB_V] = &&tl_OP_SUB_V,
+			[OP_MUL_F] = &&tl_OP_MUL_F,			[OP_MUL_V] = &&tl_OP_MUL_V,
+			[OP_MUL_FV] = &&tl_OP_MUL_FV,		[OP_MUL_VF] = &&tl_OP_MUL_VF,
+			[OP_DIV_F] = &&tl_OP_DIV_F,
+			[OP_BITAND_F] = &&tl_OP_BITAND_F,	[OP_BITOR_F] = &&tl_OP_BITOR_F,
+			[OP_GE_F] = &&tl_OP_GE_F,			[OP_LE_F] = &&tl_OP_LE_F,
+			[OP_GT_F] = &&tl_OP_GT_F,			[OP_LT_F] = &&tl_OP_LT_F,
+			[OP_AND_F] = &&tl_OP_AND_F,			[OP_OR_F] = &&tl_OP_OR_F,
+			[OP_NOT_F] = &&tl_OP_NOT_F,			[OP_NOT_V] = &&tl_OP_NOT_V,
+			[OP_NOT_S] = &&tl_OP_NOT_S,			[OP_NOT_FNC] = &&tl_OP_NOT_FNC,
+			[OP_NOT_ENT] = &&tl_OP_NOT_ENT,
+			[OP_EQ_F] = &&tl_OP_EQ_F,			[OP_EQ_V] = &&tl_OP_EQ_V,
+			[OP_EQ_S] = &&tl_OP_EQ_S,			[OP_EQ_E] = &&tl_OP_EQ_E,
+			[OP_EQ_FNC] = &&tl_OP_EQ_FNC,
+			[OP_NE_F] = &&tl_OP_NE_F,			[OP_NE_V] = &&tl_OP_NE_V,
+			[OP_NE_S] = &&tl_OP_NE_S,			[OP_NE_E] = &&tl_OP_NE_E,
+			[OP_NE_FNC] = &&tl_OP_NE_FNC,
+			[OP_STORE_F] = &&tl_OP_STORE_F,		[OP_STORE_ENT] = &&tl_OP_STORE_F,
+			[OP_STORE_FLD] = &&tl_OP_STORE_F,	[OP_STORE_S] = &&tl_OP_STORE_F,
+			[OP_STORE_I] = &&tl_OP_STORE_F,		[OP_STORE_FNC] = &&tl_OP_STORE_F,
+			[OP_STORE_P] = &&tl_OP_STORE_F,		[OP_STORE_V] = &&tl_OP_STORE_V,
+			[OP_STOREP_I] = &&tl_OP_STOREP_I,	[OP_STOREP_F] = &&tl_OP_STOREP_I,
+			[OP_STOREP_ENT] = &&tl_OP_STOREP_I,	[OP_STOREP_FLD] = &&tl_OP_STOREP_I,
+			[OP_STOREP_S] = &&tl_OP_STOREP_I,	[OP_STOREP_FNC] = &&tl_OP_STOREP_I,
+			[OP_STOREP_V] = &&tl_OP_STOREP_V,
+			[OP_ADDRESS] = &&tl_OP_ADDRESS,
+			[OP_LOAD_P] = &&tl_OP_LOAD_P,		[OP_LOAD_I] = &&tl_OP_LOAD_P,
+			[OP_LOAD_F] = &&tl_OP_LOAD_P,		[OP_LOAD_FLD] = &&tl_OP_LOAD_P,
+			[OP_LOAD_ENT] = &&tl_OP_LOAD_P,		[OP_LOAD_S] = &&tl_OP_LOAD_P,
+			[OP_LOAD_FNC] = &&tl_OP_LOAD_P,		[OP_LOAD_V] = &&tl_OP_LOAD_V,
+			[OP_IFNOT_S] = &&tl_OP_IFNOT_S,		[OP_IFNOT_F] = &&tl_OP_IFNOT_F,
+			[OP_IFNOT_I] = &&tl_OP_IFNOT_I,		[OP_IF_S] = &&tl_OP_IF_S,
+			[OP_IF_F] = &&tl_OP_IF_F,			[OP_IF_I] = &&tl_OP_IF_I,
+			[OP_GOTO] = &&tl_OP_GOTO,
+			[OP_CALL8H] = &&tl_OP_CALL8H,		[OP_CALL7H] = &&tl_OP_CALL8H,
+			[OP_CALL6H] = &&tl_OP_CALL8H,		[OP_CALL5H] = &&tl_OP_CALL8H,
+			[OP_CALL4H] = &&tl_OP_CALL8H,		[OP_CALL3H] = &&tl_OP_CALL8H,
+			[OP_CALL2H] = &&tl_OP_CALL8H,		[OP_CALL1H] = &&tl_OP_CALL1H,
+			[OP_CALL8] = &&tl_OP_CALL8,			[OP_CALL7] = &&tl_OP_CALL8,
+			[OP_CALL6] = &&tl_OP_CALL8,			[OP_CALL5] = &&tl_OP_CALL8,
+			[OP_CALL4] = &&tl_OP_CALL8,			[OP_CALL3] = &&tl_OP_CALL8,
+			[OP_CALL2] = &&tl_OP_CALL8,			[OP_CALL1] = &&tl_OP_CALL8,
+			[OP_CALL0] = &&tl_OP_CALL8,
+			[OP_DONE] = &&tl_OP_DONE,			[OP_RETURN] = &&tl_OP_DONE,
+			[OP_STATE] = &&tl_OP_STATE,
+			[OP_ADD_I] = &&tl_OP_ADD_I,			[OP_SUB_I] = &&tl_OP_SUB_I,
+			[OP_CONV_ITOF] = &&tl_OP_CONV_ITOF,	[OP_CONV_FTOI] = &&tl_OP_CONV_FTOI,
+		};
+		static const void *const fusedbranch[OP_NUMREALOPS] = {
+			[OP_EQ_F] = &&tl_OP_EQ_F_IF,		[OP_NE_F] = &&tl_OP_NE_F_IF,
+			[OP_LT_F] = &&tl_OP_LT_F_IF,		[OP_LE_F] = &&tl_OP_LE_F_IF,
+			[OP_GT_F] = &&tl_OP_GT_F_IF,		[OP_GE_F] = &&tl_OP_GE_F_IF,
+			[OP_NOT_F] = &&tl_OP_NOT_F_IF,		[OP_NOT_ENT] = &&tl_OP_NOT_ENT_IF,
+			[OP_EQ_E] = &&tl_OP_EQ_E_IF,		[OP_NE_E] = &&tl_OP_NE_E_IF,
+		};
+		unsigned int numstatements = current_progstate->progs->numstatements, n, next;
+		threaded = malloc(sizeof(*threaded) * numstatements);
+		if (!threaded)
+		{
+			current_progstate->usethreaded = false;
+			return PR_ExecuteCode32(progfuncs, s, runaway);
+		}
+		for (n = 0; n < numstatements; n++)
+		{
+			op = stbase[n].op;
+			if (op >= OP_NUMREALOPS || !handlers[op])
+			{	//uncommon, or a breakpoint.
+				threaded[n] = &&tl_switch;
+				continue;
+			}
+			threaded[n] = handlers[op];
+			if (n+1 >= numstatements)
+				continue;
+			next = stbase[n+1].op;
+			//jumps can still land on the second statement, which keeps its own handler.
+			if (handlers[op] == &&tl_OP_LOAD_P && (next == OP_STORE_F || next == OP_STORE_FLD || next == OP_STORE_ENT || next == OP_STORE_S || next == OP_STORE_FNC || next == OP_STORE_I || next == OP_STORE_P))
+				threaded[n] = &&tl_LOAD_STORE;
+			else if (op == OP_ADDRESS && next == OP_STOREP_V)
+				threaded[n] = &&tl_ADDRESS_STOREP_V;
+			else if (op == OP_ADDRESS && next < OP_NUMREALOPS && handlers[next] == &&tl_OP_STOREP_I)
+				threaded[n] = &&tl_ADDRESS_STOREP;
+			else if (fusedbranch[op] && stbase[n+1].a == stbase[n].c && (next == OP_IF_I || next == OP_IFNOT_I || next == OP_IF_F || next == OP_IFNOT_F))
+				threaded[n] = fusedbranch[op];
+		}
+		current_progstate->threadedcode = threaded;
+	}
+
+#define OPA ((eval_t *)&glob[st->a])
+#define OPB ((eval_t *)&glob[st->b])
+#define OPC ((eval_t *)&glob[st->c])
+
+#define INTSIZE 32
+#define THREADED
+	st = &pr_statements32[s];
+	while(1)
+	{
+		#include "execloop.h"
+	}
+#undef THREADED
+#undef INTSIZE
+}
+#endif
+
 /*
 ====================
 PR_ExecuteProgram
@@ -1735,6 +1881,9 @@ PR_ExecuteProgram
 static void PR_ExecuteCode (progfuncs_t *progfuncs, int s)
 {
 	int		runaway;
+#ifdef QCJIT
+	pbool	jitbail = false;
+#endif
 
 	if (prinst.watch_ptr && prinst.watch_ptr->_int != prinst.watch_old._int)
 	{
@@ -1765,14 +1914,6 @@ static void PR_ExecuteCode (progfuncs_t *progfuncs, int s)
 //		prinst->watch_ptr = NULL;
 	}
 
-#ifdef QCJIT
-	if (current_progstate->jit)
-	{
-		PR_EnterJIT(progfuncs, current_progstate->jit, s);
-		return;
-	}
-#endif
-
 	runaway = 100000000;
 
 	for(;;)
@@ -1788,7 +1929,24 @@ static void PR_ExecuteCode (progfuncs_t *progfuncs, int s)
 		case PST_KKQWSV:
 		case PST_FTE32:
 		case PST_UHEXEN2:
-			s = PR_ExecuteCode32(progfuncs, s, &runaway);
+#ifdef QCJIT
+			//the jit returns whenever it hits something it can't handle, in which case the interpreter gets to run up to the next call/return.
+			if (current_progstate->jit && externs->usejit && !jitbail && !current_progstate->hasbreakpoints && !progfuncs->funcs.debug_trace && !prinst.watch_ptr && !prinst.profiling)
+			{
+				s = PR_EnterJIT(progfuncs, current_progstate->jit, s, &runaway);
+				if (s == -1)
+					return;
+				jitbail = true;
+				continue;
+			}
+			jitbail = false;
+#endif
+#ifdef QCTHREADED
+			if (current_progstate->usethreaded && externs->usethreadedcode && !current_progstate->hasbreakpoints && !progfuncs->funcs.debug_trace && !prinst.watch_ptr && !prinst.profiling)
+				s = PR_ExecuteCode32Threaded(progfuncs, s, &runaway);
+			else
+#endif
+				s = PR_ExecuteCode32(progfuncs, s, &runaway);
 			if (s == -1)
 				return;
 			continue;
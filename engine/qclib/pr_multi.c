@@ -110,8 +110,13 @@ progsnum_t PDECL PR_LoadProgs(pubprogfuncs_t *ppf, const char *s)
 				if (a <= progfuncs->funcs.numprogs)
 					progfuncs->funcs.numprogs = a+1;
 
+				current_progstate->hasbreakpoints = false;
 #ifdef QCJIT
-				current_progstate->jit = PR_GenerateJit(progfuncs);
+				current_progstate->jit = externs->usejit?PR_GenerateJit(progfuncs):NULL;
+#endif
+#ifdef QCTHREADED
+				current_progstate->usethreaded = externs->usethreadedcode;
+				current_progstate->threadedcode = NULL;	//translated on first use
 #endif
 				if (oldtype != -1)
 					PR_SwitchProgs(progfuncs, oldtype);
@@ -141,6 +146,11 @@ void PR_Clear(progfuncs_t *progfuncs)
 #ifdef QCJIT
 		if (pr_progstate[a].jit)
 			PR_CloseJit(pr_progstate[a].jit);
+		pr_progstate[a].jit = NULL;
+#endif
+#ifdef QCTHREADED
+		free(pr_progstate[a].threadedcode);
+		pr_progstate[a].threadedcode = NULL;
 #endif
 		pr_progstate[a].progs = NULL;
 	}
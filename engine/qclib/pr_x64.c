@@ -0,0 +1,1466 @@
+/*
+x86-64 jit for 32bit-statement progs (fte, kkqwsv and uhexen2 formats). successor to pr_x86.c, which only knows about 16bit statements and i386.
+like pr_x86.c, this is load time, not execution time.
+
+each statement gets its own chunk of native code, and qc jumps become native jumps.
+calls, returns, string compares and state opcodes call out to small C helpers that return the address to continue from.
+anything else unusual (bad entities/fields/pointers, array bounds, switches, int64/double, etc) bails out to the interpreter at that statement.
+the interpreter then runs until the next call/return, before PR_ExecuteCode tries the jit again. this keeps all the error handling in execloop.h.
+if the debugger, watchpoints, profiling or breakpoints are active then we don't get used at all.
+
+registers:
+	r12 - current progs' globals
+	r13 - jitctx
+	r14 - progfuncs
+	rax,rcx,rdx,rsi,rdi, xmm0-xmm2 - scratch
+callee-saved registers are pushed once on entry, so helpers can be called without any other stack juggling.
+
+only the sysv abi is supported, so no windows.
+*/
+
+#define PROGSUSED
+#include "progsint.h"
+
+#if defined(QCJIT) && defined(__x86_64__)
+
+#include <stddef.h>
+#include <sys/mman.h>
+
+struct jitctx
+{
+	float *glob;
+	progfuncs_t *progfuncs;
+	struct jitstate *jit;
+	unsigned int *num_edicts;
+	int s;			//the statement to continue from when leaving (interpreter style, so the next one executed is s+1)
+	int runaway;
+};
+
+enum
+{
+	FIX_JUMP,		//jump to the start of a statement
+	FIX_BAIL,		//leave the jit and let the interpreter run the statement
+	FIX_RUNAWAY		//bail, but make sure the interpreter's runaway check fires
+};
+struct jitfixup
+{
+	unsigned int codeofs;
+	unsigned int statement;
+	unsigned int type;
+};
+
+struct jitstate
+{
+	unsigned char *code;
+	size_t codesize;
+	size_t codemax;
+
+	unsigned char **statementcode;	//[numstatements]
+	unsigned int *statementofs;		//[numstatements], only while generating.
+	unsigned int numstatements;
+
+	struct jitfixup *fixups;
+	unsigned int numfixups;
+	unsigned int maxfixups;
+
+	int (*enter)(void *code, struct jitctx *ctx);
+	unsigned char *leavectx;	//leaves the jit, returning ctx->s
+	size_t leaveofs;			//leaves the jit, returning %eax
+
+	unsigned int curstatement;
+	pbool bail;					//the current statement can't be generated, bail to the interpreter instead.
+	pbool failed;
+};
+
+enum
+{
+	R_EAX, R_ECX, R_EDX, R_EBX, R_ESP, R_EBP, R_ESI, R_EDI,
+	R_R8, R_R9, R_R10, R_R11, R_R12, R_R13, R_R14, R_R15
+};
+enum
+{
+	CC_O, CC_NO, CC_B, CC_AE, CC_E, CC_NE, CC_BE, CC_A,
+	CC_S, CC_NS, CC_P, CC_NP, CC_L, CC_GE, CC_LE, CC_G
+};
+#define SSE_ADD 0x0f58
+#define SSE_MUL 0x0f59
+#define SSE_SUB 0x0f5c
+#define SSE_DIV 0x0f5e
+
+static void Jit_Byte(struct jitstate *jit, unsigned char b)
+{
+	if (jit->failed)
+		return;
+	if (jit->codesize == jit->codemax)
+	{
+		unsigned char *n = realloc(jit->code, jit->codemax*2);
+		if (!n)
+		{
+			jit->failed = true;
+			return;
+		}
+		jit->code = n;
+		jit->codemax *= 2;
+	}
+	jit->code[jit->codesize++] = b;
+}
+static void Jit_Int(struct jitstate *jit, unsigned int v)
+{
+	Jit_Byte(jit, (v>> 0)&0xff);
+	Jit_Byte(jit, (v>> 8)&0xff);
+	Jit_Byte(jit, (v>>16)&0xff);
+	Jit_Byte(jit, (v>>24)&0xff);
+}
+static void Jit_Int64(struct jitstate *jit, unsigned long long v)
+{
+	Jit_Int(jit, (unsigned int)v);
+	Jit_Int(jit, (unsigned int)(v>>32));
+}
+
+//prefix, rex, opcode, modrm for register-direct operands. reg can also be an opcode extension.
+static void Jit_OpRR(struct jitstate *jit, int prefix, int wide, unsigned int op, int reg, int rm)
+{
+	int rex = (wide?8:0) | ((reg&8)?4:0) | ((rm&8)?1:0);
+	if (prefix)
+		Jit_Byte(jit, prefix);
+	if (rex)
+		Jit_Byte(jit, 0x40|rex);
+	if (op > 0xff)
+		Jit_Byte(jit, op>>8);
+	Jit_Byte(jit, op&0xff);
+	Jit_Byte(jit, 0xc0 | ((reg&7)<<3) | (rm&7));
+}
+//same, but with a memory operand of base+index*scale+disp (index<0 for none)
+static void Jit_OpRM(struct jitstate *jit, int prefix, int wide, unsigned int op, int reg, int base, int index, int scale, int disp)
+{
+	int rex = (wide?8:0) | ((reg&8)?4:0) | ((index>=0 && (index&8))?2:0) | ((base&8)?1:0);
+	int mod;
+	if (prefix)
+		Jit_Byte(jit, prefix);
+	if (rex)
+		Jit_Byte(jit, 0x40|rex);
+	if (op > 0xff)
+		Jit_Byte(jit, op>>8);
+	Jit_Byte(jit, op&0xff);
+
+	if (!disp && (base&7) != R_EBP)
+		mod = 0x00;
+	else if (disp >= -128 && disp <= 127)
+		mod = 0x40;
+	else
+		mod = 0x80;
+	if (index >= 0 || (base&7) == R_ESP)
+	{	//needs a sib byte
+		Jit_Byte(jit, mod | ((reg&7)<<3) | 4);
+		Jit_Byte(jit, ((scale==8)?0xc0:(scale==4)?0x80:(scale==2)?0x40:0) | (((index>=0)?index:R_ESP)&7)<<3 | (base&7));
+	}
+	else
+		Jit_Byte(jit, mod | ((reg&7)<<3) | (base&7));
+	if (mod == 0x40)
+		Jit_Byte(jit, disp);
+	else if (mod == 0x80)
+		Jit_Int(jit, disp);
+}
+
+//globals are addressed relative to r12
+static int Jit_GlobOfs(struct jitstate *jit, unsigned int ofs)
+{
+	if (ofs >= 0x20000000)
+	{	//would overflow our displacement. the interpreter can crash on it instead.
+		jit->bail = true;
+		return 0;
+	}
+	return ofs*4;
+}
+#define G(o) R_R12, -1, 0, Jit_GlobOfs(jit, o)
+
+static void Jit_LoadI(struct jitstate *jit, int reg, unsigned int ofs)
+{	//mov glob[ofs],%reg
+	Jit_OpRM(jit, 0, 0, 0x8b, reg, G(ofs));
+}
+static void Jit_StoreI(struct jitstate *jit, unsigned int ofs, int reg)
+{	//mov %reg,glob[ofs]
+	Jit_OpRM(jit, 0, 0, 0x89, reg, G(ofs));
+}
+static void Jit_LoadF(struct jitstate *jit, int xmm, unsigned int ofs)
+{	//movss glob[ofs],%xmm
+	Jit_OpRM(jit, 0xf3, 0, 0x0f10, xmm, G(ofs));
+}
+static void Jit_LoadIToF(struct jitstate *jit, int xmm, unsigned int ofs)
+{	//cvtsi2ssl glob[ofs],%xmm
+	Jit_OpRM(jit, 0xf3, 0, 0x0f2a, xmm, G(ofs));
+}
+static void Jit_StoreF(struct jitstate *jit, unsigned int ofs, int xmm)
+{	//movss %xmm,glob[ofs]
+	Jit_OpRM(jit, 0xf3, 0, 0x0f11, xmm, G(ofs));
+}
+
+static void Jit_AddFixup(struct jitstate *jit, unsigned int statement, unsigned int type)
+{
+	if (jit->numfixups == jit->maxfixups)
+	{
+		void *n = realloc(jit->fixups, sizeof(*jit->fixups) * (jit->maxfixups*2+256));
+		if (!n)
+		{
+			jit->failed = true;
+			return;
+		}
+		jit->fixups = n;
+		jit->maxfixups = jit->maxfixups*2+256;
+	}
+	jit->fixups[jit->numfixups].codeofs = jit->codesize;
+	jit->fixups[jit->numfixups].statement = statement;
+	jit->fixups[jit->numfixups].type = type;
+	jit->numfixups++;
+	Jit_Int(jit, 0);	//filled in later
+}
+static void Jit_JccFixup(struct jitstate *jit, int cc, unsigned int statement, unsigned int type)
+{	//j?? rel32
+	Jit_Byte(jit, 0x0f);
+	Jit_Byte(jit, 0x80|cc);
+	Jit_AddFixup(jit, statement, type);
+}
+#define Jit_JccBail(jit,cc) Jit_JccFixup(jit, cc, jit->curstatement, FIX_BAIL)
+static void Jit_JmpStatement(struct jitstate *jit, unsigned int statement)
+{	//jmp rel32
+	Jit_Byte(jit, 0xe9);
+	Jit_AddFixup(jit, statement, FIX_JUMP);
+}
+static size_t Jit_JccShort(struct jitstate *jit, int cc)
+{	//j?? rel8, returns the offset to patch with Jit_PatchShort
+	Jit_Byte(jit, (cc<0)?0xeb:(0x70|cc));
+	Jit_Byte(jit, 0);
+	return jit->codesize;
+}
+static void Jit_PatchShort(struct jitstate *jit, size_t ofs)
+{
+	size_t rel = jit->codesize - ofs;
+	if (rel > 127)
+		jit->bail = true;	//shouldn't happen...
+	else if (!jit->failed)
+		jit->code[ofs-1] = rel;
+}
+
+static void Jit_SetCC(struct jitstate *jit, int cc, int reg)
+{	//set?? %reg8
+	Jit_OpRR(jit, 0, 0, 0x0f90|cc, 0, reg);
+}
+//turns %al into a proper boolean, either 0/1 or 0.0/1.0
+static void Jit_StoreBool(struct jitstate *jit, unsigned int ofs, pbool asfloat)
+{
+	//movzbl %al,%eax
+	Jit_OpRR(jit, 0, 0, 0x0fb6, R_EAX, R_EAX);
+	if (asfloat)
+	{
+		//neg %eax
+		Jit_OpRR(jit, 0, 0, 0xf7, 3, R_EAX);
+		//and $0x3f800000,%eax
+		Jit_Byte(jit, 0x25);
+		Jit_Int(jit, 0x3f800000);
+	}
+	Jit_StoreI(jit, ofs, R_EAX);
+}
+static void Jit_TestFloat(struct jitstate *jit, unsigned int ofs)
+{	//testl $0x7fffffff,glob[ofs] (like EVAL_FLOATISTRUE, so -0 and denormals are handled the same)
+	Jit_OpRM(jit, 0, 0, 0xf7, 0, G(ofs));
+	Jit_Int(jit, 0x7fffffff);
+}
+static void Jit_TestInt(struct jitstate *jit, unsigned int ofs)
+{	//cmpl $0,glob[ofs]
+	Jit_OpRM(jit, 0, 0, 0x83, 7, G(ofs));
+	Jit_Byte(jit, 0);
+}
+
+//c = a OP b, where a or b can be ints that need converting first.
+static void Jit_FloatOp(struct jitstate *jit, unsigned int sseop, unsigned int a, pbool aint, unsigned int b, pbool bint, unsigned int c)
+{
+	if (aint)
+		Jit_LoadIToF(jit, 0, a);
+	else
+		Jit_LoadF(jit, 0, a);
+	if (bint)
+	{
+		Jit_LoadIToF(jit, 1, b);
+		Jit_OpRR(jit, 0xf3, 0, sseop, 0, 1);
+	}
+	else
+		Jit_OpRM(jit, 0xf3, 0, sseop, 0, G(b));
+	Jit_StoreF(jit, c, 0);
+}
+//c[k] = a[k] OP scalar. multiplies are commutative, so this also works for scalar*vector.
+static void Jit_VectorScale(struct jitstate *jit, unsigned int sseop, unsigned int v, unsigned int s, pbool sint, unsigned int c)
+{
+	int k;
+	if (sint)
+		Jit_LoadIToF(jit, 2, s);
+	else
+		Jit_LoadF(jit, 2, s);
+	for (k = 0; k < 3; k++)
+	{
+		Jit_LoadF(jit, 0, v+k);
+		Jit_OpRR(jit, 0xf3, 0, sseop, 0, 2);
+		Jit_StoreF(jit, c+k, 0);
+	}
+}
+
+//c = (a == b), or a == '0 0 0' if b is ~0 (with %xmm1 already 0)
+static void Jit_VectorCompare(struct jitstate *jit, unsigned int a, unsigned int b, unsigned int c, pbool invert)
+{
+	int k;
+	//mov $1,%eax
+	Jit_Byte(jit, 0xb8);
+	Jit_Int(jit, 1);
+	for (k = 0; k < 3; k++)
+	{
+		Jit_LoadF(jit, 0, a+k);
+		if (b == ~0u)	//ucomiss %xmm1,%xmm0
+			Jit_OpRR(jit, 0, 0, 0x0f2e, 0, 1);
+		else			//ucomiss glob[b+k],%xmm0
+			Jit_OpRM(jit, 0, 0, 0x0f2e, 0, G(b+k));
+		Jit_SetCC(jit, CC_E, R_ECX);
+		Jit_SetCC(jit, CC_NP, R_EDX);
+		//and %dl,%cl
+		Jit_OpRR(jit, 0, 0, 0x20, R_EDX, R_ECX);
+		//and %cl,%al
+		Jit_OpRR(jit, 0, 0, 0x20, R_ECX, R_EAX);
+	}
+	if (invert)
+	{
+		//xor $1,%eax
+		Jit_OpRR(jit, 0, 0, 0x83, 6, R_EAX);
+		Jit_Byte(jit, 1);
+	}
+	Jit_StoreBool(jit, c, true);
+}
+
+enum {JC_EQ, JC_NE, JC_LT, JC_LE, JC_GT, JC_GE};
+//the compares are arranged so that nans compare the same way as they do in C
+static void Jit_FloatCompare(struct jitstate *jit, int cmp, unsigned int a, pbool aint, unsigned int b, pbool bint, unsigned int c, pbool floatresult)
+{
+	if (aint)
+		Jit_LoadIToF(jit, 0, a);
+	else
+		Jit_LoadF(jit, 0, a);
+	if (bint)
+		Jit_LoadIToF(jit, 1, b);
+	else
+		Jit_LoadF(jit, 1, b);
+	switch(cmp)
+	{
+	case JC_EQ:
+	case JC_NE:
+		//ucomiss %xmm1,%xmm0
+		Jit_OpRR(jit, 0, 0, 0x0f2e, 0, 1);
+		Jit_SetCC(jit, (cmp==JC_EQ)?CC_E:CC_NE, R_EAX);
+		Jit_SetCC(jit, (cmp==JC_EQ)?CC_NP:CC_P, R_ECX);
+		//and/or %cl,%al
+		Jit_OpRR(jit, 0, 0, (cmp==JC_EQ)?0x20:0x08, R_ECX, R_EAX);
+		break;
+	case JC_LT:
+	case JC_LE:
+		//ucomiss %xmm0,%xmm1
+		Jit_OpRR(jit, 0, 0, 0x0f2e, 1, 0);
+		Jit_SetCC(jit, (cmp==JC_LT)?CC_A:CC_AE, R_EAX);
+		break;
+	case JC_GT:
+	case JC_GE:
+		//ucomiss %xmm1,%xmm0
+		Jit_OpRR(jit, 0, 0, 0x0f2e, 0, 1);
+		Jit_SetCC(jit, (cmp==JC_GT)?CC_A:CC_AE, R_EAX);
+		break;
+	}
+	Jit_StoreBool(jit, c, floatresult);
+}
+static void Jit_IntCompare(struct jitstate *jit, int cc, unsigned int a, unsigned int b, unsigned int c, pbool floatresult)
+{
+	Jit_LoadI(jit, R_EAX, a);
+	//cmp glob[b],%eax
+	Jit_OpRM(jit, 0, 0, 0x3b, R_EAX, G(b));
+	Jit_SetCC(jit, cc, R_EAX);
+	Jit_StoreBool(jit, c, floatresult);
+}
+static void Jit_IntOp(struct jitstate *jit, unsigned int op, unsigned int a, unsigned int b, unsigned int c)
+{
+	Jit_LoadI(jit, R_EAX, a);
+	//op glob[b],%eax
+	Jit_OpRM(jit, 0, 0, op, R_EAX, G(b));
+	Jit_StoreI(jit, c, R_EAX);
+}
+//(int)a OP (int)b, for the bitwise float ops
+static void Jit_FloatBitOp(struct jitstate *jit, unsigned int op, unsigned int a, pbool aint, unsigned int b, pbool bint)
+{
+	//cvttss2si/mov glob[a],%eax
+	if (aint)
+		Jit_LoadI(jit, R_EAX, a);
+	else
+		Jit_OpRM(jit, 0xf3, 0, 0x0f2c, R_EAX, G(a));
+	//cvttss2si/mov glob[b],%ecx
+	if (bint)
+		Jit_LoadI(jit, R_ECX, b);
+	else
+		Jit_OpRM(jit, 0xf3, 0, 0x0f2c, R_ECX, G(b));
+	//op %ecx,%eax
+	Jit_OpRR(jit, 0, 0, op, R_ECX, R_EAX);
+}
+
+//leaves %rdx pointing at an entity's field, bailing on anything that the interpreter would complain about.
+//fieldsize checks match execloop.h's (slightly inconsistent) ones: loads use (i+1+extra)*4 > size, stores use i*4 >= size, address has none.
+enum {EF_LOAD, EF_STORE, EF_ADDRESS};
+static void Jit_EntityField(struct jitstate *jit, const dstatement32_t *st, int mode, int extra)
+{
+	Jit_LoadI(jit, R_EAX, st->a);
+	//mov num_edicts(%r13),%rcx
+	Jit_OpRM(jit, 0, 1, 0x8b, R_ECX, R_R13, -1, 0, offsetof(struct jitctx, num_edicts));
+	//cmp (%rcx),%eax
+	Jit_OpRM(jit, 0, 0, 0x3b, R_EAX, R_ECX, -1, 0, 0);
+	Jit_JccBail(jit, CC_AE);
+	//mov edicttable(%r14),%rcx
+	Jit_OpRM(jit, 0, 1, 0x8b, R_ECX, R_R14, -1, 0, offsetof(progfuncs_t, inst.edicttable));
+	//mov (%rcx,%rax,8),%rcx
+	Jit_OpRM(jit, 0, 1, 0x8b, R_ECX, R_ECX, R_EAX, 8, 0);
+	//test %rcx,%rcx
+	Jit_OpRR(jit, 0, 1, 0x85, R_ECX, R_ECX);
+	Jit_JccBail(jit, CC_E);
+	if (mode != EF_LOAD)
+	{
+		//cmpl $0,readonly(%rcx)
+		Jit_OpRM(jit, 0, 0, 0x83, 7, R_ECX, -1, 0, offsetof(edictrun_t, readonly));
+		Jit_Byte(jit, 0);
+		Jit_JccBail(jit, CC_NE);
+	}
+#ifdef NOLEGACY
+	//cmpl $ER_FREE,ereftype(%rcx)
+	Jit_OpRM(jit, 0, 0, 0x83, 7, R_ECX, -1, 0, offsetof(edictrun_t, ereftype));
+	Jit_Byte(jit, ER_FREE);
+	Jit_JccBail(jit, CC_E);
+#endif
+
+	Jit_LoadI(jit, R_EDX, st->b);
+	//add fieldadjust(%r14),%edx
+	Jit_OpRM(jit, 0, 0, 0x03, R_EDX, R_R14, -1, 0, offsetof(progfuncs_t, funcs.fieldadjust));
+	if (mode == EF_LOAD)
+	{
+		//lea extra+1(%rdx),%esi
+		Jit_OpRM(jit, 0, 0, 0x8d, R_ESI, R_EDX, -1, 0, extra+1);
+		//shl $2,%esi
+		Jit_OpRR(jit, 0, 0, 0xc1, 4, R_ESI);
+		Jit_Byte(jit, 2);
+		//cmp fieldsize(%rcx),%esi
+		Jit_OpRM(jit, 0, 0, 0x3b, R_ESI, R_ECX, -1, 0, offsetof(edictrun_t, fieldsize));
+		Jit_JccBail(jit, CC_A);
+	}
+	else if (mode == EF_STORE)
+	{
+		//mov %edx,%esi
+		Jit_OpRR(jit, 0, 0, 0x89, R_EDX, R_ESI);
+		//shl $2,%esi
+		Jit_OpRR(jit, 0, 0, 0xc1, 4, R_ESI);
+		Jit_Byte(jit, 2);
+		//cmp fieldsize(%rcx),%esi
+		Jit_OpRM(jit, 0, 0, 0x3b, R_ESI, R_ECX, -1, 0, offsetof(edictrun_t, fieldsize));
+		Jit_JccBail(jit, CC_AE);
+	}
+	//movslq %edx,%rdx
+	Jit_OpRR(jit, 0, 1, 0x63, R_EDX, R_EDX);
+	//mov fields(%rcx),%rcx
+	Jit_OpRM(jit, 0, 1, 0x8b, R_ECX, R_ECX, -1, 0, offsetof(edictrun_t, fields));
+	//lea (%rcx,%rdx,4),%rdx
+	Jit_OpRM(jit, 0, 1, 0x8d, R_EDX, R_ECX, R_EDX, 4, 0);
+}
+
+//%eax is a qc pointer, leaves %rdx pointing at the memory if its within the addressable region, otherwise bails (the interpreter knows about tempstrings).
+static void Jit_Pointer(struct jitstate *jit, pbool write, int size)
+{
+	if (write)
+	{	//(unsigned int)p-1 >= addressableused-1-size
+		//lea -1(%rax),%esi
+		Jit_OpRM(jit, 0, 0, 0x8d, R_ESI, R_EAX, -1, 0, -1);
+		size++;
+	}
+	else
+	{	//(unsigned int)p >= addressableused-size
+		//mov %eax,%esi
+		Jit_OpRR(jit, 0, 0, 0x89, R_EAX, R_ESI);
+	}
+	//mov addressableused(%r14),%rdi
+	Jit_OpRM(jit, 0, 1, 0x8b, R_EDI, R_R14, -1, 0, offsetof(progfuncs_t, inst.addressableused));
+	//sub $size,%rdi
+	Jit_OpRR(jit, 0, 1, 0x83, 5, R_EDI);
+	Jit_Byte(jit, size);
+	//cmp %rdi,%rsi
+	Jit_OpRR(jit, 0, 1, 0x39, R_EDI, R_ESI);
+	Jit_JccBail(jit, CC_AE);
+	//mov stringtable(%r14),%rdx
+	Jit_OpRM(jit, 0, 1, 0x8b, R_EDX, R_R14, -1, 0, offsetof(progfuncs_t, funcs.stringtable));
+	//add %rax,%rdx
+	Jit_OpRR(jit, 0, 1, 0x01, R_EAX, R_EDX);
+}
+//%eax = glob[base] + glob[idx]*4
+static void Jit_PointerOffset(struct jitstate *jit, unsigned int base, unsigned int idx)
+{
+	Jit_LoadI(jit, R_EAX, idx);
+	//shl $2,%eax
+	Jit_OpRR(jit, 0, 0, 0xc1, 4, R_EAX);
+	Jit_Byte(jit, 2);
+	//add glob[base],%eax
+	Jit_OpRM(jit, 0, 0, 0x03, R_EAX, G(base));
+}
+
+static void Jit_Bail(struct jitstate *jit, unsigned int statement)
+{
+	//mov $statement-1,%eax
+	Jit_Byte(jit, 0xb8);
+	Jit_Int(jit, statement-1);
+	//jmp leave
+	Jit_Byte(jit, 0xe9);
+	Jit_Int(jit, jit->leaveofs - (jit->codesize+4));
+}
+
+//runaway checks only happen on backwards jumps and calls, which is enough to catch infinite loops.
+static void Jit_RunawayCheck(struct jitstate *jit)
+{
+	//subl $1,runaway(%r13)
+	Jit_OpRM(jit, 0, 0, 0x83, 5, R_R13, -1, 0, offsetof(struct jitctx, runaway));
+	Jit_Byte(jit, 1);
+	Jit_JccFixup(jit, CC_E, jit->curstatement, FIX_RUNAWAY);
+}
+
+//C helpers, called with the statement number. they return the native code to continue at.
+typedef void *(*jithelper_t)(struct jitctx *ctx, unsigned int statement);
+static void Jit_CallHelper(struct jitstate *jit, jithelper_t helper)
+{
+	//mov %r13,%rdi
+	Jit_OpRR(jit, 0, 1, 0x89, R_R13, R_EDI);
+	//mov $statement,%esi
+	Jit_Byte(jit, 0xbe);
+	Jit_Int(jit, jit->curstatement);
+	//mov $helper,%rax
+	Jit_Byte(jit, 0x48);
+	Jit_Byte(jit, 0xb8);
+	Jit_Int64(jit, (size_t)helper);
+	//call *%rax
+	Jit_Byte(jit, 0xff);
+	Jit_Byte(jit, 0xd0);
+	//mov glob(%r13),%r12
+	Jit_OpRM(jit, 0, 1, 0x8b, R_R12, R_R13, -1, 0, offsetof(struct jitctx, glob));
+	//jmp *%rax
+	Jit_Byte(jit, 0xff);
+	Jit_Byte(jit, 0xe0);
+}
+
+static void *Jit_Leave(struct jitctx *ctx, int s)
+{
+	ctx->s = s;
+	return ctx->jit->leavectx;
+}
+//continue at statement s+1, assuming its still safe to do so.
+static void *Jit_Continue(struct jitctx *ctx, int s)
+{
+	progfuncs_t *progfuncs = ctx->progfuncs;
+	struct jitstate *jit = ctx->jit;
+	if (current_progstate->jit != jit || current_progstate->hasbreakpoints || progfuncs->funcs.debug_trace || prinst.watch_ptr || prinst.profiling || (unsigned int)(s+1) >= jit->numstatements)
+		return Jit_Leave(ctx, s);
+	ctx->glob = current_progstate->globals;
+	return jit->statementcode[s+1];
+}
+
+#define OPA ((eval_t *)&glob[st->a])
+#define OPB ((eval_t *)&glob[st->b])
+#define OPC ((eval_t *)&glob[st->c])
+
+static void *Jit_Call(struct jitctx *ctx, unsigned int statement)
+{
+	progfuncs_t *progfuncs = ctx->progfuncs;
+	const dstatement32_t *st = &pr_statements32[statement];
+	float *glob = pr_globals;
+	unsigned int op = st->op;
+	unsigned int fnum = OPA->function;
+	int callerprogs = prinst.pr_typecurrent;
+	mfunction_t *newf;
+	int i;
+
+	//cross-progs calls, bad functions, and runaways are left for the interpreter
+	if (ctx->runaway <= 1 || (int)(fnum>>24) != callerprogs || !(fnum & ~0xff000000) || (fnum & ~0xff000000) >= pr_progs->numfunctions)
+		return Jit_Leave(ctx, statement-1);
+	newf = &pr_cp_functions[fnum & ~0xff000000];
+	if (newf->first_statement <= 0 && -newf->first_statement >= externs->numglobalbuiltins)
+		return Jit_Leave(ctx, statement-1);
+
+	ctx->runaway--;
+	prinst.pr_xstatement = statement;
+	if (op > OP_CALL8)
+	{
+		progfuncs->funcs.callargc = op - (OP_CALL1H-1);
+		if (op != OP_CALL1H)
+		{
+			G_VECTOR(OFS_PARM1)[0] = OPC->_vector[0];
+			G_VECTOR(OFS_PARM1)[1] = OPC->_vector[1];
+			G_VECTOR(OFS_PARM1)[2] = OPC->_vector[2];
+		}
+		G_VECTOR(OFS_PARM0)[0] = OPB->_vector[0];
+		G_VECTOR(OFS_PARM0)[1] = OPB->_vector[1];
+		G_VECTOR(OFS_PARM0)[2] = OPB->_vector[2];
+	}
+	else
+		progfuncs->funcs.callargc = op - OP_CALL0;
+
+	if (newf->first_statement <= 0)
+	{	// negative statements are built in functions
+		if (prinst.pr_typecurrent != 0)
+			PR_SwitchProgsParms(progfuncs, 0);
+		i = -newf->first_statement;
+#ifndef QCGC
+		prinst.numtempstringsstack = prinst.numtempstrings;
+#endif
+		(*externs->globalbuiltins[i]) (&progfuncs->funcs, (struct globalvars_s *)current_progstate->globals);
+		PR_SwitchProgsParms(progfuncs, (progsnum_t)callerprogs);
+
+		//the builtin might have started debugging, or whatever.
+		return Jit_Continue(ctx, prinst.pr_xstatement);
+	}
+	return Jit_Continue(ctx, PR_JitEnterFunction(progfuncs, newf, callerprogs));
+}
+
+static void *Jit_Return(struct jitctx *ctx, unsigned int statement)
+{
+	progfuncs_t *progfuncs = ctx->progfuncs;
+	const dstatement32_t *st = &pr_statements32[statement];
+	int *glob = (int*)pr_globals;
+	int s;
+
+	if (ctx->runaway <= 1)
+		return Jit_Leave(ctx, statement-1);
+	ctx->runaway--;
+
+	glob[OFS_RETURN] = glob[st->a];
+	glob[OFS_RETURN+1] = glob[st->a+1];
+	glob[OFS_RETURN+2] = glob[st->a+2];
+
+	s = PR_JitLeaveFunction(progfuncs);
+	if (prinst.pr_depth == prinst.exitdepth)
+	{
+		prinst.pr_xstatement = s;
+		return Jit_Leave(ctx, -1);	// all done
+	}
+	return Jit_Continue(ctx, s);
+}
+
+static pbool Jit_StringIsEmpty(progfuncs_t *progfuncs, string_t str)
+{
+	return !str || !*PR_StringToNative(&progfuncs->funcs, str);
+}
+static void *Jit_String(struct jitctx *ctx, unsigned int statement)
+{
+	progfuncs_t *progfuncs = ctx->progfuncs;
+	const dstatement32_t *st = &pr_statements32[statement];
+	float *glob = pr_globals;
+	pbool cond;
+
+	switch(st->op)
+	{
+	case OP_EQ_S:
+	case OP_NE_S:
+		if (OPA->string == OPB->string)
+			cond = false;
+		else if (!OPA->string)
+			cond = !Jit_StringIsEmpty(progfuncs, OPB->string);
+		else if (!OPB->string)
+			cond = !Jit_StringIsEmpty(progfuncs, OPA->string);
+		else
+		{	//ne gives the strcmp result, not just 1.
+			int r = strcmp(PR_StringToNative(&progfuncs->funcs, OPA->string), PR_StringToNative(&progfuncs->funcs, OPB->string));
+			OPC->_float = (st->op == OP_EQ_S)?(float)!r:(float)r;
+			break;
+		}
+		OPC->_float = (st->op == OP_EQ_S)?!cond:cond;
+		break;
+	case OP_NOT_S:
+		OPC->_float = Jit_StringIsEmpty(progfuncs, OPA->string);
+		break;
+	case OP_IF_S:
+	case OP_IFNOT_S:
+		if (ctx->runaway <= 1)
+			return Jit_Leave(ctx, statement-1);
+		ctx->runaway--;
+		cond = OPA->string && PR_StringToNative(&progfuncs->funcs, OPA->string);	//not the same as not_s...
+		if (cond == (st->op == OP_IF_S))
+			return Jit_Continue(ctx, statement + (int)st->b - 1);
+		break;
+	}
+	return Jit_Continue(ctx, statement);
+}
+
+static void *Jit_State(struct jitctx *ctx, unsigned int statement)
+{
+	progfuncs_t *progfuncs = ctx->progfuncs;
+	const dstatement32_t *st = &pr_statements32[statement];
+	float *glob = pr_globals;
+
+	switch(st->op)
+	{
+	case OP_STATE:
+		externs->stateop(&progfuncs->funcs, OPA->_float, OPB->function);
+		break;
+	case OP_CSTATE:
+		externs->cstateop(&progfuncs->funcs, OPA->_float, OPB->_float, prinst.pr_xfunction - pr_cp_functions);
+		break;
+	case OP_CWSTATE:
+		externs->cwstateop(&progfuncs->funcs, OPA->_float, OPB->_float, prinst.pr_xfunction - pr_cp_functions);
+		break;
+	case OP_THINKTIME:
+		externs->thinktimeop(&progfuncs->funcs, (struct edict_s *)PROG_TO_EDICT_UB(progfuncs, OPA->edict), OPB->_float);
+		break;
+	}
+	return Jit_Continue(ctx, statement);
+}
+
+#undef OPA
+#undef OPB
+#undef OPC
+
+//returns false if its something we don't support, in which case we bail to the interpreter
+static pbool Jit_Statement(struct jitstate *jit, const dstatement32_t *st, unsigned int numstatements, unsigned int globals)
+{
+	unsigned int i = jit->curstatement;
+	unsigned int target;
+	size_t j0;
+	int k;
+
+	switch(st->op)
+	{
+	case OP_ADD_F:	Jit_FloatOp(jit, SSE_ADD, st->a, false, st->b, false, st->c);	break;
+	case OP_SUB_F:	Jit_FloatOp(jit, SSE_SUB, st->a, false, st->b, false, st->c);	break;
+	case OP_MUL_F:	Jit_FloatOp(jit, SSE_MUL, st->a, false, st->b, false, st->c);	break;
+	case OP_DIV_F:	Jit_FloatOp(jit, SSE_DIV, st->a, false, st->b, false, st->c);	break;
+	case OP_ADD_FI:	Jit_FloatOp(jit, SSE_ADD, st->a, false, st->b, true, st->c);	break;
+	case OP_ADD_IF:	Jit_FloatOp(jit, SSE_ADD, st->a, true, st->b, false, st->c);	break;
+	case OP_SUB_FI:	Jit_FloatOp(jit, SSE_SUB, st->a, false, st->b, true, st->c);	break;
+	case OP_SUB_IF:	Jit_FloatOp(jit, SSE_SUB, st->a, true, st->b, false, st->c);	break;
+	case OP_MUL_FI:	Jit_FloatOp(jit, SSE_MUL, st->a, false, st->b, true, st->c);	break;
+	case OP_MUL_IF:	Jit_FloatOp(jit, SSE_MUL, st->a, true, st->b, false, st->c);	break;
+	case OP_DIV_FI:	Jit_FloatOp(jit, SSE_DIV, st->a, false, st->b, true, st->c);	break;
+	case OP_DIV_IF:	Jit_FloatOp(jit, SSE_DIV, st->a, true, st->b, false, st->c);	break;
+
+	case OP_ADD_V:
+	case OP_SUB_V:
+		for (k = 0; k < 3; k++)
+			Jit_FloatOp(jit, (st->op == OP_ADD_V)?SSE_ADD:SSE_SUB, st->a+k, false, st->b+k, false, st->c+k);
+		break;
+	case OP_MUL_V:
+		Jit_LoadF(jit, 0, st->a+0);
+		Jit_OpRM(jit, 0xf3, 0, SSE_MUL, 0, G(st->b+0));
+		for (k = 1; k < 3; k++)
+		{
+			Jit_LoadF(jit, 1, st->a+k);
+			Jit_OpRM(jit, 0xf3, 0, SSE_MUL, 1, G(st->b+k));
+			Jit_OpRR(jit, 0xf3, 0, SSE_ADD, 0, 1);
+		}
+		Jit_StoreF(jit, st->c, 0);
+		break;
+	case OP_MUL_FV:	Jit_VectorScale(jit, SSE_MUL, st->b, st->a, false, st->c);	break;
+	case OP_MUL_VF:	Jit_VectorScale(jit, SSE_MUL, st->a, st->b, false, st->c);	break;
+	case OP_MUL_IV:	Jit_VectorScale(jit, SSE_MUL, st->b, st->a, true, st->c);	break;
+	case OP_MUL_VI:	Jit_VectorScale(jit, SSE_MUL, st->a, st->b, true, st->c);	break;
+	case OP_DIV_VF:	Jit_VectorScale(jit, SSE_DIV, st->a, st->b, false, st->c);	break;
+
+	case OP_EQ_F:	Jit_FloatCompare(jit, JC_EQ, st->a, false, st->b, false, st->c, true);	break;
+	case OP_NE_F:	Jit_FloatCompare(jit, JC_NE, st->a, false, st->b, false, st->c, true);	break;
+	case OP_LT_F:	Jit_FloatCompare(jit, JC_LT, st->a, false, st->b, false, st->c, true);	break;
+	case OP_LE_F:	Jit_FloatCompare(jit, JC_LE, st->a, false, st->b, false, st->c, true);	break;
+	case OP_GT_F:	Jit_FloatCompare(jit, JC_GT, st->a, false, st->b, false, st->c, true);	break;
+	case OP_GE_F:	Jit_FloatCompare(jit, JC_GE, st->a, false, st->b, false, st->c, true);	break;
+	case OP_EQ_IF:	Jit_FloatCompare(jit, JC_EQ, st->a, true, st->b, false, st->c, false);	break;
+	case OP_EQ_FI:	Jit_FloatCompare(jit, JC_EQ, st->a, false, st->b, true, st->c, false);	break;
+	case OP_NE_IF:	Jit_FloatCompare(jit, JC_NE, st->a, true, st->b, false, st->c, false);	break;
+	case OP_NE_FI:	Jit_FloatCompare(jit, JC_NE, st->a, false, st->b, true, st->c, false);	break;
+	case OP_LT_IF:	Jit_FloatCompare(jit, JC_LT, st->a, true, st->b, false, st->c, false);	break;
+	case OP_LT_FI:	Jit_FloatCompare(jit, JC_LT, st->a, false, st->b, true, st->c, false);	break;
+	case OP_LE_IF:	Jit_FloatCompare(jit, JC_LE, st->a, true, st->b, false, st->c, false);	break;
+	case OP_LE_FI:	Jit_FloatCompare(jit, JC_LE, st->a, false, st->b, true, st->c, false);	break;
+	case OP_GT_IF:	Jit_FloatCompare(jit, JC_GT, st->a, true, st->b, false, st->c, false);	break;
+	case OP_GT_FI:	Jit_FloatCompare(jit, JC_GT, st->a, false, st->b, true, st->c, false);	break;
+	case OP_GE_IF:	Jit_FloatCompare(jit, JC_GE, st->a, true, st->b, false, st->c, false);	break;
+	case OP_GE_FI:	Jit_FloatCompare(jit, JC_GE, st->a, false, st->b, true, st->c, false);	break;
+
+	case OP_EQ_E:
+	case OP_EQ_FNC:	Jit_IntCompare(jit, CC_E, st->a, st->b, st->c, true);	break;
+	case OP_NE_E:
+	case OP_NE_FNC:	Jit_IntCompare(jit, CC_NE, st->a, st->b, st->c, true);	break;
+	case OP_EQ_I:	Jit_IntCompare(jit, CC_E, st->a, st->b, st->c, false);	break;
+	case OP_NE_I:	Jit_IntCompare(jit, CC_NE, st->a, st->b, st->c, false);	break;
+	case OP_LT_I:	Jit_IntCompare(jit, CC_L, st->a, st->b, st->c, false);	break;
+	case OP_LE_I:	Jit_IntCompare(jit, CC_LE, st->a, st->b, st->c, false);	break;
+	case OP_GT_I:	Jit_IntCompare(jit, CC_G, st->a, st->b, st->c, false);	break;
+	case OP_GE_I:	Jit_IntCompare(jit, CC_GE, st->a, st->b, st->c, false);	break;
+	case OP_LT_U:	Jit_IntCompare(jit, CC_B, st->a, st->b, st->c, false);	break;
+	case OP_LE_U:	Jit_IntCompare(jit, CC_BE, st->a, st->b, st->c, false);	break;
+
+	case OP_EQ_V:
+	case OP_NE_V:
+		//x!=y is always !(x==y), even with nans, so ne is just the inverse of eq.
+		Jit_VectorCompare(jit, st->a, st->b, st->c, st->op == OP_NE_V);
+		break;
+	case OP_NOT_V:
+		//xorps %xmm1,%xmm1
+		Jit_OpRR(jit, 0, 0, 0x0f57, 1, 1);
+		Jit_VectorCompare(jit, st->a, ~0u, st->c, false);
+		break;
+
+	case OP_NOT_F:
+		Jit_TestFloat(jit, st->a);
+		Jit_SetCC(jit, CC_E, R_EAX);
+		Jit_StoreBool(jit, st->c, true);
+		break;
+	case OP_NOT_I:
+	case OP_NOT_ENT:
+		Jit_TestInt(jit, st->a);
+		Jit_SetCC(jit, CC_E, R_EAX);
+		Jit_StoreBool(jit, st->c, st->op == OP_NOT_ENT);
+		break;
+	case OP_NOT_FNC:
+		Jit_LoadI(jit, R_EAX, st->a);
+		//and $0x00ffffff,%eax
+		Jit_Byte(jit, 0x25);
+		Jit_Int(jit, 0x00ffffff);
+		Jit_SetCC(jit, CC_E, R_EAX);
+		Jit_StoreBool(jit, st->c, true);
+		break;
+	case OP_AND_F:
+	case OP_OR_F:
+		Jit_TestFloat(jit, st->a);
+		Jit_SetCC(jit, CC_NE, R_ECX);
+		Jit_TestFloat(jit, st->b);
+		Jit_SetCC(jit, CC_NE, R_EAX);
+		//and/or %cl,%al
+		Jit_OpRR(jit, 0, 0, (st->op == OP_AND_F)?0x20:0x08, R_ECX, R_EAX);
+		Jit_StoreBool(jit, st->c, true);
+		break;
+	case OP_AND_I:
+	case OP_OR_I:
+		Jit_TestInt(jit, st->a);
+		Jit_SetCC(jit, CC_NE, R_ECX);
+		Jit_TestInt(jit, st->b);
+		Jit_SetCC(jit, CC_NE, R_EAX);
+		//and/or %cl,%al
+		Jit_OpRR(jit, 0, 0, (st->op == OP_AND_I)?0x20:0x08, R_ECX, R_EAX);
+		Jit_StoreBool(jit, st->c, false);
+		break;
+
+	case OP_BITAND_F:
+	case OP_BITOR_F:
+		Jit_FloatBitOp(jit, (st->op == OP_BITAND_F)?0x21:0x09, st->a, false, st->b, false);
+		//cvtsi2ss %eax,%xmm0
+		Jit_OpRR(jit, 0xf3, 0, 0x0f2a, 0, R_EAX);
+		Jit_StoreF(jit, st->c, 0);
+		break;
+	case OP_BITAND_IF:	Jit_FloatBitOp(jit, 0x21, st->a, true, st->b, false);	Jit_StoreI(jit, st->c, R_EAX);	break;
+	case OP_BITOR_IF:	Jit_FloatBitOp(jit, 0x09, st->a, true, st->b, false);	Jit_StoreI(jit, st->c, R_EAX);	break;
+	case OP_BITAND_FI:	Jit_FloatBitOp(jit, 0x21, st->a, false, st->b, true);	Jit_StoreI(jit, st->c, R_EAX);	break;
+	case OP_BITOR_FI:	Jit_FloatBitOp(jit, 0x09, st->a, false, st->b, true);	Jit_StoreI(jit, st->c, R_EAX);	break;
+
+	case OP_ADD_I:		Jit_IntOp(jit, 0x03, st->a, st->b, st->c);	break;
+	case OP_SUB_I:
+	case OP_SUB_S:		Jit_IntOp(jit, 0x2b, st->a, st->b, st->c);	break;
+	case OP_MUL_I:		Jit_IntOp(jit, 0x0faf, st->a, st->b, st->c);	break;
+	case OP_BITAND_I:	Jit_IntOp(jit, 0x23, st->a, st->b, st->c);	break;
+	case OP_BITOR_I:	Jit_IntOp(jit, 0x0b, st->a, st->b, st->c);	break;
+	case OP_BITXOR_I:	Jit_IntOp(jit, 0x33, st->a, st->b, st->c);	break;
+	case OP_LSHIFT_I:
+	case OP_RSHIFT_I:
+	case OP_RSHIFT_U:
+		Jit_LoadI(jit, R_EAX, st->a);
+		Jit_LoadI(jit, R_ECX, st->b);
+		//shl/sar/shr %cl,%eax
+		Jit_OpRR(jit, 0, 0, 0xd3, (st->op == OP_LSHIFT_I)?4:(st->op == OP_RSHIFT_I)?7:5, R_EAX);
+		Jit_StoreI(jit, st->c, R_EAX);
+		break;
+	case OP_DIV_I:
+	case OP_DIV_U:
+		//no division by zero, the result is 0 instead.
+		Jit_LoadI(jit, R_ECX, st->b);
+		//xor %eax,%eax
+		Jit_OpRR(jit, 0, 0, 0x31, R_EAX, R_EAX);
+		//test %ecx,%ecx
+		Jit_OpRR(jit, 0, 0, 0x85, R_ECX, R_ECX);
+		j0 = Jit_JccShort(jit, CC_E);
+		Jit_LoadI(jit, R_EAX, st->a);
+		if (st->op == OP_DIV_I)
+		{
+			//cltd
+			Jit_Byte(jit, 0x99);
+			//idiv %ecx
+			Jit_OpRR(jit, 0, 0, 0xf7, 7, R_ECX);
+		}
+		else
+		{
+			//xor %edx,%edx
+			Jit_OpRR(jit, 0, 0, 0x31, R_EDX, R_EDX);
+			//div %ecx
+			Jit_OpRR(jit, 0, 0, 0xf7, 6, R_ECX);
+		}
+		Jit_PatchShort(jit, j0);
+		Jit_StoreI(jit, st->c, R_EAX);
+		break;
+	case OP_ADD_PIW:
+		Jit_PointerOffset(jit, st->a, st->b);
+		Jit_StoreI(jit, st->c, R_EAX);
+		break;
+	case OP_ADD_SF:
+		//cvttss2si glob[b],%eax
+		Jit_OpRM(jit, 0xf3, 0, 0x0f2c, R_EAX, G(st->b));
+		//add glob[a],%eax
+		Jit_OpRM(jit, 0, 0, 0x03, R_EAX, G(st->a));
+		Jit_StoreI(jit, st->c, R_EAX);
+		break;
+
+	case OP_CONV_ITOF:
+		Jit_LoadIToF(jit, 0, st->a);
+		Jit_StoreF(jit, st->c, 0);
+		break;
+	case OP_CONV_FTOI:
+		//cvttss2si glob[a],%eax
+		Jit_OpRM(jit, 0xf3, 0, 0x0f2c, R_EAX, G(st->a));
+		Jit_StoreI(jit, st->c, R_EAX);
+		break;
+
+	case OP_STORE_F:
+	case OP_STORE_ENT:
+	case OP_STORE_FLD:
+	case OP_STORE_S:
+	case OP_STORE_I:
+	case OP_STORE_FNC:
+	case OP_STORE_P:
+		Jit_LoadI(jit, R_EAX, st->a);
+		Jit_StoreI(jit, st->b, R_EAX);
+		break;
+	case OP_STORE_V:
+		for (k = 0; k < 3; k++)
+		{
+			Jit_LoadI(jit, R_EAX, st->a+k);
+			Jit_StoreI(jit, st->b+k, R_EAX);
+		}
+		break;
+	case OP_STORE_IF:
+		Jit_LoadIToF(jit, 0, st->a);
+		Jit_StoreF(jit, st->b, 0);
+		break;
+	case OP_STORE_FI:
+		//cvttss2si glob[a],%eax
+		Jit_OpRM(jit, 0xf3, 0, 0x0f2c, R_EAX, G(st->a));
+		Jit_StoreI(jit, st->b, R_EAX);
+		break;
+
+	case OP_ADDSTORE_F:
+	case OP_SUBSTORE_F:
+	case OP_MULSTORE_F:
+	case OP_DIVSTORE_F:
+		Jit_FloatOp(jit, (st->op == OP_ADDSTORE_F)?SSE_ADD:(st->op == OP_SUBSTORE_F)?SSE_SUB:(st->op == OP_MULSTORE_F)?SSE_MUL:SSE_DIV, st->b, false, st->a, false, st->b);
+		break;
+	case OP_ADDSTORE_V:
+	case OP_SUBSTORE_V:
+		for (k = 0; k < 3; k++)
+			Jit_FloatOp(jit, (st->op == OP_ADDSTORE_V)?SSE_ADD:SSE_SUB, st->b+k, false, st->a+k, false, st->b+k);
+		break;
+	case OP_MULSTORE_VF:
+		Jit_VectorScale(jit, SSE_MUL, st->b, st->a, false, st->b);
+		break;
+	case OP_BITSETSTORE_F:
+	case OP_BITCLRSTORE_F:
+		//cvttss2si glob[a],%ecx
+		Jit_OpRM(jit, 0xf3, 0, 0x0f2c, R_ECX, G(st->a));
+		//cvttss2si glob[b],%eax
+		Jit_OpRM(jit, 0xf3, 0, 0x0f2c, R_EAX, G(st->b));
+		if (st->op == OP_BITCLRSTORE_F)
+		{
+			//not %ecx
+			Jit_OpRR(jit, 0, 0, 0xf7, 2, R_ECX);
+			//and %ecx,%eax
+			Jit_OpRR(jit, 0, 0, 0x21, R_ECX, R_EAX);
+		}
+		else	//or %ecx,%eax
+			Jit_OpRR(jit, 0, 0, 0x09, R_ECX, R_EAX);
+		//cvtsi2ss %eax,%xmm0
+		Jit_OpRR(jit, 0xf3, 0, 0x0f2a, 0, R_EAX);
+		Jit_StoreF(jit, st->b, 0);
+		break;
+
+	case OP_ADDSTOREP_F:
+	case OP_SUBSTOREP_F:
+	case OP_MULSTOREP_F:
+	case OP_DIVSTOREP_F:
+		Jit_LoadI(jit, R_EAX, st->b);
+		Jit_Pointer(jit, true, sizeof(float));
+		//movss (%rdx),%xmm0
+		Jit_OpRM(jit, 0xf3, 0, 0x0f10, 0, R_EDX, -1, 0, 0);
+		Jit_OpRM(jit, 0xf3, 0, (st->op == OP_ADDSTOREP_F)?SSE_ADD:(st->op == OP_SUBSTOREP_F)?SSE_SUB:(st->op == OP_MULSTOREP_F)?SSE_MUL:SSE_DIV, 0, G(st->a));
+		//movss %xmm0,(%rdx)
+		Jit_OpRM(jit, 0xf3, 0, 0x0f11, 0, R_EDX, -1, 0, 0);
+		Jit_StoreF(jit, st->c, 0);
+		break;
+	case OP_ADDSTOREP_V:
+	case OP_SUBSTOREP_V:
+	case OP_MULSTOREP_VF:
+		Jit_LoadI(jit, R_EAX, st->b);
+		Jit_Pointer(jit, true, sizeof(float)*3);
+		if (st->op == OP_MULSTOREP_VF)
+			Jit_LoadF(jit, 2, st->a);
+		for (k = 0; k < 3; k++)
+		{
+			//movss k*4(%rdx),%xmm0
+			Jit_OpRM(jit, 0xf3, 0, 0x0f10, 0, R_EDX, -1, 0, k*4);
+			if (st->op == OP_MULSTOREP_VF)
+				Jit_OpRR(jit, 0xf3, 0, SSE_MUL, 0, 2);
+			else
+				Jit_OpRM(jit, 0xf3, 0, (st->op == OP_ADDSTOREP_V)?SSE_ADD:SSE_SUB, 0, G(st->a+k));
+			//movss %xmm0,k*4(%rdx)
+			Jit_OpRM(jit, 0xf3, 0, 0x0f11, 0, R_EDX, -1, 0, k*4);
+			Jit_StoreF(jit, st->c+k, 0);
+		}
+		break;
+	case OP_BITSETSTOREP_F:
+	case OP_BITCLRSTOREP_F:
+		Jit_LoadI(jit, R_EAX, st->b);
+		Jit_Pointer(jit, true, sizeof(float));
+		//cvttss2si glob[a],%ecx
+		Jit_OpRM(jit, 0xf3, 0, 0x0f2c, R_ECX, G(st->a));
+		//cvttss2si (%rdx),%eax
+		Jit_OpRM(jit, 0xf3, 0, 0x0f2c, R_EAX, R_EDX, -1, 0, 0);
+		if (st->op == OP_BITCLRSTOREP_F)
+		{
+			//not %ecx
+			Jit_OpRR(jit, 0, 0, 0xf7, 2, R_ECX);
+			//and %ecx,%eax
+			Jit_OpRR(jit, 0, 0, 0x21, R_ECX, R_EAX);
+		}
+		else	//or %ecx,%eax
+			Jit_OpRR(jit, 0, 0, 0x09, R_ECX, R_EAX);
+		//cvtsi2ss %eax,%xmm0
+		Jit_OpRR(jit, 0xf3, 0, 0x0f2a, 0, R_EAX);
+		//movss %xmm0,(%rdx)
+		Jit_OpRM(jit, 0xf3, 0, 0x0f11, 0, R_EDX, -1, 0, 0);
+		break;
+
+	//pointers
+	case OP_STOREP_I:
+	case OP_STOREP_F:
+	case OP_STOREP_ENT:
+	case OP_STOREP_FLD:
+	case OP_STOREP_S:
+	case OP_STOREP_FNC:
+		Jit_PointerOffset(jit, st->b, st->c);
+		Jit_Pointer(jit, true, sizeof(int));
+		Jit_LoadI(jit, R_ECX, st->a);
+		//mov %ecx,(%rdx)
+		Jit_OpRM(jit, 0, 0, 0x89, R_ECX, R_EDX, -1, 0, 0);
+		break;
+	case OP_STOREP_V:
+		Jit_PointerOffset(jit, st->b, st->c);
+		Jit_Pointer(jit, true, sizeof(float)*3);
+		for (k = 0; k < 3; k++)
+		{
+			Jit_LoadI(jit, R_ECX, st->a+k);
+			//mov %ecx,k*4(%rdx)
+			Jit_OpRM(jit, 0, 0, 0x89, R_ECX, R_EDX, -1, 0, k*4);
+		}
+		break;
+	case OP_LOADP_I:
+	case OP_LOADP_F:
+	case OP_LOADP_FLD:
+	case OP_LOADP_ENT:
+	case OP_LOADP_S:
+	case OP_LOADP_FNC:
+		Jit_PointerOffset(jit, st->a, st->b);
+		Jit_Pointer(jit, false, sizeof(int));
+		//mov (%rdx),%eax
+		Jit_OpRM(jit, 0, 0, 0x8b, R_EAX, R_EDX, -1, 0, 0);
+		Jit_StoreI(jit, st->c, R_EAX);
+		break;
+	case OP_LOADP_V:
+		Jit_PointerOffset(jit, st->a, st->b);
+		Jit_Pointer(jit, false, sizeof(float)*3);
+		for (k = 0; k < 3; k++)
+		{
+			//mov k*4(%rdx),%eax
+			Jit_OpRM(jit, 0, 0, 0x8b, R_EAX, R_EDX, -1, 0, k*4);
+			Jit_StoreI(jit, st->c+k, R_EAX);
+		}
+		break;
+
+	//entity fields
+	case OP_LOAD_F:
+	case OP_LOAD_FLD:
+	case OP_LOAD_ENT:
+	case OP_LOAD_S:
+	case OP_LOAD_FNC:
+	case OP_LOAD_I:
+	case OP_LOAD_P:
+		Jit_EntityField(jit, st, EF_LOAD, 0);
+		//mov (%rdx),%eax
+		Jit_OpRM(jit, 0, 0, 0x8b, R_EAX, R_EDX, -1, 0, 0);
+		Jit_StoreI(jit, st->c, R_EAX);
+		break;
+	case OP_LOAD_V:
+		Jit_EntityField(jit, st, EF_LOAD, 2);
+		for (k = 0; k < 3; k++)
+		{
+			//mov k*4(%rdx),%eax
+			Jit_OpRM(jit, 0, 0, 0x8b, R_EAX, R_EDX, -1, 0, k*4);
+			Jit_StoreI(jit, st->c+k, R_EAX);
+		}
+		break;
+	case OP_ADDRESS:
+		Jit_EntityField(jit, st, EF_ADDRESS, 0);
+		//sub stringtable(%r14),%rdx
+		Jit_OpRM(jit, 0, 1, 0x2b, R_EDX, R_R14, -1, 0, offsetof(progfuncs_t, funcs.stringtable));
+		Jit_StoreI(jit, st->c, R_EDX);
+		break;
+	case OP_STOREF_F:
+	case OP_STOREF_I:
+	case OP_STOREF_S:
+		Jit_EntityField(jit, st, EF_STORE, 0);
+		Jit_LoadI(jit, R_EAX, st->c);
+		//mov %eax,(%rdx)
+		Jit_OpRM(jit, 0, 0, 0x89, R_EAX, R_EDX, -1, 0, 0);
+		break;
+	case OP_STOREF_V:
+		Jit_EntityField(jit, st, EF_STORE, 0);
+		for (k = 0; k < 3; k++)
+		{
+			Jit_LoadI(jit, R_EAX, st->c+k);
+			//mov %eax,k*4(%rdx)
+			Jit_OpRM(jit, 0, 0, 0x89, R_EAX, R_EDX, -1, 0, k*4);
+		}
+		break;
+
+	//arrays
+	case OP_FETCH_GBL_F:
+	case OP_FETCH_GBL_S:
+	case OP_FETCH_GBL_E:
+	case OP_FETCH_GBL_FNC:
+	case OP_FETCH_GBL_V:
+		//cvttss2si glob[b],%eax
+		Jit_OpRM(jit, 0xf3, 0, 0x0f2c, R_EAX, G(st->b));
+		//cmp glob[a-1],%eax
+		Jit_OpRM(jit, 0, 0, 0x3b, R_EAX, G(st->a-1));
+		Jit_JccBail(jit, CC_A);
+		if (st->op == OP_FETCH_GBL_V)
+		{
+			//lea (%rax,%rax,2),%eax
+			Jit_OpRM(jit, 0, 0, 0x8d, R_EAX, R_EAX, R_EAX, 2, 0);
+			for (k = 0; k < 3; k++)
+			{
+				//mov glob[a+k](,%rax,4),%ecx
+				Jit_OpRM(jit, 0, 0, 0x8b, R_ECX, R_R12, R_EAX, 4, Jit_GlobOfs(jit, st->a+k));
+				Jit_StoreI(jit, st->c+k, R_ECX);
+			}
+		}
+		else
+		{
+			//mov glob[a](,%rax,4),%ecx
+			Jit_OpRM(jit, 0, 0, 0x8b, R_ECX, R_R12, R_EAX, 4, Jit_GlobOfs(jit, st->a));
+			Jit_StoreI(jit, st->c, R_ECX);
+		}
+		break;
+	case OP_LOADA_I:
+	case OP_LOADA_F:
+	case OP_LOADA_FLD:
+	case OP_LOADA_ENT:
+	case OP_LOADA_S:
+	case OP_LOADA_FNC:
+	case OP_LOADA_V:
+		Jit_LoadI(jit, R_EAX, st->b);
+		//add $a,%eax
+		Jit_Byte(jit, 0x05);
+		Jit_Int(jit, st->a);
+		//cmp $limit,%eax
+		Jit_Byte(jit, 0x3d);
+		Jit_Int(jit, (st->op == OP_LOADA_V)?globals-2:globals);
+		Jit_JccBail(jit, CC_AE);
+		for (k = 0; k < ((st->op == OP_LOADA_V)?3:1); k++)
+		{
+			//mov k*4(%r12,%rax,4),%ecx
+			Jit_OpRM(jit, 0, 0, 0x8b, R_ECX, R_R12, R_EAX, 4, k*4);
+			Jit_StoreI(jit, st->c+k, R_ECX);
+		}
+		break;
+	case OP_GLOBALADDRESS:
+		//lea glob[a],%rax
+		Jit_OpRM(jit, 0, 1, 0x8d, R_EAX, G(st->a));
+		//movslq glob[b],%rcx
+		Jit_OpRM(jit, 0, 1, 0x63, R_ECX, G(st->b));
+		//lea (%rax,%rcx,4),%rax
+		Jit_OpRM(jit, 0, 1, 0x8d, R_EAX, R_EAX, R_ECX, 4, 0);
+		//sub stringtable(%r14),%rax
+		Jit_OpRM(jit, 0, 1, 0x2b, R_EAX, R_R14, -1, 0, offsetof(progfuncs_t, funcs.stringtable));
+		Jit_StoreI(jit, st->c, R_EAX);
+		break;
+	case OP_BOUNDCHECK:
+		Jit_LoadI(jit, R_EAX, st->a);
+		//cmp $c,%eax
+		Jit_Byte(jit, 0x3d);
+		Jit_Int(jit, st->c);
+		Jit_JccBail(jit, CC_B);
+		//cmp $b,%eax
+		Jit_Byte(jit, 0x3d);
+		Jit_Int(jit, st->b);
+		Jit_JccBail(jit, CC_AE);
+		break;
+
+	//control flow
+	case OP_GOTO:
+		target = i + (int)st->a;
+		if (target >= numstatements)
+			return false;
+		if (target <= i)
+			Jit_RunawayCheck(jit);
+		Jit_JmpStatement(jit, target);
+		break;
+	case OP_IF_I:
+	case OP_IFNOT_I:
+	case OP_IF_F:
+	case OP_IFNOT_F:
+		target = i + (int)st->b;
+		if (target >= numstatements)
+			return false;
+		if (target <= i)
+			Jit_RunawayCheck(jit);
+		if (st->op == OP_IF_F || st->op == OP_IFNOT_F)
+			Jit_TestFloat(jit, st->a);
+		else
+			Jit_TestInt(jit, st->a);
+		Jit_JccFixup(jit, (st->op == OP_IF_I || st->op == OP_IF_F)?CC_NE:CC_E, target, FIX_JUMP);
+		break;
+
+	case OP_CALL0:
+	case OP_CALL1:
+	case OP_CALL2:
+	case OP_CALL3:
+	case OP_CALL4:
+	case OP_CALL5:
+	case OP_CALL6:
+	case OP_CALL7:
+	case OP_CALL8:
+	case OP_CALL1H:
+	case OP_CALL2H:
+	case OP_CALL3H:
+	case OP_CALL4H:
+	case OP_CALL5H:
+	case OP_CALL6H:
+	case OP_CALL7H:
+	case OP_CALL8H:
+		Jit_CallHelper(jit, Jit_Call);
+		break;
+	case OP_DONE:
+	case OP_RETURN:
+		Jit_CallHelper(jit, Jit_Return);
+		break;
+	case OP_EQ_S:
+	case OP_NE_S:
+	case OP_NOT_S:
+	case OP_IF_S:
+	case OP_IFNOT_S:
+		Jit_CallHelper(jit, Jit_String);
+		break;
+	case OP_STATE:
+	case OP_CSTATE:
+	case OP_CWSTATE:
+	case OP_THINKTIME:
+		Jit_CallHelper(jit, Jit_State);
+		break;
+
+	default:	//switches, random, int64/double, etc (and breakpoints).
+		return false;
+	}
+	return true;
+}
+
+void PR_CloseJit(struct jitstate *jit)
+{
+	if (jit)
+	{
+		free(jit->statementcode);
+		munmap(jit->code, jit->codesize);
+		free(jit);
+	}
+}
+
+struct jitstate *PR_GenerateJit(progfuncs_t *progfuncs)
+{
+	struct jitstate *jit;
+	const dstatement32_t *st = (const dstatement32_t*)current_progstate->statements;
+	unsigned int numstatements = current_progstate->progs->numstatements;
+	unsigned int globals = current_progstate->globals_bytes>>2;
+	unsigned int i, bailed = 0;
+	size_t start, leavectxofs = 0, stubofs = 0;
+	unsigned int fixupcount, stubstatement = ~0u, stubtype = ~0u;
+	unsigned char *code;
+
+	switch(current_progstate->structtype)
+	{
+	case PST_KKQWSV:
+	case PST_FTE32:
+	case PST_UHEXEN2:
+		break;
+	default:	//16bit statements are left to the interpreter.
+		return NULL;
+	}
+	if (!numstatements)
+		return NULL;
+
+	jit = calloc(1, sizeof(*jit));
+	if (!jit)
+		return NULL;
+	jit->numstatements = numstatements;
+	jit->statementofs = malloc(sizeof(*jit->statementofs) * numstatements);
+	jit->codemax = 64*1024 + numstatements*64;
+	jit->code = malloc(jit->codemax);
+	if (!jit->statementofs || !jit->code)
+		jit->failed = true;
+	else
+	{
+		//entry: int enter(void *code, struct jitctx *ctx)
+		//push %rbx, %rbp, %r12, %r13, %r14, %r15
+		Jit_Byte(jit, 0x53);
+		Jit_Byte(jit, 0x55);
+		Jit_Byte(jit, 0x41);Jit_Byte(jit, 0x54);
+		Jit_Byte(jit, 0x41);Jit_Byte(jit, 0x55);
+		Jit_Byte(jit, 0x41);Jit_Byte(jit, 0x56);
+		Jit_Byte(jit, 0x41);Jit_Byte(jit, 0x57);
+		//sub $8,%rsp (keep the stack aligned for the helpers)
+		Jit_OpRR(jit, 0, 1, 0x83, 5, R_ESP);
+		Jit_Byte(jit, 8);
+		//mov %rsi,%r13
+		Jit_OpRR(jit, 0, 1, 0x89, R_ESI, R_R13);
+		//mov glob(%r13),%r12
+		Jit_OpRM(jit, 0, 1, 0x8b, R_R12, R_R13, -1, 0, offsetof(struct jitctx, glob));
+		//mov progfuncs(%r13),%r14
+		Jit_OpRM(jit, 0, 1, 0x8b, R_R14, R_R13, -1, 0, offsetof(struct jitctx, progfuncs));
+		//jmp *%rdi
+		Jit_Byte(jit, 0xff);Jit_Byte(jit, 0xe7);
+
+		//leavectx:
+		leavectxofs = jit->codesize;
+		//mov s(%r13),%eax
+		Jit_OpRM(jit, 0, 0, 0x8b, R_EAX, R_R13, -1, 0, offsetof(struct jitctx, s));
+		//leave:
+		jit->leaveofs = jit->codesize;
+		//add $8,%rsp
+		Jit_OpRR(jit, 0, 1, 0x83, 0, R_ESP);
+		Jit_Byte(jit, 8);
+		//pop %r15, %r14, %r13, %r12, %rbp, %rbx
+		Jit_Byte(jit, 0x41);Jit_Byte(jit, 0x5f);
+		Jit_Byte(jit, 0x41);Jit_Byte(jit, 0x5e);
+		Jit_Byte(jit, 0x41);Jit_Byte(jit, 0x5d);
+		Jit_Byte(jit, 0x41);Jit_Byte(jit, 0x5c);
+		Jit_Byte(jit, 0x5d);
+		Jit_Byte(jit, 0x5b);
+		//ret
+		Jit_Byte(jit, 0xc3);
+	}
+
+	for (i = 0; i < numstatements && !jit->failed; i++)
+	{
+		start = jit->codesize;
+		fixupcount = jit->numfixups;
+		jit->curstatement = i;
+		jit->bail = false;
+		jit->statementofs[i] = start;
+
+		if (!Jit_Statement(jit, &st[i], numstatements, globals) || jit->bail)
+		{	//forget anything it wrote, and let the interpreter deal with it
+			jit->codesize = start;
+			jit->numfixups = fixupcount;
+			Jit_Bail(jit, i);
+			bailed++;
+		}
+	}
+
+	//cold code for leaving the jit mid-statement, shared between each statement's fixups
+	for (i = 0; i < jit->numfixups && !jit->failed; i++)
+	{
+		struct jitfixup *fix = &jit->fixups[i];
+		if (fix->type == FIX_JUMP)
+			continue;
+		if (fix->statement != stubstatement || fix->type != stubtype)
+		{
+			stubstatement = fix->statement;
+			stubtype = fix->type;
+			stubofs = jit->codesize;
+			if (fix->type == FIX_RUNAWAY)
+			{	//let the interpreter's check fire instead
+				//movl $1,runaway(%r13)
+				Jit_OpRM(jit, 0, 0, 0xc7, 0, R_R13, -1, 0, offsetof(struct jitctx, runaway));
+				Jit_Int(jit, 1);
+			}
+			Jit_Bail(jit, fix->statement);
+		}
+		if (!jit->failed)
+		{
+			int rel = stubofs - (fix->codeofs+4);
+			memcpy(jit->code+fix->codeofs, &rel, 4);
+		}
+	}
+	for (i = 0; i < jit->numfixups && !jit->failed; i++)
+	{
+		struct jitfixup *fix = &jit->fixups[i];
+		int rel;
+		if (fix->type != FIX_JUMP)
+			continue;
+		rel = jit->statementofs[fix->statement] - (fix->codeofs+4);
+		memcpy(jit->code+fix->codeofs, &rel, 4);
+	}
+
+	if (!jit->failed)
+	{
+		jit->statementcode = malloc(sizeof(*jit->statementcode) * numstatements);
+		code = mmap(NULL, jit->codesize, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+		if (code == MAP_FAILED || !jit->statementcode)
+			jit->failed = true;
+		else
+		{
+			memcpy(code, jit->code, jit->codesize);
+			mprotect(code, jit->codesize, PROT_READ|PROT_EXEC);
+			for (i = 0; i < numstatements; i++)
+				jit->statementcode[i] = code + jit->statementofs[i];
+			jit->enter = (void*)code;
+			jit->leavectx = code + leavectxofs;
+		}
+	}
+
+	free(jit->code);
+	free(jit->statementofs);
+	free(jit->fixups);
+	jit->code = NULL;
+	jit->statementofs = NULL;
+	jit->fixups = NULL;
+	if (jit->failed)
+	{
+		externs->Printf("QCJIT: unable to generate code, using the interpreter.\n");
+		free(jit->statementcode);
+		free(jit);
+		return NULL;
+	}
+	jit->code = code;
+
+	externs->DPrintf("QCJIT: %u statements, %u left to the interpreter, %u bytes of code\n", numstatements, bailed, (unsigned int)jit->codesize);
+	return jit;
+}
+
+//returns the statement to continue interpreting from, or -1 if the function returned to the engine.
+int PR_EnterJIT(progfuncs_t *progfuncs, struct jitstate *jit, int statement, int *runaway)
+{
+	struct jitctx ctx;
+	if ((unsigned int)(statement+1) >= jit->numstatements)
+		return statement;
+
+	ctx.glob = current_progstate->globals;
+	ctx.progfuncs = progfuncs;
+	ctx.jit = jit;
+	ctx.num_edicts = externs->num_edicts;
+	ctx.s = statement;
+	ctx.runaway = *runaway;
+	statement = jit->enter(jit->statementcode[statement+1], &ctx);
+	*runaway = ctx.runaway;
+	return statement;
+}
+#endif
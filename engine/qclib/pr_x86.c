@@ -40,7 +40,7 @@ optimisations:
 #define PROGSUSED
 #include "progsint.h"
 
-#ifdef QCJIT
+#if defined(QCJIT) && (defined(_M_IX86) || defined(__i386__))	//see pr_x64.c for amd64
 
 #ifndef _WIN32
 #include <sys/mman.h>
@@ -1589,7 +1589,7 @@ static float foo(float arg)
 	return f;
 }
 
-void PR_EnterJIT(progfuncs_t *progfuncs, struct jitstate *jit, int statement)
+int PR_EnterJIT(progfuncs_t *progfuncs, struct jitstate *jit, int statement, int *runaway)
 {
 #ifdef __GNUC__
 	//call, it clobbers pretty much everything.
@@ -1607,5 +1607,6 @@ void PR_EnterJIT(progfuncs_t *progfuncs, struct jitstate *jit, int statement)
 #else
 	#error "Sorry, no idea how to enter assembler safely for your compiler"
 #endif
+	return -1;	//runs until the outermost function returns.
 }
 #endif
@@ -69,6 +69,11 @@ typedef unsigned char pbyte;
 	#endif
 #endif
 
+#if defined(__GNUC__) && !defined(FTE_TARGET_WEB) && !defined(SIMPLE_QCVM)
+	//32bit progs can be pretranslated for computed-goto dispatch (needs gcc's labels-as-values).
+	#define QCTHREADED
+#endif
+
 
 #ifdef _MSC_VER
 #pragma warning(disable : 4244)
@@ -385,9 +390,14 @@ typedef struct progstate_s
 
 	progstructtype_t structtype;	//specifies the sized struct types above. FIXME: should probably just load as 32bit or something.
 
+	pbool hasbreakpoints;	//breakpoints were set, so stick to the plain interpreter.
 #ifdef QCJIT
 	struct jitstate *jit;
 #endif
+#ifdef QCTHREADED
+	pbool usethreaded;			//use PR_ExecuteCode32Threaded when nothing is being debugged.
+	const void **threadedcode;	//[numstatements], generated on first use.
+#endif
 } progstate_t;
 
 //============================================================================
@@ -562,8 +572,12 @@ pbool CompileFile(progfuncs_t *progfuncs, const char *filename);
 
 struct jitstate;
 struct jitstate *PR_GenerateJit(progfuncs_t *progfuncs);
-void PR_EnterJIT(progfuncs_t *progfuncs, struct jitstate *jitstate, int statement);
+int PR_EnterJIT(progfuncs_t *progfuncs, struct jitstate *jitstate, int statement, int *runaway);
 void PR_CloseJit(struct jitstate *jit);
+#ifdef QCJIT
+int PR_JitEnterFunction (progfuncs_t *progfuncs, mfunction_t *f, int progsnum);
+int PR_JitLeaveFunction (progfuncs_t *progfuncs);
+#endif
 
 char *QCC_COM_Parse (const char *data);
 extern char	qcc_token[1024];
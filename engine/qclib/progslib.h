@@ -30,6 +30,8 @@
 	#if defined(__GNUC__) || defined(_MSC_VER)	//supported compilers (yay for inline asm)
 	//#define QCJIT
 	#endif
+#elif defined(__x86_64__) && defined(__GNUC__) && !defined(_WIN32) && !defined(NACL) && !defined(FTE_TARGET_WEB)
+	#define QCJIT	//pr_x64.c, sysv abi only
 #endif
 
 #define QCBUILTIN ASMCALL
@@ -273,6 +275,8 @@ typedef struct progexterns_s {
 	double *gametime;	//used to prevent the vm from reusing an entity faster than 2 secs.
 
 	pbool usethreadedgc;
+	pbool usejit;	//generate native code for progs as they're loaded, where supported.
+	pbool usethreadedcode;	//use computed-goto dispatch (with superinstructions) for 32bit progs instead of the plain switch, where supported.
 
 	struct edict_s **edicts;	//pointer to the engine's reference to world.
 	unsigned int *num_edicts;		//pointer to the engine's edict count.
@@ -779,6 +779,10 @@ void Q_SetProgsParms(qboolean forcompiler)
 #ifdef MULTITHREAD
 	svprogparms.usethreadedgc = pr_gc_threaded.ival;
 #endif
+#ifdef QCJIT
+	svprogparms.usejit = pr_jit.ival;
+	svprogparms.usethreadedcode = pr_threadedcode.ival;
+#endif
 
 	svprogparms.edicts = (edict_t**)&sv.world.edicts;
 	svprogparms.num_edicts = &sv.world.num_edicts;
@@ -11206,6 +11210,8 @@ static BuiltinList_t BuiltinList[] = {				//nq	qw		h2		ebfs
 #endif
 
 	{"tracebox",		PF_traceboxdp,		0,		0,		0,		90,	D("void(vector start, vector mins, vector maxs, vector end, float nomonsters, entity ent)", "Exactly like traceline, but a box instead of a uselessly thin point. Acceptable sizes are limited by bsp format, q1bsp has strict acceptable size values.")},
+	{"tracebox_list",	PF_tracebox_list,	0,		0,		0,		0,	D("typedef struct {\n\tvector start;\n\tvector end;\n\tfloat fraction;\n\tfloat allsolid;\n\tfloat startsolid;\n\tentity ent;\n\tvector endpos;\n\tvector plane_normal;\n\tfloat plane_dist;\n\tint contents;\n} traceray_t;\n"
+					"void(traceray_t *rays, int numrays, vector mins, vector maxs, float nomonsters, entity forent)", "Performs a tracebox from each ray's start to its end, writing the results back into the same struct instead of the trace_* globals. This is much faster than calling tracebox lots of times, for things like shotgun pellets or line-of-sight checks. Note that fraction is not forced to 1 when startsolid is set, regardless of sv_gameplayfix_honest_tracelines.")},
 
 	{"randomvec",		PF_randomvector,	0,		0,		0,		91,	D("vector()", "Returns a vector with random values. Each axis is independantly a value between -1 and 1 inclusive.")},
 	{"getlight",		PF_sv_getlight,		0,		0,		0,		92, "vector(vector org)"},// (DP_QC_GETLIGHT),
@@ -84,6 +84,8 @@ typedef struct edict_s
 #ifdef USEAREAGRID
 	areagridlink_t	gridareas[AREAGRIDPERENT];	//on overflow, use the inefficient overflow list.
 	size_t			gridareasequence;	//used to avoid iterrating the same ent twice.
+	struct areabvh_s *areabvh;		//the tree we're linked into when using the bvh instead of the grid.
+	int				areabvhleaf;
 #else
 	link_t	area;
 #endif
@@ -727,6 +727,7 @@ typedef struct client_s
 
 	size_t lastseen_count;
 	float *lastseen_time;	//timer for cullentities_trace, so we can get away with fewer traces per test
+	struct snapshotvis_s *snapvis;	//pvs/trace culling results precomputed by worker threads (sv_threadedsnapshots)
 
 #ifdef VM_Q1
 	int hideentity;
@@ -1144,6 +1145,7 @@ NORETURN void VARGS SV_Error (char *error, ...) LIKEPRINTF(1);
 void SV_Shutdown (void);
 float SV_Frame (void);
 void SV_ReadPacket(void);
+qboolean SV_ThreadedConnectionless (netadr_t *from, const qbyte *data, size_t length, void (*Reply)(void *ctx, netadr_t *to, const void *data, size_t length), void *ctx);
 void SV_FinalMessage (char *message);
 void SV_DropClient (client_t *drop);
 struct quakeparms_s;
@@ -1389,6 +1391,10 @@ void SV_GibFilterInit(void);
 void SV_GibFilterPurge(void);
 void SV_CleanupEnts(void);
 void SV_ProcessSendFlags(client_t *c);
+void SV_Snapshot_BuildVisibility(void);
+void SV_Snapshot_DiscardVisibility(client_t *client);
+void SV_Snapshot_FreeVisibility(client_t *client);
+void SV_Snapshot_FlushStateCache(void);
 
 void SV_AckEntityFrame(client_t *cl, int framenum);
 void SV_ReplaceEntityFrame(client_t *cl, int framenum);
@@ -1562,14 +1568,21 @@ typedef struct mvddest_s {
 	char filename[MAX_QPATH];	//demos/foo.mvd (or a username)
 	char simplename[MAX_QPATH];	//foo.mvd (or a qtv resource)
 
-	int flushing;	//worker has a cache (used as a sync point)
 	char *cache;
-	char *altcache;
 	int cacheused;
 	int maxcachesize;
 
 	unsigned int totalsize;
 
+	vfsfile_t *indexfile;	//optional .idx sidecar for seeking, see MVDINDEX_MAGIC.
+	unsigned int msecs;		//demo time written to this dest so far, as the client will count it.
+	double nextkeyframe;	//sv.time when the next keyframe should be written to the index.
+
+	qboolean keepfiles;		//a newer recording reused our filename while we were still closing, so a cancel mustn't delete anything.
+	qboolean closed;		//set by the writer thread once the file is closed. protected by its condition.
+	int closereason;		//mvdclosereason_e, for when it finishes closing.
+	struct mvddest_s *nextclosing;	//threaded dests that are waiting for the writer to close them.
+
 	struct mvddest_s *nextdest;
 } mvddest_t;
 void SV_MVDPings (void);
@@ -1590,8 +1603,10 @@ void SV_MVDStop (enum mvdclosereason_e reason, qboolean mvdonly);
 void SV_MVDStop_f (void);
 qboolean SV_MVDWritePackets (int num);
 void MVD_Init (void);
+void SV_MVD_Shutdown(void);
 void SV_MVD_RunPendingConnections(void);
 void SV_MVD_SendInitialGamestate(mvddest_t *dest);
+void SV_MVD_WriteKeyframes(void);
 
 extern demo_t			demo;				// server demo struct
 
@@ -3201,6 +3201,254 @@ void SV_MemInfo_f(void)
 		Con_Printf("ssqc: %u (used) / %u (reserved)\n", sv.world.progs->stringtablesize, sv.world.progs->stringtablemaxsize);
 }
 
+//runs whole server ticks back to back, returning the time taken.
+static double SV_ProgsBench_Run(int frames)
+{
+	double step = max(sv_maxtic.value, 0.001), t;
+	int i;
+
+	t = Sys_DoubleTime();
+	for (i = 0; i < frames; i++)
+	{
+		sv.time += step;
+		SV_Physics();
+	}
+	t = Sys_DoubleTime() - t;
+	sv.starttime -= frames*step/sv.gamespeed;	//don't leave the clock stalled until real time catches up
+	return t;
+}
+//compares the qc execution modes on the same progs and game state.
+static void SV_ProgsBench_f(void)
+{
+	int frames = (Cmd_Argc()>1)?atoi(Cmd_Argv(1)):1000;
+	pbool usejit = svprogparms.usejit;
+	pbool usethreaded = svprogparms.usethreadedcode;
+	double t;
+
+	if (sv.state != ss_active || !svprogfuncs)
+	{
+		Con_Printf("sv_progsbench: requires a running server\n");
+		return;
+	}
+	if (frames < 1)
+		frames = 1;
+
+	SV_ProgsBench_Run(frames/10+1);	//warm up, so any lazily generated stuff isn't counted
+
+	if (usejit)
+	{
+		t = SV_ProgsBench_Run(frames);
+		Con_Printf("jit: %i ticks, %.3f ms/tick\n", frames, t*1000/frames);
+	}
+	else
+		Con_Printf("jit: not generated (set pr_jit 1 and reload the map)\n");
+
+	svprogparms.usejit = false;
+	if (usethreaded)
+	{
+		t = SV_ProgsBench_Run(frames);
+		Con_Printf("threaded dispatch: %i ticks, %.3f ms/tick\n", frames, t*1000/frames);
+	}
+	else
+		Con_Printf("threaded dispatch: disabled (set pr_threadedcode 1 and reload the map)\n");
+
+	svprogparms.usethreadedcode = false;
+	t = SV_ProgsBench_Run(frames);
+	Con_Printf("switch interpreter: %i ticks, %.3f ms/tick\n", frames, t*1000/frames);
+	svprogparms.usejit = usejit;
+	svprogparms.usethreadedcode = usethreaded;
+}
+
+#ifdef USEAREAGRID
+//spawns groups of moving ents (like players and their projectiles in a busy game) and times relinking them each frame plus the box queries that their physics would do.
+static void SV_AreaBench_Clustered(world_t *w, const vec3_t bmins, const vec3_t bmaxs, int count, int frames)
+{
+	extern cvar_t sv_areabvh;
+	int numclusters = (count+15)/16;
+	vec3_t *centre = BZ_Malloc(sizeof(*centre)*numclusters*2), *drift = centre+numclusters;
+	vec3_t *offset = BZ_Malloc(sizeof(*offset)*count);
+	wedict_t **bench = BZ_Malloc(sizeof(*bench)*count);
+	wedict_t **list;
+	vec3_t mins, maxs;
+	int mode, f, i, j, c, found;
+	unsigned int seed;
+	double t, linktime, querytime;
+
+	for (i = 0; i < count; i++)
+	{
+		bench[i] = (wedict_t*)ED_Alloc(svprogfuncs, false, 0);
+		if (!bench[i])
+			break;
+		bench[i]->v->solid = SOLID_BBOX;
+		VectorSet(bench[i]->v->mins, -16, -16, -24);
+		VectorSet(bench[i]->v->maxs, 16, 16, 32);
+	}
+	count = i;
+	list = BZ_Malloc(sizeof(*list)*w->num_edicts);
+
+	for (mode = 0; mode < 2; mode++)
+	{
+		//same starting positions and movement for both
+		seed = 1;
+		for (c = 0; c < numclusters; c++)
+		{
+			for (j = 0; j < 3; j++)
+			{
+				seed = seed*1103515245+12345;
+				centre[c][j] = bmins[j] + (bmaxs[j]-bmins[j]) * ((seed>>8)&0xffff)/65535.0f;
+				seed = seed*1103515245+12345;
+				drift[c][j] = (((seed>>8)&0xffff)/65535.0f - 0.5) * 32;	//up to 320qu/s at 20fps
+			}
+		}
+		for (i = 0; i < count; i++)
+		{
+			for (j = 0; j < 3; j++)
+			{
+				seed = seed*1103515245+12345;
+				offset[i][j] = (((seed>>8)&0xffff)/65535.0f - 0.5) * 256;
+			}
+			VectorAdd(centre[i/16], offset[i], bench[i]->v->origin);
+		}
+
+		Cvar_SetValue(&sv_areabvh, mode);
+		World_ClearWorld(w, true);
+
+		found = 0;
+		linktime = querytime = 0;
+		for (f = 0; f < frames; f++)
+		{
+			t = Sys_DoubleTime();
+			for (c = 0; c < numclusters; c++)
+			{
+				for (j = 0; j < 3; j++)
+				{
+					centre[c][j] += drift[c][j];
+					if (centre[c][j] < bmins[j] || centre[c][j] > bmaxs[j])
+						drift[c][j] *= -1;
+				}
+			}
+			for (i = 0; i < count; i++)
+			{
+				for (j = 0; j < 3; j++)
+				{
+					seed = seed*1103515245+12345;
+					offset[i][j] += (((seed>>8)&0xffff)/65535.0f - 0.5) * 8;	//jostle around within the group
+				}
+				VectorAdd(centre[i/16], offset[i], bench[i]->v->origin);
+				VectorScale(drift[i/16], 20, bench[i]->v->velocity);
+				World_LinkEdict(w, bench[i], false);
+			}
+			linktime += Sys_DoubleTime() - t;
+
+			t = Sys_DoubleTime();
+			for (i = 0; i < count; i++)
+			{
+				for (j = 0; j < 3; j++)
+				{
+					mins[j] = bench[i]->v->absmin[j] - 64;
+					maxs[j] = bench[i]->v->absmax[j] + 64;
+				}
+				found += World_AreaEdicts(w, mins, maxs, list, w->num_edicts, AREA_SOLID);
+			}
+			querytime += Sys_DoubleTime() - t;
+		}
+		Con_Printf("%s: %i clustered ents, %i frames, %.2f us/frame relinking, %.2f us/frame querying, %i hits\n", mode?"bvh ":"grid", count, frames, linktime*1000000/frames, querytime*1000000/frames, found);
+	}
+
+	for (i = 0; i < count; i++)
+		ED_Free(svprogfuncs, (edict_t*)bench[i]);
+	BZ_Free(list);
+	BZ_Free(bench);
+	BZ_Free(offset);
+	BZ_Free(centre);
+}
+
+//times the same random box queries and traces against the area grid and then the bvh.
+static void SV_AreaBench_f(void)
+{
+	extern cvar_t sv_areabvh;
+	int queries = (Cmd_Argc()>1)?atoi(Cmd_Argv(1)):100000;
+	float boxsize = (Cmd_Argc()>2)?atof(Cmd_Argv(2)):256;
+	int clusterents = (Cmd_Argc()>3)?atoi(Cmd_Argv(3)):0;
+	world_t *w = &sv.world;
+	wedict_t **list, *ent;
+	vec3_t mins, maxs, bmins, bmaxs, start, end;
+	int oldbvh = sv_areabvh.ival;
+	int mode, i, j, found;
+	unsigned int seed;
+	double t, fracsum;
+	trace_t tr;
+
+	if (sv.state != ss_active || !w->progs || (svs.gametype != GT_PROGS && svs.gametype != GT_Q1QVM))
+	{
+		Con_Printf("sv_areabench: requires a running q1 server\n");
+		return;
+	}
+	if (queries < 1)
+		queries = 1;
+
+	//query within the space the entities actually occupy, not just the bsp
+	VectorCopy(w->worldmodel->mins, bmins);
+	VectorCopy(w->worldmodel->maxs, bmaxs);
+	for (i = 1; i < w->num_edicts; i++)
+	{
+		ent = WEDICT_NUM_PB(w->progs, i);
+		if (!ent || ED_ISFREE(ent))
+			continue;
+		AddPointToBounds(ent->v->absmin, bmins, bmaxs);
+		AddPointToBounds(ent->v->absmax, bmins, bmaxs);
+	}
+
+	list = BZ_Malloc(sizeof(*list)*w->num_edicts);
+	for (mode = 0; mode < 2; mode++)
+	{
+		Cvar_SetValue(&sv_areabvh, mode);
+		World_ClearWorld(w, true);
+
+		seed = 1;
+		found = 0;
+		t = Sys_DoubleTime();
+		for (i = 0; i < queries; i++)
+		{
+			for (j = 0; j < 3; j++)
+			{
+				seed = seed*1103515245+12345;
+				mins[j] = bmins[j] + (bmaxs[j]-bmins[j]) * ((seed>>8)&0xffff)/65535.0f;
+				maxs[j] = mins[j] + boxsize;
+			}
+			found += World_AreaEdicts(w, mins, maxs, list, w->num_edicts, AREA_SOLID);
+		}
+		t = Sys_DoubleTime() - t;
+		Con_Printf("%s: %i %g-unit box queries, %.2f us/query, %i hits\n", mode?"bvh ":"grid", queries, boxsize, t*1000000/queries, found);
+
+		seed = 1;
+		fracsum = 0;
+		t = Sys_DoubleTime();
+		for (i = 0; i < queries; i++)
+		{
+			for (j = 0; j < 3; j++)
+			{
+				seed = seed*1103515245+12345;
+				start[j] = bmins[j] + (bmaxs[j]-bmins[j]) * ((seed>>8)&0xffff)/65535.0f;
+				seed = seed*1103515245+12345;
+				end[j] = bmins[j] + (bmaxs[j]-bmins[j]) * ((seed>>8)&0xffff)/65535.0f;
+			}
+			tr = World_Move(w, start, vec3_origin, vec3_origin, end, MOVE_NORMAL, w->edicts);
+			fracsum += tr.fraction;
+		}
+		t = Sys_DoubleTime() - t;
+		Con_Printf("%s: %i traces, %.2f us/trace, fraction sum %g\n", mode?"bvh ":"grid", queries, t*1000000/queries, fracsum);
+	}
+	BZ_Free(list);
+
+	if (clusterents > 0)
+		SV_AreaBench_Clustered(w, bmins, bmaxs, clusterents, 200);
+
+	Cvar_SetValue(&sv_areabvh, oldbvh);
+	World_ClearWorld(w, true);
+}
+#endif
+
 void SV_Download_f (void)
 {	//command for dedicated servers. apparently.
 #ifdef WEBCLIENT
@@ -3351,6 +3599,10 @@ void SV_InitOperatorCommands (void)
 	Cmd_AddCommand ("pin_add", SV_Pin_Add_f);
 
 	Cmd_AddCommand("sv_meminfo", SV_MemInfo_f);
+	Cmd_AddCommandD("sv_progsbench", SV_ProgsBench_f, "Runs the given number of server ticks back to back with the qc jit, threaded dispatch and the plain switch interpreter, and reports the time per tick for each.");
+#ifdef USEAREAGRID
+	Cmd_AddCommandD("sv_areabench", SV_AreaBench_f, "Times random box queries and traces against the area grid and the bvh, using the entities on the current map.\nArgs: [queries] [boxsize] [clusteredents] - the last spawns that many temporary ents in moving groups of 16 and also times relinking them every frame.");
+#endif
 
 //	Cmd_AddCommand ("reallyevilhack", SV_ReallyEvilHack_f);
 }
@@ -26,6 +26,8 @@ extern cvar_t sv_nailhack;
 extern cvar_t sv_cullentities_trace;
 extern cvar_t sv_cullplayers_trace;
 extern cvar_t sv_nopvs;
+extern cvar_t sv_threadedsnapshots;
+extern cvar_t sv_snapshotcache;
 
 #define SV_PVS_CAMERAS 16
 typedef struct
@@ -38,6 +40,39 @@ typedef struct
 	pvsbuffer_t pvs;
 } pvscamera_t;
 
+//culling results for a single client, generated on a worker thread before the snapshot itself gets built.
+typedef struct snapshotvis_s
+{
+	unsigned int sequence;	//only valid when it matches snapshotvis_sequence
+	unsigned int numents;	//entities beyond this were spawned after the results were generated, and need to be tested normally.
+	size_t maxents;
+	qbyte *culled;			//bitmask. set if the entity failed its pvs or trace test.
+	unsigned int seed;		//for the trace culling's sample points, as rand() isn't safe on the workers.
+	pvscamera_t cameras;
+} snapshotvis_t;
+static unsigned int snapshotvis_sequence;
+static int snapshotvis_pending;
+static qbyte *snapshotvis_moved;	//bitmask of entities that moved after every client's results were generated, so need to be tested normally.
+static size_t snapshotvis_movedents;
+
+static snapshotvis_t *SV_Snapshot_GetVisibility(client_t *client)
+{
+	if (client->snapvis && client->snapvis->sequence == snapshotvis_sequence)
+		return client->snapvis;
+	return NULL;
+}
+//returns true if the worker's results for entity e can still be used.
+static qboolean SV_Snapshot_VisibilityValid(int visents, int e, edict_t *tracecullent)
+{
+	if (e >= visents)
+		return false;	//spawned after the results were generated.
+	if (e < snapshotvis_movedents && (snapshotvis_moved[e>>3] & (1<<(e&7))))
+		return false;
+	if (tracecullent && tracecullent->entnum < snapshotvis_movedents && (snapshotvis_moved[tracecullent->entnum>>3] & (1<<(tracecullent->entnum&7))))
+		return false;	//whatever its attached to moved.
+	return true;
+}
+
 static void *AllocateBoneSpace(packet_entities_t *pack, unsigned char bonecount, unsigned int *allocationpos)
 {
 	size_t space = bonecount * sizeof(short)*7;
@@ -2462,12 +2497,13 @@ void SV_WritePlayerToClient(sizebuf_t *msg, clstate_t *ent)
 #endif
 
 
-qboolean Cull_Traceline(float *timestamp, pvscamera_t *cameras, edict_t *seen)
+//seed is for callers that run on worker threads, where rand() can't be used. its updated as samples are taken.
+qboolean Cull_Traceline(float *timestamp, pvscamera_t *cameras, edict_t *seen, unsigned int *seed)
 {
 	int i;
 	trace_t tr;
 	vec3_t end, amin, size;
-	int c;
+	int c, k;
 
 	if (seen->v->solid == SOLID_BSP)
 		return false;	//bsp ents are never culled this way (typically far too large to care, often with large parts inside walls)
@@ -2492,9 +2528,20 @@ qboolean Cull_Traceline(float *timestamp, pvscamera_t *cameras, edict_t *seen)
 		{
 			for (i = 0; i < tests; i++)
 			{
-				end[0] = amin[0] + frandom()*size[0];
-				end[1] = amin[1] + frandom()*size[1];
-				end[2] = amin[2] + frandom()*size[2];
+				if (seed)
+				{
+					for (k = 0; k < 3; k++)
+					{
+						*seed = *seed*1103515245u + 12345u;
+						end[k] = amin[k] + (*seed>>8)*(1.0f/(1<<24))*size[k];
+					}
+				}
+				else
+				{
+					end[0] = amin[0] + frandom()*size[0];
+					end[1] = amin[1] + frandom()*size[1];
+					end[2] = amin[2] + frandom()*size[2];
+				}
 
 				if (!sv.world.worldmodel->funcs.NativeTrace (sv.world.worldmodel, 1, NULLFRAMESTATE, NULL, cameras->org[c], end, vec3_origin, vec3_origin, false, FTECONTENTS_SOLID, &tr))
 				{
@@ -2842,7 +2889,7 @@ void SV_WritePlayersToClient (client_t *client, client_frame_t *frame, edict_t *
 			if (!((int)clent->xv->dimension_see & ((int)ent->xv->dimension_seen | (int)ent->xv->dimension_ghost)))
 				continue;	//not in this dimension - sorry...
 			if (cameras && (sv_cullplayers_trace.value || sv_cullentities_trace.value))
-				if (Cull_Traceline(NULL, cameras, ent))
+				if (Cull_Traceline(NULL, cameras, ent, NULL))
 					continue;
 		}
 
@@ -3358,6 +3405,18 @@ static void SV_Snapshot_Build_Playback(client_t *client, packet_entities_t *pack
 }
 #endif
 
+static unsigned int SV_Snapshot_SolidSize(edict_t *ent, client_t *client)
+{
+	if (client && client->edict && (ent->v->owner == client->edict->entnum))
+		return 0;	//don't predict against your own missiles
+	else if (ent->v->solid == SOLID_BSP || (ent->v->skin < 0 && ent->v->modelindex))
+		return ES_SOLID_BSP;
+	else if (ent->v->solid == SOLID_BBOX || ent->v->solid == SOLID_SLIDEBOX || ent->v->skin < 0)
+		return ent->solidsize;
+	else
+		return 0;
+}
+
 void SV_Snapshot_BuildStateQ1(entity_state_t *state, edict_t *ent, client_t *client, packet_entities_t *pack)
 {
 //builds an entity_state from an entity
@@ -3430,14 +3489,7 @@ void SV_Snapshot_BuildStateQ1(entity_state_t *state, edict_t *ent, client_t *cli
 		}
 	}
 
-	if (client && client->edict && (ent->v->owner == client->edict->entnum))
-		state->solidsize = 0;
-	else if (ent->v->solid == SOLID_BSP || (ent->v->skin < 0 && ent->v->modelindex))
-		state->solidsize = ES_SOLID_BSP;
-	else if (ent->v->solid == SOLID_BBOX || ent->v->solid == SOLID_SLIDEBOX || ent->v->skin < 0)
-		state->solidsize = ent->solidsize;
-	else
-		state->solidsize = 0;
+	state->solidsize = SV_Snapshot_SolidSize(ent, client);
 
 	state->dpflags = 0;
 	if (ent->xv->viewmodelforclient)
@@ -3718,6 +3770,71 @@ void SV_Snapshot_BuildStateQ1(entity_state_t *state, edict_t *ent, client_t *cli
 #pragma warningmsg("TODO: Fix attachments for more vanilla clients")
 }
 
+/*
+=============
+SV_Snapshot_BuildStateCachedQ1
+
+Most entities look the same to every client that can see them, so there's no point converting them again for each client.
+The first client to see the entity each frame fills in the cache, and later clients copy it and fix up the few per-viewer fields.
+Entities whose state depends upon who is looking at them are always rebuilt.
+The cache is flushed at the start of each send phase (and whenever the edicts may have been changed mid-way through it).
+=============
+*/
+typedef struct
+{
+	unsigned int sequence;
+	int max_net_clients;	//colormaps are clamped to this
+	entity_state_t state;
+} snapshotstate_t;
+static snapshotstate_t *snapshotstates;
+static size_t snapshotstates_max;
+static unsigned int snapshotstate_sequence;
+
+void SV_Snapshot_FlushStateCache(void)
+{
+	snapshotstate_sequence++;
+}
+
+static void SV_Snapshot_BuildStateCachedQ1(entity_state_t *state, edict_t *ent, client_t *client, packet_entities_t *pack)
+{
+	snapshotstate_t *cached;
+	unsigned int e = ent->entnum;
+
+	if (!sv_snapshotcache.ival || !ISQWCLIENT(client) ||	//nq clients get per-client muzzleflashes.
+		e <= sv.allocated_client_slots ||	//players have lots of per-client prediction info
+		ent->xv->customizeentityforclient ||	//qc may change it between clients
+		ent->xv->exteriormodeltoclient || ent->xv->dimension_ghost || ((int)ent->v->flags & FL_CLASS_DEPENDENT) ||
+		(ent->xv->basebone < 0 && ent->xv->skeletonindex))	//bone data is stored in the pack
+	{
+		SV_Snapshot_BuildStateQ1(state, ent, client, pack);
+		return;
+	}
+
+	if (e >= snapshotstates_max)
+	{
+		size_t newmax = sv.world.max_edicts;
+		if (newmax <= e)
+			newmax = e+1;
+		snapshotstates = BZ_Realloc(snapshotstates, sizeof(*snapshotstates)*newmax);
+		memset(snapshotstates+snapshotstates_max, 0, sizeof(*snapshotstates)*(newmax-snapshotstates_max));
+		snapshotstates_max = newmax;
+	}
+	cached = &snapshotstates[e];
+
+	if (cached->sequence == snapshotstate_sequence && cached->max_net_clients == client->max_net_clients)
+	{
+		*state = cached->state;
+		state->solidsize = SV_Snapshot_SolidSize(ent, client);
+	}
+	else
+	{
+		SV_Snapshot_BuildStateQ1(state, ent, client, pack);
+		cached->sequence = snapshotstate_sequence;
+		cached->max_net_clients = client->max_net_clients;
+		cached->state = *state;
+	}
+}
+
 void SV_Snapshot_BuildQ1(client_t *client, packet_entities_t *pack, pvscamera_t *cameras, edict_t *clent)
 {
 //pvs and clent can be null, but only if the other is also null
@@ -3735,6 +3852,8 @@ void SV_Snapshot_BuildQ1(client_t *client, packet_entities_t *pack, pvscamera_t
 	int limit;
 	int c, maxc = cameras?cameras->numents:0;
 	client_t *seat;
+	snapshotvis_t *vis = cameras?SV_Snapshot_GetVisibility(client):NULL;
+	int visents = vis?vis->numents:0;
 
 	limit = sv.world.num_edicts;
 	if (client->max_net_ents < limit)
@@ -3891,12 +4010,23 @@ void SV_Snapshot_BuildQ1(client_t *client, packet_entities_t *pack, pvscamera_t
 								continue;
 							tracecullent = NULL;	//don't tracecull
 						}
+						else if (SV_Snapshot_VisibilityValid(visents, e, tracecullent))
+						{
+							if (vis->culled[e>>3] & (1<<(e&7)))
+								continue;
+						}
 						else
 						{
 							if (!sv.world.worldmodel->funcs.EdictInFatPVS(sv.world.worldmodel, &((wedict_t*)tracecullent)->pvsinfo, cameras->pvs.buffer, cameras->area))
 								continue;
 						}
 					}
+					else if (SV_Snapshot_VisibilityValid(visents, e, NULL))
+					{
+						if (vis->culled[e>>3] & (1<<(e&7)))
+							continue;
+						tracecullent = ent;
+					}
 					else
 					{
 						if (!sv.world.worldmodel->funcs.EdictInFatPVS(sv.world.worldmodel, &((wedict_t*)ent)->pvsinfo, cameras->pvs.buffer, cameras->area))
@@ -3972,11 +4102,11 @@ void SV_Snapshot_BuildQ1(client_t *client, packet_entities_t *pack, pvscamera_t
 					continue;
 
 
-		if (cameras && tracecullent && !((unsigned int)ent->v->effects & (EF_DIMLIGHT|EF_BLUE|EF_RED|EF_BRIGHTLIGHT|EF_BRIGHTFIELD|EF_NODEPTHTEST)))
-		{	//more expensive culling
+		if (cameras && tracecullent && !SV_Snapshot_VisibilityValid(visents, e, tracecullent) && !((unsigned int)ent->v->effects & (EF_DIMLIGHT|EF_BLUE|EF_RED|EF_BRIGHTLIGHT|EF_BRIGHTFIELD|EF_NODEPTHTEST)))
+		{	//more expensive culling (already done by a worker if we have visibility info)
 			if (!(pvsflags & PVSF_MODE_MASK))
 				if ((e <= sv.allocated_client_slots && sv_cullplayers_trace.value) || sv_cullentities_trace.value)
-					if (Cull_Traceline(e < client->lastseen_count?&client->lastseen_time[e]:NULL, cameras, tracecullent))
+					if (Cull_Traceline(e < client->lastseen_count?&client->lastseen_time[e]:NULL, cameras, tracecullent, NULL))
 						continue;
 		}
 
@@ -4056,7 +4186,7 @@ void SV_Snapshot_BuildQ1(client_t *client, packet_entities_t *pack, pvscamera_t
 		}
 
 		//its not a nail or anything, pack it up and ship it on
-		SV_Snapshot_BuildStateQ1(state, ent, client, pack);
+		SV_Snapshot_BuildStateCachedQ1(state, ent, client, pack);
 	}
 }
 
@@ -4127,6 +4257,165 @@ void SV_Snapshot_SetupPVS(client_t *client, pvscamera_t *camera)
 		SV_AddCameraEntity(camera, NULL, sv.skyroom_pos);
 }
 
+/*
+=============
+SV_Snapshot_BuildVisibility
+
+When sv_threadedsnapshots is set, this runs each client's pvs and trace culling
+tests on the worker threads, before any of the snapshots are actually built.
+Edicts are read-only while this happens. Anything that needs the qcvm
+(customizeentityforclient), the shared nail/csqc lists or the client's netchan
+still happens on the main thread, inside SV_Snapshot_BuildQ1 and the emit functions.
+=============
+*/
+static void SV_Snapshot_VisibilityDone(void *ctx, void *data, size_t a, size_t b)
+{
+	snapshotvis_pending--;
+}
+static void SV_Snapshot_VisibilityWorker(void *ctx, void *data, size_t a, size_t b)
+{
+	client_t *client = ctx;
+	snapshotvis_t *vis = data;
+	pvscamera_t *cameras = &vis->cameras;
+	model_t *wm = sv.world.worldmodel;
+	edict_t *clent = client->edict;
+	edict_t *ent, *tracecullent;
+	unsigned int e;
+	int c, pvsflags;
+	qboolean culled;
+
+	for (e = 1; e < vis->numents; e++)
+	{
+		ent = EDICT_NUM_PB(svprogfuncs, e);
+		if (ED_ISFREE(ent))
+			continue;
+
+		//these cases are never culled (or are handled by the main thread), keep this in sync with SV_Snapshot_BuildQ1.
+		for (c = 0; c < cameras->numents; c++)
+		{
+			if (ent == cameras->ent[c])
+				break;
+		}
+		if (c < cameras->numents)
+			continue;
+		if (ent->xv->viewmodelforclient)
+			continue;
+		if ((int)ent->v->effects & EF_NODEPTHTEST)
+			continue;
+		pvsflags = ent->xv->pvsflags;
+		if ((pvsflags & PVSF_MODE_MASK) >= PVSF_USEPHS)
+			continue;
+
+		tracecullent = ent;
+		if (ent->xv->tag_entity)
+		{
+			c = 10;
+			while(tracecullent->xv->tag_entity&&c-->0)
+				tracecullent = EDICT_NUM_UB(svprogfuncs, tracecullent->xv->tag_entity);
+			if (tracecullent == clent || tracecullent->xv->viewmodelforclient)
+				continue;
+		}
+
+		culled = !wm->funcs.EdictInFatPVS(wm, &((wedict_t*)tracecullent)->pvsinfo, cameras->pvs.buffer, cameras->area);
+		if (!culled && !((unsigned int)ent->v->effects & (EF_DIMLIGHT|EF_BLUE|EF_RED|EF_BRIGHTLIGHT|EF_BRIGHTFIELD)))
+		{
+			if (!(pvsflags & PVSF_MODE_MASK))
+				if ((e <= sv.allocated_client_slots && sv_cullplayers_trace.value) || sv_cullentities_trace.value)
+					culled = Cull_Traceline(e < client->lastseen_count?&client->lastseen_time[e]:NULL, cameras, tracecullent, &vis->seed);
+		}
+		if (culled)
+			vis->culled[e>>3] |= 1<<(e&7);
+	}
+
+	COM_AddWork(WG_MAIN, SV_Snapshot_VisibilityDone, NULL, NULL, 0, 0);
+}
+void SV_Snapshot_BuildVisibility(void)
+{
+	int i;
+	client_t *client;
+	snapshotvis_t *vis;
+	unsigned int limit;
+
+	//invalidate anything left over from the last frame.
+	snapshotvis_sequence++;
+	if (snapshotvis_moved)
+		memset(snapshotvis_moved, 0, (snapshotvis_movedents+7)>>3);
+
+	if (!sv_threadedsnapshots.ival || sv_nopvs.ival || svs.gametype != GT_PROGS || !sv.world.worldmodel)
+		return;
+	if (sv.world.worldmodel->fromgame != fg_quake && sv.world.worldmodel->fromgame != fg_halflife)
+		return;	//q2/q3 bsp traces use globals and are not safe to run on multiple threads.
+#ifdef SERVER_DEMO_PLAYBACK
+	if (sv.demostatevalid)
+		return;
+#endif
+
+	for (i = 0, client = svs.clients; i < svs.allocated_client_slots; i++, client++)
+	{
+		if (client->state != cs_spawned || client->controller || !client->edict || (client->penalties & BAN_BLIND))
+			continue;
+		if (!ISQWCLIENT(client) && !ISNQCLIENT(client))
+			continue;
+		if (ISQWCLIENT(client) && !client->send_message)
+			continue;	//not going to get a packet this frame. nq clients decide that later, so always do them.
+
+		limit = min(sv.world.num_edicts, client->max_net_ents);
+
+		vis = client->snapvis;
+		if (!vis)
+			vis = client->snapvis = Z_Malloc(sizeof(*vis));
+		if (vis->maxents < limit)
+		{
+			vis->maxents = limit;
+			vis->culled = BZ_Realloc(vis->culled, (vis->maxents+7)>>3);
+		}
+		memset(vis->culled, 0, (limit+7)>>3);
+		vis->numents = limit;
+
+		//anything that needs to be reallocated must be done before the worker gets it.
+		if (sv_cullentities_trace.ival && client->lastseen_count < limit)
+			Z_ReallocElements((void**)&client->lastseen_time, &client->lastseen_count, limit, sizeof(client->lastseen_time));
+		SV_Snapshot_SetupPVS(client, &vis->cameras);
+
+		vis->sequence = snapshotvis_sequence;
+		vis->seed = snapshotvis_sequence*2654435761u + i;	//deterministic, but different for each client and frame.
+		snapshotvis_pending++;
+		COM_AddWork(WG_LOADER, SV_Snapshot_VisibilityWorker, client, vis, 0, 0);
+	}
+
+	//edicts may not change until every worker is done with them.
+	while (snapshotvis_pending)
+		COM_WorkerPartialSync(NULL, &snapshotvis_pending, snapshotvis_pending);
+}
+//the client moved after the visibility was generated.
+//its own results are from the wrong place, and every other client's results for its entity are stale too, so fall back to testing those normally.
+void SV_Snapshot_DiscardVisibility(client_t *client)
+{
+	unsigned int e;
+	if (client->snapvis)
+		client->snapvis->sequence = 0;
+	if (!client->edict)
+		return;
+	e = client->edict->entnum;
+	if (e >= snapshotvis_movedents)
+	{
+		snapshotvis_moved = BZ_Realloc(snapshotvis_moved, (sv.world.max_edicts+7)>>3);
+		memset(snapshotvis_moved + ((snapshotvis_movedents+7)>>3), 0, ((sv.world.max_edicts+7)>>3) - ((snapshotvis_movedents+7)>>3));
+		snapshotvis_movedents = sv.world.max_edicts;
+	}
+	snapshotvis_moved[e>>3] |= 1<<(e&7);
+}
+void SV_Snapshot_FreeVisibility(client_t *client)
+{
+	snapshotvis_t *vis = client->snapvis;
+	if (!vis)
+		return;
+	client->snapvis = NULL;
+	BZ_Free(vis->culled);
+	BZ_Free(vis->cameras.pvs.buffer);
+	Z_Free(vis);
+}
+
 void SV_Snapshot_Clear(packet_entities_t *pack)
 {
 	pack->num_entities = 0;
@@ -4170,7 +4459,7 @@ void SV_WriteEntitiesToClient (client_t *client, sizebuf_t *msg, qboolean ignore
 	client_frame_t	*frame;
 	pvscamera_t camerasbuf;
 	pvscamera_t *cameras = &camerasbuf;
-	cameras->pvs.buffer = alloca(cameras->pvs.buffersize=sv.world.worldmodel->pvsbytes);
+	snapshotvis_t *vis;
 
 	// this is the frame we are creating
 	frame = &client->frameunion.frames[client->netchan.incoming_sequence & UPDATE_MASK];
@@ -4188,12 +4477,20 @@ void SV_WriteEntitiesToClient (client_t *client, sizebuf_t *msg, qboolean ignore
 		clent = client->edict;
 		if (sv_nopvs.ival)
 			cameras = NULL;
+		else if ((vis = SV_Snapshot_GetVisibility(client)))
+			cameras = &vis->cameras;	//already set up by SV_Snapshot_BuildVisibility
 #ifdef HLSERVER
 		else if (svs.gametype == GT_HALFLIFE)
+		{
+			cameras->pvs.buffer = alloca(cameras->pvs.buffersize=sv.world.worldmodel->pvsbytes);
 			SVHL_Snapshot_SetupPVS(client, cameras->pvs, sizeof(cameras->pvs));
+		}
 #endif
-		else 
+		else
+		{
+			cameras->pvs.buffer = alloca(cameras->pvs.buffersize=sv.world.worldmodel->pvsbytes);
 			SV_Snapshot_SetupPVS(client, cameras);
+		}
 	}
 
 	host_client = client;
@@ -595,11 +595,11 @@ unsigned SV_CheckModel(char *mdl)
 	qbyte *buf;
 	unsigned short crc;
 
-	buf = (qbyte *)FS_LoadMallocFile (mdl, &fsize);
+	buf = (qbyte *)FS_LoadMappedFile (mdl, &fsize, false);
 	if (!buf)
 		return 0;
 	crc = CalcHashInt(&hash_crc16, buf, fsize);
-	BZ_Free(buf);
+	FS_FreeFile(buf);
 	return crc;
 }
 
@@ -656,6 +656,7 @@ void SV_UnspawnServer (void)	//terminate the running server.
 		svs.clients[i].frameunion.frames = NULL;
 		svs.clients[i].pendingdeltabits = NULL;
 		svs.clients[i].pendingcsqcbits = NULL;
+		SV_Snapshot_FreeVisibility(&svs.clients[i]);
 		svs.clients[i].state = 0;
 		*svs.clients[i].namebuf = '\0';
 		svs.clients[i].name = NULL;
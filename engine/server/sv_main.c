@@ -152,6 +152,8 @@ cvar_t sv_calcphs			= CVARFD("sv_calcphs", "2", CVAR_MAPLATCH, "Enables culling
 cvar_t sv_showconnectionlessmessages	= CVARD("sv_showconnectionlessmessages", "0", "Display a line describing each connectionless message that arrives on the server. Primarily a debugging feature, but also potentially useful to admins.");
 cvar_t sv_cullplayers_trace		= CVARFD("sv_cullplayers_trace", "", CVAR_SERVERINFO, "Attempt to cull player entities using tracelines as an anti-wallhack.");
 cvar_t sv_cullentities_trace	= CVARFD("sv_cullentities_trace", "", CVAR_SERVERINFO, "Attempt to cull non-player entities using tracelines as an extreeme anti-wallhack.");
+cvar_t sv_threadedsnapshots		= CVARD("sv_threadedsnapshots", "0", "Run each client's entity pvs and trace culling on worker threads before any packets are built. Entities are treated as frozen for the duration of the send phase, so QC that moves entities from within customizeentityforclient may be culled against their old positions. Requires worker threads and a q1/hl bsp.");
+cvar_t sv_snapshotcache			= CVARD("sv_snapshotcache", "1", "Share converted entity states between all clients that can see an entity within a single frame, instead of regenerating them for each client. Entities using customizeentityforclient are never shared.");
 cvar_t sv_phs					= CVARD("sv_phs", "1", "If 1, do not use the phs. It is generally better to use sv_calcphs instead, and leave this as 1.");
 cvar_t sv_resetparms			= CVAR("sv_resetparms", "0");
 cvar_t sv_pupglow				= CVARFD("sv_pupglow", "", CVAR_SERVERINFO, "Instructs clients to enable hexen2-style powerup pulsing.");
@@ -250,6 +252,7 @@ void SV_Shutdown (void)
 #ifdef MVD_RECORDING
 	if (sv.mvdrecording)
 		SV_MVDStop (MVD_CLOSE_STOPPED, false);
+	SV_MVD_Shutdown();	//make sure they're fully written
 #endif
 
 	if (svs.entstatebuffer.entities)
@@ -688,6 +691,7 @@ void SV_DropClient (client_t *drop)
 
 	drop->pendingdeltabits = NULL;
 	drop->pendingcsqcbits = NULL;
+	SV_Snapshot_FreeVisibility(drop);
 	if (drop->frameunion.frames)	//union of the same sort of structure
 	{
 		Z_Free(drop->frameunion.frames);
@@ -1123,62 +1127,177 @@ char *SV_PlayerPublicAddress(client_t *cl)
 #define STATUS_QTVLIST					32 //qtv destid "name" "streamid@host:port" numviewers
 
 /*
-================
-SVC_Status
-
-Responds with all the info that qplug or qspy can see
-This message can be up to around 5k with worst case string lengths.
-================
+status and info responses are generated from a snapshot of the server's state.
+with net_querythreads, the net code's query threads answer from the same snapshot (so they never touch anything the game is using).
 */
-static void SVC_Status (void)
+typedef struct
 {
-	int displayflags;
-	int		i;
-	client_t	*cl;
-	char *name;
-	int		ping;
-	int		top, bottom;
-	char frags[64];
-	char *skin, *team, *botpre, *specpre;
+	int userid;
+	int frags;
+	int minutes;
+	int ping;
+	int top, bottom;
+	qboolean spectator;
+	qboolean bot;
+	char name[32];
+	char dpteam[32];	//cl->team, for getstatus
+	char skin[64];
+	char team[64];		//userinfo's, for status
+} svcqueryplayer_t;
+static struct
+{
+	double time;		//Sys_DoubleTime() when it was last refreshed
+	qboolean wanted;	//set by query threads, so we keep it fresh for them
+	qboolean public;	//sv_public >= 0
+	qboolean infoenabled;	//whether to respond to getinfo/getstatus
+	qboolean showmessages;
+	char statusinfo[1024];	//FIXME: vanilla limit is 512. we should probably have a list of known cvars for lower priority sending.
+	char getinfo[MAX_UDP_PACKET];	//everything except the challenge
+	char qtvlist[1024];
+	int numplayers;
+	svcqueryplayer_t player[MAX_CLIENTS];
+} svc_query;
+#ifdef HAVE_REUSEPORT
+static void *svc_querymutex;	//protects svc_query and the info throttling, which are shared with query threads.
+#define SVC_LockQueries()	do {if (svc_querymutex) Sys_LockMutex(svc_querymutex);} while(0)
+#define SVC_UnlockQueries()	do {if (svc_querymutex) Sys_UnlockMutex(svc_querymutex);} while(0)
+#else
+#define SVC_LockQueries()
+#define SVC_UnlockQueries()
+#endif
 
-	int slots=0;
+//must be called with the lock held.
+static void SVC_RefreshQueries (void)
+{
+	int i;
+	client_t *cl;
+	svcqueryplayer_t *p;
+	char *resp = svc_query.getinfo;
+	size_t respsize = sizeof(svc_query.getinfo);
+	char protocolname[MAX_QPATH];
+	const char *gamestatus;
+	int numclients = 0;
+	eval_t *v;
 
-	displayflags = atoi(Cmd_Argv(1));
-	if (displayflags == STATUS_OLDSTYLE)
-		displayflags = STATUS_SERVERINFO|STATUS_PLAYERS;
+	svc_query.time = Sys_DoubleTime();
+	svc_query.wanted = false;
+	svc_query.public = sv_public.ival >= 0;
+	svc_query.showmessages = !!sv_showconnectionlessmessages.ival;
+#ifdef NQPROT
+	svc_query.infoenabled = sv_listen_nq.ival || sv_listen_dp.ival;
+#else
+	svc_query.infoenabled = true;
+#endif
 
-	Cmd_TokenizeString ("status", false, false);
-	SV_BeginRedirect (RD_PACKET, TL_FindLanguage(""));
-	if (displayflags&STATUS_SERVERINFO)
 	{
-		char infostr[1024];	//FIXME: vanilla limit is 512. we should probably have a list of known cvars for lower priority sending.
 		const char *ignorekeys[] = {"mapname", "*z_ext", NULL};	//ignore some pointless stuff
 		const char *prioritykeys[] = {"hostname", "admin", "*gamedir", "*version", "deathmatch", "timelimit", "fraglimit", "maxclients", "maxspectators", "status", NULL}; //make sure we include these before we start overflowing
-		InfoBuf_ToString(&svs.info, infostr, sizeof(infostr), prioritykeys, ignorekeys, NULL, NULL, NULL);
-		Con_Printf ("%s\n", infostr);
+		InfoBuf_ToString(&svs.info, svc_query.statusinfo, sizeof(svc_query.statusinfo), prioritykeys, ignorekeys, NULL, NULL, NULL);
 	}
-	for (i=0 ; i<svs.allocated_client_slots ; i++)
+
+	svc_query.numplayers = 0;
+	for (i=0 ; i<svs.allocated_client_slots && svc_query.numplayers < countof(svc_query.player) ; i++)
 	{
 		cl = &svs.clients[i];
-		if ((cl->state == cs_connected || cl->state == cs_spawned || cl->name[0]) && ((cl->spectator && displayflags&STATUS_SPECTATORS) || (!cl->spectator && displayflags&STATUS_PLAYERS)))
+		if (!(cl->state == cs_connected || cl->state == cs_spawned || cl->name[0]))
+			continue;
+		p = &svc_query.player[svc_query.numplayers++];
+
+		p->userid = cl->userid;
+		p->frags = cl->old_frags;
+		p->minutes = (int)(realtime - cl->connection_started)/60;
+		p->ping = SV_CalcPing (cl, false);
+		p->top = atoi(InfoBuf_ValueForKey (&cl->userinfo, "topcolor"));
+		p->bottom = atoi(InfoBuf_ValueForKey (&cl->userinfo, "bottomcolor"));
+		p->top = (p->top < 0) ? 0 : ((p->top > 13) ? 13 : p->top);
+		p->bottom = (p->bottom < 0) ? 0 : ((p->bottom > 13) ? 13 : p->bottom);
+		p->spectator = cl->spectator;
+		p->bot = (!cl->state || cl->protocol == SCP_BAD);	//show bots differently. Just to be courteous.
+		Q_strncpyz(p->name, cl->name, sizeof(p->name));
+		Q_strncpyz(p->dpteam, cl->team, sizeof(p->dpteam));
+		Q_strncpyz(p->skin, InfoBuf_ValueForKey (&cl->userinfo, "skin"), sizeof(p->skin));
+		Q_strncpyz(p->team, InfoBuf_ValueForKey (&cl->userinfo, "team"), sizeof(p->team));
+
+		if (!cl->spectator)
+			numclients++;
+	}
+
+	*svc_query.qtvlist = 0;
+#ifdef MVD_RECORDING
+	{
+		struct mvddest_s *d;
+		for (d = demo.dest; d; d = d->nextdest)
 		{
-			top = atoi(InfoBuf_ValueForKey (&cl->userinfo, "topcolor"));
-			bottom = atoi(InfoBuf_ValueForKey (&cl->userinfo, "bottomcolor"));
-			top = (top < 0) ? 0 : ((top > 13) ? 13 : top);
-			bottom = (bottom < 0) ? 0 : ((bottom > 13) ? 13 : bottom);
-			ping = SV_CalcPing (cl, false);
-			name = cl->name;
+			if (d->desttype == DEST_STREAM)
+				Q_strncatz(svc_query.qtvlist, va("qtv %d \"%s\" \"%s\" %d\n", d->id, d->simplename, d->filename, 0/*d->viewercount*/), sizeof(svc_query.qtvlist));
+		}
+	}
+#endif
 
-			skin = InfoBuf_ValueForKey (&cl->userinfo, "skin");
-			team = InfoBuf_ValueForKey (&cl->userinfo, "team");
+	//dpmaster's serverinfo, minus the challenge (which comes first, and differs per request)
+	if (svprogfuncs)
+	{
+		v = PR_FindGlobal(svprogfuncs, "worldstatus", PR_ANY, NULL);
+		if (v)
+			gamestatus = PR_GetString(svprogfuncs, v->string);
+		else
+			gamestatus = "";
+	}
+	else
+		gamestatus = "";
 
-			if (!cl->state || cl->protocol == SCP_BAD)	//show bots differently. Just to be courteous.
-				botpre = "BOT:";
-			else
-				botpre = "";
+	COM_ParseOut(com_protocolname.string, protocolname, sizeof(protocolname));	//we can only report one, so report the first.
+	{
+		const char *ignorekeys[] = {
+			"maxclients", "map", "*gamedir", "*z_ext",	//this is a DP protocol query, so some QW fields are not needed
+			"gamename", "modname", "protocol", "clients", "sv_maxclients", "mapname", "qcstatus", "challenge", NULL};	//and we need to add some
+		const char *prioritykeys[] = {"hostname", NULL}; //make sure we include these before we start overflowing
+
+		*resp = 0;
+		Info_SetValueForKey(resp, "gamename", protocolname, respsize - (resp-svc_query.getinfo));//distinguishes it from other types of games
+		Info_SetValueForKey(resp, "protocol", com_protocolversion.string, respsize - (resp-svc_query.getinfo));	//should be an int.
+		Info_SetValueForKey(resp, "modname", FS_GetGamedir(true), respsize - (resp-svc_query.getinfo));
+		Info_SetValueForKey(resp, "clients", va("%d", numclients), respsize - (resp-svc_query.getinfo));
+		Info_SetValueForKey(resp, "sv_maxclients", maxclients.string, respsize - (resp-svc_query.getinfo));
+		Info_SetValueForKey(resp, "mapname", InfoBuf_ValueForKey(&svs.info, "map"), respsize - (resp-svc_query.getinfo));
+		resp += strlen(resp);
+		//now include the full/regular serverinfo
+		resp += InfoBuf_ToString(&svs.info, resp, respsize - (resp-svc_query.getinfo), prioritykeys, ignorekeys, NULL, NULL, NULL);
+		*resp = 0;
+		//and any possibly-long qc status string
+		if (*gamestatus)
+			Info_SetValueForKey(resp, "qcstatus", gamestatus, respsize - (resp-svc_query.getinfo));
+	}
+}
+
+//generates the lines of a status response from the snapshot. must be called with the lock held.
+static void SVC_StatusResponse (int displayflags, void (*Print)(void *ctx, const char *line), void *ctx)
+{
+	int		i;
+	svcqueryplayer_t	*p;
+	int		ping;
+	char frags[64];
+	char line[512];
+	char *botpre, *specpre;
+
+	if (displayflags == STATUS_OLDSTYLE)
+		displayflags = STATUS_SERVERINFO|STATUS_PLAYERS;
+
+	if (displayflags&STATUS_SERVERINFO)
+	{
+		Q_snprintfz(line, sizeof(line), "%s\n", svc_query.statusinfo);
+		Print(ctx, line);
+	}
+	for (i=0 ; i<svc_query.numplayers ; i++)
+	{
+		p = &svc_query.player[i];
+		if ((p->spectator && displayflags&STATUS_SPECTATORS) || (!p->spectator && displayflags&STATUS_PLAYERS))
+		{
+			ping = p->ping;
+			botpre = p->bot?"BOT:":"";
 
 			specpre = "";
-			if (cl->spectator)
+			if (p->spectator)
 			{	//silly mvdsv stuff
 				if (displayflags & STATUS_SPECTATORS_AS_PLAYERS)
 				{
@@ -1193,77 +1312,33 @@ static void SVC_Status (void)
 				}
 			}
 			else
-				sprintf(frags, "%i", cl->old_frags);
+				sprintf(frags, "%i", p->frags);
 
 			if (displayflags & STATUS_SHOWTEAMS)
 			{
-				Con_Printf ("%i %s %i %i \"%s%s%s\" \"%s\" %i %i \"%s\"\n", cl->userid,
-					frags, (int)(realtime - cl->connection_started)/60,
-					ping, specpre, botpre, name, skin, top, bottom, team);
+				Q_snprintfz (line, sizeof(line), "%i %s %i %i \"%s%s%s\" \"%s\" %i %i \"%s\"\n", p->userid,
+					frags, p->minutes,
+					ping, specpre, botpre, p->name, p->skin, p->top, p->bottom, p->team);
 			}
 			else
 			{
-				Con_Printf ("%i %s %i %i \"%s%s%s\" \"%s\" %i %i\n", cl->userid,
-					frags, (int)(realtime - cl->connection_started)/60,
-					ping, specpre, botpre, name, skin, top, bottom);
+				Q_snprintfz (line, sizeof(line), "%i %s %i %i \"%s%s%s\" \"%s\" %i %i\n", p->userid,
+					frags, p->minutes,
+					ping, specpre, botpre, p->name, p->skin, p->top, p->bottom);
 			}
+			Print(ctx, line);
 		}
-		else
-			slots++;
 	}
-#ifdef MVD_RECORDING
-	if (displayflags & STATUS_QTVLIST)
-	{
-		struct mvddest_s *d;
-		for (d = demo.dest; d; d = d->nextdest)
-		{
-			if (d->desttype == DEST_STREAM)
-				Con_Printf("qtv %d \"%s\" \"%s\" %d\n", d->id, d->simplename, d->filename, 0/*d->viewercount*/);
-		}
-	}
-#endif
-
-	SV_EndRedirect ();
+	if ((displayflags & STATUS_QTVLIST) && *svc_query.qtvlist)
+		Print(ctx, svc_query.qtvlist);
 }
 
-#if 1//def NQPROT
-static void SVC_GetInfo (const char *challenge, int fullstatus)
+//generates a dpmaster info/status response packet from the snapshot. must be called with the lock held.
+static size_t SVC_InfoResponse (char *response, size_t responsesize, const char *challenge, int fullstatus)
 {
-	//dpmaster support
-	char response[MAX_UDP_PACKET];
-	char protocolname[MAX_QPATH];
-
-	client_t	*cl;
-	int numclients = 0;
 	int i;
 	char *resp;
-	const char *gamestatus;
-	eval_t *v;
-
-#ifdef NQPROT
-	if (!sv_listen_nq.ival && !sv_listen_dp.ival)
-		return;
-#endif
-
-	for (i=0 ; i<svs.allocated_client_slots ; i++)
-	{
-		cl = &svs.clients[i];
-		if ((cl->state == cs_connected || cl->state == cs_spawned || cl->name[0]) && !cl->spectator)
-			numclients++;
-	}
-
-	if (svprogfuncs)
-	{
-		v = PR_FindGlobal(svprogfuncs, "worldstatus", PR_ANY, NULL);
-		if (v)
-			gamestatus = PR_GetString(svprogfuncs, v->string);
-		else
-			gamestatus = "";
-	}
-	else
-		gamestatus = "";
-
-	COM_ParseOut(com_protocolname.string, protocolname, sizeof(protocolname));	//we can only report one, so report the first.
+	svcqueryplayer_t *p;
 
 	resp = response;
 
@@ -1273,67 +1348,48 @@ static void SVC_GetInfo (const char *challenge, int fullstatus)
 	*resp++ = 0xff;
 	*resp++ = 0xff;
 	if (fullstatus)
-		Q_strncpyz(resp, "statusResponse", sizeof(response) - (resp-response) - 1);
+		Q_strncpyz(resp, "statusResponse", responsesize - (resp-response) - 1);
 	else
-		Q_strncpyz(resp, "infoResponse", sizeof(response) - (resp-response) - 1);
+		Q_strncpyz(resp, "infoResponse", responsesize - (resp-response) - 1);
 	resp += strlen(resp);
 	*resp++ = '\n';
 
 	//first line contains the serverinfo, or some form of it
-	{
-		const char *ignorekeys[] = {
-			"maxclients", "map", "*gamedir", "*z_ext",	//this is a DP protocol query, so some QW fields are not needed
-			"gamename", "modname", "protocol", "clients", "sv_maxclients", "mapname", "qcstatus", "challenge", NULL};	//and we need to add some
-		const char *prioritykeys[] = {"hostname", NULL}; //make sure we include these before we start overflowing
-
-		*resp = 0;
-		Info_SetValueForKey(resp, "challenge", challenge, sizeof(response) - (resp-response));	//the challenge can be important for the master protocol to prevent poisoning
-		Info_SetValueForKey(resp, "gamename", protocolname, sizeof(response) - (resp-response));//distinguishes it from other types of games
-		Info_SetValueForKey(resp, "protocol", com_protocolversion.string, sizeof(response) - (resp-response));	//should be an int.
-		Info_SetValueForKey(resp, "modname", FS_GetGamedir(true), sizeof(response) - (resp-response));
-		Info_SetValueForKey(resp, "clients", va("%d", numclients), sizeof(response) - (resp-response));
-		Info_SetValueForKey(resp, "sv_maxclients", maxclients.string, sizeof(response) - (resp-response));
-		Info_SetValueForKey(resp, "mapname", InfoBuf_ValueForKey(&svs.info, "map"), sizeof(response) - (resp-response));
-		resp += strlen(resp);
-		//now include the full/regular serverinfo
-		resp += InfoBuf_ToString(&svs.info, resp, sizeof(response) - (resp-response), prioritykeys, ignorekeys, NULL, NULL, NULL);
-		*resp = 0;
-		//and any possibly-long qc status string
-		if (*gamestatus)
-			Info_SetValueForKey(resp, "qcstatus", gamestatus, sizeof(response) - (resp-response));
-		resp += strlen(resp);
-	}
+	*resp = 0;
+	Info_SetValueForKey(resp, "challenge", challenge, responsesize - (resp-response));	//the challenge can be important for the master protocol to prevent poisoning
+	resp += strlen(resp);
+	Q_strncpyz(resp, svc_query.getinfo, responsesize - (resp-response));
+	resp += strlen(resp);
 	*resp++ = 0;
 
 	if (fullstatus)
 	{
-		client_t *cl;
 		char *start = resp;
 
-		if (resp != response+sizeof(response))
+		if (resp != response+responsesize)
 		{
 			resp[-1] = '\n';	//replace the null terminator that we already wrote
 
 			//on the following lines we have an entry for each client
-			for (i=0 ; i<svs.allocated_client_slots ; i++)
+			for (i=0 ; i<svc_query.numplayers ; i++)
 			{
-				cl = &svs.clients[i];
-				if ((cl->state == cs_connected || cl->state == cs_spawned || cl->name[0]) && !cl->spectator)
+				p = &svc_query.player[i];
+				if (!p->spectator)
 				{
-					Q_strncpyz(resp, va(
+					Q_snprintfz(resp, responsesize - (resp-response),
 									"%d %d \"%s\" \"%s\"\n"
 									,
-									cl->old_frags,
-									SV_CalcPing(cl, false),
-									cl->team,
-									cl->name
-									), sizeof(response) - (resp-response));
+									p->frags,
+									p->ping,
+									p->dpteam,
+									p->name
+									);
 					resp += strlen(resp);
 				}
 			}
 
 			*resp++ = 0;	//this might not be a null
-			if (resp == response+sizeof(response))
+			if (resp == response+responsesize)
 			{
 				//we're at the end of the buffer, it's full. bummer
 				//replace 12 bytes with infoResponse
@@ -1347,8 +1403,55 @@ static void SVC_GetInfo (const char *challenge, int fullstatus)
 			}
 		}
 	}
+	return resp-response;
+}
 
-	NET_SendPacket (svs.sockets, resp-response, response, &net_from);
+static void SVC_StatusPrint (void *ctx, const char *line)
+{
+	Con_Printf ("%s", line);
+}
+
+/*
+================
+SVC_Status
+
+Responds with all the info that qplug or qspy can see
+This message can be up to around 5k with worst case string lengths.
+================
+*/
+static void SVC_Status (void)
+{
+	int displayflags;
+
+	displayflags = atoi(Cmd_Argv(1));
+
+	Cmd_TokenizeString ("status", false, false);
+	SV_BeginRedirect (RD_PACKET, TL_FindLanguage(""));
+	SVC_LockQueries();
+	SVC_RefreshQueries();
+	SVC_StatusResponse(displayflags, SVC_StatusPrint, NULL);
+	SVC_UnlockQueries();
+	SV_EndRedirect ();
+}
+
+#if 1//def NQPROT
+static void SVC_GetInfo (const char *challenge, int fullstatus)
+{
+	//dpmaster support
+	char response[MAX_UDP_PACKET];
+	size_t len;
+
+#ifdef NQPROT
+	if (!sv_listen_nq.ival && !sv_listen_dp.ival)
+		return;
+#endif
+
+	SVC_LockQueries();
+	SVC_RefreshQueries();
+	len = SVC_InfoResponse(response, sizeof(response), challenge, fullstatus);
+	SVC_UnlockQueries();
+
+	NET_SendPacket (svs.sockets, len, response, &net_from);
 }
 #endif
 
@@ -3910,13 +4013,14 @@ void SVC_ACK (void)
 
 //returns false to block replies
 //this is to mitigate wasted bandwidth if we're used as a udp amplification
-qboolean SVC_ThrottleInfo (void)
+//must be called with the query lock held.
+static qboolean SVC_ThrottleInfoFrom (netadr_t *from)
 {
 #define THROTTLE_PPS 20
 	static unsigned int blockuntil;
 	unsigned int curtime, inc = 1000/THROTTLE_PPS;
 
-	if (SV_Master_AddressIsMaster(&net_from))
+	if (SV_Master_AddressIsMaster(from))
 		return true; //allow it without contributing to any throttling.
 
 	curtime = Sys_Milliseconds();
@@ -3933,6 +4037,14 @@ qboolean SVC_ThrottleInfo (void)
 	blockuntil += inc;
 	return true;
 }
+qboolean SVC_ThrottleInfo (void)
+{
+	qboolean allow;
+	SVC_LockQueries();
+	allow = SVC_ThrottleInfoFrom(&net_from);
+	SVC_UnlockQueries();
+	return allow;
+}
 
 //more aggressive logic.
 static struct attacker_s
@@ -3949,12 +4061,15 @@ static size_t dosattacker_max;
 #define dosattacker_limit 10				//if we get X packets
 #define dosattacker_period 30					//within Y secs
 #define dosattacker_blocktime (60*60*24)	//block them for Z secs (24 hours).
-static qboolean SV_DetectAmplificationDDOS (void)
+//returns false to block replies. *justblocked is set when the sender just got blocked, so that they can be told why.
+//must be called with the query lock held.
+static qboolean SV_AllowInfoReply (netadr_t *from, qboolean *justblocked)
 {
 	size_t at;
 	double t = Sys_DoubleTime();
 	int as;
-	switch(net_from.type)	//trying to be efficient and avoiding net_comparebaseaddr
+	*justblocked = false;
+	switch(from->type)	//trying to be efficient and avoiding net_comparebaseaddr
 	{
 	case NA_IP:		as = 4;	break;
 	case NA_IPX:	as = 10;break;
@@ -3965,9 +4080,9 @@ static qboolean SV_DetectAmplificationDDOS (void)
 	{
 		for (at = 0; at < dosattacker_count; at++)
 		{	//look for an existing one
-			if (net_from.type != dosattacker->af)
+			if (from->type != dosattacker[at].af)
 				continue;
-			if (!memcmp(dosattacker[at].addr, &net_from.address, as))
+			if (!memcmp(dosattacker[at].addr, &from->address, as))
 			{	//a match.
 				if (t > dosattacker[at].timeout)
 				{	//they survived, for now...
@@ -3978,16 +4093,12 @@ static qboolean SV_DetectAmplificationDDOS (void)
 				{
 					if (dosattacker[at].count == dosattacker_limit)
 					{
-						char buf[128];
-						Con_Printf(CON_ERROR "%s: Presumed amplification ddos attack, blocking further status queries.\n", NET_BaseAdrToString(buf, sizeof(buf), &net_from));
-						Q_snprintfz(buf, sizeof(buf), "\xff\xff\xff\xff%cProbable ddos amplification attack\n", A2C_PRINT);
-						NET_SendPacket(svs.sockets, strlen(buf), buf, &net_from);
-
+						*justblocked = true;
 						dosattacker[at].timeout = t + dosattacker_blocktime;	//a 24 hour block.
 					}
 					else	//extend by a smidge...
 						dosattacker[at].timeout += dosattacker_period/(double)dosattacker_limit;
-					return true;
+					return false;
 				}
 				break;
 			}
@@ -4013,17 +4124,162 @@ static qboolean SV_DetectAmplificationDDOS (void)
 				else
 					at = dosattacker_count++;
 			}
-			dosattacker[at].af = net_from.type;
-			memcpy(dosattacker[at].addr, &net_from.address, as);
+			dosattacker[at].af = from->type;
+			memcpy(dosattacker[at].addr, &from->address, as);
 			dosattacker[at].count = 0;
 			dosattacker[at].timeout = t + dosattacker_period;
 		}
 	}
 
-	if (SVC_ThrottleInfo())
+	if (SVC_ThrottleInfoFrom(from))
 		return true;
 	return false;
 }
+static void SV_AmplificationBlocked (netadr_t *from, char *buf, size_t bufsize)
+{
+	Con_Printf(CON_ERROR "%s: Presumed amplification ddos attack, blocking further status queries.\n", NET_BaseAdrToString(buf, bufsize, from));
+	Q_snprintfz(buf, bufsize, "\xff\xff\xff\xff%cProbable ddos amplification attack\n", A2C_PRINT);
+}
+static qboolean SV_DetectAmplificationDDOS (void)
+{
+	qboolean allow, justblocked;
+	char buf[128];
+
+	SVC_LockQueries();
+	allow = SV_AllowInfoReply(&net_from, &justblocked);
+	SVC_UnlockQueries();
+
+	if (justblocked)
+	{
+		SV_AmplificationBlocked(&net_from, buf, sizeof(buf));
+		NET_SendPacket(svs.sockets, strlen(buf), buf, &net_from);
+	}
+	return allow;
+}
+
+#ifdef HAVE_REUSEPORT
+typedef struct
+{
+	netadr_t *to;
+	void (*Reply)(void *ctx, netadr_t *to, const void *data, size_t length);
+	void *ctx;
+	size_t len;
+	char data[max(MAX_UDP_PACKET, sizeof(sv_redirected_buf)+6)];
+} svcthreadedreply_t;
+static void SVC_ThreadedFlush (svcthreadedreply_t *r)
+{
+	if (r->len > 5)
+		r->Reply(r->ctx, r->to, r->data, r->len+1);	//include the null, like SV_FlushRedirect
+	r->len = 5;
+}
+static void SVC_ThreadedPrint (void *ctx, const char *line)
+{
+	svcthreadedreply_t *r = ctx;
+	size_t len = strlen(line);
+	if (r->len-5 + len >= sizeof(sv_redirected_buf)-1)
+		SVC_ThreadedFlush(r);	//split it into multiple packets the same way SV_FlushRedirect would
+	len = min(len, sizeof(sv_redirected_buf)-1 - (r->len-5));
+	memcpy(r->data+r->len, line, len);
+	r->len += len;
+	r->data[r->len] = 0;
+}
+
+/*
+=================
+SV_ThreadedConnectionless
+
+Called from the net code's query threads, to answer status queries without involving the main thread.
+Returns false for anything it can't handle, which then gets passed on to SV_ConnectionlessPacket as normal.
+=================
+*/
+qboolean SV_ThreadedConnectionless (netadr_t *from, const qbyte *data, size_t length, void (*Reply)(void *ctx, netadr_t *to, const void *data, size_t length), void *ctx)
+{
+	char line[256];
+	char *args;
+	size_t i;
+	qboolean justblocked = false;
+	svcthreadedreply_t r;
+
+	//skip the -1 marker, and read the first line without using any of the main thread's globals.
+	for (i = 0, data += 4, length -= 4; i < length && i < sizeof(line)-1 && data[i] && data[i] != '\n'; i++)
+		line[i] = data[i];
+	line[i] = 0;
+	for (args = line; *args && *args != ' ' && *args != '	'; args++)
+		;
+	if (*args)
+		*args++ = 0;
+	while (*args == ' ' || *args == '	')
+		args++;
+
+	if (!strcmp(line, "ping") || (line[0] == A2A_PING && !line[1]))
+		;
+	else if (!strcmp(line, "status") || !strcmp(line, "getstatus"))
+		;
+	else if (!strcmp(line, "getinfo") && *args && strlen(args) <= 12)
+		;	//other challenges are from masters and clients, and are tracked by SV_Master_HeartbeatResponse.
+	else
+		return false;
+
+	SVC_LockQueries();
+	svc_query.wanted = true;
+	if (!svc_querymutex || Sys_DoubleTime() - svc_query.time > 2)
+	{	//too old to be useful (or the server isn't running). let the main thread handle this one, it'll get refreshed for the next.
+		SVC_UnlockQueries();
+		return false;
+	}
+
+	if (svc_query.showmessages)
+	{
+		char adr[MAX_ADR_SIZE];
+		Con_Printf(S_COLOR_GRAY"%s: %s %s\n", NET_AdrToString (adr, sizeof(adr), from), line, args);
+	}
+
+	r.to = from;
+	r.Reply = Reply;
+	r.ctx = ctx;
+	if (!strcmp(line, "ping") || line[0] == A2A_PING)
+	{	//only respond to these if we're actually public, same as the main thread.
+		if (svc_query.public)
+		{
+			r.data[0] = A2A_ACK;
+			Reply(ctx, from, r.data, 1);
+		}
+	}
+	else if (!strcmp(line, "status"))
+	{
+		if (svc_query.public && SV_AllowInfoReply(from, &justblocked))
+		{
+			memcpy(r.data, "\xff\xff\xff\xff", 4);
+			r.data[4] = A2C_PRINT;
+			r.len = 5;
+			SVC_StatusResponse(atoi(args), SVC_ThreadedPrint, &r);
+			SVC_ThreadedFlush(&r);
+		}
+	}
+	else if (svc_query.public && svc_query.infoenabled && SV_AllowInfoReply(from, &justblocked))
+	{	//getinfo/getstatus
+		r.len = SVC_InfoResponse(r.data, sizeof(r.data), args, !strcmp(line, "getstatus"));
+		Reply(ctx, from, r.data, r.len);
+	}
+	SVC_UnlockQueries();
+
+	if (justblocked)
+	{
+		SV_AmplificationBlocked(from, r.data, sizeof(r.data));
+		Reply(ctx, from, r.data, strlen(r.data));
+	}
+	return true;
+}
+
+//called each frame, to keep the query threads' snapshot reasonably fresh while they're using it.
+static void SV_UpdateQueries (void)
+{
+	SVC_LockQueries();
+	if (svc_query.wanted && Sys_DoubleTime() - svc_query.time > 1)
+		SVC_RefreshQueries();
+	SVC_UnlockQueries();
+}
+#endif
 
 /*
 =================
@@ -5385,6 +5641,9 @@ float SV_Frame (void)
 
 // get packets
 	isidle = !SV_ReadPackets (&delay);
+#ifdef HAVE_REUSEPORT
+	SV_UpdateQueries ();
+#endif
 	if (isDedicated)
 		NET_Tick();
 
@@ -5696,6 +5955,10 @@ void SV_InitLocal (void)
 	Cvar_Register (&sv_heartbeat_checks, cvargroup_servercontrol);
 
 	Cvar_Register (&sv_showconnectionlessmessages, cvargroup_servercontrol);
+#ifdef HAVE_REUSEPORT
+	if (!svc_querymutex)
+		svc_querymutex = Sys_CreateMutex();
+#endif
 	Cvar_Register (&sv_banproxies, cvargroup_serverpermissions);
 #ifdef SV_MASTER
 	Cvar_Register (&sv_master,	cvargroup_servercontrol);
@@ -5729,6 +5992,8 @@ void SV_InitLocal (void)
 	Cvar_Register (&sv_phs,	cvargroup_servercontrol);
 	Cvar_Register (&sv_cullplayers_trace, cvargroup_servercontrol);
 	Cvar_Register (&sv_cullentities_trace, cvargroup_servercontrol);
+	Cvar_Register (&sv_threadedsnapshots, cvargroup_servercontrol);
+	Cvar_Register (&sv_snapshotcache, cvargroup_servercontrol);
 
 	Cvar_Register (&sv_csqc_progname,	cvargroup_servercontrol);
 	Cvar_Register (&sv_csqcdebug, cvargroup_servercontrol);
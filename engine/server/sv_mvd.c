@@ -58,6 +58,7 @@ cvar_t			sv_demoAutoPrefix = CVAR("sv_demoAutoPrefix", "auto_");
 cvar_t			sv_demoPrefix = CVAR("sv_demoPrefix", "");
 cvar_t			sv_demoSuffix = CVAR("sv_demoSuffix", "");
 cvar_t			sv_demotxt = CVAR("sv_demotxt", "1");
+cvar_t			sv_demoIndex = CVARD("sv_demoIndex", "0", "Writes a .idx file alongside uncompressed mvds, containing a full-state keyframe every this many seconds. This allows players and proxies to seek within the demo without replaying everything before.\n0: no index.");
 
 void SV_WriteMVDMessage (sizebuf_t *msg, int type, int to, float time);
 void SV_WriteRecordMVDMessage (sizebuf_t *msg);
@@ -101,33 +102,257 @@ static struct reversedest_s
 static mvddest_t *SV_MVD_InitStream(vfsfile_t *stream, const char *info);
 qboolean SV_MVD_Record (mvddest_t *dest);
 char *SV_MVDName2Txt(char *name);
+char *SV_MVDName2Idx(char *name);
 extern cvar_t qtv_password;
 
-//does not unlink.
-static void DestClose(mvddest_t *d, enum mvdclosereason_e reason)
+static void DestClosed(mvddest_t *d, enum mvdclosereason_e reason);
+
+#ifdef LOADERTHREAD
+//demo files get their own writer thread, so the server never has to wait for the disk (or for deflate, when the file is gzipped).
+//the main thread hands over whole caches, and the writer frees them once they're written (or closes the file, when data is NULL).
+#define MVDWRITER_MAXPENDING (16*1024*1024)	//if the disk is this far behind then we'd rather stall than eat all our memory.
+struct mvdwrite_s
 {
-	if (d->desttype == DEST_THREADEDFILE)
+	struct mvdwrite_s *next;
+	mvddest_t *dest;
+	char *data;
+	size_t datasize;
+	qboolean toindex;	//data is for the .idx sidecar rather than the demo itself.
+};
+static struct
+{
+	void *thread;
+	void *condition;	//protects everything else here, and wakes whoever's waiting.
+	struct mvdwrite_s *head, *tail;
+	size_t pending;
+	unsigned int queued;	//entries not yet fully processed, including the one the writer is working on.
+	qboolean die;
+} mvdwriter;
+static mvddest_t *mvdclosing;	//main thread only.
+static void MVD_Writer_Process(struct mvdwrite_s *w)
+{
+	mvddest_t *d = w->dest;
+	if (w->toindex)
+	{	//failing to write the index isn't fatal to the demo.
+		VFS_WRITE(d->indexfile, w->data, w->datasize);
+		BZ_Free(w->data);
+	}
+	else if (w->data)
+	{
+		if (!d->error)
+		{
+			if (VFS_WRITE(d->file, w->data, w->datasize) != w->datasize)
+				d->error = true;
+			VFS_FLUSH(d->file);
+		}
+		BZ_Free(w->data);
+	}
+	else
 	{
-		while(d->flushing == true)
-			COM_WorkerPartialSync(d, &d->flushing, true);
+		if (d->indexfile)
+			VFS_CLOSE(d->indexfile);
+		d->indexfile = NULL;
+		VFS_CLOSE(d->file);
+		d->file = NULL;
+	}
+}
+static int MVD_Writer_Thread(void *arg)
+{
+	struct mvdwrite_s *w;
+	Sys_LockConditional(mvdwriter.condition);
+	for(;;)
+	{
+		w = mvdwriter.head;
+		if (!w)
+		{
+			if (mvdwriter.die)
+				break;
+			Sys_ConditionWait(mvdwriter.condition);
+			continue;
+		}
+		mvdwriter.head = w->next;
+		if (!mvdwriter.head)
+			mvdwriter.tail = NULL;
+		Sys_UnlockConditional(mvdwriter.condition);
+
+		MVD_Writer_Process(w);
+
+		Sys_LockConditional(mvdwriter.condition);
+		if (!w->data)
+			w->dest->closed = true;
+		mvdwriter.pending -= w->datasize;
+		mvdwriter.queued--;
+		Sys_ConditionBroadcast(mvdwriter.condition);	//wake up the main thread if its waiting for us to catch up
+		Z_Free(w);
+	}
+	Sys_UnlockConditional(mvdwriter.condition);
+	return 0;
+}
+static void MVD_Writer_Queue(mvddest_t *d, char *data, size_t datasize, qboolean toindex)
+{
+	struct mvdwrite_s *w = Z_Malloc(sizeof(*w));
+	w->dest = d;
+	w->data = data;
+	w->datasize = datasize;
+	w->toindex = toindex;
+
+	if (!mvdwriter.thread && !mvdwriter.die)
+	{
+		mvdwriter.condition = Sys_CreateConditional();
+		if (mvdwriter.condition)
+			mvdwriter.thread = Sys_CreateThread("mvdwriter", MVD_Writer_Thread, NULL, THREADP_NORMAL, 0);
+		if (!mvdwriter.thread)
+		{
+			if (mvdwriter.condition)
+				Sys_DestroyConditional(mvdwriter.condition);
+			mvdwriter.condition = NULL;
+			mvdwriter.die = true;	//don't keep retrying
+		}
+	}
+	if (!mvdwriter.thread)
+	{	//threads not available, so do it the slow way.
+		MVD_Writer_Process(w);
+		if (!data)
+			d->closed = true;
+		Z_Free(w);
+		return;
 	}
 
+	Sys_LockConditional(mvdwriter.condition);
+	while (mvdwriter.pending > MVDWRITER_MAXPENDING)
+		Sys_ConditionWait(mvdwriter.condition);
+	if (mvdwriter.tail)
+		mvdwriter.tail->next = w;
+	else
+		mvdwriter.head = w;
+	mvdwriter.tail = w;
+	mvdwriter.pending += datasize;
+	mvdwriter.queued++;
+	Sys_ConditionBroadcast(mvdwriter.condition);
+	Sys_UnlockConditional(mvdwriter.condition);
+}
+//waits until everything queued so far has been written and closed.
+static void MVD_Writer_Sync(void)
+{
+	if (!mvdwriter.thread)
+		return;
+	Sys_LockConditional(mvdwriter.condition);
+	while (mvdwriter.queued)
+		Sys_ConditionWait(mvdwriter.condition);
+	Sys_UnlockConditional(mvdwriter.condition);
+}
+//finishes off any dests that the writer has closed.
+//this is polled from the main loop rather than queued to WG_MAIN, because that work can get run from inside COM_WorkerLock, and DestClosed needs to take that lock itself.
+void SV_MVD_FinishClosing(void)
+{
+	mvddest_t **link, *d;
+	qboolean closed;
+
+	for (link = &mvdclosing; (d = *link); )
+	{
+		if (mvdwriter.thread)
+		{
+			Sys_LockConditional(mvdwriter.condition);
+			closed = d->closed;
+			Sys_UnlockConditional(mvdwriter.condition);
+		}
+		else
+			closed = d->closed;
+		if (closed)
+		{
+			*link = d->nextclosing;
+			DestClosed(d, d->closereason);
+		}
+		else
+			link = &d->nextclosing;
+	}
+}
+//a new recording is about to reuse this name, so older dests that are still closing must neither write into it nor delete it.
+static void MVD_Writer_Reopening(const char *filename)
+{
+	mvddest_t *d;
+	qboolean found = false;
+	for (d = mvdclosing; d; d = d->nextclosing)
+	{
+		if (!Q_strcasecmp(d->filename, filename))
+		{
+			d->keepfiles = true;
+			found = true;
+		}
+	}
+	if (found)
+	{
+		MVD_Writer_Sync();
+		SV_MVD_FinishClosing();
+	}
+}
+//waits for everything to be written out.
+void SV_MVD_Shutdown(void)
+{
+	if (mvdwriter.thread)
+	{
+		Sys_LockConditional(mvdwriter.condition);
+		mvdwriter.die = true;
+		Sys_ConditionBroadcast(mvdwriter.condition);
+		Sys_UnlockConditional(mvdwriter.condition);
+		Sys_WaitOnThread(mvdwriter.thread);
+		Sys_DestroyConditional(mvdwriter.condition);
+	}
+	memset(&mvdwriter, 0, sizeof(mvdwriter));
+	SV_MVD_FinishClosing();	//everything was closed by now.
+}
+#else
+void SV_MVD_FinishClosing(void)
+{
+}
+void SV_MVD_Shutdown(void)
+{
+}
+#endif
+
+//does not unlink.
+static void DestClose(mvddest_t *d, enum mvdclosereason_e reason)
+{
 	if (d->cache)
 		BZ_Free(d->cache);
+	d->cache = NULL;
+#ifdef LOADERTHREAD
+	if (d->desttype == DEST_THREADEDFILE)
+	{	//queue it after any data that's still pending (index included). SV_MVD_FinishClosing calls DestClosed once the writer is done.
+		d->closereason = reason;
+		d->nextclosing = mvdclosing;
+		mvdclosing = d;
+		MVD_Writer_Queue(d, NULL, 0, false);
+		return;
+	}
+#endif
+	if (d->indexfile)
+		VFS_CLOSE(d->indexfile);
+	d->indexfile = NULL;
 	if (d->file)
 	{
 		VFS_CLOSE(d->file);
-		if (d->desttype != DEST_STREAM)
-			FS_FlushFSHashWritten(d->filename);
+		d->file = NULL;
 	}
+	DestClosed(d, reason);
+}
 
+//the file is now closed.
+static void DestClosed(mvddest_t *d, enum mvdclosereason_e reason)
+{
 	if (d->desttype != DEST_STREAM)
 	{
+		FS_FlushFSHashWritten(d->filename);
+
 		if (reason == MVD_CLOSE_CANCEL)
 		{
-			FS_Remove(d->filename, FS_GAMEONLY);
+			if (!d->keepfiles)	//otherwise a newer recording owns these files now.
+			{
+				FS_Remove(d->filename, FS_GAMEONLY);
 
-			FS_Remove(SV_MVDName2Txt(d->filename), FS_GAMEONLY);
+				FS_Remove(SV_MVDName2Txt(d->filename), FS_GAMEONLY);
+				FS_Remove(SV_MVDName2Idx(d->filename), FS_GAMEONLY);
+			}
 
 			//SV_BroadcastPrintf (PRINT_CHAT, "Server recording canceled, demo removed\n");
 		}
@@ -143,24 +368,6 @@ static void DestClose(mvddest_t *d, enum mvdclosereason_e reason)
 	Z_Free(d);
 }
 
-static void MVD_FlushDest_Flushed(void *ctx, void *data, size_t a, size_t b)
-{
-	mvddest_t *d = ctx;
-	d->flushing = false;
-}
-static void MVD_FlushDest_Worker(void *ctx, void *data, size_t datasize, size_t b)
-{
-	mvddest_t *d = ctx;
-	int len = VFS_WRITE(d->file, data, datasize);
-	VFS_FLUSH(d->file);
-
-	if (len != datasize)
-		d->error = true;
-
-	d->altcache = data;
-	COM_AddWork(WG_MAIN, MVD_FlushDest_Flushed, d, NULL, 0, 0);
-}
-
 void DestFlush(qboolean compleate)
 {
 	int len;
@@ -205,19 +412,16 @@ void DestFlush(qboolean compleate)
 				d->cacheused = 0;
 			}
 			break;
+#ifdef LOADERTHREAD
 		case DEST_THREADEDFILE:
-			if (d->cacheused+demo_size_padding > d->maxcachesize || compleate)
-			{
-				void *data = d->cache;
-				while(d->flushing == true)
-					COM_WorkerPartialSync(d, &d->flushing, true);
-				d->cache = d->altcache;
-				d->altcache = NULL;
-				d->flushing = true;
-				COM_AddWork(WG_LOADER, MVD_FlushDest_Worker, d, data, d->cacheused, 0);
+			if (d->cacheused+demo_size_padding > d->maxcachesize || (compleate && d->cacheused))
+			{	//hand the whole cache over to the writer and start a new one, rather than waiting for the old one to come back.
+				MVD_Writer_Queue(d, d->cache, d->cacheused, false);
+				d->cache = BZ_Malloc(d->maxcachesize);
 				d->cacheused = 0;
 			}
 			break;
+#endif
 
 		case DEST_STREAM:
 			if (d->cacheused && !d->error)
@@ -951,6 +1155,7 @@ void SV_WriteMVDMessage (sizebuf_t *msg, int type, int to, float time)
 {
 	int		len, i, msec;
 	qbyte	c;
+	mvddest_t *d;
 
 	if (!sv.mvdrecording)
 		return;
@@ -982,6 +1187,11 @@ void SV_WriteMVDMessage (sizebuf_t *msg, int type, int to, float time)
 
 	c = msec;
 	DemoWrite(&c, sizeof(c));
+	for (d = demo.dest; d; d = d->nextdest)
+	{
+		if (!singledest || singledest == d)
+			d->msecs += msec;
+	}
 
 	if (demo.lasttype != type || demo.lastto != to)
 	{
@@ -1275,6 +1485,7 @@ void MVD_Init (void)
 	Cvar_Register (&sv_demoPrefix,		MVDVARGROUP);
 	Cvar_Register (&sv_demoSuffix,		MVDVARGROUP);
 	Cvar_Register (&sv_demotxt,			MVDVARGROUP);
+	Cvar_Register (&sv_demoIndex,		MVDVARGROUP);
 	Cvar_Register (&sv_demoExtraNames,	MVDVARGROUP);
 	Cvar_Register (&sv_demoExtensions,	MVDVARGROUP);
 	Cvar_Register (&sv_demoAutoCompress,MVDVARGROUP);
@@ -1378,6 +1589,9 @@ mvddest_t *SV_MVD_InitRecordFile (char *name)
 		return NULL;
 	}
 
+#ifdef LOADERTHREAD
+	MVD_Writer_Reopening(name);
+#endif
 	file = FS_OpenVFS (name, "wb", FS_GAMEONLY);
 	if (!file)
 	{
@@ -1417,10 +1631,6 @@ mvddest_t *SV_MVD_InitRecordFile (char *name)
 		else
 			dst->maxcachesize = sv_demoCacheSize.ival;
 		dst->cache = BZ_Malloc(dst->maxcachesize);
-		if (dst->desttype == DEST_THREADEDFILE)
-			dst->altcache = BZ_Malloc(dst->maxcachesize);
-		else
-			dst->altcache = NULL;
 	}
 	dst->droponmapchange = true;
 
@@ -1449,6 +1659,22 @@ mvddest_t *SV_MVD_InitRecordFile (char *name)
 		break;
 	}
 
+	//offsets within compressed files are useless for seeking, so only index plain mvds.
+	if (sv_demoIndex.value > 0 && Q_strcasecmp(".gz", COM_GetFileExtension(name, NULL)))
+	{
+		dst->indexfile = FS_OpenVFS (SV_MVDName2Idx(name), "wb", FS_GAMEONLY);
+		if (dst->indexfile)
+		{
+			int header[2];
+			header[0] = LittleLong(MVDINDEX_MAGIC);
+			header[1] = LittleLong(MVDINDEX_VERSION);
+			VFS_WRITE(dst->indexfile, header, sizeof(header));
+		}
+		dst->nextkeyframe = sv.time + sv_demoIndex.value;
+	}
+	else
+		FS_Remove(SV_MVDName2Idx(name), FS_GAMEONLY);	//don't leave a stale index from some older demo lying around.
+
 	txtname = SV_MVDName2Txt(name);
 	if (sv_demotxt.value)
 	{
@@ -1922,6 +2148,83 @@ void SV_MVD_SendInitialGamestate(mvddest_t *dest)
 	singledest = NULL;
 }
 
+//writes a keyframe to the .idx of each demo that is due one.
+//the keyframe is simply the same gamestate that a qtv would get when joining mid-game, captured to memory.
+void SV_MVD_WriteKeyframes(void)
+{
+	mvddest_t *d, *kf;
+	vfsfile_t *pipe;
+	float oldprevtime = demo_prevtime;
+	int *header;
+	char *data;
+	int datasize;
+
+	for (d = demo.dest; d; d = d->nextdest)
+	{
+		if (d->indexfile && sv.time >= d->nextkeyframe)
+			break;
+	}
+	if (!d)
+		return;
+
+	//make sure nothing pending from this frame ends up inside the keyframe instead of the demo.
+	SV_MVD_WriteReliables(false);
+	MVDWrite_Begin(255, -1, 0);
+
+	pipe = VFSPIPE_Open(1, false);
+	kf = Z_Malloc(sizeof(*kf));
+	kf->desttype = DEST_BUFFEREDFILE;
+	kf->file = pipe;
+	kf->maxcachesize = 0x8000;
+	kf->cache = BZ_Malloc(kf->maxcachesize);
+	kf->nextdest = demo.dest;
+	demo.dest = kf;
+
+	SV_MVD_SendInitialGamestate(kf);
+	VFS_WRITE(pipe, kf->cache, kf->cacheused);
+
+	demo.dest = kf->nextdest;
+	BZ_Free(kf->cache);
+
+	//the real demos didn't see any of that, so make sure the next message states its type explicitly and doesn't skip any time.
+	demo.lasttype = -1;
+	demo_prevtime = oldprevtime;
+	//and make sure the next frame doesn't depend upon player info the seeking client won't have.
+	memset(demo.info, 0, sizeof(demo.info));
+
+	//leave room for each dest's header in front of the gamestate.
+	datasize = VFS_GETLEN(pipe);
+	data = BZ_Malloc(sizeof(int)*3 + datasize);
+	datasize = VFS_READ(pipe, data + sizeof(int)*3, datasize);
+	VFS_CLOSE(pipe);
+
+	for (d = demo.dest; d; d = d->nextdest)
+	{
+		if (!d->indexfile || sv.time < d->nextkeyframe)
+			continue;
+		d->nextkeyframe = sv.time + ((sv_demoIndex.value > 1)?sv_demoIndex.value:1);
+
+		//any time within the keyframe itself was never written to the demo, so don't count it twice.
+		header = (int*)data;
+		header[0] = LittleLong((d->msecs > kf->msecs)?d->msecs - kf->msecs:0);
+		header[1] = LittleLong(d->totalsize);
+		header[2] = LittleLong(datasize);
+#ifdef LOADERTHREAD
+		if (d->desttype == DEST_THREADEDFILE)
+		{	//the writer frees it, so it needs its own copy.
+			char *copy = BZ_Malloc(sizeof(int)*3 + datasize);
+			memcpy(copy, data, sizeof(int)*3 + datasize);
+			MVD_Writer_Queue(d, copy, sizeof(int)*3 + datasize, true);
+			continue;
+		}
+#endif
+		VFS_WRITE(d->indexfile, data, sizeof(int)*3 + datasize);
+	}
+
+	BZ_Free(data);
+	Z_Free(kf);
+}
+
 //double-underscores will get merged together.
 const char *SV_GenCleanTable(void)
 {
@@ -2077,6 +2380,7 @@ qboolean MVD_CheckSpace(qboolean broadcastwarnings)
 
 					//Try to take the .txt too.
 					f->path->RemoveFile(f->path, SV_MVDName2Txt(f->name));
+					f->path->RemoveFile(f->path, SV_MVDName2Idx(f->name));
 					continue;
 				}
 			}
@@ -2856,6 +3160,13 @@ char *SV_MVDName2Txt(char *name)
 	return va("%s", s);
 }
 
+char *SV_MVDName2Idx(char *name)
+{
+	if (!name)
+		return NULL;
+	return va("%s.idx", name);
+}
+
 char *SV_MVDTxTNum(char *buffer, int bufferlen, int num)
 {
 	return SV_MVDName2Txt(SV_MVDNum(buffer, bufferlen, num));
@@ -2902,6 +3213,7 @@ void SV_MVDRemove_f (void)
 				}
 
 				FS_Remove(SV_MVDName2Txt(path), FS_GAMEONLY);
+				FS_Remove(SV_MVDName2Idx(path), FS_GAMEONLY);
 			}
 		}
 		Sys_freedir(dir);
@@ -2935,6 +3247,7 @@ void SV_MVDRemove_f (void)
 		Con_Printf("unable to remove demo %s\n", name);
 
 	FS_Remove(SV_MVDName2Txt(path), FS_GAMEONLY);
+	FS_Remove(SV_MVDName2Idx(path), FS_GAMEONLY);
 }
 
 void SV_MVDRemoveNum_f (void)
@@ -2974,6 +3287,7 @@ void SV_MVDRemoveNum_f (void)
 			Con_Printf("unable to remove demo %s\n", name);
 
 		FS_Remove(SV_MVDName2Txt(path), FS_GAMEONLY);
+		FS_Remove(SV_MVDName2Idx(path), FS_GAMEONLY);
 	}
 	else
 		Con_Printf("invalid demo num\n");
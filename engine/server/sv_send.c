@@ -3394,9 +3394,16 @@ void SV_SendClientMessages (void)
 	}
 #endif
 
+// queue up our outgoing packets, so they can be sent with fewer syscalls
+	NET_BatchSends (svs.sockets, true);
+
 // update frags, names, etc
 	SV_UpdateToReliableMessages ();
 
+// cull entities for each client (on worker threads, if enabled)
+	SV_Snapshot_FlushStateCache ();
+	SV_Snapshot_BuildVisibility ();
+
 // build individual updates
 	for (i=0, c = svs.clients ; i<svs.allocated_client_slots ; i++, c++)
 	{
@@ -3447,6 +3454,8 @@ void SV_SendClientMessages (void)
 				cmd.buttons = c->lastcmd.buttons;
 				SV_RunCmd (&cmd, true);
 				SV_PostRunCmd();
+				SV_Snapshot_DiscardVisibility(c);
+				SV_Snapshot_FlushStateCache();
 				c->lastruncmd = sv.time*1000-c->msecs;
 				if (stepmsec > c->msecs)
 					c->msecs = 0;
@@ -3636,6 +3645,8 @@ void SV_SendClientMessages (void)
 		SV_ProcessSendFlags(&demo.recorder);
 #endif
 	SV_CleanupEnts();
+
+	NET_BatchSends (svs.sockets, false);
 }
 
 //#ifdef _MSC_VER
@@ -3645,6 +3656,7 @@ void SV_SendClientMessages (void)
 #ifdef MVD_RECORDING
 void SV_WriteMVDMessage (sizebuf_t *msg, int type, int to, float time);
 void SV_MVD_CheckReverse(void);
+void SV_MVD_FinishClosing(void);
 
 void DemoWriteQTVTimePad(int msecs);
 #define Max(a, b) ((a>b)?a:b)
@@ -3664,10 +3676,13 @@ void SV_SendMVDMessage(void)
 	sizebuf_t *dmsg;
 
 	SV_MVD_CheckReverse();
+	SV_MVD_FinishClosing();
 
 	if (!sv.mvdrecording)
 		return;
 
+	SV_Snapshot_FlushStateCache();
+
 	if (sv_demoPings.value)
 	{
 		if (sv.time - demo.pingtime > sv_demoPings.value)
@@ -3704,6 +3719,9 @@ void SV_SendMVDMessage(void)
 		return;
 	}
 
+	//this needs to happen before the frame so that the frame is written in full.
+	SV_MVD_WriteKeyframes();
+
 	msg.data = buf;
 	msg.maxsize = sizeof(buf);
 	msg.cursize = 0;
@@ -6770,16 +6770,44 @@ static qboolean AddEntityToPmove(world_t *w, wedict_t *player, wedict_t *check)
 #if 1
 #ifdef USEAREAGRID
 extern size_t areagridsequence;
-static void AddLinksToPmove (world_t *w, wedict_t *player, areagridlink_t *node)
+//returns false once pmove is full.
+static qboolean AddLinkToPmove (world_t *w, wedict_t *check, void *ctx)
 {
-	int Q1_HullPointContents (hull_t *hull, int num, vec3_t p);
-	link_t		*l, *next;
-	wedict_t		*check;
-	int			pl;
+	wedict_t	*player = ctx;
 	int			i;
 	int			solid;
 
-	pl = EDICT_TO_PROG(w->progs, player);
+	if (check->v->owner == EDICT_TO_PROG(w->progs, player))
+		return true;		// player's own missile
+	if (check == player)
+		return true;
+	solid = check->v->solid;
+	if (
+		(solid == SOLID_TRIGGER && check->v->skin < 0)
+		|| solid == SOLID_BSP
+		|| solid == SOLID_PORTAL
+		|| solid == SOLID_BBOX
+		|| solid == SOLID_SLIDEBOX
+		|| solid == SOLID_LADDER
+		//|| (solid == SOLID_PHASEH2 && progstype == PROG_H2) //logically matches hexen2, but I hate it
+		)
+	{
+
+		for (i=0 ; i<3 ; i++)
+			if (check->v->absmin[i] > pmove_maxs[i]
+			|| check->v->absmax[i] < pmove_mins[i])
+				break;
+		if (i != 3)
+			return true;
+
+		return AddEntityToPmove(w, player, check);
+	}
+	return true;
+}
+static void AddLinksToPmove (world_t *w, wedict_t *player, areagridlink_t *node)
+{
+	link_t		*l, *next;
+	wedict_t		*check;
 
 	// touch linked edicts
 	for (l = node->l.next ; l != &node->l ; l = next)
@@ -6791,32 +6819,8 @@ static void AddLinksToPmove (world_t *w, wedict_t *player, areagridlink_t *node)
 			continue;
 		check->gridareasequence = areagridsequence;
 
-		if (check->v->owner == pl)
-			continue;		// player's own missile
-		if (check == player)
-			continue;
-		solid = check->v->solid;
-		if (
-			(solid == SOLID_TRIGGER && check->v->skin < 0)
-			|| solid == SOLID_BSP
-			|| solid == SOLID_PORTAL
-			|| solid == SOLID_BBOX
-			|| solid == SOLID_SLIDEBOX
-			|| solid == SOLID_LADDER
-			//|| (solid == SOLID_PHASEH2 && progstype == PROG_H2) //logically matches hexen2, but I hate it
-			)
-		{
-
-			for (i=0 ; i<3 ; i++)
-				if (check->v->absmin[i] > pmove_maxs[i]
-				|| check->v->absmax[i] < pmove_mins[i])
-					break;
-			if (i != 3)
-				continue;
-
-			if (!AddEntityToPmove(w, player, check))
-				break;
-		}
+		if (!AddLinkToPmove(w, check, player))
+			break;
 	}
 }
 
@@ -6865,14 +6869,20 @@ static void AddPortalsToPmove (world_t *w, wedict_t *player, areagridlink_t *nod
 void AddAllLinksToPmove (world_t *w, wedict_t *player)
 {
 	int ming[2], maxg[2], g[2];
-	CALCAREAGRIDBOUNDS(w, pmove_mins, pmove_maxs);
 
 	areagridsequence++;
 
-	AddLinksToPmove(w, player, &w->jumboarea);
-	for (g[0] = ming[0]; g[0] < maxg[0]; g[0]++)
-		for (g[1] = ming[1]; g[1] < maxg[1]; g[1]++)
-			AddLinksToPmove(w, player, &w->gridareas[g[0] + g[1]*w->gridsize[0]]);
+	if (w->useareabvh)
+		World_AreaBVH_Walk(w, pmove_mins, pmove_maxs, NULL, NULL, NULL, NULL, AddLinkToPmove, player);
+	else
+	{
+		CALCAREAGRIDBOUNDS(w, pmove_mins, pmove_maxs);
+
+		AddLinksToPmove(w, player, &w->jumboarea);
+		for (g[0] = ming[0]; g[0] < maxg[0]; g[0]++)
+			for (g[1] = ming[1]; g[1] < maxg[1]; g[1]++)
+				AddLinksToPmove(w, player, &w->gridareas[g[0] + g[1]*w->gridsize[0]]);
+	}
 
 	AddPortalsToPmove(w, player, &w->portallist);
 }
@@ -37,6 +37,9 @@ size_t areagridsequence;	//used to avoid poking the same ent twice.
 
 extern cvar_t sv_compatiblehulls;
 extern cvar_t sv_gameplayfix_linknonsolid;
+#ifdef USEAREAGRID
+extern cvar_t sv_areabvh;
+#endif
 
 typedef struct
 {
@@ -56,6 +59,9 @@ typedef struct
 } moveclip_t;
 
 static unsigned int World_ContentsOfAllLinks (world_t *w, vec3_t pos);
+#ifdef USEAREAGRID
+static void World_UnlinkAreaGrid (wedict_t *ent);
+#endif
 /*
 ===============================================================================
 
@@ -287,7 +293,9 @@ void World_ClearWorld_Nodes (world_t *w, qboolean relink)
 
 	World_InitBoxHull ();
 
-#if !defined(USEAREAGRID)
+#ifdef USEAREAGRID
+	w->useareabvh = false;	//q2 has its own linking.
+#else
 	memset (&w->portallist, 0, sizeof(w->portallist));
 	ClearLink (&w->portallist.edicts);
 	w->portallist.axis = -1;
@@ -325,6 +333,416 @@ void World_ClearWorld_Nodes (world_t *w, qboolean relink)
 #endif
 
 #ifdef USEAREAGRID
+/*
+===============
+Dynamic AABB tree
+
+Balanced binary tree of ent boxes. Unlike the grid, large ents don't need to be linked into lots of cells
+(or dumped into the jumbo list), and traces only visit nodes along their path.
+===============
+*/
+#define AREABVH_NULL -1
+#define AREABVH_MARGIN 8		//leafs are fattened by this much, so ents that are only fidgeting don't touch the tree.
+#define AREABVH_PREDICT 0.05	//and extended along their velocity by this many seconds.
+
+static int World_AreaBVH_AllocNode(areabvh_t *t)
+{
+	int n;
+	if (t->freenodes != AREABVH_NULL)
+	{
+		n = t->freenodes;
+		t->freenodes = t->nodes[n].parent;
+	}
+	else
+	{
+		if (t->numnodes == t->maxnodes)
+		{
+			t->maxnodes = t->maxnodes?t->maxnodes*2:256;
+			t->nodes = BZ_Realloc(t->nodes, sizeof(*t->nodes)*t->maxnodes);
+		}
+		n = t->numnodes++;
+	}
+	t->nodes[n].parent = AREABVH_NULL;
+	t->nodes[n].child[0] = t->nodes[n].child[1] = AREABVH_NULL;
+	t->nodes[n].height = 0;
+	t->nodes[n].ed = NULL;
+	return n;
+}
+static void World_AreaBVH_FreeNode(areabvh_t *t, int n)
+{
+	t->nodes[n].parent = t->freenodes;
+	t->nodes[n].height = -1;
+	t->nodes[n].ed = NULL;
+	t->freenodes = n;
+}
+static void World_AreaBVH_Reset(areabvh_t *t)
+{
+	t->numnodes = 0;
+	t->root = AREABVH_NULL;
+	t->freenodes = AREABVH_NULL;
+}
+
+//half the surface area, which is what the insertion heuristic tries to keep small.
+static float World_AreaBVH_Cost(const vec3_t mins, const vec3_t maxs)
+{
+	float x = maxs[0]-mins[0], y = maxs[1]-mins[1], z = maxs[2]-mins[2];
+	return x*y + y*z + z*x;
+}
+static float World_AreaBVH_UnionCost(const areabvhnode_t *a, const areabvhnode_t *b)
+{
+	vec3_t mins, maxs;
+	int i;
+	for (i = 0; i < 3; i++)
+	{
+		mins[i] = min(a->mins[i], b->mins[i]);
+		maxs[i] = max(a->maxs[i], b->maxs[i]);
+	}
+	return World_AreaBVH_Cost(mins, maxs);
+}
+static void World_AreaBVH_Union(areabvhnode_t *out, const areabvhnode_t *a, const areabvhnode_t *b)
+{
+	int i;
+	for (i = 0; i < 3; i++)
+	{
+		out->mins[i] = min(a->mins[i], b->mins[i]);
+		out->maxs[i] = max(a->maxs[i], b->maxs[i]);
+	}
+}
+
+//rotates the taller grandchild upwards if the two children of ia have heights that differ by more than one.
+//returns the index of the node that now sits where ia was.
+static int World_AreaBVH_Balance(areabvh_t *t, int ia)
+{
+	areabvhnode_t *n = t->nodes;
+	areabvhnode_t *a = &n[ia], *b, *c, *f, *g;
+	int ib, ic, i_f, ig, balance;
+
+	if (a->child[0] == AREABVH_NULL || a->height < 2)
+		return ia;
+
+	ib = a->child[0];
+	ic = a->child[1];
+	b = &n[ib];
+	c = &n[ic];
+	balance = c->height - b->height;
+
+	if (balance > 1)
+	{	//rotate c up
+		i_f = c->child[0];
+		ig = c->child[1];
+		f = &n[i_f];
+		g = &n[ig];
+
+		c->child[0] = ia;
+		c->parent = a->parent;
+		a->parent = ic;
+		if (c->parent == AREABVH_NULL)
+			t->root = ic;
+		else if (n[c->parent].child[0] == ia)
+			n[c->parent].child[0] = ic;
+		else
+			n[c->parent].child[1] = ic;
+
+		if (f->height > g->height)
+		{
+			c->child[1] = i_f;
+			a->child[1] = ig;
+			g->parent = ia;
+			World_AreaBVH_Union(a, b, g);
+			World_AreaBVH_Union(c, a, f);
+			a->height = 1 + max(b->height, g->height);
+			c->height = 1 + max(a->height, f->height);
+		}
+		else
+		{
+			c->child[1] = ig;
+			a->child[1] = i_f;
+			f->parent = ia;
+			World_AreaBVH_Union(a, b, f);
+			World_AreaBVH_Union(c, a, g);
+			a->height = 1 + max(b->height, f->height);
+			c->height = 1 + max(a->height, g->height);
+		}
+		return ic;
+	}
+	if (balance < -1)
+	{	//rotate b up
+		i_f = b->child[0];
+		ig = b->child[1];
+		f = &n[i_f];
+		g = &n[ig];
+
+		b->child[0] = ia;
+		b->parent = a->parent;
+		a->parent = ib;
+		if (b->parent == AREABVH_NULL)
+			t->root = ib;
+		else if (n[b->parent].child[0] == ia)
+			n[b->parent].child[0] = ib;
+		else
+			n[b->parent].child[1] = ib;
+
+		if (f->height > g->height)
+		{
+			b->child[1] = i_f;
+			a->child[0] = ig;
+			g->parent = ia;
+			World_AreaBVH_Union(a, c, g);
+			World_AreaBVH_Union(b, a, f);
+			a->height = 1 + max(c->height, g->height);
+			b->height = 1 + max(a->height, f->height);
+		}
+		else
+		{
+			b->child[1] = ig;
+			a->child[0] = i_f;
+			f->parent = ia;
+			World_AreaBVH_Union(a, c, f);
+			World_AreaBVH_Union(b, a, g);
+			a->height = 1 + max(c->height, f->height);
+			b->height = 1 + max(a->height, g->height);
+		}
+		return ib;
+	}
+	return ia;
+}
+
+//walks back up to the root fixing up the boxes+heights.
+static void World_AreaBVH_Refit(areabvh_t *t, int idx)
+{
+	areabvhnode_t *n = t->nodes;
+	int c0, c1;
+	while (idx != AREABVH_NULL)
+	{
+		idx = World_AreaBVH_Balance(t, idx);
+
+		c0 = n[idx].child[0];
+		c1 = n[idx].child[1];
+		n[idx].height = 1 + max(n[c0].height, n[c1].height);
+		World_AreaBVH_Union(&n[idx], &n[c0], &n[c1]);
+
+		idx = n[idx].parent;
+	}
+}
+
+static void World_AreaBVH_InsertLeaf(areabvh_t *t, int leaf)
+{
+	areabvhnode_t *n;
+	int idx, sibling, oldparent, newparent, c0, c1;
+	float area, combined, cost, inherit, cost0, cost1;
+
+	if (t->root == AREABVH_NULL)
+	{
+		t->root = leaf;
+		t->nodes[leaf].parent = AREABVH_NULL;
+		return;
+	}
+	newparent = World_AreaBVH_AllocNode(t);	//may realloc.
+	n = t->nodes;
+
+	//find the best sibling, by descending into whichever child would grow the least.
+	idx = t->root;
+	while (n[idx].child[0] != AREABVH_NULL)
+	{
+		c0 = n[idx].child[0];
+		c1 = n[idx].child[1];
+
+		area = World_AreaBVH_Cost(n[idx].mins, n[idx].maxs);
+		combined = World_AreaBVH_UnionCost(&n[idx], &n[leaf]);
+		cost = 2*combined;				//cost of making a new parent for this node and the leaf
+		inherit = 2*(combined - area);	//cost that everything below will be paying regardless
+
+		cost0 = World_AreaBVH_UnionCost(&n[c0], &n[leaf]) + inherit;
+		if (n[c0].child[0] != AREABVH_NULL)
+			cost0 -= World_AreaBVH_Cost(n[c0].mins, n[c0].maxs);
+		cost1 = World_AreaBVH_UnionCost(&n[c1], &n[leaf]) + inherit;
+		if (n[c1].child[0] != AREABVH_NULL)
+			cost1 -= World_AreaBVH_Cost(n[c1].mins, n[c1].maxs);
+
+		if (cost < cost0 && cost < cost1)
+			break;
+		idx = (cost0 < cost1)?c0:c1;
+	}
+	sibling = idx;
+
+	oldparent = n[sibling].parent;
+	n[newparent].parent = oldparent;
+	n[newparent].child[0] = sibling;
+	n[newparent].child[1] = leaf;
+	n[newparent].height = n[sibling].height + 1;
+	World_AreaBVH_Union(&n[newparent], &n[sibling], &n[leaf]);
+	n[sibling].parent = newparent;
+	n[leaf].parent = newparent;
+	if (oldparent == AREABVH_NULL)
+		t->root = newparent;
+	else if (n[oldparent].child[0] == sibling)
+		n[oldparent].child[0] = newparent;
+	else
+		n[oldparent].child[1] = newparent;
+
+	World_AreaBVH_Refit(t, n[leaf].parent);
+}
+
+static void World_AreaBVH_RemoveLeaf(areabvh_t *t, int leaf)
+{
+	areabvhnode_t *n = t->nodes;
+	int parent, grandparent, sibling;
+
+	if (leaf == t->root)
+	{
+		t->root = AREABVH_NULL;
+		return;
+	}
+
+	parent = n[leaf].parent;
+	grandparent = n[parent].parent;
+	sibling = (n[parent].child[0] == leaf)?n[parent].child[1]:n[parent].child[0];
+
+	n[sibling].parent = grandparent;
+	if (grandparent == AREABVH_NULL)
+		t->root = sibling;
+	else
+	{
+		if (n[grandparent].child[0] == parent)
+			n[grandparent].child[0] = sibling;
+		else
+			n[grandparent].child[1] = sibling;
+	}
+	World_AreaBVH_FreeNode(t, parent);
+	World_AreaBVH_Refit(t, grandparent);
+}
+
+static void World_AreaBVH_Unlink(wedict_t *ent)
+{
+	areabvh_t *t = ent->areabvh;
+	if (!t)
+		return;	// not linked in anywhere
+	World_AreaBVH_RemoveLeaf(t, ent->areabvhleaf);
+	World_AreaBVH_FreeNode(t, ent->areabvhleaf);
+	ent->areabvh = NULL;
+}
+
+static void World_AreaBVH_Link(world_t *w, wedict_t *ent)
+{
+	areabvh_t *t = &w->areabvh;
+	areabvhnode_t *l;
+	int leaf, i;
+	float v;
+
+	if (ent->areabvh == t)
+	{
+		l = &t->nodes[ent->areabvhleaf];
+		if (l->mins[0] <= ent->v->absmin[0] && l->maxs[0] >= ent->v->absmax[0] &&
+			l->mins[1] <= ent->v->absmin[1] && l->maxs[1] >= ent->v->absmax[1] &&
+			l->mins[2] <= ent->v->absmin[2] && l->maxs[2] >= ent->v->absmax[2])
+			return;	//still within its fattened box, the tree doesn't need to change.
+		leaf = ent->areabvhleaf;
+		World_AreaBVH_RemoveLeaf(t, leaf);
+	}
+	else
+	{
+		World_AreaBVH_Unlink(ent);
+		leaf = World_AreaBVH_AllocNode(t);
+		t->nodes[leaf].ed = ent;
+		ent->areabvh = t;
+		ent->areabvhleaf = leaf;
+	}
+
+	l = &t->nodes[leaf];
+	for (i = 0; i < 3; i++)
+	{
+		v = ent->v->velocity[i] * AREABVH_PREDICT;
+		if (!(v > -256))	//also catches nans
+			v = (v < 0)?-256:0;
+		else if (v > 256)
+			v = 256;
+		l->mins[i] = ent->v->absmin[i] - AREABVH_MARGIN + min(v, 0);
+		l->maxs[i] = ent->v->absmax[i] + AREABVH_MARGIN + max(v, 0);
+	}
+	World_AreaBVH_InsertLeaf(t, leaf);
+}
+
+//slab test of the line against the node, with the node expanded by the moving box.
+static qboolean World_AreaBVH_HitsLine(const areabvhnode_t *node, const float *start, const vec3_t delta, const vec3_t invdelta, const float *emins, const float *emaxs)
+{
+	float t0 = 0, t1 = 1, a, b, lo, hi;
+	int i;
+	for (i = 0; i < 3; i++)
+	{
+		lo = node->mins[i] - emaxs[i];
+		hi = node->maxs[i] - emins[i];
+		if (!delta[i])
+		{
+			if (start[i] < lo || start[i] > hi)
+				return false;
+			continue;
+		}
+		a = (lo - start[i]) * invdelta[i];
+		b = (hi - start[i]) * invdelta[i];
+		if (a > b)
+		{
+			t0 = max(t0, b);
+			t1 = min(t1, a);
+		}
+		else
+		{
+			t0 = max(t0, a);
+			t1 = min(t1, b);
+		}
+		if (t0 > t1)
+			return false;
+	}
+	return true;
+}
+
+void World_AreaBVH_Walk (world_t *w, const vec3_t mins, const vec3_t maxs, const float *start, const float *end, const float *emins, const float *emaxs, qboolean (*callback)(world_t *w, wedict_t *ed, void *ctx), void *ctx)
+{
+	areabvh_t *t = &w->areabvh;
+	areabvhnode_t *node;
+	int stack[128], sp = 0;
+	vec3_t delta, invdelta;
+	int i;
+
+	if (t->root == AREABVH_NULL)
+		return;
+
+	if (start)
+	{
+		for (i = 0; i < 3; i++)
+		{
+			delta[i] = end[i] - start[i];
+			invdelta[i] = delta[i]?1/delta[i]:0;
+		}
+	}
+
+	stack[sp++] = t->root;
+	while (sp)
+	{
+		node = &t->nodes[stack[--sp]];
+		if (node->mins[0] > maxs[0] || node->mins[1] > maxs[1] || node->mins[2] > maxs[2]
+		 || node->maxs[0] < mins[0] || node->maxs[1] < mins[1] || node->maxs[2] < mins[2])
+			continue;
+		if (start && !World_AreaBVH_HitsLine(node, start, delta, invdelta, emins, emaxs))
+			continue;
+
+		if (node->child[0] == AREABVH_NULL)
+		{
+			if (!callback(w, node->ed, ctx))
+				return;
+		}
+		else if (sp+2 <= countof(stack))
+		{	//callbacks must not link or unlink anything, as that can restructure the tree.
+			stack[sp++] = node->child[1];
+			stack[sp++] = node->child[0];
+		}
+		else
+		{
+			Con_DPrintf("World_AreaBVH_Walk: tree too deep\n");
+			return;
+		}
+	}
+}
+
 static void World_ClearWorld_AreaGrid (world_t *w, qboolean relink)
 {
 	int numareas = 1;
@@ -370,8 +788,11 @@ static void World_ClearWorld_AreaGrid (world_t *w, qboolean relink)
 	ClearLink (&w->jumboarea.l);
 	ClearLink (&w->portallist.l);
 
+	w->useareabvh = !!sv_areabvh.ival;
+	World_AreaBVH_Reset(&w->areabvh);
 
-	if (relink)
+	//the tree's nodes are gone now, so no ent may keep its old leaf even if we're not relinking (it'd try to remove it from the new tree).
+	if (w->progs)
 	{
 		for (i=0 ; i<w->num_edicts ; i++)
 		{
@@ -384,7 +805,8 @@ static void World_ClearWorld_AreaGrid (world_t *w, qboolean relink)
 					break;		// not linked in anywhere
 				ClearLink(&ent->gridareas[j].l);
 			}
-			if (ED_ISFREE(ent))
+			ent->areabvh = NULL;
+			if (!relink || ED_ISFREE(ent))
 				continue;
 			World_LinkEdict (w, ent, false);	// relink ents so touch functions continue to work.
 		}
@@ -516,7 +938,9 @@ void QDECL World_LinkEdict (world_t *w, wedict_t *ent, qboolean touch_triggers)
 	int solid;
 
 #ifdef USEAREAGRID
-	World_UnlinkEdict (ent);	// unlink from old position
+	World_UnlinkAreaGrid (ent);	// unlink from old position (the bvh can often skip the relinking, so that's done later)
+	if (ent == w->edicts || ED_ISFREE(ent) || (ent->v->solid == SOLID_NOT && !sv_gameplayfix_linknonsolid.ival) || ent->v->solid == SOLID_PORTAL || !w->useareabvh)
+		World_AreaBVH_Unlink (ent);
 #else
 	areanode_t	*node;
 	
@@ -665,6 +1089,8 @@ void QDECL World_LinkEdict (world_t *w, wedict_t *ent, qboolean touch_triggers)
 		ent->gridareas[0].ed = ent;
 		InsertLinkBefore (&ent->gridareas[0].l, &w->portallist.l);
 	}
+	else if (w->useareabvh)
+		World_AreaBVH_Link(w, ent);
 	else
 	{
 		int ming[2], maxg[2], g[2], ga;
@@ -1098,6 +1524,43 @@ static trace_t World_ClipMoveToEntity (world_t *w, wedict_t *ent, vec3_t eorg, v
 
 #ifdef USEAREAGRID
 
+struct areaedicts_s
+{
+	float *mins, *maxs;
+	wedict_t **list;
+	int count, maxcount;
+	int areatype;
+};
+static qboolean World_AreaEdicts_BVH (world_t *w, wedict_t *check, void *ctx)
+{
+	struct areaedicts_s *a = ctx;
+	if (a->areatype != AREA_ALL)
+	{
+		if (check->v->solid == SOLID_NOT)
+			return true;		// deactivated
+
+		if ((check->v->solid == SOLID_TRIGGER||check->v->solid == SOLID_BSPTRIGGER) != (a->areatype == AREA_TRIGGER))
+			return true;
+	}
+
+	if (check->v->absmin[0] > a->maxs[0]
+	|| check->v->absmin[1] > a->maxs[1]
+	|| check->v->absmin[2] > a->maxs[2]
+	|| check->v->absmax[0] < a->mins[0]
+	|| check->v->absmax[1] < a->mins[1]
+	|| check->v->absmax[2] < a->mins[2])
+		return true;		// not touching
+
+	if (a->count == a->maxcount)
+	{
+		Con_Printf ("World_AreaEdicts: MAXCOUNT\n");
+		return false;
+	}
+
+	a->list[a->count++] = check;
+	return true;
+}
+
 /*
 ================
 SV_AreaEdicts
@@ -1109,6 +1572,14 @@ int World_AreaEdicts (world_t *w, vec3_t mins, vec3_t maxs, wedict_t **list, int
 	areagridlink_t *start, *l;
 	size_t count = 0;
 	int ming[2], maxg[2], g[2], ga;
+
+	if (w->useareabvh)
+	{
+		struct areaedicts_s a = {mins, maxs, list, 0, maxcount, areatype};
+		World_AreaBVH_Walk(w, mins, maxs, NULL, NULL, NULL, NULL, World_AreaEdicts_BVH, &a);
+		return a.count;
+	}
+
 	CALCAREAGRIDBOUNDS(w, mins, maxs);
 
 	areagridsequence++;
@@ -1696,7 +2167,7 @@ void World_TouchAllLinks (world_t *w, wedict_t *ent)
 	}
 }
 
-void World_UnlinkEdict (wedict_t *ent)
+static void World_UnlinkAreaGrid (wedict_t *ent)
 {
 	size_t i;
 	for (i = 0; i < countof(ent->gridareas); i++)
@@ -1707,138 +2178,161 @@ void World_UnlinkEdict (wedict_t *ent)
 		ent->gridareas[i].l.prev = ent->gridareas[i].l.next = NULL;
 	}
 }
+void World_UnlinkEdict (wedict_t *ent)
+{
+	World_UnlinkAreaGrid(ent);
+	World_AreaBVH_Unlink(ent);
+}
 
-static void World_ClipToLinks (world_t *w, areagridlink_t *node, moveclip_t *clip)
+//returns true to keep going, for World_AreaBVH_Walk's sake.
+static qboolean World_ClipToEdict (world_t *w, wedict_t *touch, void *ctx)
 {
-	link_t		*l, *next;
-	wedict_t		*touch;
+	moveclip_t	*clip = ctx;
 	trace_t		trace;
 
-// touch linked edicts
-	for (l = node->l.next ; l != &node->l ; l = next)
-	{
-		next = l->next;
-		touch = ((areagridlink_t*)l)->ed;
+	if (touch->v->solid == SOLID_NOT)
+		return true;
+	if (touch == clip->passedict)
+		return true;
 
-		if (touch->gridareasequence == areagridsequence)
-			continue;
-		touch->gridareasequence = areagridsequence;
-
-		if (touch->v->solid == SOLID_NOT)
-			continue;
-		if (touch == clip->passedict)
-			continue;
-
-		/*if its a trigger, we only clip against it if the flags are aligned*/
-		if (SOLID_ISTRIGGER(touch->v->solid))
-		{
-			if (!(clip->type & MOVE_TRIGGERS))
-				continue;
-			if (!((int)touch->v->flags & FL_FINDABLE_NONSOLID))
-				continue;
-		}
+	/*if its a trigger, we only clip against it if the flags are aligned*/
+	if (SOLID_ISTRIGGER(touch->v->solid))
+	{
+		if (!(clip->type & MOVE_TRIGGERS))
+			return true;
+		if (!((int)touch->v->flags & FL_FINDABLE_NONSOLID))
+			return true;
+	}
 
-		if (clip->type & MOVE_LAGGED)
-		{
-			//can't touch lagged ents - we do an explicit test for them later.
-			if (touch->entnum-1 < w->maxlagents)
-				if (w->lagents[touch->entnum-1].present)
-					continue;
-		}
+	if (clip->type & MOVE_LAGGED)
+	{
+		//can't touch lagged ents - we do an explicit test for them later.
+		if (touch->entnum-1 < w->maxlagents)
+			if (w->lagents[touch->entnum-1].present)
+				return true;
+	}
 
-		if ((clip->type & MOVE_NOMONSTERS) && (touch->v->solid != SOLID_BSP && touch->v->solid != SOLID_PORTAL))
-			continue;
+	if ((clip->type & MOVE_NOMONSTERS) && (touch->v->solid != SOLID_BSP && touch->v->solid != SOLID_PORTAL))
+		return true;
 
-		if (clip->passedict)
+	if (clip->passedict)
+	{
+		if (w->usesolidcorpse)
 		{
-			if (w->usesolidcorpse)
-			{
 #if 1
 //				if (!(clip->hitcontentsmask & ((touch->v->solid == SOLID_CORPSE)?FTECONTENTS_CORPSE:FTECONTENTS_BODY)))
-//					continue;
+//					return true;
 #else
-				// don't clip corpse against character
-				if (clip->passedict->v->solid == SOLID_CORPSE && (touch->v->solid == SOLID_SLIDEBOX || touch->v->solid == SOLID_CORPSE))
-					continue;
-				// don't clip character against corpse
-				if (clip->passedict->v->solid == SOLID_SLIDEBOX && touch->v->solid == SOLID_CORPSE)
-					continue;
+			// don't clip corpse against character
+			if (clip->passedict->v->solid == SOLID_CORPSE && (touch->v->solid == SOLID_SLIDEBOX || touch->v->solid == SOLID_CORPSE))
+				return true;
+			// don't clip character against corpse
+			if (clip->passedict->v->solid == SOLID_SLIDEBOX && touch->v->solid == SOLID_CORPSE)
+				return true;
 #endif
-			}
-			if (!((int)clip->passedict->xv->dimension_hit & (int)touch->xv->dimension_solid))
-				continue;
 		}
+		if (!((int)clip->passedict->xv->dimension_hit & (int)touch->xv->dimension_solid))
+			return true;
+	}
 
-		if (clip->boxmins[0] > touch->v->absmax[0]
-		|| clip->boxmins[1] > touch->v->absmax[1]
-		|| clip->boxmins[2] > touch->v->absmax[2]
-		|| clip->boxmaxs[0] < touch->v->absmin[0]
-		|| clip->boxmaxs[1] < touch->v->absmin[1]
-		|| clip->boxmaxs[2] < touch->v->absmin[2] )
-			continue;
+	if (clip->boxmins[0] > touch->v->absmax[0]
+	|| clip->boxmins[1] > touch->v->absmax[1]
+	|| clip->boxmins[2] > touch->v->absmax[2]
+	|| clip->boxmaxs[0] < touch->v->absmin[0]
+	|| clip->boxmaxs[1] < touch->v->absmin[1]
+	|| clip->boxmaxs[2] < touch->v->absmin[2] )
+		return true;
 
-		if (clip->passedict && clip->passedict->v->size[0] && !touch->v->size[0])
-			continue;	// points never interact
+	if (clip->passedict && clip->passedict->v->size[0] && !touch->v->size[0])
+		return true;	// points never interact
 
-	// might intersect, so do an exact clip
+// might intersect, so do an exact clip
 //		if (clip->trace.allsolid)
 //			return;
-		if (clip->passedict)
-		{
-		 	if ((wedict_t*)PROG_TO_EDICT(w->progs, touch->v->owner) == clip->passedict)
-				continue;	// don't clip against own missiles
-			if ((wedict_t*)PROG_TO_EDICT(w->progs, clip->passedict->v->owner) == touch)
-				continue;	// don't clip against owner
-		}
+	if (clip->passedict)
+	{
+	 	if ((wedict_t*)PROG_TO_EDICT(w->progs, touch->v->owner) == clip->passedict)
+			return true;	// don't clip against own missiles
+		if ((wedict_t*)PROG_TO_EDICT(w->progs, clip->passedict->v->owner) == touch)
+			return true;	// don't clip against owner
+	}
 
-		if (touch->v->solid == SOLID_PORTAL)
+	if (touch->v->solid == SOLID_PORTAL)
+	{
+		//make sure we don't hit the world if we're inside the portal
+		World_PortalCSG(touch, clip->mins, clip->maxs, clip->start, clip->end, &clip->trace);
+	}
+
+	if ((int)touch->v->flags & FL_MONSTER)
+		trace = World_ClipMoveToEntity (w, touch, touch->v->origin, touch->v->angles, clip->start, clip->mins2, clip->maxs2, clip->end, clip->hullnum, clip->type & MOVE_HITMODEL, clip->capsule, clip->hitcontentsmask);
+	else
+		trace = World_ClipMoveToEntity (w, touch, touch->v->origin, touch->v->angles, clip->start, clip->mins, clip->maxs, clip->end, clip->hullnum, clip->type & MOVE_HITMODEL, clip->capsule, clip->hitcontentsmask);
+
+	if (trace.fraction < clip->trace.fraction)
+	{
+		//trace traveled less, but don't forget if we started in a solid.
+		trace.startsolid |= clip->trace.startsolid;
+		trace.allsolid |= clip->trace.allsolid;
+
+		if (clip->type & MOVE_ENTCHAIN)
 		{
-			//make sure we don't hit the world if we're inside the portal
-			World_PortalCSG(touch, clip->mins, clip->maxs, clip->start, clip->end, &clip->trace);
+			touch->v->chain = EDICT_TO_PROG(w->progs, clip->trace.ent?clip->trace.ent:w->edicts);
+			clip->trace.ent = touch;
 		}
-
-		if ((int)touch->v->flags & FL_MONSTER)
-			trace = World_ClipMoveToEntity (w, touch, touch->v->origin, touch->v->angles, clip->start, clip->mins2, clip->maxs2, clip->end, clip->hullnum, clip->type & MOVE_HITMODEL, clip->capsule, clip->hitcontentsmask);
 		else
-			trace = World_ClipMoveToEntity (w, touch, touch->v->origin, touch->v->angles, clip->start, clip->mins, clip->maxs, clip->end, clip->hullnum, clip->type & MOVE_HITMODEL, clip->capsule, clip->hitcontentsmask);
-
-		if (trace.fraction < clip->trace.fraction)
 		{
-			//trace traveled less, but don't forget if we started in a solid.
-			trace.startsolid |= clip->trace.startsolid;
-			trace.allsolid |= clip->trace.allsolid;
-
-			if (clip->type & MOVE_ENTCHAIN)
-			{
-				touch->v->chain = EDICT_TO_PROG(w->progs, clip->trace.ent?clip->trace.ent:w->edicts);
-				clip->trace.ent = touch;
-			}
+			if (clip->trace.startsolid && !trace.startsolid)
+				trace.ent = clip->trace.ent;	//something else hit earlier, that one gets the trace entity, but not the fraction. yeah, combining traces like this was always going to be weird.
 			else
-			{
-				if (clip->trace.startsolid && !trace.startsolid)
-					trace.ent = clip->trace.ent;	//something else hit earlier, that one gets the trace entity, but not the fraction. yeah, combining traces like this was always going to be weird.
-				else
-					trace.ent = touch;
-				clip->trace = trace;
-			}
+				trace.ent = touch;
+			clip->trace = trace;
 		}
-		else if (trace.startsolid || trace.allsolid)
+	}
+	else if (trace.startsolid || trace.allsolid)
+	{
+		//even if the trace traveled less, we still care if it was in a solid.
+		clip->trace.startsolid |= trace.startsolid;
+		clip->trace.allsolid |= trace.allsolid;
+		clip->trace.contents |= trace.contents;
+		if (!clip->trace.ent || trace.fraction == clip->trace.fraction)	//xonotic requires that second test (DP has no check at all, which would end up reporting mismatched fraction/ent results, so yuck).
 		{
-			//even if the trace traveled less, we still care if it was in a solid.
-			clip->trace.startsolid |= trace.startsolid;
-			clip->trace.allsolid |= trace.allsolid;
-			clip->trace.contents |= trace.contents;
-			if (!clip->trace.ent || trace.fraction == clip->trace.fraction)	//xonotic requires that second test (DP has no check at all, which would end up reporting mismatched fraction/ent results, so yuck).
-			{
-				clip->trace.ent = touch;
-			}
+			clip->trace.ent = touch;
 		}
 	}
+	return true;
+}
+static void World_ClipToLinks (world_t *w, areagridlink_t *node, moveclip_t *clip)
+{
+	link_t		*l, *next;
+	wedict_t		*touch;
+
+// touch linked edicts
+	for (l = node->l.next ; l != &node->l ; l = next)
+	{
+		next = l->next;
+		touch = ((areagridlink_t*)l)->ed;
+
+		if (touch->gridareasequence == areagridsequence)
+			continue;
+		touch->gridareasequence = areagridsequence;
+
+		World_ClipToEdict(w, touch, clip);
+	}
 }
 static void World_ClipToAllLinks (world_t *w, moveclip_t *clip)
 {
 	int ming[2], maxg[2], g[2];
 	areagridsequence++;
+
+	if (w->useareabvh)
+	{	//clip->boxmins/boxmaxs is the whole swept box, which is wasteful for diagonal traces, so walk only the nodes along the actual line.
+		vec3_t emins, emaxs;
+		VectorSet(emins, clip->mins2[0]-1, clip->mins2[1]-1, clip->mins2[2]-1);
+		VectorSet(emaxs, clip->maxs2[0]+1, clip->maxs2[1]+1, clip->maxs2[2]+1);
+		World_AreaBVH_Walk(w, clip->boxmins, clip->boxmaxs, clip->start, clip->end, emins, emaxs, World_ClipToEdict, clip);
+		return;
+	}
+
 	World_ClipToLinks(w, &w->jumboarea, clip);
 
 	CALCAREAGRIDBOUNDS(w, clip->boxmins, clip->boxmaxs);
@@ -1850,15 +2344,87 @@ static void World_ClipToAllLinks (world_t *w, moveclip_t *clip)
 		}
 }
 
-static unsigned int World_ContentsOfLinks (world_t *w, areagridlink_t *node, vec3_t pos)
+struct contentsoflinks_s
 {
-	link_t		*l, *next;
-	wedict_t		*touch;
-
+	float *pos;
+	unsigned int ret;
+};
+static qboolean World_ContentsOfEdict (world_t *w, wedict_t *touch, void *ctx)
+{
+	struct contentsoflinks_s *cl = ctx;
+	float *pos = cl->pos;
 	model_t		*model;
 	int mdlidx;
 	vec3_t pos_l, axis[3];
-	unsigned int ret = 0, c;
+	unsigned int c;
+
+	if (touch->v->solid != SOLID_BSP)
+		return true;
+
+	if (   pos[0] > touch->v->absmax[0]
+		|| pos[1] > touch->v->absmax[1]
+		|| pos[2] > touch->v->absmax[2]
+		|| pos[0] < touch->v->absmin[0]
+		|| pos[1] < touch->v->absmin[1]
+		|| pos[2] < touch->v->absmin[2] )
+		return true;
+
+//		if (touch->v->solid == SOLID_PORTAL)
+//			//FIXME: recurse!
+
+	mdlidx = touch->v->modelindex;
+	if (!mdlidx)
+		return true;
+	model = w->Get_CModel(w, mdlidx);
+	if (!model || (model->type != mod_brush && model->type != mod_heightmap) || model->loadstate != MLS_LOADED)
+		return true;
+
+	VectorSubtract (pos, touch->v->origin, pos_l);
+	if (touch->v->angles[0] || touch->v->angles[1] || touch->v->angles[2])
+	{
+		AngleVectors (touch->v->angles, axis[0], axis[1], axis[2]);
+		VectorNegate(axis[1], axis[1]);
+		c = model->funcs.PointContents(model, axis, pos_l);
+	}
+	else
+		c = model->funcs.PointContents(model, NULL, pos_l);
+
+	if (c && touch->v->skin < 0)
+	{	//if forcedcontents is set, then ALL brushes in this model are forced to the specified contents value.
+		//we achive this by tracing against ALL then forcing it after.
+		unsigned int forcedcontents;
+		safeswitch((enum q1contents_e)(int)touch->v->skin)
+		{
+		case Q1CONTENTS_EMPTY:			forcedcontents = FTECONTENTS_EMPTY;			break;
+		case Q1CONTENTS_SOLID:			forcedcontents = FTECONTENTS_SOLID;			break;
+		case Q1CONTENTS_WATER:			forcedcontents = FTECONTENTS_WATER;			break;
+		case Q1CONTENTS_SLIME:			forcedcontents = FTECONTENTS_SLIME;			break;
+		case Q1CONTENTS_LAVA:			forcedcontents = FTECONTENTS_LAVA;			break;
+		case Q1CONTENTS_SKY:			forcedcontents = FTECONTENTS_SKY;			break;
+		case Q1CONTENTS_CLIP:			forcedcontents = FTECONTENTS_PLAYERCLIP|FTECONTENTS_MONSTERCLIP;	break;
+		case Q1CONTENTS_CURRENT_0:		forcedcontents = FTECONTENTS_WATER|Q2CONTENTS_CURRENT_0;			break;
+		case Q1CONTENTS_CURRENT_90:		forcedcontents = FTECONTENTS_WATER|Q2CONTENTS_CURRENT_90;			break;
+		case Q1CONTENTS_CURRENT_180:	forcedcontents = FTECONTENTS_WATER|Q2CONTENTS_CURRENT_180;			break;
+		case Q1CONTENTS_CURRENT_270:	forcedcontents = FTECONTENTS_WATER|Q2CONTENTS_CURRENT_270;			break;
+		case Q1CONTENTS_CURRENT_UP:		forcedcontents = FTECONTENTS_WATER|Q2CONTENTS_CURRENT_UP;			break;
+		case Q1CONTENTS_CURRENT_DOWN:	forcedcontents = FTECONTENTS_WATER|Q2CONTENTS_CURRENT_DOWN;			break;
+		case Q1CONTENTS_TRANS:			forcedcontents = FTECONTENTS_SOLID;			break;
+		case Q1CONTENTS_LADDER:			forcedcontents = FTECONTENTS_LADDER;		break;
+		case Q1CONTENTS_MONSTERCLIP:	forcedcontents = FTECONTENTS_MONSTERCLIP;	break;
+		case Q1CONTENTS_PLAYERCLIP:		forcedcontents = FTECONTENTS_PLAYERCLIP;	break;
+		case Q1CONTENTS_CORPSE:			forcedcontents = FTECONTENTS_CORPSE;		break;
+		safedefault:					forcedcontents = 0;							break;
+		}
+		c = forcedcontents;
+	}
+	cl->ret |= c;
+	return true;
+}
+static unsigned int World_ContentsOfLinks (world_t *w, areagridlink_t *node, vec3_t pos)
+{
+	link_t		*l, *next;
+	wedict_t		*touch;
+	struct contentsoflinks_s cl = {pos, 0};
 
 // touch linked edicts
 	for (l = node->l.next ; l != &node->l ; l = next)
@@ -1870,74 +2436,21 @@ static unsigned int World_ContentsOfLinks (world_t *w, areagridlink_t *node, vec
 			continue;
 		touch->gridareasequence = areagridsequence;
 
-		if (touch->v->solid != SOLID_BSP)
-			continue;
-
-		if (   pos[0] > touch->v->absmax[0]
-			|| pos[1] > touch->v->absmax[1]
-			|| pos[2] > touch->v->absmax[2]
-			|| pos[0] < touch->v->absmin[0]
-			|| pos[1] < touch->v->absmin[1]
-			|| pos[2] < touch->v->absmin[2] )
-			continue;
-
-//		if (touch->v->solid == SOLID_PORTAL)
-//			//FIXME: recurse!
-
-		mdlidx = touch->v->modelindex;
-		if (!mdlidx)
-			continue;
-		model = w->Get_CModel(w, mdlidx);
-		if (!model || (model->type != mod_brush && model->type != mod_heightmap) || model->loadstate != MLS_LOADED)
-			continue;
-
-		VectorSubtract (pos, touch->v->origin, pos_l);
-		if (touch->v->angles[0] || touch->v->angles[1] || touch->v->angles[2])
-		{
-			AngleVectors (touch->v->angles, axis[0], axis[1], axis[2]);
-			VectorNegate(axis[1], axis[1]);
-			c = model->funcs.PointContents(model, axis, pos_l);
-		}
-		else
-			c = model->funcs.PointContents(model, NULL, pos_l);
-
-		if (c && touch->v->skin < 0)
-		{	//if forcedcontents is set, then ALL brushes in this model are forced to the specified contents value.
-			//we achive this by tracing against ALL then forcing it after.
-			unsigned int forcedcontents;
-			safeswitch((enum q1contents_e)(int)touch->v->skin)
-			{
-			case Q1CONTENTS_EMPTY:			forcedcontents = FTECONTENTS_EMPTY;			break;
-			case Q1CONTENTS_SOLID:			forcedcontents = FTECONTENTS_SOLID;			break;
-			case Q1CONTENTS_WATER:			forcedcontents = FTECONTENTS_WATER;			break;
-			case Q1CONTENTS_SLIME:			forcedcontents = FTECONTENTS_SLIME;			break;
-			case Q1CONTENTS_LAVA:			forcedcontents = FTECONTENTS_LAVA;			break;
-			case Q1CONTENTS_SKY:			forcedcontents = FTECONTENTS_SKY;			break;
-			case Q1CONTENTS_CLIP:			forcedcontents = FTECONTENTS_PLAYERCLIP|FTECONTENTS_MONSTERCLIP;	break;
-			case Q1CONTENTS_CURRENT_0:		forcedcontents = FTECONTENTS_WATER|Q2CONTENTS_CURRENT_0;			break;
-			case Q1CONTENTS_CURRENT_90:		forcedcontents = FTECONTENTS_WATER|Q2CONTENTS_CURRENT_90;			break;
-			case Q1CONTENTS_CURRENT_180:	forcedcontents = FTECONTENTS_WATER|Q2CONTENTS_CURRENT_180;			break;
-			case Q1CONTENTS_CURRENT_270:	forcedcontents = FTECONTENTS_WATER|Q2CONTENTS_CURRENT_270;			break;
-			case Q1CONTENTS_CURRENT_UP:		forcedcontents = FTECONTENTS_WATER|Q2CONTENTS_CURRENT_UP;			break;
-			case Q1CONTENTS_CURRENT_DOWN:	forcedcontents = FTECONTENTS_WATER|Q2CONTENTS_CURRENT_DOWN;			break;
-			case Q1CONTENTS_TRANS:			forcedcontents = FTECONTENTS_SOLID;			break;
-			case Q1CONTENTS_LADDER:			forcedcontents = FTECONTENTS_LADDER;		break;
-			case Q1CONTENTS_MONSTERCLIP:	forcedcontents = FTECONTENTS_MONSTERCLIP;	break;
-			case Q1CONTENTS_PLAYERCLIP:		forcedcontents = FTECONTENTS_PLAYERCLIP;	break;
-			case Q1CONTENTS_CORPSE:			forcedcontents = FTECONTENTS_CORPSE;		break;
-			safedefault:					forcedcontents = 0;							break;
-			}
-			c = forcedcontents;
-		}
-		ret |= c;
+		World_ContentsOfEdict(w, touch, &cl);
 	}
-	return ret;
+	return cl.ret;
 }
 static unsigned int World_ContentsOfAllLinks (world_t *w, vec3_t pos)
 {
 	int ming[2], maxg[2], g[2];
 	unsigned int ret;
 	areagridsequence++;
+	if (w->useareabvh)
+	{
+		struct contentsoflinks_s cl = {pos, 0};
+		World_AreaBVH_Walk(w, pos, pos, NULL, NULL, NULL, NULL, World_ContentsOfEdict, &cl);
+		return cl.ret;
+	}
 	ret = World_ContentsOfLinks(w, &w->jumboarea, pos);
 
 	CALCAREAGRIDBOUNDS(w, pos, pos);
@@ -2393,13 +2906,12 @@ qboolean SV_AntiKnockBack(world_t *w, client_t *client)
 SV_Move
 ==================
 */
-trace_t World_Move (world_t *w, vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, int type, wedict_t *passedict)
+//works out the hull and contents that traces from passedict should use.
+static int World_MoveSetup (world_t *w, moveclip_t *clip, vec3_t mins, vec3_t maxs, int type, wedict_t *passedict)
 {
-	moveclip_t	clip;
-	int			i;
 	int hullnum;
 
-	memset ( &clip, 0, sizeof ( moveclip_t ) );
+	memset ( clip, 0, sizeof ( moveclip_t ) );
 
 	if (passedict->xv->hull && !(type & MOVE_IGNOREHULL))
 		hullnum = passedict->xv->hull;
@@ -2411,6 +2923,7 @@ trace_t World_Move (world_t *w, vec3_t start, vec3_t mins, vec3_t maxs, vec3_t e
 		hullnum = 0;
 	else
 	{
+		int i;
 		int diff;
 		int best;
 		hullnum = 0;
@@ -2436,24 +2949,8 @@ trace_t World_Move (world_t *w, vec3_t start, vec3_t mins, vec3_t maxs, vec3_t e
 	}
 #endif
 
-#if !defined(CLIENTONLY)
-	//figure out where the firing player was, and re-run their input frames to calculate their position without any velocity/knockback changes.
-	//then update the start position to compensate.
-	if ((clip.type & MOVE_LAGGED) && w == &sv.world && passedict->entnum && passedict->entnum <= sv.allocated_client_slots && sv_antilag.ival==3)
-	{
-		vec3_t nudge;
-		if (SV_AntiKnockBack(w, &svs.clients[passedict->entnum-1]))
-		{
-			VectorSubtract(pmove.origin, passedict->v->origin, nudge);
-
-			VectorAdd(start, nudge, start);
-			VectorAdd(end, nudge, end);
-		}
-	}
-#endif
-
 	if (passedict->xv->hitcontentsmaski)
-		clip.hitcontentsmask = passedict->xv->hitcontentsmaski;
+		clip->hitcontentsmask = passedict->xv->hitcontentsmaski;
 #ifdef HAVE_LEGACY
 	else if (passedict->xv->dphitcontentsmask)
 	{
@@ -2485,29 +2982,55 @@ trace_t World_Move (world_t *w, vec3_t start, vec3_t mins, vec3_t maxs, vec3_t e
 //		if (fl & DPCONTENTS_OPAQUE)
 //			nm |= DPCONTENTS_OPAQUE;
 
-		clip.hitcontentsmask = nm;
+		clip->hitcontentsmask = nm;
 	}
 #endif
 /*#ifdef HAVE_LEGACY
 	else if (passedict->xv->hitcontentsmask)
-		clip.hitcontentsmask = passedict->xv->hitcontentsmask;
+		clip->hitcontentsmask = passedict->xv->hitcontentsmask;
 #endif*/
 	else if (passedict->v->solid == SOLID_SLIDEBOX)
 	{
 		if ((int)passedict->v->flags & FL_MONSTER)
-			clip.hitcontentsmask = FTECONTENTS_SOLID|Q2CONTENTS_WINDOW | FTECONTENTS_BODY | FTECONTENTS_MONSTERCLIP; /*solid only to world*/
+			clip->hitcontentsmask = FTECONTENTS_SOLID|Q2CONTENTS_WINDOW | FTECONTENTS_BODY | FTECONTENTS_MONSTERCLIP; /*solid only to world*/
 		else if (maxs[0] - mins[0] > 0)
-			clip.hitcontentsmask = FTECONTENTS_SOLID|Q2CONTENTS_WINDOW | FTECONTENTS_BODY | FTECONTENTS_PLAYERCLIP;	/*impacts playerclip*/
+			clip->hitcontentsmask = FTECONTENTS_SOLID|Q2CONTENTS_WINDOW | FTECONTENTS_BODY | FTECONTENTS_PLAYERCLIP;	/*impacts playerclip*/
 		else
-			clip.hitcontentsmask = FTECONTENTS_SOLID|Q2CONTENTS_WINDOW | FTECONTENTS_BODY;	//slidebox passes through corpses
+			clip->hitcontentsmask = FTECONTENTS_SOLID|Q2CONTENTS_WINDOW | FTECONTENTS_BODY;	//slidebox passes through corpses
 	}
 	else if (passedict->v->solid == SOLID_CORPSE)
-		clip.hitcontentsmask = FTECONTENTS_SOLID|Q2CONTENTS_WINDOW | FTECONTENTS_BODY;	//corpses ignore corpses
+		clip->hitcontentsmask = FTECONTENTS_SOLID|Q2CONTENTS_WINDOW | FTECONTENTS_BODY;	//corpses ignore corpses
 	else if (passedict->v->solid == SOLID_TRIGGER||passedict->v->solid == SOLID_BSPTRIGGER)
-		clip.hitcontentsmask = FTECONTENTS_SOLID|Q2CONTENTS_WINDOW | FTECONTENTS_BODY;	//triggers ignore corpses too, apparently
+		clip->hitcontentsmask = FTECONTENTS_SOLID|Q2CONTENTS_WINDOW | FTECONTENTS_BODY;	//triggers ignore corpses too, apparently
 	else
-		clip.hitcontentsmask = FTECONTENTS_SOLID|Q2CONTENTS_WINDOW | FTECONTENTS_BODY | FTECONTENTS_CORPSE; //regular projectiles.
-	clip.capsule = (passedict->xv->geomtype == GEOMTYPE_CAPSULE);
+		clip->hitcontentsmask = FTECONTENTS_SOLID|Q2CONTENTS_WINDOW | FTECONTENTS_BODY | FTECONTENTS_CORPSE; //regular projectiles.
+	clip->capsule = (passedict->xv->geomtype == GEOMTYPE_CAPSULE);
+	return hullnum;
+}
+
+trace_t World_Move (world_t *w, vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, int type, wedict_t *passedict)
+{
+	moveclip_t	clip;
+	int			i;
+	int hullnum;
+
+	hullnum = World_MoveSetup(w, &clip, mins, maxs, type, passedict);
+
+#if !defined(CLIENTONLY)
+	//figure out where the firing player was, and re-run their input frames to calculate their position without any velocity/knockback changes.
+	//then update the start position to compensate.
+	if ((clip.type & MOVE_LAGGED) && w == &sv.world && passedict->entnum && passedict->entnum <= sv.allocated_client_slots && sv_antilag.ival==3)
+	{
+		vec3_t nudge;
+		if (SV_AntiKnockBack(w, &svs.clients[passedict->entnum-1]))
+		{
+			VectorSubtract(pmove.origin, passedict->v->origin, nudge);
+
+			VectorAdd(start, nudge, start);
+			VectorAdd(end, nudge, end);
+		}
+	}
+#endif
 
 	if (type & MOVE_OTHERONLY)
 	{
@@ -2726,6 +3249,97 @@ trace_t World_Move (world_t *w, vec3_t start, vec3_t mins, vec3_t maxs, vec3_t e
 
 	return clip.trace;
 }
+
+/*
+==================
+World_MoveList
+
+Traces lots of lines/boxes that share the same size/type/passedict, like shotgun pellets or a batch of line-of-sight checks.
+The entities that any of them might hit are found with a single broadphase query instead of one per trace.
+Types that need special handling just fall back to World_Move.
+==================
+*/
+void World_MoveList (world_t *w, size_t count, vec3_t *starts, vec3_t *ends, vec3_t mins, vec3_t maxs, int type, wedict_t *passedict, trace_t *results)
+{
+	size_t		i;
+#ifdef USEAREAGRID
+	moveclip_t	clip;
+	int			hullnum, j, numtouch = 0;
+	wedict_t	**touch = NULL;
+	vec3_t		boxmins, boxmaxs;
+	qboolean	batch = count > 1, worldonly;
+
+	if (type & (MOVE_LAGGED|MOVE_EVERYTHING|MOVE_ENTCHAIN|MOVE_OTHERONLY))
+		batch = false;	//these are all a bit too weird.
+	if ((type&MOVE_WORLDONLY) == MOVE_WORLDONLY)
+		batch = false;
+#if defined(HAVE_CLIENT) && defined(CSQC_DAT)
+	{
+		extern world_t csqc_world;
+		if (w == &csqc_world)
+			batch = false;	//needs to check the network ents too
+	}
+#endif
+
+	if (batch)
+	{
+		hullnum = World_MoveSetup(w, &clip, mins, maxs, type, passedict);
+		clip.mins = mins;
+		clip.maxs = maxs;
+		clip.type = type;
+		clip.passedict = (passedict!=w->edicts)?passedict:NULL;
+		clip.hullnum = 0;	//see World_Move
+		if (type & MOVE_MISSILE)
+		{
+			VectorSet(clip.mins2, -15, -15, -15);
+			VectorSet(clip.maxs2, 15, 15, 15);
+		}
+		else
+		{
+			VectorCopy (mins, clip.mins2);
+			VectorCopy (maxs, clip.maxs2);
+		}
+
+		worldonly = (type & MOVE_MISSILE) && (type & MOVE_NOMONSTERS);	//dp compat, see World_Move
+		if (!worldonly)
+		{
+			//find everything any of the traces could touch, in one go.
+			World_MoveBounds (starts[0], clip.mins2, clip.maxs2, ends[0], boxmins, boxmaxs);
+			for (i = 1; i < count; i++)
+			{
+				World_MoveBounds (starts[i], clip.mins2, clip.maxs2, ends[i], clip.boxmins, clip.boxmaxs);
+				AddPointToBounds(clip.boxmins, boxmins, boxmaxs);
+				AddPointToBounds(clip.boxmaxs, boxmins, boxmaxs);
+			}
+			touch = BZ_Malloc(sizeof(*touch)*w->num_edicts);
+			numtouch = World_AreaEdicts(w, boxmins, boxmaxs, touch, w->num_edicts, AREA_ALL);
+		}
+
+		for (i = 0; i < count; i++)
+		{
+			clip.start = starts[i];
+			clip.end = ends[i];
+			clip.trace = World_ClipMoveToEntity (w, w->edicts, w->edicts->v->origin, w->edicts->v->angles, clip.start, mins, maxs, clip.end, hullnum, false, clip.capsule, clip.hitcontentsmask);
+			if (!worldonly)
+			{
+				World_MoveBounds (clip.start, clip.mins2, clip.maxs2, clip.end, clip.boxmins, clip.boxmaxs);
+				for (j = 0; j < numtouch; j++)
+					World_ClipToEdict(w, touch[j], &clip);
+				areagridsequence++;
+				World_ClipToLinks(w, &w->portallist, &clip);
+			}
+			results[i] = clip.trace;
+		}
+
+		BZ_Free(touch);
+		return;
+	}
+#endif
+
+	for (i = 0; i < count; i++)
+		results[i] = World_Move(w, starts[i], mins, maxs, ends[i], type, passedict);
+}
+
 #ifdef Q2SERVER
 trace_t WorldQ2_Move (world_t *w, vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, int hitcontentsmask, q2edict_t *passedict)
 {
@@ -2825,6 +3439,7 @@ void World_Destroy(world_t *world)
 
 #ifdef USEAREAGRID
 	Z_Free(world->gridareas);
+	BZ_Free(world->areabvh.nodes);
 #else
 	Z_Free(world->areanodes);
 	world->areanodes = NULL;
@@ -28,6 +28,8 @@ typedef struct
 	unsigned int interlaceline;
 	unsigned int interlacemod;
 	unsigned int threadnum;	//for relocating viewport info
+	unsigned int tilex0, tiley0;	//the scissor rect of the tile currently being rendered
+	unsigned int tilex1, tiley1;
 	unsigned int *vpdbuf;
 	unsigned int *vpcbuf;
 	unsigned int vpwidth;
@@ -41,6 +43,7 @@ typedef struct
 {
 	int scoord[2];
 	float zicoord;
+	float oow;		//1/w, for perspective correction. only valid once projected.
 	vec4_t vcoord;
 	vec2_t tccoord;
 	vec2_t lmcoord;
@@ -48,6 +51,46 @@ typedef struct
 	unsigned int clipflags;	/*1=left,2=right,4=top,8=bottom,16=near*/
 } swvert_t;
 
+//the front end bins its clipped triangles into screen tiles, and the span threads then render whole tiles each.
+#define SWTILE_SIZE 64			//tiles are square
+#define SWBIN_MAXTRIS 32768		//triangles that can be binned before they must be flushed
+
+typedef struct
+{
+	swimage_t *img;
+	swvert_t v[3];
+} swbintri_t;
+
+typedef struct
+{
+	unsigned int *tris;		//indexes into swbins_t::tris, in submission order
+	unsigned int numtris;
+	unsigned int maxtris;
+} swtile_t;
+
+typedef struct swbins_s
+{
+	//the viewport that the binned triangles are to be rendered into
+	unsigned int *vpdbuf;
+	unsigned int *vpcbuf;
+	unsigned int vpwidth;
+	unsigned int vpheight;
+	qintptr_t vpcstride;
+	unsigned int interlaceline;
+	unsigned int interlacemod;
+	qboolean cleardepth;
+	qboolean clearcolour;
+
+	unsigned int tilesx;
+	unsigned int tilesy;
+	unsigned int maxtiles;
+	swtile_t *tiles;
+	volatile qatomic32_t nexttile;	//workers claim tiles from this until they run out
+
+	unsigned int numtris;
+	swbintri_t *tris;
+} swbins_t;
+
 #define WQ_SIZE 1024*1024*8
 #define WQ_MASK (WQ_SIZE-1)
 #define WQ_MAXTHREADS 64
@@ -60,6 +103,7 @@ struct workqueue_s
 	swthread_t swthreads[WQ_MAXTHREADS];
 };
 extern struct workqueue_s commandqueue;
+extern struct workqueue_s spanqueue;
 
 
 
@@ -134,7 +178,8 @@ typedef union
 	} uniforms;
 	struct
 	{
-		int foo;
+		struct wqcom_s com;
+		swbins_t *bins;
 	} spans;
 } wqcom_t;
 
@@ -143,6 +188,7 @@ typedef union
 void SWRast_EndCommand(struct workqueue_s *wq, wqcom_t *com);
 wqcom_t *SWRast_BeginCommand(struct workqueue_s *wq, int cmdtype, unsigned int size);
 void SWRast_Sync(struct workqueue_s *wq);
+void SWRast_Wait(struct workqueue_s *wq);
 
 
 
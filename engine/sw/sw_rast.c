@@ -23,12 +23,16 @@ main thread builds command:
 	command contains vertex data in the command block
 	main thread runs the vertex programs (much like q3) and performs matrix transforms (much like d3d)
 
-worker threads read each command sequentially:
+the front end (sw_vthread, or the main thread) reads each command sequentially:
 	clip to viewport
+	bin the resulting screen-space triangles into SWTILE_SIZE tiles
 
-division of labour between worker threads works by interlacing.
-each thread gets a different set of scanlines to render.
-we can also trivially implement interlacing with this method
+when the bins fill up, the viewport changes, or we sync, the bins are flushed:
+	the span threads (sw_fthreads) and the front end claim whole tiles from a shared counter until there are none left
+	each tile is cleared and then has its triangles drawn in submission order, scissored to the tile.
+	no two threads ever touch the same pixels, so there's no locking, and a thread that finishes early just takes another tile.
+
+interlacing (sw_interlace) just skips scanlines within each tile.
 
 */
 
@@ -38,36 +42,126 @@ cvar_t sw_fthreads = CVAR("sw_fthreads", "0");
 
 struct workqueue_s commandqueue;
 struct workqueue_s spanqueue;
+static swbins_t swbins;	//only the front end writes to this
 
-static void WT_Triangle(swthread_t *th, swimage_t *img, swvert_t *v1, swvert_t *v2, swvert_t *v3)
-{
-	//affine vs correct:
-	//to correct perspective, divide interpolants by z.
-	//per pixel, divide by interpolated 1 (actually 1/z)
+static void WT_BinTriangle(swthread_t *th, swimage_t *img, swvert_t *v1, swvert_t *v2, swvert_t *v3);
 
-	unsigned int tpix;
-#if 1
-	#define PERSPECTIVE(v) (v>>16)
-#else
-	#define PERSPECTIVE(v) (v/zi)
-	#define SPAN_ZI
+#if defined(__AVX2__)
+	#define SW_AVX2
+	#include <immintrin.h>
 #endif
-#define SPAN_ST
 
-#define SPAN_Z
+#define SPAN_BLOCKSHIFT 3
+#define SPAN_BLOCK (1<<SPAN_BLOCKSHIFT)	//perspective is corrected at the edges of each block of this many pixels, and is affine within it.
+
+//converts a perspective-divided coord to 16.16, wrapping instead of overflowing.
+#define SPAN_FIXED(f) ((unsigned int)(long long)((f)*65536.0f))
+
+//draws a depth-tested, alpha-tested, textured span, dividing out the perspective once per block.
+static void WT_PerspectiveSpan(const swimage_t *img, unsigned int *restrict outbuf, unsigned int *restrict zb, int count, float q, float sq, float tq, float qd, float sqd, float tqd, unsigned int z, int zd)
+{
+	float w = 1/q;
+	unsigned int s = SPAN_FIXED(sq*w), ns;
+	unsigned int t = SPAN_FIXED(tq*w), nt;
+	int sd, td;
+	int n;
+#ifdef SW_AVX2
+	//a block is exactly one vector, with partial blocks masked.
+	const __m256i signbit = _mm256_set1_epi32(0x80000000);
+	const __m256i alphabits = _mm256_set1_epi32(0xff000000);
+	const __m256i wmask = _mm256_set1_epi32(img->pwidthmask);
+	const __m256i hmask = _mm256_set1_epi32(img->pheightmask);
+	const __m256i pitch = _mm256_set1_epi32(img->pitch);
+	const __m256i ramp = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	const __m256i zramp = _mm256_mullo_epi32(_mm256_set1_epi32(zd), ramp);
+	__m256i lanes, z8, s8, t8, pass, tex, draw;
+#else
+	unsigned int tpix;
 #define PLOT_PIXEL(o) \
 	{	\
 		if (*zb >= z)	\
 		{	\
 			*zb = z;	\
-		tpix = img->data[	\
-					((unsigned)PERSPECTIVE(s)&img->pwidthmask)	\
-					+ (((unsigned)PERSPECTIVE(t)&img->pheightmask) * img->pitch)	\
+			tpix = img->data[	\
+					((s>>16)&img->pwidthmask)	\
+					+ (((t>>16)&img->pheightmask) * img->pitch)	\
 				];	\
-		if (tpix&0xff000000) \
-			o = tpix; \
+			if (tpix&0xff000000) \
+				o = tpix; \
 		}	\
 	}
+#endif
+
+	while (count > 0)
+	{
+		n = (count > SPAN_BLOCK)?SPAN_BLOCK:count;
+		q += qd*n;
+		sq += sqd*n;
+		tq += tqd*n;
+		w = 1/q;
+		ns = SPAN_FIXED(sq*w);
+		nt = SPAN_FIXED(tq*w);
+		if (n == SPAN_BLOCK)
+		{	//avoid the integer divide for full blocks
+			sd = (int)(ns-s)>>SPAN_BLOCKSHIFT;
+			td = (int)(nt-t)>>SPAN_BLOCKSHIFT;
+		}
+		else
+		{
+			sd = (int)(ns-s)/n;
+			td = (int)(nt-t)/n;
+		}
+		count -= n;
+
+#ifdef SW_AVX2
+		lanes = _mm256_cmpgt_epi32(_mm256_set1_epi32(n), ramp);
+		z8 = _mm256_add_epi32(_mm256_set1_epi32(z), zramp);
+		//avx2 only has signed compares, so bias both sides. passes when *zb >= z.
+		pass = _mm256_andnot_si256(_mm256_cmpgt_epi32(_mm256_xor_si256(z8, signbit), _mm256_xor_si256(_mm256_maskload_epi32((const int*)zb, lanes), signbit)), lanes);
+		if (!_mm256_testz_si256(pass, pass))
+		{
+			_mm256_maskstore_epi32((int*)zb, pass, z8);
+
+			s8 = _mm256_add_epi32(_mm256_set1_epi32(s), _mm256_mullo_epi32(_mm256_set1_epi32(sd), ramp));
+			t8 = _mm256_add_epi32(_mm256_set1_epi32(t), _mm256_mullo_epi32(_mm256_set1_epi32(td), ramp));
+			s8 = _mm256_and_si256(_mm256_srli_epi32(s8, 16), wmask);
+			t8 = _mm256_and_si256(_mm256_srli_epi32(t8, 16), hmask);
+			tex = _mm256_i32gather_epi32((const int*)img->data, _mm256_add_epi32(s8, _mm256_mullo_epi32(t8, pitch)), 4);
+
+			//only write texels that passed the depth test and have some alpha
+			draw = _mm256_andnot_si256(_mm256_cmpeq_epi32(_mm256_and_si256(tex, alphabits), _mm256_setzero_si256()), pass);
+			_mm256_maskstore_epi32((int*)outbuf, draw, tex);
+		}
+		outbuf += n;
+		zb += n;
+		z += zd*n;
+#else
+		while(n-->0)
+		{
+			PLOT_PIXEL(*outbuf);
+			outbuf++;
+			zb++;
+			s += sd;
+			t += td;
+			z += zd;
+		}
+#endif
+		s = ns;
+		t = nt;
+	}
+#undef PLOT_PIXEL
+}
+
+static void WT_Triangle(swthread_t *th, swimage_t *img, swvert_t *v1, swvert_t *v2, swvert_t *v3)
+{
+	//affine vs correct:
+	//to correct perspective, divide interpolants by z.
+	//per pixel, divide by interpolated 1 (actually 1/z)
+
+	//we interpolate s/w, t/w and 1/w across the triangle, and only divide them out at the edges of each span block.
+#define SPAN_STQ
+
+#define SPAN_Z
 
 #ifdef MSVCWORKSPROPERLY
 #include "sw_spans.h"
@@ -79,6 +173,7 @@ to define create a new pixel shader, define PLOT_PIXEL(outval) at the top of you
 //modifiers:
 SPAN_ST - interpolates S+T across the span. access with 'sc' and 'tc'
 		affine... no perspective correction.
+SPAN_STQ - interpolates S+T across the span, perspective-correct per SPAN_BLOCK pixels. requires SPAN_Z, and ignores PLOT_PIXEL.
 
 
 */
@@ -96,6 +191,13 @@ SPAN_ST - interpolates S+T across the span. access with 'sc' and 'tc'
 	int sl,sld, sd;
 	int tl,tld, td;
 #endif
+#ifdef SPAN_STQ
+	//these are plane equations relative to v1, rather than walked along the edges
+	float q1, qdx, qdy;
+	float sq1, sqdx, sqdy;
+	float tq1, tqdx, tqdy;
+	float fx, fy;
+#endif
 #ifdef SPAN_ZI
 	int zil, zild, zid;
 #endif
@@ -108,10 +210,9 @@ SPAN_ST - interpolates S+T across the span. access with 'sc' and 'tc'
 	const swvert_t *vlt,*vlb,*vrt,*vrb;
 	int spanlen;
 	int numspans;
-	unsigned int *vplout;
 	int dx, dy;
 	int recalcside;
-	int interlace;
+	int row, rowend;
 
 	float fdx1,fdy1,fdx2,fdy2,fz,d1,d2;
 
@@ -198,6 +299,25 @@ SPAN_ST - interpolates S+T across the span. access with 'sc' and 'tc'
 	tld = fdx1*d2 - fdx2*d1;
 	td = fdy2*d1 - fdy1*d2;
 #endif
+#ifdef SPAN_STQ
+	q1 = v1->oow;
+	d1 = v2->oow - q1;
+	d2 = v3->oow - q1;
+	qdy = fdx1*d2 - fdx2*d1;
+	qdx = fdy2*d1 - fdy1*d2;
+
+	sq1 = v1->tccoord[0] * img->pwidth * v1->oow;
+	d1 = v2->tccoord[0] * img->pwidth * v2->oow - sq1;
+	d2 = v3->tccoord[0] * img->pwidth * v3->oow - sq1;
+	sqdy = fdx1*d2 - fdx2*d1;
+	sqdx = fdy2*d1 - fdy1*d2;
+
+	tq1 = v1->tccoord[1] * img->pheight * v1->oow;
+	d1 = v2->tccoord[1] * img->pheight * v2->oow - tq1;
+	d2 = v3->tccoord[1] * img->pheight * v3->oow - tq1;
+	tqdy = fdx1*d2 - fdx2*d1;
+	tqdx = fdy2*d1 - fdy1*d2;
+#endif
 #ifdef SPAN_ZI
 	d1 = (1<<16);
 	d2 = (1<<16);
@@ -219,29 +339,6 @@ SPAN_ST - interpolates S+T across the span. access with 'sc' and 'tc'
 	{
 		if (secondhalf)
 		{
-		//	return;
-			if (numspans < 0)
-			{
-				interlace = -numspans;
-				y+=interlace;
-				numspans-=interlace;
-
-				xl += xld*interlace;
-				xr += xrd*interlace;
-				vplout += th->vpcstride*interlace;
-
-#ifdef SPAN_ST
-				sl += sld*interlace;
-				tl += tld*interlace;
-#endif
-#ifdef SPAN_ZI
-				zil += zild*interlace;
-#endif
-#ifdef SPAN_Z
-				zl += zld*interlace;
-#endif
-			}
-
 			/*v2->v3*/
 			if (fz <= 0)
 			{
@@ -334,80 +431,71 @@ SPAN_ST - interpolates S+T across the span. access with 'sc' and 'tc'
 			xr = (int)vrt->scoord[0]<<16;
 		}
 
-		if (y + numspans > th->vpheight)
-			numspans = th->vpheight - y;
-
 		if (numspans <= 0)
 			continue;
 
+		//only rows inside our tile (and interlace field) get drawn. the rest of the rows are just stepped over.
+		row = y;
+		if (row < (int)th->tiley0)
+			row = th->tiley0;
+		row += (th->interlacemod - ((row + th->interlaceline) % th->interlacemod)) % th->interlacemod;
+		rowend = y + numspans;
+		if (rowend > (int)th->tiley1)
+			rowend = th->tiley1;
 
-		vplout = th->vpcbuf + y * th->vpcstride;	//this is a pointer to the left of the viewport buffer.
-
-		interlace = ((y + th->interlaceline) % th->interlacemod);
-		if (interlace)
+		for (; row < rowend; row += th->interlacemod)
 		{
-			if (interlace > numspans)
-			{
-				interlace = numspans;
-				y+=interlace;
-			}
-			else
-			{
-				y+=interlace;
-				numspans-=interlace;
-			}
-			xl += xld*interlace;
-			xr += xrd*interlace;
-			vplout += th->vpcstride*interlace;
-
+			int n = row - y;
+			int x0 = (xl + xld*n)>>16;
+			int x1 = x0 + ((xr + xrd*n - (xl + xld*n))>>16);
 #ifdef SPAN_ST
-			sl += sld*interlace;
-			tl += tld*interlace;
+			unsigned int s = sl + sld*n;
+			unsigned int t = tl + tld*n;
 #endif
 #ifdef SPAN_ZI
-			zil += zild*interlace;
+			unsigned int zi = zil + zild*n;
+#else
+			const unsigned int zi = (1<<16);
 #endif
 #ifdef SPAN_Z
-			zl += zld*interlace;
+			unsigned int z = zl + zld*n;
+			unsigned int *restrict zb;
 #endif
-		}
-
-		for (; numspans > 0; 
-			numspans -= th->interlacemod
-			,xl += xld*th->interlacemod
-			,xr += xrd*th->interlacemod
-			,vplout += th->vpcstride*th->interlacemod
-			,y += th->interlacemod
 
+			//clip the span to the tile
+			if (x1 > (int)th->tilex1)
+				x1 = th->tilex1;
+			if (x0 < (int)th->tilex0)
+			{
+				n = th->tilex0 - x0;
+				x0 = th->tilex0;
 #ifdef SPAN_ST
-			,sl += sld*th->interlacemod
-			,tl += tld*th->interlacemod
+				s += sd*n;
+				t += td*n;
 #endif
 #ifdef SPAN_ZI
-			,zil += zild*th->interlacemod
+				zi += zid*n;
 #endif
 #ifdef SPAN_Z
-			,zl += zld*th->interlacemod
-#endif
-			)
-		{
-#ifdef SPAN_ST
-			unsigned int s = sl;
-			unsigned int t = tl;
-#endif
-#ifdef SPAN_ZI
-			unsigned int zi = zil;
-#else
-			const unsigned int zi = (1<<16);
+				z += zd*n;
 #endif
+			}
+
+			spanlen = x1 - x0;
+			outbuf = th->vpcbuf + row * th->vpcstride + x0;
 #ifdef SPAN_Z
-			unsigned int z = zl;
-			unsigned int *restrict zb = th->vpdbuf + y * th->vpwidth + (xl>>16);
+			zb = th->vpdbuf + row * th->vpwidth + x0;
 #endif
 
-			spanlen = (xr - xl)>>16;
-			outbuf = vplout + (xl>>16);
-
+#ifdef SPAN_STQ
+			if (spanlen <= 0)
+				continue;
+			fx = x0 - v1->scoord[0];
+			fy = row - v1->scoord[1];
+			WT_PerspectiveSpan(img, outbuf, zb, spanlen,
+					q1 + fx*qdx + fy*qdy, sq1 + fx*sqdx + fy*sqdy, tq1 + fx*tqdx + fy*tqdy,
+					qdx, sqdx, tqdx, z, zd);
+#else
 			while(spanlen-->0)
 			{
 				PLOT_PIXEL(*outbuf);
@@ -425,55 +513,74 @@ SPAN_ST - interpolates S+T across the span. access with 'sc' and 'tc'
 				zb++;
 #endif
 			}
+#endif
 		}
+
+		//step the edges down to where the next half starts
+		y += numspans;
+		xl += xld*numspans;
+		xr += xrd*numspans;
+#ifdef SPAN_ST
+		sl += sld*numspans;
+		tl += tld*numspans;
+#endif
+#ifdef SPAN_ZI
+		zil += zild*numspans;
+#endif
+#ifdef SPAN_Z
+		zl += zld*numspans;
+#endif
 	}
 }
 
 #undef SPAN_ST
+#undef SPAN_STQ
+#undef SPAN_Z
 #undef PLOT_PIXEL
 #endif
 	
 }
 
+//screen-space clipping. 1/w is linear in screen space, but texture coords are only linear once they've been divided by w.
+static void WT_Clip_Screen(swvert_t *out, swvert_t *in, float frac, swvert_t *result)
+{
+	Vector2Interpolate(in->scoord, frac, out->scoord, result->scoord);
+	FloatInterpolate(in->zicoord, frac, out->zicoord, result->zicoord);
+	FloatInterpolate(in->oow, frac, out->oow, result->oow);
+	result->tccoord[0] = (in->tccoord[0]*in->oow + (out->tccoord[0]*out->oow - in->tccoord[0]*in->oow)*frac) / result->oow;
+	result->tccoord[1] = (in->tccoord[1]*in->oow + (out->tccoord[1]*out->oow - in->tccoord[1]*in->oow)*frac) / result->oow;
+}
 static void WT_Clip_Top(swthread_t *th, swvert_t *out, swvert_t *in, swvert_t *result)
 {
 	float frac;
 	frac =	(0 - in->scoord[1]) /
 			(float)(out->scoord[1] - in->scoord[1]);
-	Vector2Interpolate(in->scoord, frac, out->scoord, result->scoord);
-	FloatInterpolate(in->zicoord, frac, out->zicoord, result->zicoord);
+	WT_Clip_Screen(out, in, frac, result);
 	result->scoord[1] = 0;
-	Vector2Interpolate(in->tccoord, frac, out->tccoord, result->tccoord);
 }
 static void WT_Clip_Bottom(swthread_t *th, swvert_t *out, swvert_t *in, swvert_t *result)
 {
 	float frac;
 	frac =	((th->vpheight) - in->scoord[1]) /
 			(float)(out->scoord[1] - in->scoord[1]);
-	Vector2Interpolate(in->scoord, frac, out->scoord, result->scoord);
-	FloatInterpolate(in->zicoord, frac, out->zicoord, result->zicoord);
+	WT_Clip_Screen(out, in, frac, result);
 	result->scoord[1] = th->vpheight;
-	Vector2Interpolate(in->tccoord, frac, out->tccoord, result->tccoord);
 }
 static void WT_Clip_Left(swthread_t *th, swvert_t *out, swvert_t *in, swvert_t *result)
 {
 	float frac;
 	frac =	(0 - in->scoord[0]) /
 			(float)(out->scoord[0] - in->scoord[0]);
-	Vector2Interpolate(in->scoord, frac, out->scoord, result->scoord);
-	FloatInterpolate(in->zicoord, frac, out->zicoord, result->zicoord);
+	WT_Clip_Screen(out, in, frac, result);
 	result->scoord[0] = 0;
-	Vector2Interpolate(in->tccoord, frac, out->tccoord, result->tccoord);
 }
 static void WT_Clip_Right(swthread_t *th, swvert_t *out, swvert_t *in, swvert_t *result)
 {
 	float frac;
 	frac =	((th->vpwidth) - in->scoord[0]) /
 			(float)(out->scoord[0] - in->scoord[0]);
-	Vector2Interpolate(in->scoord, frac, out->scoord, result->scoord);
-	FloatInterpolate(in->zicoord, frac, out->zicoord, result->zicoord);
+	WT_Clip_Screen(out, in, frac, result);
 	result->scoord[0] = th->vpwidth;
-	Vector2Interpolate(in->tccoord, frac, out->tccoord, result->tccoord);
 }
 static void WT_Clip_Near(swthread_t *th, swvert_t *out, swvert_t *in, swvert_t *result)
 {
@@ -560,6 +667,7 @@ static int WT_TransformVertXY(swthread_t *th, swvert_t *v)
 		tr[1] /= tr[3];
 		tr[2] /= tr[3];
 	}
+	v->oow = (tr[3] > 0)?1/tr[3]:1;
 
 	v->scoord[0] = (tr[0]+1)/2 * th->vpwidth;
 	if (v->scoord[0] < 0)
@@ -654,23 +762,27 @@ static void WT_ClipTriangle(swthread_t *th, swimage_t *img, swvert_t *v1, swvert
 		list ^= 1;
 	}
 
-	//draw the damn thing. FIXME: generate spans and push to a fragment thread.
+	//bin the damn thing, the span threads will draw it later.
 	for (i = 2; i < count; i++)
 	{
-		WT_Triangle(th, img, &final[list][0], &final[list][i-1], &final[list][i]);
+		WT_BinTriangle(th, img, &final[list][0], &final[list][i-1], &final[list][i]);
 	}
 }
 
+//clears the current tile
 void WQ_ClearBuffer(swthread_t *t, unsigned int *mbuf, qintptr_t stride, unsigned int clearval)
 {
 	int y;
 	int x;
 	unsigned int *buf;
+	int width = t->tilex1 - t->tilex0;
 
-	for (y = t->interlaceline; y < t->vpheight; y += t->interlacemod)
+	y = t->tiley0;
+	y += (t->interlacemod - ((y + t->interlaceline) % t->interlacemod)) % t->interlacemod;
+	for (; y < t->tiley1; y += t->interlacemod)
 	{
-		buf = mbuf + stride*y;
-		for (x = 0; x < (t->vpwidth & ~15);)
+		buf = mbuf + stride*y + t->tilex0;
+		for (x = 0; x < (width & ~15);)
 		{
 			buf[x++] = clearval;
 			buf[x++] = clearval;
@@ -689,11 +801,156 @@ void WQ_ClearBuffer(swthread_t *t, unsigned int *mbuf, qintptr_t stride, unsigne
 			buf[x++] = clearval;
 			buf[x++] = clearval;
 		}
-		for (; x < t->vpwidth; )
+		for (; x < width; )
 			buf[x++] = clearval;
 	}
 }
 
+//renders tiles until there are none left to claim. called by the span threads and the front end alike.
+static void WT_RenderTiles(swthread_t *th, swbins_t *b)
+{
+	unsigned int tile, numtiles = b->tilesx*b->tilesy;
+	unsigned int i;
+	swtile_t *t;
+	swbintri_t *bt;
+
+	th->vpcbuf = b->vpcbuf;
+	th->vpdbuf = b->vpdbuf;
+	th->vpwidth = b->vpwidth;
+	th->vpheight = b->vpheight;
+	th->vpcstride = b->vpcstride;
+	th->interlacemod = b->interlacemod;
+	th->interlaceline = b->interlaceline;
+
+	for(;;)
+	{
+		tile = FTE_Atomic32_Inc(&b->nexttile)-1;
+		if (tile >= numtiles)
+			break;
+		t = &b->tiles[tile];
+
+		th->tilex0 = (tile % b->tilesx) * SWTILE_SIZE;
+		th->tiley0 = (tile / b->tilesx) * SWTILE_SIZE;
+		th->tilex1 = min(th->tilex0 + SWTILE_SIZE, b->vpwidth);
+		th->tiley1 = min(th->tiley0 + SWTILE_SIZE, b->vpheight);
+
+		if (b->clearcolour)
+			WQ_ClearBuffer(th, th->vpcbuf, th->vpcstride, 0);
+		if (b->cleardepth)
+			WQ_ClearBuffer(th, th->vpdbuf, th->vpwidth, ~0u);
+
+		for (i = 0; i < t->numtris; i++)
+		{
+			bt = &b->tris[t->tris[i]];
+			WT_Triangle(th, bt->img, &bt->v[0], &bt->v[1], &bt->v[2]);
+		}
+	}
+}
+
+//has everything that was binned drawn, and waits for it to complete.
+static void WT_FlushBins(swthread_t *th)
+{
+	swbins_t *b = &swbins;
+	wqcom_t *com;
+	unsigned int i;
+
+	if (!b->numtris && !b->clearcolour && !b->cleardepth)
+		return;
+
+	if (b->vpcbuf && b->tilesx)
+	{
+		b->nexttile = 0;
+		if (spanqueue.numthreads)
+		{
+			com = SWRast_BeginCommand(&spanqueue, WTC_SPANS, sizeof(com->spans));
+			com->spans.bins = b;
+			SWRast_EndCommand(&spanqueue, com);
+		}
+		//help out instead of sitting idle
+		WT_RenderTiles(th, b);
+		SWRast_Wait(&spanqueue);
+	}
+
+	for (i = 0; i < b->tilesx*b->tilesy; i++)
+		b->tiles[i].numtris = 0;
+	b->numtris = 0;
+	b->clearcolour = false;
+	b->cleardepth = false;
+}
+
+//the bins need to match the viewport that we're going to be drawing to.
+static void WT_SetupBins(swthread_t *th)
+{
+	swbins_t *b = &swbins;
+	unsigned int numtiles;
+
+	b->vpcbuf = th->vpcbuf;
+	b->vpdbuf = th->vpdbuf;
+	b->vpwidth = th->vpwidth;
+	b->vpheight = th->vpheight;
+	b->vpcstride = th->vpcstride;
+	b->interlacemod = th->interlacemod;
+	b->interlaceline = th->interlaceline;
+
+	b->tilesx = (b->vpwidth + SWTILE_SIZE-1) / SWTILE_SIZE;
+	b->tilesy = (b->vpheight + SWTILE_SIZE-1) / SWTILE_SIZE;
+	numtiles = b->tilesx*b->tilesy;
+	if (numtiles > b->maxtiles)
+	{
+		b->tiles = BZ_Realloc(b->tiles, sizeof(*b->tiles)*numtiles);
+		memset(b->tiles+b->maxtiles, 0, sizeof(*b->tiles)*(numtiles-b->maxtiles));
+		b->maxtiles = numtiles;
+	}
+	if (!b->tris)
+		b->tris = BZ_Malloc(sizeof(*b->tris)*SWBIN_MAXTRIS);
+}
+
+static void WT_BinTriangle(swthread_t *th, swimage_t *img, swvert_t *v1, swvert_t *v2, swvert_t *v3)
+{
+	swbins_t *b = &swbins;
+	swbintri_t *bt;
+	swtile_t *t;
+	int minx, miny, maxx, maxy;
+	int tx, ty;
+
+	if (!img || !b->tilesx)
+		return;
+	if (b->numtris == SWBIN_MAXTRIS)
+		WT_FlushBins(th);
+
+	bt = &b->tris[b->numtris];
+	bt->img = img;
+	bt->v[0] = *v1;
+	bt->v[1] = *v2;
+	bt->v[2] = *v3;
+
+	minx = min(v1->scoord[0], min(v2->scoord[0], v3->scoord[0]));
+	maxx = max(v1->scoord[0], max(v2->scoord[0], v3->scoord[0]));
+	miny = min(v1->scoord[1], min(v2->scoord[1], v3->scoord[1]));
+	maxy = max(v1->scoord[1], max(v2->scoord[1], v3->scoord[1]));
+	if (maxx < 0 || maxy < 0 || minx >= (int)b->vpwidth || miny >= (int)b->vpheight)
+		return;	//offscreen (the clipper should have caught this)
+	minx = max(minx, 0) / SWTILE_SIZE;
+	miny = max(miny, 0) / SWTILE_SIZE;
+	maxx = min(maxx / SWTILE_SIZE, (int)b->tilesx-1);
+	maxy = min(maxy / SWTILE_SIZE, (int)b->tilesy-1);
+
+	for (ty = miny; ty <= maxy; ty++)
+	{
+		for (tx = minx; tx <= maxx; tx++)
+		{
+			t = &b->tiles[tx + ty*b->tilesx];
+			if (t->numtris == t->maxtris)
+			{
+				t->maxtris = t->maxtris?t->maxtris*2:64;
+				t->tris = BZ_Realloc(t->tris, sizeof(*t->tris)*t->maxtris);
+			}
+			t->tris[t->numtris++] = b->numtris;
+		}
+	}
+	b->numtris++;
+}
+
 qboolean WT_HandleCommand(swthread_t *t, wqcom_t *com)
 {
 	index_t *idx;
@@ -705,36 +962,29 @@ qboolean WT_HandleCommand(swthread_t *t, wqcom_t *com)
 		return 1;
 	case WTC_NOOP:
 		break;
+	case WTC_SYNC:
+		if (t->wq == &commandqueue)	//span threads have no bins of their own
+			WT_FlushBins(t);
+		break;
 	case WTC_NEWFRAME:
 		break;
 	case WTC_UNIFORMS:
 		memcpy(&t->u, &com->uniforms.u, sizeof(t->u));
 		break;
 	case WTC_VIEWPORT:
+		WT_FlushBins(t);
 		t->vpcbuf = com->viewport.cbuf;
 		t->vpdbuf = com->viewport.dbuf;
 		t->vpwidth = com->viewport.width;
 		t->vpheight = com->viewport.height;
 		t->vpcstride = com->viewport.stride;
-		if (!t->wq->numthreads)
-		{
-			t->interlacemod = com->viewport.interlace;	//this many vthreads
-			t->interlaceline = com->viewport.framenum%com->viewport.interlace;	//this vthread
-		}
-		else
-		{
-			t->interlacemod = t->wq->numthreads*com->viewport.interlace;	//this many vthreads
-			t->interlaceline = (t->threadnum*com->viewport.interlace) + (com->viewport.framenum%com->viewport.interlace);	//this vthread
-		}
+		t->interlacemod = com->viewport.interlace;
+		t->interlaceline = com->viewport.framenum%com->viewport.interlace;
+		WT_SetupBins(t);
 
-		if (com->viewport.clearcolour)
-		{
-			WQ_ClearBuffer(t, t->vpcbuf, t->vpcstride, 0);
-		}
-		if (com->viewport.cleardepth)
-		{
-			WQ_ClearBuffer(t, t->vpdbuf, t->vpwidth, ~0u);
-		}
+		//clears happen per-tile, when the bins are next flushed
+		swbins.clearcolour = com->viewport.clearcolour;
+		swbins.cleardepth = com->viewport.cleardepth;
 		break;
 	case WTC_TRIFAN:
 		for (i = 2; i < com->trifan.numverts; i++)
@@ -750,6 +1000,7 @@ qboolean WT_HandleCommand(swthread_t *t, wqcom_t *com)
 		}
 		break;
 	case WTC_SPANS:
+		WT_RenderTiles(t, com->spans.bins);
 		break;
 	default:
 		Sys_Printf("Unknown render command!\n");
@@ -808,7 +1059,8 @@ wqcom_t *SWRast_BeginCommand(struct workqueue_s *wq, int cmdtype, unsigned int s
 
 	return com;
 }
-void SWRast_Sync(struct workqueue_s *wq)
+//waits for the worker threads to catch up with what's already been queued
+void SWRast_Wait(struct workqueue_s *wq)
 {
 	int i;
 	swthread_t *t;
@@ -822,6 +1074,13 @@ void SWRast_Sync(struct workqueue_s *wq)
 
 	//all worker threads are up to speed
 }
+//has everything that was queued drawn, and waits for it
+void SWRast_Sync(struct workqueue_s *wq)
+{
+	wqcom_t *com = SWRast_BeginCommand(wq, WTC_SYNC, sizeof(com->com));
+	SWRast_EndCommand(wq, com);
+	SWRast_Wait(wq);
+}
 void SWRast_CreateThreadPool(struct workqueue_s *wq, int numthreads)
 {
 	int i = 0;
@@ -833,6 +1092,8 @@ void SWRast_CreateThreadPool(struct workqueue_s *wq, int numthreads)
 	{
 		t = &wq->swthreads[i];
 		t->threadnum = i;
+		t->readpoint = wq->pos;
+		t->wq = wq;	//must be valid before the thread starts reading
 		t->thread = Sys_CreateThread("swrast", WT_Main, t, THREADP_NORMAL, 0);
 		if (!t->thread)
 			break;
@@ -878,6 +1139,84 @@ void SWRast_TerminateThreadPool(struct workqueue_s *wq)
 
 
 
+//renders a fixed scene of overlapping, tilted, textured quads into an offscreen 1080p buffer, to measure fill rate.
+static void SW_FillBench_f(void)
+{
+	const int width = 1920, height = 1080, layers = 8;
+	int frames = (Cmd_Argc()>1)?atoi(Cmd_Argv(1)):20;
+	unsigned int *cbuf;
+	swimage_t *img;
+	wqcom_t *com;
+	swvert_t *v;
+	int f, l, i;
+	float z;
+	double start, elapsed;
+
+	if (frames < 1)
+		frames = 1;
+
+	SWRast_Sync(&commandqueue);
+
+	cbuf = BZ_Malloc(sizeof(*cbuf)*width*height*2);
+	img = BZ_Malloc(sizeof(*img) - sizeof(img->data) + sizeof(img->data)*64*64);
+	img->pwidth = img->pheight = img->pitch = 64;
+	img->pwidthmask = img->pheightmask = 63;
+	for (i = 0; i < 64*64; i++)	//checkerboard, with some holes to exercise the alpha test
+		img->data[i] = (((i>>3)^(i>>9))&1)?0xffc08040:((i&7)?0xff204060:0);
+
+	start = Sys_DoubleTime();
+	for (f = 0; f < frames; f++)
+	{
+		com = SWRast_BeginCommand(&commandqueue, WTC_VIEWPORT, sizeof(com->viewport));
+		com->viewport.cbuf = cbuf;
+		com->viewport.dbuf = cbuf + width*height;
+		com->viewport.width = width;
+		com->viewport.height = height;
+		com->viewport.stride = width;
+		com->viewport.interlace = 1;
+		com->viewport.framenum = f;
+		com->viewport.clearcolour = true;
+		com->viewport.cleardepth = true;
+		SWRast_EndCommand(&commandqueue, com);
+
+		//w=z, so everything gets a perspective divide
+		com = SWRast_BeginCommand(&commandqueue, WTC_UNIFORMS, sizeof(com->uniforms));
+		memset(&com->uniforms.u, 0, sizeof(com->uniforms.u));
+		com->uniforms.u.matrix[0] = com->uniforms.u.matrix[5] = com->uniforms.u.matrix[10] = com->uniforms.u.matrix[11] = 1;
+		com->uniforms.u.viewplane[2] = 1.0/8192;
+		SWRast_EndCommand(&commandqueue, com);
+
+		//back to front, so every layer passes the depth test
+		for (l = 0; l < layers; l++)
+		{
+			z = 800 - l*80;
+			com = SWRast_BeginCommand(&commandqueue, WTC_TRIFAN, 4*sizeof(swvert_t) + sizeof(com->trifan) - sizeof(com->trifan.verts));
+			com->trifan.texture = img;
+			com->trifan.numverts = 4;
+			memset(com->trifan.verts, 0, sizeof(*v)*4);
+			for (i = 0; i < 4; i++)
+			{
+				v = &com->trifan.verts[i];
+				v->vcoord[2] = z * (((i==1||i==2)^(l&1))?1.5:0.7);	//tilted, alternating directions
+				v->vcoord[0] = ((i==1||i==2)?0.95:-0.95) * v->vcoord[2];
+				v->vcoord[1] = ((i>=2)?0.95:-0.95) * v->vcoord[2];
+				v->vcoord[3] = 1;
+				v->tccoord[0] = (i==1||i==2)?8:0;
+				v->tccoord[1] = (i>=2)?8:0;
+			}
+			SWRast_EndCommand(&commandqueue, com);
+		}
+		SWRast_Sync(&commandqueue);
+	}
+	elapsed = Sys_DoubleTime() - start;
+
+	Con_Printf("%i frames of %i layers at %ix%i: %.2f ms/frame, %.1f Mpixels/sec\n", frames, layers, width, height,
+			elapsed*1000/frames, (double)width*height*layers*0.95*0.95*frames/(elapsed*1000000));
+
+	BZ_Free(img);
+	BZ_Free(cbuf);
+}
+
 void SW_Draw_Init(void)
 {
 	R2D_Init();
@@ -892,9 +1231,11 @@ void SW_R_Init(void)
 {
 	SWRast_CreateThreadPool(&commandqueue, sw_vthread.ival?1:0);
 	sw_vthread.modified = true;
+	Cmd_AddCommandD("sw_fillbench", SW_FillBench_f, "Renders a fixed scene of overlapping textured quads to an offscreen 1080p buffer, and reports the fill rate.");
 }
 void SW_R_DeInit(void)
 {
+	Cmd_RemoveCommand("sw_fillbench");
 	SWRast_TerminateThreadPool(&commandqueue);
 }
 void SW_R_RenderView(void)
@@ -204,59 +204,316 @@ void Cluster_BuildAvailableDemoList(cluster_t *cluster)
 	qsort(cluster->availdemos, cluster->availdemoscount, sizeof(cluster->availdemos[0]), SortFilesByDate);
 }
 
-void Cluster_Run(cluster_t *cluster, qboolean dowait)
-{
-	oproxy_t *pend, *pend2, *pend3;
-	sv_t *sv, *old;
+#ifdef USE_THREADS
+#ifdef _WIN32
+	#define Sys_InitMutex(m)	InitializeCriticalSection(m)
+	#define Sys_DestroyMutex(m)	DeleteCriticalSection(m)
+	#define Sys_LockMutex(m)	EnterCriticalSection(m)
+	#define Sys_UnlockMutex(m)	LeaveCriticalSection(m)
+	#define Sys_Sleep(ms)		Sleep(ms)
+#else
+	#define Sys_InitMutex(m)	pthread_mutex_init(m, NULL)
+	#define Sys_DestroyMutex(m)	pthread_mutex_destroy(m)
+	#define Sys_LockMutex(m)	pthread_mutex_lock(m)
+	#define Sys_UnlockMutex(m)	pthread_mutex_unlock(m)
+	#define Sys_Sleep(ms)		usleep((ms)*1000)
+#endif
 
-	int m;
-	struct timeval timeout;
+static void Cluster_RunWorker(worker_t *w)
+{
+	cluster_t *cluster = w->cluster;
+	sv_t *sv;
+	viewer_t *v;
+	int timeout;
+#ifdef USE_EPOLL
+	struct epoll_event events[64];
+	char drain[64];
+#else
 	fd_set socketset;
+	struct timeval tv;
+	int m;
+#endif
 
-	if (dowait)
+	while (!w->quit)
 	{
-		//FIXME: use poll or epoll to work around FD_SETSIZE limits, though we're mostly only doing this for the sleeping.
+		Sys_LockMutex(&w->lock);
+
+		//viewer packet rates and timeouts go by this. cluster->curtime is only for the main thread.
+		w->curtime = Sys_Milliseconds();
+
+		for (sv = cluster->servers; sv; sv = sv->next)
+		{
+			if (sv->threadnum != w->threadnum)
+				continue;
+			if (sv->errored == ERR_PERMANENT || sv->errored == ERR_DISABLED || sv->errored == ERR_DROP)
+				continue;	//QTV_Run deals with these on the main thread
+			QTV_RunStream(sv);
+		}
+
+		for (v = cluster->viewers; v; v = v->next)
+		{
+			if (v->server && v->server->threadnum == w->threadnum)
+				SendViewerPackets(cluster, v, w->curtime);
+		}
 
+		//streams that aren't getting anything still need to tick over, same as on the main thread.
+		timeout = cluster->viewserver?1:100;
+#ifndef USE_EPOLL
 		FD_ZERO(&socketset);
 		m = 0;
-		if (cluster->qwdsocket[0] != INVALID_SOCKET)
+		for (sv = cluster->servers; sv; sv = sv->next)
 		{
-			if (cluster->qwdsocket[0] < FD_SETSIZE)
-			{
-				FD_SET(cluster->qwdsocket[0], &socketset);
-				if (cluster->qwdsocket[0] >= m)
-					m = cluster->qwdsocket[0]+1;
-			}
+			if (sv->threadnum != w->threadnum || sv->sourcesock == INVALID_SOCKET)
+				continue;
+			if (sv->sourcesock >= FD_SETSIZE)
+				continue;	//panic...
+			FD_SET(sv->sourcesock, &socketset);
+			if (sv->sourcesock >= m)
+				m = sv->sourcesock+1;
 		}
-		if (cluster->qwdsocket[1] != INVALID_SOCKET)
+#endif
+
+		Sys_UnlockMutex(&w->lock);
+
+		//sleep until one of our sources has something, or the main thread pokes us.
+#ifdef USE_EPOLL
+		if (epoll_wait(w->epollfd, events, sizeof(events)/sizeof(events[0]), timeout) > 0)
 		{
-			if (cluster->qwdsocket[1] < FD_SETSIZE)
-			{
-				FD_SET(cluster->qwdsocket[1], &socketset);
-				if (cluster->qwdsocket[1] >= m)
-					m = cluster->qwdsocket[1]+1;
-			}
+			while (read(w->wakefd[0], drain, sizeof(drain)) > 0)
+				;
 		}
+#else
+		tv.tv_sec = 0;
+		tv.tv_usec = timeout*1000;
+		if (m)
+			select(m, &socketset, NULL, NULL, &tv);
+		else
+			Sys_Sleep(timeout);
+#endif
+	}
+}
 
-		for (sv = cluster->servers; sv; sv = sv->next)
+//wakes the worker up early. harmless if it's already awake.
+static void Cluster_PokeWorker(worker_t *w)
+{
+#ifdef USE_EPOLL
+	char c = 0;
+	if (write(w->wakefd[1], &c, 1) < 0)
+		return;	//the pipe is full, so it has plenty of pokes already
+#endif
+}
+
+//for the main thread, when it has done something that a worker's viewers might want to send. the worker gets poked once the streams are unlocked.
+void Cluster_WakeWorker(cluster_t *cluster, int threadnum)
+{
+	if (threadnum > 0 && threadnum <= cluster->numworkers)
+		cluster->workers[threadnum-1].wakeup = true;
+}
+#ifdef _WIN32
+static DWORD WINAPI Cluster_WorkerThread(LPVOID arg)
+{
+	Cluster_RunWorker(arg);
+	return 0;
+}
+#else
+static void *Cluster_WorkerThread(void *arg)
+{
+	Cluster_RunWorker(arg);
+	return NULL;
+}
+#endif
+
+//the main thread holds every worker's lock while it's doing anything that might poke another thread's streams or viewers
+static void Cluster_LockStreams(cluster_t *cluster)
+{
+	int i;
+	for (i = 0; i < cluster->numworkers; i++)
+		Sys_LockMutex(&cluster->workers[i].lock);
+}
+static void Cluster_UnlockStreams(cluster_t *cluster)
+{
+	int i;
+	qboolean wake;
+	worker_t *w;
+	for (i = cluster->numworkers; i-- > 0; )
+	{
+		w = &cluster->workers[i];
+		wake = w->wakeup;
+		w->wakeup = false;
+		Sys_UnlockMutex(&w->lock);
+		if (wake)
+			Cluster_PokeWorker(w);
+	}
+}
+
+//new streams go to whichever worker has the fewest.
+int Cluster_PickWorker(cluster_t *cluster)
+{
+	int count[MAX_WORKERS+1];
+	int i, best;
+	sv_t *sv;
+
+	if (!cluster->numworkers)
+		return 0;
+
+	memset(count, 0, sizeof(count));
+	for (sv = cluster->servers; sv; sv = sv->next)
+		count[sv->threadnum]++;
+	best = 1;
+	for (i = 2; i <= cluster->numworkers; i++)
+	{
+		if (count[i] < count[best])
+			best = i;
+	}
+	return best;
+}
+
+//registers the stream's source socket with whichever thread runs it. streams must be locked.
+void Cluster_WatchStream(sv_t *qtv)
+{
+	if (qtv->sourcesock == INVALID_SOCKET)
+		return;
+	if (qtv->threadnum)
+	{
+		Net_UnwatchSocket(qtv->cluster, qtv->sourcesock);
+#ifdef USE_EPOLL
+		//workers don't track upstreamwantwrite. its edge triggered, so they only wake when the socket becomes writable again anyway.
+		Net_EpollWatch(qtv->cluster->workers[qtv->threadnum-1].epollfd, qtv->sourcesock, true);
+#endif
+	}
+	else
+		Net_WatchSocket(qtv->cluster, qtv->sourcesock, qtv->upstreamwantwrite);
+}
+
+//moves a stream to a different thread (0 for the main thread). streams must be locked.
+void Cluster_PinStream(sv_t *qtv, int threadnum)
+{
+	int oldthread = qtv->threadnum;
+	qtv->threadnum = threadnum;
+
+	if (qtv->sourcesock == INVALID_SOCKET)
+		return;
+#ifdef USE_EPOLL
+	if (oldthread > 0 && oldthread <= qtv->cluster->numworkers)
+		Net_EpollUnwatch(qtv->cluster->workers[oldthread-1].epollfd, qtv->sourcesock);
+#endif
+	Cluster_WatchStream(qtv);
+	Cluster_WakeWorker(qtv->cluster, threadnum);
+}
+
+static void Cluster_SetWorkers(cluster_t *cluster, int count)
+{
+	int i;
+	worker_t *w;
+	sv_t *sv;
+
+	//stop the old set
+	for (i = 0; i < cluster->numworkers; i++)
+	{
+		cluster->workers[i].quit = true;
+		Cluster_PokeWorker(&cluster->workers[i]);
+	}
+	for (i = 0; i < cluster->numworkers; i++)
+	{
+		w = &cluster->workers[i];
+#ifdef _WIN32
+		WaitForSingleObject(w->thread, INFINITE);
+		CloseHandle(w->thread);
+#else
+		pthread_join(w->thread, NULL);
+#endif
+		Sys_DestroyMutex(&w->lock);
+#ifdef USE_EPOLL
+		close(w->epollfd);
+		close(w->wakefd[0]);
+		close(w->wakefd[1]);
+		w->epollfd = -1;
+#endif
+	}
+	cluster->numworkers = 0;
+
+	for (i = 0; i < count && i < MAX_WORKERS; i++)
+	{
+		w = &cluster->workers[i];
+		w->cluster = cluster;
+		w->threadnum = i+1;
+		w->quit = false;
+		w->wakeup = false;
+#ifdef USE_EPOLL
+		//each worker sleeps on its own streams' sockets, plus a pipe that the main thread can poke it with.
+		w->epollfd = epoll_create(64);
+		if (w->epollfd == -1)
 		{
-			if (sv->usequakeworldprotocols && sv->sourcesock != INVALID_SOCKET)
-			{
-				if (sv->sourcesock >= FD_SETSIZE)
-					continue;	//panic...
-				FD_SET(sv->sourcesock, &socketset);
-				if (sv->sourcesock >= m)
-					m = sv->sourcesock+1;
-			}
+			Sys_Printf(cluster, "Unable to create worker thread\n");
+			break;
+		}
+		if (pipe(w->wakefd))
+		{
+			Sys_Printf(cluster, "Unable to create worker thread\n");
+			close(w->epollfd);
+			w->epollfd = -1;
+			break;
+		}
+		fcntl(w->wakefd[0], F_SETFL, O_NONBLOCK);
+		fcntl(w->wakefd[1], F_SETFL, O_NONBLOCK);
+		Net_EpollWatch(w->epollfd, w->wakefd[0], false);
+#endif
+		Sys_InitMutex(&w->lock);
+#ifdef _WIN32
+		w->thread = CreateThread(NULL, 0, Cluster_WorkerThread, w, 0, NULL);
+		if (!w->thread)
+#else
+		if (pthread_create(&w->thread, NULL, Cluster_WorkerThread, w))
+#endif
+		{
+			Sys_Printf(cluster, "Unable to create worker thread\n");
+			Sys_DestroyMutex(&w->lock);
+#ifdef USE_EPOLL
+			close(w->epollfd);
+			close(w->wakefd[0]);
+			close(w->wakefd[1]);
+			w->epollfd = -1;
+#endif
+			break;
 		}
+		cluster->numworkers++;
+	}
+	cluster->wantworkers = cluster->numworkers;
+
+	//spread the existing streams over the new set
+	Cluster_LockStreams(cluster);
+	for (i = 0, sv = cluster->servers; sv; sv = sv->next, i++)
+		Cluster_PinStream(sv, cluster->numworkers?(i%cluster->numworkers)+1:0);
+	Cluster_UnlockStreams(cluster);
+}
+#else
+	#define Cluster_LockStreams(cluster)
+	#define Cluster_UnlockStreams(cluster)
+#endif
+
+void Cluster_Run(cluster_t *cluster, qboolean dowait)
+{
+	oproxy_t *pend, *pend2, *pend3;
+	sv_t *sv, *old;
+
+	int m;
+	struct timeval timeout;
+	fd_set socketset;
+
+#ifdef USE_THREADS
+	if (cluster->wantworkers != cluster->numworkers)
+		Cluster_SetWorkers(cluster, cluster->wantworkers);
+#endif
+
+	if (dowait)
+	{
+		FD_ZERO(&socketset);
+		m = 0;
 
 	#ifndef _WIN32
 		#ifndef STDIN
 			#define STDIN 0
 		#endif
-		FD_SET(STDIN, &socketset);
-		if (STDIN >= m)
-			m = STDIN+1;
 	#endif
 
 		if (cluster->viewserver)
@@ -270,8 +527,67 @@ void Cluster_Run(cluster_t *cluster, qboolean dowait)
 			timeout.tv_usec = (100%1000)*1000;
 		}
 
-		m = select(m, &socketset, NULL, NULL, &timeout);
+#ifdef USE_EPOLL
+		if (cluster->epollfd != -1)
+		{	//every socket is already registered, so there's nothing to rebuild and no FD_SETSIZE limit.
+			struct epoll_event events[64];
+			int i;
+			m = epoll_wait(cluster->epollfd, events, sizeof(events)/sizeof(events[0]), timeout.tv_sec*1000 + timeout.tv_usec/1000);
+			for (i = 0; i < m; i++)
+			{
+				if (events[i].data.fd == STDIN)
+					FD_SET(STDIN, &socketset);
+			}
+		}
+		else
+#endif
+		{
+			if (cluster->qwdsocket[0] != INVALID_SOCKET)
+			{
+				if (cluster->qwdsocket[0] < FD_SETSIZE)
+				{
+					FD_SET(cluster->qwdsocket[0], &socketset);
+					if (cluster->qwdsocket[0] >= m)
+						m = cluster->qwdsocket[0]+1;
+				}
+			}
+			if (cluster->qwdsocket[1] != INVALID_SOCKET)
+			{
+				if (cluster->qwdsocket[1] < FD_SETSIZE)
+				{
+					FD_SET(cluster->qwdsocket[1], &socketset);
+					if (cluster->qwdsocket[1] >= m)
+						m = cluster->qwdsocket[1]+1;
+				}
+			}
+
+			for (sv = cluster->servers; sv; sv = sv->next)
+			{
+				if (sv->usequakeworldprotocols && sv->sourcesock != INVALID_SOCKET)
+				{
+					if (sv->sourcesock >= FD_SETSIZE)
+						continue;	//panic...
+					FD_SET(sv->sourcesock, &socketset);
+					if (sv->sourcesock >= m)
+						m = sv->sourcesock+1;
+				}
+			}
+
+		#ifndef _WIN32
+			FD_SET(STDIN, &socketset);
+			if (STDIN >= m)
+				m = STDIN+1;
+		#endif
+
+			m = select(m, &socketset, NULL, NULL, &timeout);
+		}
+	}
+
+	//the rest of the frame can touch anything.
+	Cluster_LockStreams(cluster);
 
+	if (dowait)
+	{
 #ifdef _WIN32
 		for (;;)
 		{
@@ -382,6 +698,8 @@ void Cluster_Run(cluster_t *cluster, qboolean dowait)
 			}
 		}
 	}
+
+	Cluster_UnlockStreams(cluster);
 }
 
 
@@ -492,6 +810,11 @@ int main(int argc, char **argv)
 
 		strcpy(cluster->demodir, "qw/demos/");
 
+#ifdef USE_EPOLL
+		cluster->epollfd = epoll_create(64);
+		Net_WatchSocket(cluster, STDIN, false);
+#endif
+
 		Sys_Printf(cluster, "QTV "QTV_VERSION_STRING"\n");
 
 		DoCommandLine(cluster, argc, argv);
@@ -534,6 +857,13 @@ int main(int argc, char **argv)
 #endif
 		}
 
+#ifdef USE_THREADS
+		Cluster_SetWorkers(cluster, 0);
+#endif
+#ifdef USE_EPOLL
+		if (cluster->epollfd != -1)
+			close(cluster->epollfd);
+#endif
 		free(cluster);
 	}
 
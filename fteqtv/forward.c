@@ -27,6 +27,20 @@ Password checks and stuff are implemented here. This i server side stuff.
 #include "qtv.h"
 #include "time.h"
 
+#ifdef _WIN32
+	typedef WSABUF proxyiov_t;
+	#define IOV_SET(v,p,l) ((v).buf = (char*)(p), (v).len = (l))
+	#define IOV_BASE(v) ((v).buf)
+	#define IOV_LEN(v) ((v).len)
+#else
+	#include <sys/uio.h>
+	typedef struct iovec proxyiov_t;
+	#define IOV_SET(v,p,l) ((v).iov_base = (p), (v).iov_len = (l))
+	#define IOV_BASE(v) ((v).iov_base)
+	#define IOV_LEN(v) ((v).iov_len)
+#endif
+#define MAX_PROXY_IOV 64	//keep this well under IOV_MAX
+
 
 #undef IN
 #define IN(x) buffer[(x)&(MAX_PROXY_BUFFER-1)]
@@ -62,58 +76,63 @@ void CheckMVDConsistancy(unsigned char *buffer, int pos, int size)
 
 
 
-void SV_FindProxies(SOCKET sock, cluster_t *cluster, sv_t *defaultqtv)
+void SV_FindProxies(SOCKET listensock, cluster_t *cluster, sv_t *defaultqtv)
 {
 	unsigned long nonblocking = true;
 	oproxy_t *prox;
+	SOCKET sock;
 
-	if (sock == INVALID_SOCKET)
-		return;
-	sock = accept(sock, NULL, NULL);
-	if (sock == INVALID_SOCKET)
+	if (listensock == INVALID_SOCKET)
 		return;
 
-	if (ioctlsocket (sock, FIONBIO, &nonblocking) == -1)
-	{
-		Sys_Printf(cluster, "failed to set client socket to nonblocking. dropping.\n");
-		closesocket(sock);	//failed...
-		return;
-	}
+	for (;;)
+	{	//accept everything that's waiting rather than one per frame.
+		sock = accept(listensock, NULL, NULL);
+		if (sock == INVALID_SOCKET)
+			return;
 
-	if (cluster->maxproxies >= 0 && cluster->numproxies >= cluster->maxproxies)
-	{
-		const char buffer[] = {dem_all, 1, 'P','r','o','x','y',' ','i','s',' ','f','u','l','l','.'};
-		send(sock, buffer, strlen(buffer), 0);
-		closesocket(sock);
-		return;
-	}
+		if (ioctlsocket (sock, FIONBIO, &nonblocking) == -1)
+		{
+			Sys_Printf(cluster, "failed to set client socket to nonblocking. dropping.\n");
+			closesocket(sock);	//failed...
+			continue;
+		}
 
-	prox = malloc(sizeof(*prox));
-	if (!prox)
-	{//out of mem?
-		closesocket(sock);
-		return;
-	}
-	memset(prox, 0, sizeof(*prox));
-	prox->sock = sock;
-	prox->file = NULL;
+		if (cluster->maxproxies >= 0 && cluster->numproxies >= cluster->maxproxies)
+		{
+			const char buffer[] = {dem_all, 1, 'P','r','o','x','y',' ','i','s',' ','f','u','l','l','.'};
+			send(sock, buffer, strlen(buffer), 0);
+			closesocket(sock);
+			continue;
+		}
 
-	cluster->numproxies++;
+		prox = malloc(sizeof(*prox));
+		if (!prox)
+		{//out of mem?
+			closesocket(sock);
+			return;
+		}
+		memset(prox, 0, sizeof(*prox));
+		prox->sock = sock;
+		prox->file = NULL;
+		Net_WatchSocket(cluster, sock, false);
+
+		cluster->numproxies++;
 
-	prox->droptime = cluster->curtime + 5*1000;
+		prox->droptime = cluster->curtime + 5*1000;
 #if 1
-	prox->defaultstream = defaultqtv;
+		prox->defaultstream = defaultqtv;
 
-	prox->next = cluster->pendingproxies;
-	cluster->pendingproxies = prox;
+		prox->next = cluster->pendingproxies;
+		cluster->pendingproxies = prox;
 #else
-	prox->next = qtv->pendingproxies;
-	qtv->pendingproxies = prox;
-	Net_SendConnectionMVD(qtv, prox);
+		prox->next = qtv->pendingproxies;
+		qtv->pendingproxies = prox;
+		Net_SendConnectionMVD(qtv, prox);
 #endif
+	}
 }
 
-
 void Fwd_ParseCommands(cluster_t *cluster, oproxy_t *prox)
 {
 	netmsg_t buf;
@@ -175,11 +194,136 @@ void Fwd_ParseCommands(cluster_t *cluster, oproxy_t *prox)
 	}
 }
 
+static proxyseg_t *Prox_NewSegment(void *header, int headerlength, void *data, int length)
+{
+	proxyseg_t *seg;
+	unsigned int total = headerlength + length;
+
+	seg = malloc(sizeof(*seg) + total);
+	if (!seg)
+		return NULL;
+	seg->refs = 1;	//the creator's reference
+	seg->length = total;
+	if (headerlength)
+		memcpy(seg->data, header, headerlength);
+	memcpy(seg->data+headerlength, data, length);
+
+	//websocket proxies get each segment as a single binary frame
+	seg->wshdr[0] = 0x80|2;
+	if (total >= 0x10000)
+	{
+		seg->wshdr[1] = 127;
+		seg->wshdr[2] = 0;
+		seg->wshdr[3] = 0;
+		seg->wshdr[4] = 0;
+		seg->wshdr[5] = 0;
+		seg->wshdr[6] = total>>24;
+		seg->wshdr[7] = total>>16;
+		seg->wshdr[8] = total>>8;
+		seg->wshdr[9] = total;
+		seg->wshdrlen = 10;
+	}
+	else if (total >= 126)
+	{
+		seg->wshdr[1] = 126;
+		seg->wshdr[2] = total>>8;
+		seg->wshdr[3] = total;
+		seg->wshdrlen = 4;
+	}
+	else
+	{
+		seg->wshdr[1] = total;
+		seg->wshdrlen = 2;
+	}
+	return seg;
+}
+
+static void Prox_ReleaseSegment(proxyseg_t *seg)
+{
+	if (!--seg->refs)
+		free(seg);
+}
+
+static unsigned int Prox_SegmentSize(oproxy_t *prox, proxyseg_t *seg)
+{
+	if (prox->websocket.websocket)
+		return seg->wshdrlen + seg->length;
+	return seg->length;
+}
+
+//how much data is still waiting to be sent, both private and shared.
+static unsigned int Net_ProxyPending(oproxy_t *prox)
+{
+	return prox->buffersize - prox->bufferpos + prox->segbytes;
+}
+
+void Net_ProxyReleaseSegments(oproxy_t *prox)
+{
+	while (prox->segshead != prox->segstail)
+		Prox_ReleaseSegment(prox->segs[prox->segshead++&(MAX_PROXY_SEGMENTS-1)].seg);
+	prox->segoffset = 0;
+	prox->segbytes = 0;
+}
+
+static int Net_SendV(SOCKET sock, proxyiov_t *iov, int count)
+{
+#ifdef _WIN32
+	DWORD sent;
+	if (WSASend(sock, iov, count, &sent, 0, NULL, NULL))
+		return -1;
+	return sent;
+#else
+	return writev(sock, iov, count);
+#endif
+}
+
+//advances past data that was sent, releasing any segments that are now fully sent.
+static void Net_ProxyConsume(oproxy_t *prox, unsigned int length)
+{
+	unsigned int end, n, total;
+	proxyseg_t *seg;
+
+	while (length)
+	{
+		if (prox->segshead == prox->segstail)
+			end = prox->buffersize;
+		else
+			end = prox->segs[prox->segshead&(MAX_PROXY_SEGMENTS-1)].bufferpos;
+		if (prox->bufferpos < end)
+		{
+			n = end - prox->bufferpos;
+			if (n > length)
+				n = length;
+			prox->bufferpos += n;
+			length -= n;
+			continue;
+		}
+		if (prox->segshead == prox->segstail)
+			break;	//shouldn't happen
+
+		seg = prox->segs[prox->segshead&(MAX_PROXY_SEGMENTS-1)].seg;
+		total = Prox_SegmentSize(prox, seg);
+		n = total - prox->segoffset;
+		if (n > length)
+			n = length;
+		prox->segoffset += n;
+		prox->segbytes -= n;
+		length -= n;
+		if (prox->segoffset == total)
+		{
+			Prox_ReleaseSegment(seg);
+			prox->segs[prox->segshead++&(MAX_PROXY_SEGMENTS-1)].seg = NULL;
+			prox->segoffset = 0;
+		}
+	}
+}
+
 void Net_TryFlushProxyBuffer(cluster_t *cluster, oproxy_t *prox)
 {
-	unsigned char *buffer;
-	int length;
-	int bufpos;
+	proxyiov_t iov[MAX_PROXY_IOV];
+	int niov, i, length, written;
+	unsigned int pos, end, bufpos, skip, seghead;
+	proxyseg_t *seg;
 
 //	if (prox->drop)
 //		return;
@@ -188,25 +332,71 @@ void Net_TryFlushProxyBuffer(cluster_t *cluster, oproxy_t *prox)
 	{	//so we never get any issues with wrapping..
 		prox->bufferpos -= MAX_PROXY_BUFFER;
 		prox->buffersize -= MAX_PROXY_BUFFER;
+		for (seghead = prox->segshead; seghead != prox->segstail; seghead++)
+			prox->segs[seghead&(MAX_PROXY_SEGMENTS-1)].bufferpos -= MAX_PROXY_BUFFER;
 	}
 
-	bufpos = prox->bufferpos&(MAX_PROXY_BUFFER-1);
-	length = prox->buffersize - prox->bufferpos;
-	if (length > MAX_PROXY_BUFFER-bufpos)	//cap the length correctly.
-		length = MAX_PROXY_BUFFER-bufpos;
-	if (!length)
-		return;	//already flushed.
-	buffer = prox->buffer + bufpos;
-
 //	CheckMVDConsistancy(prox->buffer, prox->bufferpos, prox->buffersize);
 
-	if (bufpos+length > MAX_PROXY_BUFFER)
-		Sys_Printf(cluster, "oversize flush\n");
+	//gather our private data and the shared segments in the order they were queued, so it can all go in a single syscall.
+	niov = 0;
+	pos = prox->bufferpos;
+	skip = prox->segoffset;
+	for (seghead = prox->segshead; niov+4 <= MAX_PROXY_IOV; seghead++)
+	{
+		if (seghead == prox->segstail)
+			end = prox->buffersize;
+		else
+			end = prox->segs[seghead&(MAX_PROXY_SEGMENTS-1)].bufferpos;
+		while (pos < end)
+		{	//at most two parts, due to wrapping.
+			bufpos = pos&(MAX_PROXY_BUFFER-1);
+			length = end - pos;
+			if (length > MAX_PROXY_BUFFER-bufpos)	//cap the length correctly.
+				length = MAX_PROXY_BUFFER-bufpos;
+			IOV_SET(iov[niov], prox->buffer+bufpos, length);
+			niov++;
+			pos += length;
+		}
+		if (seghead == prox->segstail)
+			break;
+
+		seg = prox->segs[seghead&(MAX_PROXY_SEGMENTS-1)].seg;
+		if (prox->websocket.websocket)
+		{
+			if (skip < seg->wshdrlen)
+			{
+				IOV_SET(iov[niov], seg->wshdr+skip, seg->wshdrlen-skip);
+				niov++;
+				skip = 0;
+			}
+			else
+				skip -= seg->wshdrlen;
+		}
+		IOV_SET(iov[niov], seg->data+skip, seg->length-skip);
+		niov++;
+		skip = 0;
+	}
+	if (!niov)
+	{	//already flushed.
+		if (prox->sock != INVALID_SOCKET)
+			Net_WatchSocketWrites(cluster, prox->sock, &prox->wantwrite, false);
+		return;
+	}
 
 	if (prox->file)
-		length = fwrite(buffer, 1, length, prox->file);
+	{
+		length = 0;
+		for (i = 0; i < niov; i++)
+		{
+			written = fwrite(IOV_BASE(iov[i]), 1, IOV_LEN(iov[i]), prox->file);
+			length += written;
+			if (written != IOV_LEN(iov[i]))
+				break;
+		}
+	}
 	else
-		length = send(prox->sock, buffer, length, 0);
+		length = Net_SendV(prox->sock, iov, niov);
 
 
 	switch (length)
@@ -224,8 +414,50 @@ void Net_TryFlushProxyBuffer(cluster_t *cluster, oproxy_t *prox)
 		}
 		break;
 	default:
-		prox->bufferpos += length;
+		Net_ProxyConsume(prox, length);
 	}
+
+	//if we couldn't send it all, wake up when we can send more.
+	if (prox->sock != INVALID_SOCKET && !prox->drop)
+		Net_WatchSocketWrites(cluster, prox->sock, &prox->wantwrite, Net_ProxyPending(prox)>0);
+}
+
+//queues a reference to a shared segment, instead of copying it.
+static void Net_ProxySendSegment(cluster_t *cluster, oproxy_t *prox, proxyseg_t *seg)
+{
+	unsigned int length = Prox_SegmentSize(prox, seg);
+	if (prox->segstail-prox->segshead == MAX_PROXY_SEGMENTS || Net_ProxyPending(prox) + length > MAX_PROXY_BUFFER)
+	{
+		Net_TryFlushProxyBuffer(cluster, prox);	//try flushing
+		if (prox->segstail-prox->segshead == MAX_PROXY_SEGMENTS || Net_ProxyPending(prox) + length > MAX_PROXY_BUFFER)	//damn, still too big.
+		{	//they're too slow. hopefully it was just momentary lag
+			if (!prox->flushing)
+			{
+				printf("QTV client is too lagged\n");
+				prox->flushing = true;
+			}
+			return;
+		}
+	}
+
+	seg->refs++;
+	prox->segs[prox->segstail&(MAX_PROXY_SEGMENTS-1)].seg = seg;
+	prox->segs[prox->segstail&(MAX_PROXY_SEGMENTS-1)].bufferpos = prox->buffersize;
+	prox->segstail++;
+	prox->segbytes += length;
+}
+
+//copies into the private buffer, the caller must have already checked that there's space.
+static void Net_ProxyWrite(oproxy_t *prox, void *buffer, int length)
+{
+	int bufpos = prox->buffersize&(MAX_PROXY_BUFFER-1);
+	int wrap = MAX_PROXY_BUFFER - bufpos;	//the ammount of data we can fit before wrapping.
+
+	if (wrap > length)
+		wrap = length;
+	memcpy(prox->buffer+bufpos, buffer, wrap);
+	memcpy(prox->buffer, (char*)buffer+wrap, length-wrap);
+	prox->buffersize += length;
 }
 
 void Net_ProxySendString(cluster_t *cluster, oproxy_t *prox, void *buffer)
@@ -235,8 +467,6 @@ void Net_ProxySendString(cluster_t *cluster, oproxy_t *prox, void *buffer)
 
 void Net_ProxySend(cluster_t *cluster, oproxy_t *prox, void *buffer, int length)
 {
-	int wrap;
-
 	if (!length)
 		return;
 
@@ -260,10 +490,10 @@ void Net_ProxySend(cluster_t *cluster, oproxy_t *prox, void *buffer, int length)
 			}
 		}
 
-		if (prox->buffersize-prox->bufferpos + (enclen+4) > MAX_PROXY_BUFFER)
+		if (Net_ProxyPending(prox) + (enclen+4) > MAX_PROXY_BUFFER)
 		{
 			Net_TryFlushProxyBuffer(cluster, prox);	//try flushing
-			if (prox->buffersize-prox->bufferpos + (enclen+4) > MAX_PROXY_BUFFER)	//damn, still too big.
+			if (Net_ProxyPending(prox) + (enclen+4) > MAX_PROXY_BUFFER)	//damn, still too big.
 			{	//they're too slow. hopefully it was just momentary lag
 				if (!prox->flushing)
 				{
@@ -287,10 +517,7 @@ void Net_ProxySend(cluster_t *cluster, oproxy_t *prox, void *buffer, int length)
 			prox->buffer[prox->buffersize++&(MAX_PROXY_BUFFER-1)] = enclen;
 		}
 		if (datatype == 2)
-		{
-			for(; length-->0; buffer = (char*)buffer+1)
-				prox->buffer[prox->buffersize++&(MAX_PROXY_BUFFER-1)] = *(unsigned char*)buffer;
-		}
+			Net_ProxyWrite(prox, buffer, length);
 		else
 		{	//utf-8 (or really just bytes with upper bits truncated. sue me.
 			while(length-->0)
@@ -312,10 +539,10 @@ void Net_ProxySend(cluster_t *cluster, oproxy_t *prox, void *buffer, int length)
 		return;
 	}
 
-	if (prox->buffersize-prox->bufferpos + length > MAX_PROXY_BUFFER)
+	if (Net_ProxyPending(prox) + length > MAX_PROXY_BUFFER)
 	{
 		Net_TryFlushProxyBuffer(cluster, prox);	//try flushing
-		if (prox->buffersize-prox->bufferpos + length > MAX_PROXY_BUFFER)	//damn, still too big.
+		if (Net_ProxyPending(prox) + length > MAX_PROXY_BUFFER)	//damn, still too big.
 		{	//they're too slow. hopefully it was just momentary lag
 			if (!prox->flushing)
 			{
@@ -325,34 +552,7 @@ void Net_ProxySend(cluster_t *cluster, oproxy_t *prox, void *buffer, int length)
 			return;
 		}
 	}
-#if 1
-	//just simple
-	prox->buffersize+=length;
-	for (wrap = prox->buffersize-length; wrap < prox->buffersize; wrap++)
-	{
-		prox->buffer[wrap&(MAX_PROXY_BUFFER-1)] = *(unsigned char*)buffer;
-		buffer = (char*)buffer+1;
-	}
-#else
-	//we don't do multiple wrappings, the above check cannot succeed if it were required.
-
-	//find the wrap point
-	wrap = prox->buffersize-(prox->buffersize&(MAX_PROXY_BUFFER-1)) + MAX_PROXY_BUFFER;
-	wrap = wrap - (prox->buffersize&(MAX_PROXY_BUFFER-1));	//the ammount of data we can fit before wrapping.
-
-	if (wrap > length)
-	{	//we don't wrap afterall
-		memcpy(prox->buffer+(prox->buffersize)&(MAX_PROXY_BUFFER-1), buffer, length);
-		prox->buffersize+=length;
-		return;
-	}
-	memcpy(prox->buffer+prox->buffersize&(MAX_PROXY_BUFFER-1), buffer, wrap);
-	buffer += wrap;
-	length -= wrap;
-	memcpy(prox->buffer, buffer, length);
-
-	prox->buffersize+=length;
-#endif
+	Net_ProxyWrite(prox, buffer, length);
 }
 
 void Prox_SendMessage(cluster_t *cluster, oproxy_t *prox, char *buf, int length, int dem_type, unsigned int playermask)
@@ -366,10 +566,10 @@ void Prox_SendMessage(cluster_t *cluster, oproxy_t *prox, char *buf, int length,
 	if (dem_type == dem_multiple)
 		WriteLong(&msg, playermask);
 
-	if (prox->buffersize-prox->bufferpos + length + msg.cursize > MAX_PROXY_BUFFER)
+	if (Net_ProxyPending(prox) + length + msg.cursize > MAX_PROXY_BUFFER)
 	{
 		Net_TryFlushProxyBuffer(cluster, prox);	//try flushing
-		if (prox->buffersize-prox->bufferpos + length + msg.cursize > MAX_PROXY_BUFFER)	//damn, still too big.
+		if (Net_ProxyPending(prox) + length + msg.cursize > MAX_PROXY_BUFFER)	//damn, still too big.
 		{	//they're too slow. hopefully it was just momentary lag
 			prox->flushing = true;
 			return;
@@ -385,10 +585,28 @@ void Prox_SendMessage(cluster_t *cluster, oproxy_t *prox, char *buf, int length,
 void Fwd_SendDownstream(sv_t *qtv, void *buffer, int length)
 {	//broadcasts data to all client proxies, with dont-buffer
 	oproxy_t *prox;
+	proxyseg_t *seg;
+	netmsg_t msg;
+	char tbuf[16];
+
+	if (!qtv->proxies)
+		return;
+
+	InitNetMsg(&msg, tbuf, sizeof(tbuf));
+	WriteByte(&msg, 0);
+	WriteByte(&msg, dem_qtvdata);
+	WriteLong(&msg, length);
+	seg = Prox_NewSegment(msg.data, msg.cursize, buffer, length);
+
 	for (prox = qtv->proxies; prox; prox = prox->next)
 	{
-		Prox_SendMessage(qtv->cluster, prox, buffer, length, dem_qtvdata, (unsigned int)-1);
+		if (seg)
+			Net_ProxySendSegment(qtv->cluster, prox, seg);
+		else
+			Prox_SendMessage(qtv->cluster, prox, buffer, length, dem_qtvdata, (unsigned int)-1);
 	}
+	if (seg)
+		Prox_ReleaseSegment(seg);
 }
 
 void Fwd_SayToDownstream(sv_t *qtv, char *message)
@@ -632,6 +850,7 @@ qboolean Net_StopFileProxy(sv_t *qtv)
 void SV_ForwardStream(sv_t *qtv, void *buffer, int length)
 {	//forward the stream on to connected clients
 	oproxy_t *prox, *next, *fre;
+	proxyseg_t *seg = NULL;
 
 	CheckMVDConsistancy(buffer, 0, length);
 
@@ -644,8 +863,9 @@ void SV_ForwardStream(sv_t *qtv, void *buffer, int length)
 			fclose(fre->file);
 		else
 			closesocket(fre->sock);
+		Net_ProxyReleaseSegments(fre);
 		free(fre);
-		qtv->cluster->numproxies--;
+		Sys_AtomicDec(&qtv->cluster->numproxies);	//other workers might be dropping proxies too
 		qtv->proxies = next;
 	}
 
@@ -661,14 +881,15 @@ void SV_ForwardStream(sv_t *qtv, void *buffer, int length)
 				closesocket(fre->sock);
 			if (fre->srcfile)
 				fclose(fre->srcfile);
+			Net_ProxyReleaseSegments(fre);
 			free(fre);
-			qtv->cluster->numproxies--;
+			Sys_AtomicDec(&qtv->cluster->numproxies);
 			prox->next = next;
 		}
 
 		if (prox->flushing)	//don't send it if we're trying to empty thier buffer.
 		{
-			if (prox->buffersize == prox->bufferpos)
+			if (!Net_ProxyPending(prox))
 			{
 				if (!qtv->parsingconnectiondata)
 					Net_SendConnectionMVD(qtv, prox);	//they're up to date, resend the connection info.
@@ -683,8 +904,13 @@ void SV_ForwardStream(sv_t *qtv, void *buffer, int length)
 		if (prox->drop)
 			continue;
 
-		//add the new data
-		Net_ProxySend(qtv->cluster, prox, buffer, length);
+		//add the new data. every proxy references the same copy of it.
+		if (length && !seg)
+			seg = Prox_NewSegment(NULL, 0, buffer, length);
+		if (seg)
+			Net_ProxySendSegment(qtv->cluster, prox, seg);
+		else
+			Net_ProxySend(qtv->cluster, prox, buffer, length);
 
 		Net_TryFlushProxyBuffer(qtv->cluster, prox);
 //		Net_TryFlushProxyBuffer(qtv->cluster, prox);
@@ -698,6 +924,8 @@ void SV_ForwardStream(sv_t *qtv, void *buffer, int length)
 			Fwd_ParseCommands(qtv->cluster, prox);
 		}
 	}
+	if (seg)
+		Prox_ReleaseSegment(seg);	//anyone who didn't send it all yet still holds a reference
 }
 
 /*wrapper around recv to handle websocket connections*/
@@ -1102,6 +1330,8 @@ qboolean SV_ReadPendingProxy(cluster_t *cluster, oproxy_t *pend)
 							Net_TryFlushProxyBuffer(cluster, pend); //flush anything... this isn't ideal, but should be small enough
 							qtv->sourcesock = pend->sock;
 							pend->sock = INVALID_SOCKET;
+							qtv->upstreamwantwrite = pend->wantwrite;
+							Cluster_WatchStream(qtv);	//its worker might want it instead
 
 							memcpy(qtv->buffer, pend->inbuffer + headersize, pend->inbuffersize - headersize);
 							qtv->parsingqtvheader = true;
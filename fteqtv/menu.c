@@ -249,7 +249,7 @@ void WriteStringSelection(netmsg_t *b, qboolean selected, const char *str)
 	}
 }
 
-void Menu_Draw(cluster_t *cluster, viewer_t *viewer)
+void Menu_Draw(cluster_t *cluster, viewer_t *viewer, unsigned int curtime)
 {
 	char buffer[2048];
 	char str[256];
@@ -265,9 +265,9 @@ void Menu_Draw(cluster_t *cluster, viewer_t *viewer)
 	if (viewer->menunum == MENU_FORWARDING)
 		return;
 
-	if (viewer->menuspamtime > cluster->curtime && viewer->menuspamtime < cluster->curtime + CENTERTIME*2000)
+	if (viewer->menuspamtime > curtime && viewer->menuspamtime < curtime + CENTERTIME*2000)
 		return;
-	viewer->menuspamtime = cluster->curtime + CENTERTIME*1000;
+	viewer->menuspamtime = curtime + CENTERTIME*1000;
 
 	InitNetMsg(&m, buffer, sizeof(buffer));
 
@@ -106,12 +106,65 @@ void NET_InitUDPSocket(cluster_t *cluster, int port, int socketid)
 		Sys_Printf(cluster, "closed udp%i port\n", socketid?6:4);
 	}
 	cluster->qwdsocket[socketid] = sock;
+	Net_WatchSocket(cluster, sock, false);
 	if (v6only)
 		Sys_Printf(cluster, "opened udp%i port %i\n", socketid?6:4, port);
 	else
 		Sys_Printf(cluster, "opened udp port %i\n", port);
 }
 
+#ifdef USE_EPOLL
+//registers the socket with an epoll set, or updates what we're waiting for if it already is.
+//edge triggered, as whichever thread owns the set services everything whenever it wakes anyway.
+//sockets are automatically removed from the set when they're closed.
+void Net_EpollWatch(int epollfd, SOCKET sock, qboolean wantwrite)
+{
+	struct epoll_event ev;
+
+	if (epollfd == -1 || sock == INVALID_SOCKET)
+		return;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN | EPOLLET;
+	if (wantwrite)
+		ev.events |= EPOLLOUT;
+	ev.data.fd = sock;
+	if (epoll_ctl(epollfd, EPOLL_CTL_MOD, sock, &ev) == -1 && errno == ENOENT)
+		epoll_ctl(epollfd, EPOLL_CTL_ADD, sock, &ev);
+}
+void Net_EpollUnwatch(int epollfd, SOCKET sock)
+{
+	struct epoll_event ev;
+
+	if (epollfd == -1 || sock == INVALID_SOCKET)
+		return;
+
+	memset(&ev, 0, sizeof(ev));	//pre-2.6.9 kernels insist on a non-null event, even for deletes.
+	epoll_ctl(epollfd, EPOLL_CTL_DEL, sock, &ev);
+}
+
+//the main thread's set.
+void Net_WatchSocket(cluster_t *cluster, SOCKET sock, qboolean wantwrite)
+{
+	Net_EpollWatch(cluster->epollfd, sock, wantwrite);
+}
+
+//only bothers the kernel when a connection starts or stops having buffered output.
+void Net_WatchSocketWrites(cluster_t *cluster, SOCKET sock, qboolean *wantwrite, qboolean newwant)
+{
+	if (*wantwrite == newwant)
+		return;
+	*wantwrite = newwant;
+	Net_WatchSocket(cluster, sock, newwant);
+}
+
+//for sockets that some worker thread waits on instead.
+void Net_UnwatchSocket(cluster_t *cluster, SOCKET sock)
+{
+	Net_EpollUnwatch(cluster->epollfd, sock);
+}
+#endif
+
 SOCKET NET_ChooseSocket(SOCKET sock[2], netadr_t *toadr, netadr_t ina)
 {
 #ifdef AF_INET6
@@ -249,6 +302,7 @@ void NET_SendPacket(cluster_t *cluster, SOCKET sock, int length, void *data, net
 					dest->outbuffersize-=l;
 				}
 			}
+			Net_WatchSocketWrites(cluster, dest->sock, &dest->wantwrite, dest->outbuffersize>0);
 		}
 		return;
 	}
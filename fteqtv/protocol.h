@@ -205,6 +205,11 @@ enum {
 
 #define dem_mask		7
 
+//optional .idx sidecar written next to mvds by fteqw's sv_demoIndex.
+//header is {MVDINDEX_MAGIC, MVDINDEX_VERSION}, followed by keyframes of {msecs, fileoffset, length} and then length bytes of mvd data that recreate the full gamestate (to be followed by the demo's data from fileoffset).
+#define MVDINDEX_MAGIC		(('I'<<24)+('D'<<16)+('V'<<8)+'M')	//"MVDI"
+#define MVDINDEX_VERSION	1
+
 
 #define PROTOCOL_VERSION_NQ	15
 #define	PROTOCOL_VERSION	28
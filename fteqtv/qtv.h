@@ -225,6 +225,24 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include <stdio.h>
 #include <string.h>
 
+#if defined(__linux__) && !defined(LIBQTV)
+	#include <sys/epoll.h>
+	#include <fcntl.h>
+	#define USE_EPOLL	//sleep on any number of sockets, instead of being limited by FD_SETSIZE
+#endif
+
+#if !defined(LIBQTV) && (defined(_WIN32) || defined(__linux__) || defined(__APPLE__))
+	#define USE_THREADS	//streams can be pinned to worker threads
+	#ifdef _WIN32
+		#define Sys_AtomicDec(p) InterlockedDecrement((volatile LONG*)(p))
+	#else
+		#include <pthread.h>
+		#define Sys_AtomicDec(p) __sync_sub_and_fetch((p), 1)
+	#endif
+#else
+	#define Sys_AtomicDec(p) (--*(p))
+#endif
+
 #ifndef _WIN32
 //stricmp is ansi, strcasecmp is unix.
 	#define stricmp strcasecmp
@@ -539,6 +557,17 @@ typedef struct
 	int wsbits;
 } wsrbuf_t;
 
+//a chunk of the stream that is shared between every downstream proxy instead of being copied into each one's buffer.
+//immutable once created, freed when the last proxy has sent it.
+typedef struct proxyseg_s {
+	int refs;
+	unsigned int length;
+	unsigned int wshdrlen;		//websocket framing, precomputed so websocket proxies don't need their own copy
+	unsigned char wshdr[10];
+	unsigned char data[1];
+} proxyseg_t;
+#define MAX_PROXY_SEGMENTS 256	//must be power-of-two
+
 //'other proxy', these are mvd stream clients.
 typedef struct oproxy_s {
 	int authkey;
@@ -561,6 +590,17 @@ typedef struct oproxy_s {
 	unsigned char buffer[MAX_PROXY_BUFFER];
 	unsigned int buffersize;	//use cyclic buffering.
 	unsigned int bufferpos;
+
+	struct
+	{
+		proxyseg_t *seg;
+		unsigned int bufferpos;	//buffer data before this point must be sent before the segment
+	} segs[MAX_PROXY_SEGMENTS];
+	unsigned int segshead;	//also cyclic
+	unsigned int segstail;
+	unsigned int segoffset;	//amount of the head segment that was already sent
+	unsigned int segbytes;	//amount of segment data still waiting to be sent
+	qboolean wantwrite;		//we've asked to be woken when the socket can be written to
 	struct oproxy_s *next;
 } oproxy_t;
 
@@ -576,6 +616,7 @@ typedef struct tcpconnect_s
 
 	unsigned char outbuffer[MAX_PROXY_INBUFFER];
 	unsigned int outbuffersize;	//amount of data available.
+	qboolean wantwrite;
 } tcpconnect_t;
 
 typedef struct {
@@ -648,6 +689,9 @@ struct sv_s {	//details about a server connection (also known as stream)
 	qboolean upstreamacceptsdownload;
 	//
 
+	qboolean upstreamwantwrite;	//waiting for the connection to complete, or upstreambuffer to drain
+	int threadnum;	//0 if the main thread runs this stream, otherwise the worker it's pinned to
+
 	qboolean parsingqtvheader;
 
 	unsigned char upstreambuffer[2048];
@@ -689,6 +733,8 @@ struct sv_s {	//details about a server connection (also known as stream)
 
 	FILE *sourcefile;
 	unsigned int filelength;
+	char sourcefilename[512];	//so we can find its .idx
+	unsigned int demotime;	//msecs of the demo that have been parsed so far
 	SOCKET sourcesock;
 	int last_random_number;	// for demo directories randomizing stuff
 
@@ -785,9 +831,44 @@ enum
 	SG_UNIX,
 	SOCKETGROUPS
 };
+
+#ifdef USE_THREADS
+#define MAX_WORKERS 32
+#ifdef _WIN32
+typedef CRITICAL_SECTION qmutex_t;
+typedef HANDLE qthread_t;
+#else
+typedef pthread_mutex_t qmutex_t;
+typedef pthread_t qthread_t;
+#endif
+typedef struct {
+	//runs every stream (and their proxies+viewers) that is pinned to it.
+	//the main thread takes every worker's lock while it touches anything shared (menus, admin, the stream list...)
+	cluster_t *cluster;
+	int threadnum;
+	volatile qboolean quit;
+	qthread_t thread;
+	qmutex_t lock;
+	unsigned int curtime;	//the worker's own clock, cluster->curtime belongs to the main thread
+	qboolean wakeup;		//the main thread has something for this worker's viewers, poke it when the streams are unlocked
+#ifdef USE_EPOLL
+	int epollfd;			//its streams' source sockets, and wakefd
+	int wakefd[2];
+#endif
+} worker_t;
+#endif
+
 struct cluster_s {
 	SOCKET qwdsocket[SOCKETGROUPS];	//udp + quakeworld protocols
 	SOCKET tcpsocket[SOCKETGROUPS];	//tcp listening socket (for mvd and listings and stuff)
+#ifdef USE_EPOLL
+	int epollfd;	//every socket we have is registered with this, so we can sleep until something happens
+#endif
+#ifdef USE_THREADS
+	worker_t workers[MAX_WORKERS];
+	int numworkers;
+	int wantworkers;	//changed by the threads command, applied at the start of the next frame
+#endif
 	tcpconnect_t *tcpconnects;	//'tcpconnect' qizmo-compatible quakeworld-over-tcp connection
 
 	char commandinput[512];
@@ -918,10 +999,12 @@ void ParseMessage(sv_t *tv, void *buffer, int length, int to, int mask);
 void BuildServerData(sv_t *tv, netmsg_t *msg, int servercount, viewer_t *spectatorflag);
 void BuildNQServerData(sv_t *tv, netmsg_t *msg, qboolean mvd, int servercount);
 void QW_UpdateUDPStuff(cluster_t *qtv);
+void SendViewerPackets(cluster_t *cluster, viewer_t *v, unsigned int curtime);
 void QW_TCPConnection(cluster_t *cluster, SOCKET sock, wsrbuf_t ws);
 unsigned int Sys_Milliseconds(void);
 void Prox_SendInitialEnts(sv_t *qtv, oproxy_t *prox, netmsg_t *msg);
 qboolean QTV_ConnectStream(sv_t *qtv, char *serverurl);
+qboolean QTV_SeekDemo(sv_t *qtv, unsigned int msecs);
 void QTV_ShutdownStream(sv_t *qtv);
 qboolean	NET_StringToAddr (char *s, netadr_t *sadr, int defaultport);
 void QTV_Printf(sv_t *qtv, char *format, ...) PRINTFWARNING(2);
@@ -946,6 +1029,17 @@ void Netchan_Setup (SOCKET sock, netchan_t *chan, netadr_t adr, int qport, qbool
 void Netchan_OutOfBandPrint (cluster_t *cluster, netadr_t adr, char *format, ...) PRINTFWARNING(3);
 //int Netchan_IsLocal (netadr_t adr);
 void NET_InitUDPSocket(cluster_t *cluster, int port, int socketid);
+#ifdef USE_EPOLL
+void Net_EpollWatch(int epollfd, SOCKET sock, qboolean wantwrite);
+void Net_EpollUnwatch(int epollfd, SOCKET sock);
+void Net_WatchSocket(cluster_t *cluster, SOCKET sock, qboolean wantwrite);
+void Net_WatchSocketWrites(cluster_t *cluster, SOCKET sock, qboolean *wantwrite, qboolean newwant);
+void Net_UnwatchSocket(cluster_t *cluster, SOCKET sock);
+#else
+#define Net_WatchSocket(cluster,sock,wantwrite)
+#define Net_WatchSocketWrites(cluster,sock,wantwrite,newwant)
+#define Net_UnwatchSocket(cluster,sock)
+#endif
 void NET_SendPacket(cluster_t *cluster, SOCKET sock, int length, void *data, netadr_t adr);
 SOCKET NET_ChooseSocket(SOCKET sock[], netadr_t *toadr, netadr_t in);
 qboolean Net_CompareAddress(netadr_t *s1, netadr_t *s2, int qp1, int qp2);
@@ -974,6 +1068,7 @@ unsigned short QCRC_Value(unsigned short crcvalue);
 void WriteDeltaUsercmd (netmsg_t *m, const usercmd_t *from, usercmd_t *move);
 void SendClientCommand(sv_t *qtv, char *fmt, ...) PRINTFWARNING(2);
 void QTV_Run(sv_t *qtv);
+void QTV_RunStream(sv_t *qtv);
 
 char *COM_ParseToken (char *data, char *out, int outsize, const char *punctuation);
 char *Info_ValueForKey (char *s, const char *key, char *buffer, int buffersize);
@@ -982,12 +1077,22 @@ void ReadDeltaUsercmd (netmsg_t *m, const usercmd_t *from, usercmd_t *move);
 unsigned Com_BlockChecksum (void *buffer, int length);
 void Com_BlockFullChecksum (void *buffer, int len, unsigned char *outbuf);
 void Cluster_BuildAvailableDemoList(cluster_t *cluster);
+#ifdef USE_THREADS
+int Cluster_PickWorker(cluster_t *cluster);
+void Cluster_PinStream(sv_t *qtv, int threadnum);
+void Cluster_WatchStream(sv_t *qtv);
+void Cluster_WakeWorker(cluster_t *cluster, int threadnum);
+#else
+#define Cluster_WatchStream(qtv) Net_WatchSocket((qtv)->cluster, (qtv)->sourcesock, (qtv)->upstreamwantwrite)
+#define Cluster_WakeWorker(cluster,threadnum)
+#endif
 
 void Sys_Printf(cluster_t *cluster, char *fmt, ...) PRINTFWARNING(2);
 //void Sys_mkdir(char *path);
 void QTV_mkdir(char *path);
 
 void Net_ProxySend(cluster_t *cluster, oproxy_t *prox, void *buffer, int length);
+void Net_ProxyReleaseSegments(oproxy_t *prox);
 oproxy_t *Net_FileProxy(sv_t *qtv, char *filename);
 sv_t *QTV_NewServerConnection(cluster_t *cluster, int streamid, char *server, char *password, qboolean force, enum autodisconnect_e autodisconnect, qboolean noduplicates, qboolean query);
 void Net_TCPListen(cluster_t *cluster, int port, int socketid);
@@ -1015,7 +1120,7 @@ void tobase64(unsigned char *out, int outlen, unsigned char *in, int inlen);
 
 //menu.c
 void Menu_Enter(cluster_t *cluster, viewer_t *viewer, int buttonnum);
-void Menu_Draw(cluster_t *cluster, viewer_t *viewer);
+void Menu_Draw(cluster_t *cluster, viewer_t *viewer, unsigned int curtime);
 
 
 #ifdef __cplusplus
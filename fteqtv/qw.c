@@ -4149,7 +4149,7 @@ void QW_FreeViewer(cluster_t *cluster, viewer_t *viewer)
 	cluster->numviewers--;
 }
 
-void SendViewerPackets(cluster_t *cluster, viewer_t *v)
+void SendViewerPackets(cluster_t *cluster, viewer_t *v, unsigned int curtime)
 {
 	char buffer[MAX_MSGLEN];
 	netmsg_t m;
@@ -4158,7 +4158,7 @@ void SendViewerPackets(cluster_t *cluster, viewer_t *v)
 
 	v->drop |= v->netchan.drop;
 
-	if (v->timeout < cluster->curtime)
+	if (v->timeout < curtime)
 	{
 		Sys_Printf(cluster, "Viewer %s timed out\n", v->name);
 		v->drop = true;
@@ -4166,7 +4166,7 @@ void SendViewerPackets(cluster_t *cluster, viewer_t *v)
 
 	if (v->netchan.isnqprotocol && (v->server == NULL || v->server->parsingconnectiondata))
 	{
-		v->maysend = (v->nextpacket < cluster->curtime);
+		v->maysend = (v->nextpacket < curtime);
 	}
 	if (!Netchan_CanPacket(&v->netchan))
 	{
@@ -4174,12 +4174,12 @@ void SendViewerPackets(cluster_t *cluster, viewer_t *v)
 	}
 	if (v->maysend)	//don't send incompleate connection data.
 	{
-//		printf("maysend (%i, %i)\n", cluster->curtime, v->nextpacket);
+//		printf("maysend (%i, %i)\n", curtime, v->nextpacket);
 		v->nextpacket = v->nextpacket + 1000/NQ_PACKETS_PER_SECOND;
-		if (v->nextpacket < cluster->curtime)
-			v->nextpacket = cluster->curtime;
-		if (v->nextpacket > cluster->curtime+1000/NQ_PACKETS_PER_SECOND)
-			v->nextpacket = cluster->curtime+1000/NQ_PACKETS_PER_SECOND;
+		if (v->nextpacket < curtime)
+			v->nextpacket = curtime;
+		if (v->nextpacket > curtime+1000/NQ_PACKETS_PER_SECOND)
+			v->nextpacket = curtime+1000/NQ_PACKETS_PER_SECOND;
 
 		useserver = v->server;
 		if (useserver && useserver->controller == v)
@@ -4202,7 +4202,7 @@ void SendViewerPackets(cluster_t *cluster, viewer_t *v)
 			UpdateStats(useserver, v);
 		}
 		if (v->menunum)
-			Menu_Draw(cluster, v);
+			Menu_Draw(cluster, v, curtime);
 		else if (v->server && v->server->parsingconnectiondata && v->server->controller != v)
 		{
 			WriteByte(&m, svc_centerprint);
@@ -4240,7 +4240,7 @@ void SendViewerPackets(cluster_t *cluster, viewer_t *v)
 		}
 	}
 //	else
-//		printf("maynotsend (%i, %i)\n", cluster->curtime, v->nextpacket);
+//		printf("maynotsend (%i, %i)\n", curtime, v->nextpacket);
 }
 
 void QW_ProcessUDPPacket(cluster_t *cluster, netmsg_t *m, netadr_t from)
@@ -4282,6 +4282,8 @@ void QW_ProcessUDPPacket(cluster_t *cluster, netmsg_t *m, netadr_t from)
 						useserver = NULL;
 
 					v->timeout = cluster->curtime + 15*1000;
+					if (v->server)
+						Cluster_WakeWorker(cluster, v->server->threadnum);	//it might have something to send now
 
 					ParseNQC(cluster, useserver, v, m);
 
@@ -4297,7 +4299,7 @@ void QW_ProcessUDPPacket(cluster_t *cluster, netmsg_t *m, netadr_t from)
 			if (Net_CompareAddress(&v->netchan.remote_address, &from, v->netchan.qport, qport))
 			{
 				if (v->server && v->server->controller == v && v->maysend)
-					SendViewerPackets(cluster, v);	//do this before we read the new sequences
+					SendViewerPackets(cluster, v, cluster->curtime);	//do this before we read the new sequences
 
 				if (Netchan_Process(&v->netchan, m))
 				{
@@ -4306,6 +4308,8 @@ void QW_ProcessUDPPacket(cluster_t *cluster, netmsg_t *m, netadr_t from)
 						useserver = NULL;
 
 					v->timeout = cluster->curtime + 15*1000;
+					if (v->server)
+						Cluster_WakeWorker(cluster, v->server->threadnum);	//it might have something to send now
 
 					if (v->server && v->server->controller == v)
 					{
@@ -4418,6 +4422,8 @@ void QW_TCPConnection(cluster_t *cluster, SOCKET sock, wsrbuf_t ws)
 	tc->websocket = ws;
 	tc->inbuffersize = 0;
 	tc->outbuffersize = 0;
+	tc->wantwrite = false;
+	Net_WatchSocket(cluster, sock, false);	//probably already is, but might not be.
 
 	memset(&tc->peeraddr, 0, sizeof(tc->peeraddr));
 	tc->peeraddr.tcpcon = tc;
@@ -4569,6 +4575,8 @@ void QW_UpdateUDPStuff(cluster_t *cluster)
 			QW_FreeViewer(cluster, f);
 		}
 
-		SendViewerPackets(cluster, v);
+		if (v->server && v->server->threadnum)
+			continue;	//its stream's worker sends its packets
+		SendViewerPackets(cluster, v, cluster->curtime);
 	}
 }
@@ -828,6 +828,33 @@ void Cmd_MaxProxies(cmdctxt_t *ctx)
 	}
 }
 
+void Cmd_Threads(cmdctxt_t *ctx)
+{
+#ifdef USE_THREADS
+	char *val = Cmd_Argv(ctx, 1);
+	int count;
+	if (!*val)
+	{
+		if (ctx->cluster->numworkers)
+			Cmd_Printf(ctx, "streams are currently spread over %i worker threads\n", ctx->cluster->numworkers);
+		else
+			Cmd_Printf(ctx, "streams are currently all run on the main thread\n");
+	}
+	else
+	{
+		count = atoi(val);
+		if (count < 0)
+			count = 0;
+		if (count > MAX_WORKERS)
+			count = MAX_WORKERS;
+		ctx->cluster->wantworkers = count;
+		Cmd_Printf(ctx, "threads set\n");
+	}
+#else
+	Cmd_Printf(ctx, "threads are not supported in this build\n");
+#endif
+}
+
 
 void Cmd_Ping(cmdctxt_t *ctx)
 {
@@ -933,6 +960,34 @@ void Cmd_DemoSpeed(cmdctxt_t *ctx)
 		Cmd_Printf(ctx, "Playing demo at %f speed\n", ctx->qtv->parsespeed/1000.0f);
 }
 
+void Cmd_Seek(cmdctxt_t *ctx)
+{
+	char *val = Cmd_Argv(ctx, 1);
+	char *colon = strchr(val, ':');
+	int secs;
+
+	if (!*val)
+	{
+		Cmd_Printf(ctx, "Demo time is %u:%02u\n", ctx->qtv->demotime/60000, (ctx->qtv->demotime/1000)%60);
+		return;
+	}
+
+	//[+|-][mins:]secs
+	if (colon)
+		secs = atoi(val)*60 + ((*val=='-')?-atoi(colon+1):atoi(colon+1));
+	else
+		secs = atoi(val);
+	if (*val == '+' || *val == '-')
+		secs += ctx->qtv->demotime/1000;
+	if (secs < 0)
+		secs = 0;
+
+	if (QTV_SeekDemo(ctx->qtv, secs*1000))
+		Cmd_Printf(ctx, "Seeking to %i:%02i\n", secs/60, secs%60);
+	else
+		Cmd_Printf(ctx, "Sorry, only demos may be seeked.\n");
+}
+
 void Cmd_Disconnect(cmdctxt_t *ctx)
 {
 	QTV_ShutdownStream(ctx->qtv);
@@ -1193,6 +1248,30 @@ void Cmd_MapSource(cmdctxt_t *ctx)
 	}
 }
 
+void Cmd_StreamThread(cmdctxt_t *ctx)
+{
+#ifdef USE_THREADS
+	char *val;
+	int threadnum;
+	val = Cmd_Argv(ctx, 1);
+	if (*val)
+	{
+		threadnum = atoi(val);
+		if (threadnum < 0 || threadnum > ctx->cluster->numworkers)
+			Cmd_Printf(ctx, "There are only %i worker threads\n", ctx->cluster->numworkers);
+		else
+		{
+			Cluster_PinStream(ctx->qtv, threadnum);
+			Cmd_Printf(ctx, "Stream is now run by thread %i\n", threadnum);
+		}
+	}
+	else
+		Cmd_Printf(ctx, "Stream is currently run by thread %i\n", ctx->qtv->threadnum);
+#else
+	Cmd_Printf(ctx, "threads are not supported in this build\n");
+#endif
+}
+
 void Cmd_MuteStream(cmdctxt_t *ctx)
 {
 	char *val;
@@ -1289,6 +1368,7 @@ const rconcommands_t rconcommands[] =
 	{"userconnects",	0, 1, Cmd_UserConnects,	"prevents users from creating thier own streams"},
 	{"maxviewers",		0, 1, Cmd_MaxViewers,	"sets a limit on udp/qw client connections"},
 	{"maxproxies",		0, 1, Cmd_MaxProxies,	"sets a limit on tcp/qtv client connections"},
+	{"threads",		0, 1, Cmd_Threads,	"spreads streams (along with their proxies and viewers) over this many worker threads. 0 runs everything on the main thread"},
 	{"demodir",		0, 1, Cmd_DemoDir,	"specifies where to get the demo list from"},
 	{"basedir",		0, 1, Cmd_BaseDir,	"specifies where to get any files required by the game. this is prefixed to the server-specified game dir."},
 	{"ping",		0, 1, Cmd_Ping,		"sends a udp ping to a qtv proxy or server"},
@@ -1309,10 +1389,12 @@ const rconcommands_t rconcommands[] =
 	{"enable",		1, 0, Cmd_Resume},
 	{"mute",		1, 0, Cmd_MuteStream,	"hides prints that come from the game server"},
 	{"mutestream",		1, 0, Cmd_MuteStream},
+	{"thread",		1, 0, Cmd_StreamThread,	"pins a stream to a specific worker thread, or 0 for the main thread"},
 	{"disconnect",		1, 0, Cmd_Disconnect,	"fully closes a stream"},
 	{"record",		1, 0, Cmd_Record,	"records a stream to a demo"},
 	{"stop",		1, 0, Cmd_Stop,		"stops recording of a demo"},
 	{"demospeed",		1, 0, Cmd_DemoSpeed,	"changes the rate the demo is played at"},
+	{"seek",		1, 0, Cmd_Seek,		"jumps to a time within a demo ([+|-][mins:]secs). Fast if the demo has an .idx from sv_demoIndex."},
 	{"tcpport",		0, 1, Cmd_MVDPort,	"specifies which port to listen on for tcp/qtv connections"},
 	 {"mvdport",		0, 1, Cmd_MVDPort},
 
@@ -354,7 +354,8 @@ void Net_TCPListen(cluster_t *cluster, int port, int socketid)
 		return;
 	}
 
-	listen(sock, 2);	//don't listen for too many clients at once.
+	listen(sock, 64);	//enough to ride out bursts of connections, we accept them all each frame anyway.
+	Net_WatchSocket(cluster, sock, false);
 
 	Sys_Printf(cluster, "opened %s port %i\n", famname, port);
 
@@ -570,6 +571,10 @@ qboolean Net_ConnectToTCPServer(sv_t *qtv, char *ip)
 		}
 	}
 
+	//wake up once the connect completes.
+	qtv->upstreamwantwrite = true;
+	Cluster_WatchStream(qtv);
+
 	//make sure the buffers are empty. we could have disconnected prematurly
 	qtv->upstreambuffersize = 0;
 	qtv->buffersize = 0;
@@ -621,6 +626,9 @@ qboolean Net_ConnectToUDPServer(sv_t *qtv, char *ip)
 
 	qtv->qport = Sys_Milliseconds()*1000+Sys_Milliseconds();
 
+	qtv->upstreamwantwrite = false;
+	Cluster_WatchStream(qtv);
+
 	return true;
 }
 
@@ -696,6 +704,7 @@ qboolean Net_ConnectToDemoServer(sv_t* qtv, char* ip, char* dir)
 		else
 			snprintf(fullname, sizeof(fullname), "%s%s/%s", qtv->cluster->demodir, dir, ip);
 		qtv->sourcefile = fopen(fullname, "rb");
+		strlcpy(qtv->sourcefilename, fullname, sizeof(qtv->sourcefilename));
 	}
 	else
 		qtv->sourcefile = NULL;
@@ -984,6 +993,10 @@ qboolean Net_WriteUpstream(sv_t *qtv)
 		qtv->upstreambuffersize -= len;
 		memmove(qtv->upstreambuffer, qtv->upstreambuffer + len, qtv->upstreambuffersize);
 	}
+	if (qtv->threadnum)
+		qtv->upstreamwantwrite = qtv->upstreambuffersize>0;
+	else if (qtv->sourcesock != INVALID_SOCKET)
+		Net_WatchSocketWrites(qtv->cluster, qtv->sourcesock, &qtv->upstreamwantwrite, qtv->upstreambuffersize>0);
 	return true;
 }
 
@@ -1334,6 +1347,7 @@ qboolean QTV_ConnectStream(sv_t *qtv, char *serverurl)
 	}
 
 	memcpy(qtv->server, serverurl, sizeof(qtv->server)-1);
+	qtv->demotime = 0;
 	if (qtv->autodisconnect == AD_STATUSPOLL && !qtv->numviewers && !qtv->proxies)
 	{
 		char *ip;
@@ -1380,6 +1394,83 @@ qboolean QTV_ConnectStream(sv_t *qtv, char *serverurl)
 	return true;
 }
 
+//jumps a demo stream to the given time.
+//restarts from the last keyframe in the demo's .idx before that point (or the start of the file, without one), and then plays through the rest as fast as it can.
+qboolean QTV_SeekDemo(sv_t *qtv, unsigned int msecs)
+{
+	char idxname[sizeof(qtv->sourcefilename)+4];
+	FILE *idx;
+	int header[3];
+	long pos;
+	unsigned int besttime = 0, bestofs = 0, bestlen = 0;
+	long bestpos = 0;
+
+	if (qtv->sourcetype != SRC_DEMO)
+		return false;
+	if (!qtv->sourcefile && *qtv->sourcefilename)	//we may have already read up to the end of it
+		qtv->sourcefile = fopen(qtv->sourcefilename, "rb");
+	if (!qtv->sourcefile)
+		return false;
+
+	snprintf(idxname, sizeof(idxname), "%s.idx", qtv->sourcefilename);
+	idx = fopen(idxname, "rb");
+	if (idx)
+	{
+		if (fread(header, 1, sizeof(int)*2, idx) == sizeof(int)*2 && LittleLong(header[0]) == MVDINDEX_MAGIC && LittleLong(header[1]) == MVDINDEX_VERSION)
+		{
+			for (pos = sizeof(int)*2; fread(header, 1, sizeof(header), idx) == sizeof(header); )
+			{
+				if ((unsigned int)LittleLong(header[0]) > msecs)
+					break;
+				//keyframes that are too big to fit in our buffer are useless to us, but earlier ones are still better than nothing.
+				if ((unsigned int)LittleLong(header[2]) <= MAX_PROXY_BUFFER-PREFERRED_PROXY_BUFFER)
+				{
+					besttime = LittleLong(header[0]);
+					bestofs = LittleLong(header[1]);
+					bestlen = LittleLong(header[2]);
+					bestpos = pos + sizeof(header);
+				}
+
+				pos += sizeof(header) + LittleLong(header[2]);
+				if (fseek(idx, pos, SEEK_SET))
+					break;
+			}
+		}
+		if (bestpos)
+		{
+			fseek(idx, bestpos, SEEK_SET);
+			if (fread(qtv->buffer, 1, bestlen, idx) != bestlen)
+				bestpos = 0;
+		}
+		fclose(idx);
+	}
+
+	if (!bestpos)
+	{	//no usable keyframe. the file itself starts with a gamestate though.
+		besttime = 0;
+		bestofs = 0;
+		bestlen = 0;
+	}
+	if (fseek(qtv->sourcefile, bestofs, SEEK_SET))
+	{
+		qtv->buffersize = 0;
+		qtv->forwardpoint = 0;
+		return false;
+	}
+
+	//anything still buffered is from the wrong part of the demo. the keyframe's gamestate replaces it.
+	qtv->buffersize = bestlen;
+	qtv->forwardpoint = 0;
+	qtv->demotime = besttime;
+
+	//pretend we're running late, so the gap from the keyframe is played through immediately.
+	msecs -= besttime;
+	if (qtv->parsespeed>0)
+		msecs = ((unsigned long long)msecs*1000) / qtv->parsespeed;
+	qtv->parsetime = qtv->curtime - msecs;
+	return true;
+}
+
 void QTV_CleanupMap(sv_t *qtv)
 {
 	int i;
@@ -1473,6 +1564,7 @@ void QTV_Cleanup(sv_t *qtv, qboolean leaveadmins)
 			closesocket(prox->sock);
 		old = prox;
 		prox = prox->next;
+		Net_ProxyReleaseSegments(old);
 		free(old);
 		cluster->numproxies--;
 	}
@@ -1826,14 +1918,6 @@ void QTV_CollectCommentry(sv_t *qtv)
 
 void QTV_Run(sv_t *qtv)
 {
-	int from;
-	int to;
-	int lengthofs;
-	unsigned int length;
-	unsigned char *buffer;
-	int oldcurtime;
-	int packettime;
-
 	if (qtv->numviewers == 0 && qtv->proxies == NULL)
 	{
 		if (qtv->autodisconnect == AD_WHENEMPTY)
@@ -1869,6 +1953,23 @@ void QTV_Run(sv_t *qtv)
 		}
 	}
 
+	if (!qtv->threadnum)	//otherwise its worker does the rest
+		QTV_RunStream(qtv);
+}
+
+//reads+parses the source and keeps proxies fed.
+//unlike QTV_Run, this may be called from a worker thread, so must leave shared cluster state alone.
+void QTV_RunStream(sv_t *qtv)
+{
+	int from;
+	int to;
+	int lengthofs;
+	unsigned int length;
+	unsigned char *buffer;
+	int oldcurtime;
+	int packettime;
+	unsigned char demomsecs;
+
 
 
 //we will read out as many packets as we can until we're up to date
@@ -2338,6 +2439,7 @@ void QTV_Run(sv_t *qtv)
 				continue;
 			}
 			qtv->parsetime += buffer[0];	//well this was pointless
+			qtv->demotime += buffer[0];
 
 			if (qtv->forwardpoint < length)	//we're about to destroy this data, so it had better be forwarded by now!
 			{
@@ -2400,7 +2502,8 @@ void QTV_Run(sv_t *qtv)
 //			qtv->parsespeed = 1000;	//no speeding up/slowing down routed demos
 //		}
 
-		packettime = buffer[0];
+		demomsecs = buffer[0];	//the buffer gets shuffled down before we're done with this packet
+		packettime = demomsecs;
 		if (qtv->parsespeed>0)
 			packettime = ((1000*packettime) / qtv->parsespeed);
 		qtv->nextpackettime = qtv->parsetime + packettime;
@@ -2456,6 +2559,7 @@ void QTV_Run(sv_t *qtv)
 				qtv->nextconnectattempt = qtv->curtime + RECONNECT_TIME;
 
 			qtv->parsetime += packettime;
+			qtv->demotime += demomsecs;
 		}
 		else
 			break;
@@ -2523,6 +2627,9 @@ sv_t *QTV_NewServerConnection(cluster_t *cluster, int newstreamid, char *server,
 
 	qtv->cluster = cluster;
 	qtv->next = cluster->servers;
+#ifdef USE_THREADS
+	qtv->threadnum = Cluster_PickWorker(cluster);
+#endif
 
 	if (autoclose != AD_REVERSECONNECT)	//2 means reverse connection (don't ever try reconnecting)
 	{